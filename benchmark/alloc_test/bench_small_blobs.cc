@@ -0,0 +1,97 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * Create many small blobs like the null bitmaps, offsets buffers and schema
+ * blobs of arrow tables, and report the latency of blob creation and the
+ * memory usage of vineyardd.
+ *
+ * Compare the results of vineyardd with `--small_blob_threshold=0` and the
+ * default threshold.
+ */
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./bench_small_blobs <ipc_socket> [<count>] [<max size>]");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  size_t count = 100000, max_size = 4096;
+  if (argc > 2) {
+    count = std::strtoull(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    max_size = std::strtoull(argv[3], nullptr, 10);
+  }
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+
+  std::shared_ptr<InstanceStatus> status_before, status_after;
+  VINEYARD_CHECK_OK(client.InstanceStatus(status_before));
+
+  // most of the small blobs are tiny
+  std::mt19937_64 rng(0);
+  std::geometric_distribution<size_t> sizes(16.0 / max_size);
+
+  std::vector<ObjectID> blobs;
+  std::vector<double> latencies;
+  size_t requested = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    size_t size = std::min(max_size, sizes(rng) + 1);
+    auto begin = std::chrono::steady_clock::now();
+    std::unique_ptr<BlobWriter> blob;
+    VINEYARD_CHECK_OK(client.CreateBlob(size, blob));
+    latencies.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - begin)
+                            .count());
+    blobs.push_back(blob->id());
+    requested += size;
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  VINEYARD_CHECK_OK(client.InstanceStatus(status_after));
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "created " << count << " blobs (" << requested
+            << " bytes) in " << elapsed << " seconds, "
+            << count / elapsed << " blobs/s" << std::endl;
+  std::cout << "latency: p50 = " << latencies[count / 2]
+            << " us, p99 = " << latencies[count * 99 / 100] << " us"
+            << std::endl;
+  std::cout << "memory usage of vineyardd: "
+            << status_after->memory_usage - status_before->memory_usage
+            << " bytes" << std::endl;
+
+  VINEYARD_CHECK_OK(client.DelData(blobs, true, true));
+  client.Disconnect();
+  return 0;
+}
@@ -0,0 +1,170 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "server/memory/eviction.h"
+
+using vineyard::detail::EvictionPolicy;
+
+/**
+ * Replay a trace of the cold object tracker against the eviction policies.
+ *
+ * Each line of the trace is "<op> <blob id> <size in bytes>", where the op is
+ * either
+ *  - "ref": the blob is released by clients and becomes a candidate to spill,
+ *  - "unref": the blob is accessed by clients, it needs to be reloaded if it
+ *    has been spilled.
+ */
+struct TraceEvent {
+  bool ref;
+  uint64_t id;
+  size_t size;
+};
+
+struct ReplayResult {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t reload_bytes = 0;
+  size_t spill_bytes = 0;
+};
+
+ReplayResult Replay(std::vector<TraceEvent> const& trace,
+                    std::string const& policy_name, size_t memory_size) {
+  auto policy = EvictionPolicy<uint64_t>::Make(policy_name);
+  ReplayResult result;
+  std::unordered_map<uint64_t, size_t> in_memory, spilled;
+  size_t resident = 0;
+
+  for (auto const& event : trace) {
+    if (event.ref) {
+      if (in_memory.find(event.id) != in_memory.end()) {
+        policy->Add(event.id);
+      }
+      continue;
+    }
+    policy->Access(event.id);
+    auto iter = spilled.find(event.id);
+    if (iter != spilled.end()) {
+      result.misses += 1;
+      result.reload_bytes += iter->second;
+      spilled.erase(iter);
+      in_memory.emplace(event.id, event.size);
+      resident += event.size;
+    } else if (in_memory.find(event.id) != in_memory.end()) {
+      result.hits += 1;
+      policy->Remove(event.id);
+    } else {
+      // a newly created blob
+      in_memory.emplace(event.id, event.size);
+      resident += event.size;
+    }
+    uint64_t victim;
+    while (resident > memory_size && policy->Victim(victim)) {
+      size_t size = in_memory[victim];
+      policy->Remove(victim);
+      in_memory.erase(victim);
+      spilled.emplace(victim, size);
+      resident -= size;
+      result.spill_bytes += size;
+    }
+  }
+  return result;
+}
+
+/**
+ * Generate a trace where a small set of hot blobs are accessed repeatedly by
+ * online jobs, while large scans over blobs that are used only once happen
+ * periodically.
+ */
+std::vector<TraceEvent> GenerateTrace(size_t rounds) {
+  constexpr size_t kHotBlobs = 256, kScanBlobs = 2048;
+  constexpr size_t kBlobSize = 1024 * 1024;
+  std::vector<TraceEvent> trace;
+  std::mt19937_64 rng(0);
+  std::uniform_int_distribution<uint64_t> hot(0, kHotBlobs - 1);
+  uint64_t next_scan_id = kHotBlobs;
+  for (size_t round = 0; round < rounds; ++round) {
+    for (size_t i = 0; i < kHotBlobs * 4; ++i) {
+      uint64_t id = hot(rng);
+      trace.push_back({false, id, kBlobSize});
+      trace.push_back({true, id, kBlobSize});
+    }
+    if (round % 4 == 3) {
+      for (size_t i = 0; i < kScanBlobs; ++i) {
+        uint64_t id = next_scan_id++;
+        trace.push_back({false, id, kBlobSize});
+        trace.push_back({true, id, kBlobSize});
+      }
+    }
+  }
+  return trace;
+}
+
+bool LoadTrace(std::string const& path, std::vector<TraceEvent>& trace) {
+  std::ifstream input(path);
+  if (!input) {
+    return false;
+  }
+  std::string op;
+  uint64_t id;
+  size_t size;
+  while (input >> op >> id >> size) {
+    trace.push_back({op == "ref", id, size});
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  // 512 MiB by default, which is enough for the hot blobs in the generated
+  // trace.
+  size_t memory_size = 512;
+  if (argc > 1) {
+    memory_size = std::strtoull(argv[1], nullptr, 10);
+  }
+  memory_size *= 1024 * 1024;
+
+  std::vector<TraceEvent> trace;
+  if (argc > 2) {
+    if (!LoadTrace(argv[2], trace)) {
+      std::cerr << "Failed to open the trace file: " << argv[2] << std::endl;
+      return 1;
+    }
+  } else {
+    trace = GenerateTrace(32);
+  }
+
+  std::cout << "replaying " << trace.size() << " events with "
+            << memory_size / (1024 * 1024) << " MiB memory" << std::endl;
+  for (auto const& policy : {"lru", "wtinylfu"}) {
+    auto result = Replay(trace, policy, memory_size);
+    size_t total = result.hits + result.misses;
+    double hit_rate =
+        total == 0 ? 0 : static_cast<double>(result.hits) / total * 100;
+    std::cout << policy << ": hit rate = " << hit_rate
+              << "%, reload bytes = " << result.reload_bytes
+              << ", spill bytes = " << result.spill_bytes << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,137 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if !defined(MFD_HUGETLB)
+#define MFD_HUGETLB 0x0004U
+#endif
+#if !defined(MFD_HUGE_SHIFT)
+#define MFD_HUGE_SHIFT 26
+#endif
+
+/**
+ * Compare sequential column scans over shared memory backed by normal pages
+ * and huge pages, in the same way as the bulk store of vineyardd (memfd) and
+ * the clients (a second, read-only mapping of the same fd).
+ */
+
+constexpr size_t kColumns = 8;
+
+int CreateBuffer(size_t size, size_t huge_page_size) {
+  unsigned int flags = 0;
+  if (huge_page_size != 0) {
+    flags = MFD_HUGETLB;
+    flags |= (huge_page_size == (1ULL << 30) ? 30U : 21U) << MFD_HUGE_SHIFT;
+  }
+  int fd = static_cast<int>(syscall(SYS_memfd_create, "bench-scan", flags));
+  if (fd < 0) {
+    return -1;
+  }
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+double Scan(const int64_t* data, size_t rows, int64_t& sum) {
+  auto start = std::chrono::steady_clock::now();
+  // scan the columns one by one, as reading arrow arrays
+  for (size_t column = 0; column < kColumns; ++column) {
+    const int64_t* values = data + column * rows;
+    for (size_t row = 0; row < rows; ++row) {
+      sum += values[row];
+    }
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+bool Bench(std::string const& name, size_t size, size_t huge_page_size,
+           int repeats) {
+  if (huge_page_size != 0) {
+    size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+  }
+  int fd = CreateBuffer(size, huge_page_size);
+  if (fd < 0) {
+    std::cout << name << ": not available, " << strerror(errno) << std::endl;
+    return false;
+  }
+  // the writer (server) side
+  void* writer =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (writer == MAP_FAILED) {
+    std::cout << name << ": mmap failed, " << strerror(errno) << std::endl;
+    close(fd);
+    return false;
+  }
+  size_t rows = size / sizeof(int64_t) / kColumns;
+  int64_t* values = static_cast<int64_t*>(writer);
+  for (size_t i = 0; i < rows * kColumns; ++i) {
+    values[i] = static_cast<int64_t>(i);
+  }
+
+  // the reader (client) side
+  void* reader = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (reader == MAP_FAILED) {
+    std::cout << name << ": mmap failed, " << strerror(errno) << std::endl;
+    munmap(writer, size);
+    close(fd);
+    return false;
+  }
+  int64_t sum = 0;
+  double first = Scan(static_cast<const int64_t*>(reader), rows, sum);
+  double total = 0;
+  for (int i = 0; i < repeats; ++i) {
+    total += Scan(static_cast<const int64_t*>(reader), rows, sum);
+  }
+  double gb = static_cast<double>(rows * kColumns * sizeof(int64_t)) / 1e9;
+  std::cout << name << ": first scan " << gb / first << " GB/s, warm scan "
+            << gb * repeats / total << " GB/s (checksum " << sum << ")"
+            << std::endl;
+  munmap(reader, size);
+  munmap(writer, size);
+  close(fd);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  // 1 GiB by default
+  size_t size = 1024;
+  int repeats = 5;
+  if (argc > 1) {
+    size = std::strtoull(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    repeats = std::atoi(argv[2]);
+  }
+  size *= 1024 * 1024;
+
+  Bench("4K pages", size, 0, repeats);
+  Bench("2M huge pages", size, 2ULL << 20, repeats);
+  Bench("1G huge pages", size, 1ULL << 30, repeats);
+  return 0;
+}
@@ -0,0 +1,262 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <fnmatch.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/json.h"
+#include "common/util/status.h"
+#include "common/util/uuid.h"
+#include "server/util/meta_tree.h"
+#include "server/util/spec_resolvers.h"
+
+namespace vineyard {
+// the metrics are not printed in the benchmark
+DEFINE_bool(prometheus, false,
+            "Whether to print metrics for prometheus or not");
+}  // namespace vineyard
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * Build a meta tree of the given number of objects, as it is in vineyardd,
+ * and compare the lookups that walk the json tree with the lookups that are
+ * resolved by the `MetaIndex`.
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+static const std::string kInstanceName = "i0";
+
+double elapsed_us(clock_type::time_point const& begin) {
+  return std::chrono::duration<double, std::micro>(clock_type::now() - begin)
+      .count();
+}
+
+std::string TypeOf(size_t index) {
+  if (index % 100000 == 0) {
+    return "vineyard::Table<std::string>";
+  }
+  if (index % 8 == 7) {
+    return "vineyard::GlobalTensor";
+  }
+  static const std::vector<std::string> types = {
+      "vineyard::Tensor<double>", "vineyard::Tensor<int64_t>",
+      "vineyard::Table<int64_t>", "vineyard::DataFrame"};
+  return types[index % types.size()];
+}
+
+/**
+ * The object `index` refers a blob, and every 8 objects the global object
+ * refers the previous one by the signature.
+ */
+void BuildMetaTree(json& tree, meta_tree::MetaIndex& index, size_t objects) {
+  json& datas = tree["data"];
+  json& signatures = tree["signatures"][kInstanceName];
+  std::vector<std::string> keys;
+  for (size_t i = 1; i <= objects; ++i) {
+    std::string name = ObjectIDToString(static_cast<ObjectID>(i));
+    std::string signature = SignatureToString(static_cast<Signature>(i));
+    std::string type = TypeOf(i);
+    json object;
+    object["typename"] = meta_tree::EncodeValue(type);
+    object["instance_id"] = 0;
+    object["signature"] = static_cast<Signature>(i);
+    object["transient"] = false;
+    object["nbytes"] = 1024;
+    if (type == "vineyard::GlobalTensor") {
+      object["global"] = true;
+      object["partitions_-0"] =
+          "l" + SignatureToString(static_cast<Signature>(i - 1)) +
+          ".vineyard::Tensor";
+    } else {
+      ObjectID blob_id = 0x8000000000000000UL | i;
+      object["buffer_"] =
+          "l" + ObjectIDToString(blob_id) + ".vineyard::Blob@0";
+    }
+    datas[name] = object;
+    signatures[signature] = name;
+    keys.emplace_back("/data/" + name);
+    keys.emplace_back("/signatures/" + kInstanceName + "/" + signature);
+  }
+
+  auto begin = clock_type::now();
+  for (auto const& key : keys) {
+    index.Update(key);
+  }
+  std::cout << "indexing " << objects
+            << " objects: " << elapsed_us(begin) / 1000000 << " s" << std::endl;
+}
+
+/**
+ * Resolve the object as `meta_tree::GetData()` did before the `MetaIndex`,
+ * i.e., by json pointers, and copy the subtree on the way.
+ */
+Status GetDataByJson(const json& tree, const std::string& name,
+                     json& sub_tree) {
+  auto path = json::json_pointer("/data/" + name);
+  if (!tree.contains(path)) {
+    return Status::ObjectNotExists(name);
+  }
+  json object = tree[path];
+  for (auto const& item : object.items()) {
+    if (!item.value().is_string()) {
+      sub_tree[item.key()] = item.value();
+      continue;
+    }
+    std::string const& value = item.value().get_ref<std::string const&>();
+    if (value[0] != 'l') {
+      sub_tree[item.key()] = value.substr(1);
+      continue;
+    }
+    std::string member = value.substr(1, value.find('.') - 1);
+    if (member[0] == 's') {
+      auto signature =
+          json::json_pointer("/signatures/" + kInstanceName + "/" + member);
+      if (!tree.contains(signature)) {
+        continue;
+      }
+      member = tree[signature].get<std::string>();
+    }
+    json member_tree;
+    if (GetDataByJson(tree, member, member_tree).ok()) {
+      sub_tree[item.key()] = member_tree;
+    }
+  }
+  sub_tree["id"] = name;
+  return Status::OK();
+}
+
+size_t ListDataByJson(const json& tree, const std::string& pattern,
+                      size_t const limit) {
+  size_t found = 0;
+  for (auto const& item : tree["data"].items()) {
+    if (found >= limit) {
+      break;
+    }
+    std::string type =
+        item.value()["typename"].get_ref<std::string const&>().substr(1);
+    if (fnmatch(pattern.c_str(), type.c_str(), 0) == 0) {
+      json sub_tree;
+      VINEYARD_DISCARD(GetDataByJson(tree, item.key(), sub_tree));
+      found += 1;
+    }
+  }
+  return found;
+}
+
+void BenchLookups(const json& tree, const meta_tree::MetaIndex& index,
+                  size_t objects, size_t lookups) {
+  std::mt19937_64 engine(42);
+  std::uniform_int_distribution<ObjectID> distribution(1, objects);
+  std::vector<ObjectID> ids;
+  for (size_t i = 0; i < lookups; ++i) {
+    ids.emplace_back(distribution(engine));
+  }
+
+  auto begin = clock_type::now();
+  for (auto const& id : ids) {
+    json sub_tree;
+    VINEYARD_CHECK_OK(GetDataByJson(tree, ObjectIDToString(id), sub_tree));
+  }
+  std::cout << "get data (json tree): " << elapsed_us(begin) / lookups << " us"
+            << std::endl;
+
+  begin = clock_type::now();
+  for (auto const& id : ids) {
+    json sub_tree;
+    VINEYARD_CHECK_OK(meta_tree::GetData(index, kInstanceName, id, sub_tree));
+  }
+  std::cout << "get data (index): " << elapsed_us(begin) / lookups << " us"
+            << std::endl;
+
+  size_t found = 0;
+  begin = clock_type::now();
+  for (auto const& id : ids) {
+    found += tree.contains(json::json_pointer("/data/" + ObjectIDToString(id)));
+  }
+  std::cout << "exists (json tree): " << elapsed_us(begin) / lookups << " us"
+            << std::endl;
+
+  begin = clock_type::now();
+  for (auto const& id : ids) {
+    bool exists = false;
+    VINEYARD_CHECK_OK(meta_tree::Exists(index, id, exists));
+    found -= exists;
+  }
+  std::cout << "exists (index): " << elapsed_us(begin) / lookups << " us"
+            << std::endl;
+  CHECK_EQ(found, 0);
+}
+
+void BenchLists(const json& tree, const meta_tree::MetaIndex& index) {
+  const size_t limit = 1000;
+  for (auto const& pattern :
+       {"vineyard::Table<std::string>", "vineyard::Global*",
+        "vineyard::NotExists"}) {
+    auto begin = clock_type::now();
+    size_t found = ListDataByJson(tree, pattern, limit);
+    std::cout << "list '" << pattern << "' (json tree): " << elapsed_us(begin)
+              << " us" << std::endl;
+
+    begin = clock_type::now();
+    json tree_group;
+    VINEYARD_CHECK_OK(meta_tree::ListData(index, kInstanceName, pattern, false,
+                                          limit, tree_group));
+    std::cout << "list '" << pattern << "' (index): " << elapsed_us(begin)
+              << " us" << std::endl;
+    CHECK_EQ(found, tree_group.size());
+  }
+
+  auto begin = clock_type::now();
+  std::vector<ObjectID> objects;
+  for (auto const& item : tree["data"].items()) {
+    objects.emplace_back(ObjectIDFromString(item.key()));
+  }
+  std::cout << "list all (json tree): " << elapsed_us(begin) << " us"
+            << std::endl;
+
+  begin = clock_type::now();
+  objects.clear();
+  VINEYARD_CHECK_OK(meta_tree::ListAllData(index, objects));
+  std::cout << "list all (index): " << elapsed_us(begin) << " us" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  size_t objects = 1000000, lookups = 100000;
+  if (argc > 1) {
+    objects = std::strtoull(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    lookups = std::strtoull(argv[2], nullptr, 10);
+  }
+
+  json tree;
+  meta_tree::MetaIndex index(tree);
+  auto begin = clock_type::now();
+  BuildMetaTree(tree, index, objects);
+  std::cout << "building the meta tree of " << objects
+            << " objects: " << elapsed_us(begin) / 1000000 << " s" << std::endl;
+
+  BenchLookups(tree, index, objects, lookups);
+  BenchLists(tree, index);
+  return 0;
+}
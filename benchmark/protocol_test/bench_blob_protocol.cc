@@ -0,0 +1,124 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * Run create/seal/get/release loops on small blobs, where the cost is
+ * dominated by the IPC messages rather than the payload, and report the
+ * latency of each command and the throughput of the loop.
+ *
+ * The loops are run with the JSON messages first, then with the binary
+ * encoding of the blob commands over the socket, and finally with the binary
+ * encoding over the shared memory channel.
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+struct Latencies {
+  std::vector<double> create, seal, get, release;
+};
+
+double elapsed_us(clock_type::time_point const& begin) {
+  return std::chrono::duration<double, std::micro>(clock_type::now() - begin)
+      .count();
+}
+
+void report(std::string const& name, std::vector<double>& latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "  " << name << ": p50 = " << latencies[latencies.size() / 2]
+            << " us, p99 = " << latencies[latencies.size() * 99 / 100] << " us"
+            << std::endl;
+}
+
+void bench(std::string const& ipc_socket, std::string const& name, bool binary,
+           bool shm_channel, size_t count, size_t size) {
+  setenv("VINEYARD_IPC_BINARY_PROTOCOL", binary ? "1" : "0", 1);
+  setenv("VINEYARD_IPC_SHM_CHANNEL", shm_channel ? "1" : "0", 1);
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+
+  Latencies latencies;
+  std::vector<ObjectID> blobs;
+  auto start = clock_type::now();
+  for (size_t i = 0; i < count; ++i) {
+    auto begin = clock_type::now();
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(client.CreateBlob(size, writer));
+    latencies.create.push_back(elapsed_us(begin));
+    memset(writer->data(), static_cast<int>(i), size);
+
+    begin = clock_type::now();
+    ObjectID id = writer->Seal(client)->id();
+    latencies.seal.push_back(elapsed_us(begin));
+
+    begin = clock_type::now();
+    std::shared_ptr<Blob> blob;
+    VINEYARD_CHECK_OK(client.GetBlob(id, blob));
+    latencies.get.push_back(elapsed_us(begin));
+
+    begin = clock_type::now();
+    VINEYARD_CHECK_OK(client.Release(id));
+    latencies.release.push_back(elapsed_us(begin));
+    blobs.push_back(id);
+  }
+  double elapsed =
+      std::chrono::duration<double>(clock_type::now() - start).count();
+
+  std::cout << name << ": " << count / elapsed
+            << " loops/s" << std::endl;
+  report("create", latencies.create);
+  report("seal", latencies.seal);
+  report("get", latencies.get);
+  report("release", latencies.release);
+
+  VINEYARD_CHECK_OK(client.DelData(blobs, true, true));
+  client.Disconnect();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./bench_blob_protocol <ipc_socket> [<count>] [<size>]");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  size_t count = 100000, size = 64;
+  if (argc > 2) {
+    count = std::strtoull(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    size = std::strtoull(argv[3], nullptr, 10);
+  }
+
+  bench(ipc_socket, "json", false, false, count, size);
+  bench(ipc_socket, "binary", true, false, count, size);
+  bench(ipc_socket, "shm channel", true, true, count, size);
+  return 0;
+}
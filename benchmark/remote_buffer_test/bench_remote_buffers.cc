@@ -0,0 +1,94 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "client/ds/remote_blob.h"
+#include "client/rpc_client.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * Fetch many small blobs with `GetRemoteBlobs` over the RPC socket, where the
+ * cost is dominated by the number of blobs rather than the bytes, and report
+ * the throughput.
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf(
+        "usage ./bench_remote_buffers <ipc_socket> <rpc_endpoint> [<count>] "
+        "[<size>] [<rounds>]");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  std::string rpc_endpoint = std::string(argv[2]);
+  size_t count = 10000, size = 1024, rounds = 10;
+  if (argc > 3) {
+    count = std::strtoull(argv[3], nullptr, 10);
+  }
+  if (argc > 4) {
+    size = std::strtoull(argv[4], nullptr, 10);
+  }
+  if (argc > 5) {
+    rounds = std::strtoull(argv[5], nullptr, 10);
+  }
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  RPCClient rpc_client;
+  VINEYARD_CHECK_OK(rpc_client.Connect(rpc_endpoint));
+
+  std::vector<std::unique_ptr<BlobWriter>> writers;
+  VINEYARD_CHECK_OK(
+      client.CreateBlobs(std::vector<size_t>(count, size), writers));
+  std::vector<ObjectID> blobs;
+  for (size_t i = 0; i < count; ++i) {
+    memset(writers[i]->data(), static_cast<int>(i), size);
+    blobs.push_back(writers[i]->Seal(client)->id());
+  }
+
+  double elapsed = 0;
+  for (size_t round = 0; round < rounds; ++round) {
+    std::vector<std::shared_ptr<RemoteBlob>> remote_blobs;
+    auto begin = clock_type::now();
+    VINEYARD_CHECK_OK(rpc_client.GetRemoteBlobs(blobs, remote_blobs));
+    elapsed +=
+        std::chrono::duration<double>(clock_type::now() - begin).count();
+    CHECK_EQ(remote_blobs.size(), count);
+  }
+
+  double fetched = static_cast<double>(count) * rounds;
+  std::cout << "get remote blobs: " << fetched / elapsed << " blobs/s, "
+            << fetched * size / elapsed / 1024 / 1024 << " MiB/s" << std::endl;
+
+  VINEYARD_CHECK_OK(client.DelData(blobs, true, true));
+  rpc_client.Disconnect();
+  client.Disconnect();
+  return 0;
+}
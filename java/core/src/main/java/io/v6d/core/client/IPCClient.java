@@ -336,7 +336,12 @@ public class IPCClient extends Client {
         for (val payload : reply.getPayloads()) {
             val buffer = new Buffer();
             if (payload.getDataSize() > 0) {
-                long pointer = this.mmap(payload.getStoreFD(), payload.getMapSize(), true, true);
+                long pointer =
+                        this.mmap(
+                                payload.getStoreFD(),
+                                payload.getMapSize(),
+                                true,
+                                !payload.isDiskMapped());
                 buffer.setObjectId(payload.getObjectID());
                 buffer.setPointer(pointer + payload.getDataOffset());
                 buffer.setSize(payload.getDataSize());
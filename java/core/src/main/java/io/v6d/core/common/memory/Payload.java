@@ -31,6 +31,8 @@ public class Payload {
     @JsonProperty private long dataSize;
     @JsonProperty private long mapSize;
     @JsonProperty private long pointer; // uint8_t *
+    // the blob is mapped from a file on disk rather than the allocator's arena
+    @JsonProperty private boolean diskMapped;
 
     private Payload() {
         this.objectID = ObjectID.EmptyBlobID;
@@ -40,6 +42,7 @@ public class Payload {
         this.dataSize = 0;
         this.mapSize = 0;
         this.pointer = 0;
+        this.diskMapped = false;
     }
 
     public static Payload makeEmpty() {
@@ -87,6 +90,8 @@ public class Payload {
         payload.dataOffset = root.get("data_offset").longValue();
         payload.dataSize = root.get("data_size").longValue();
         payload.mapSize = root.get("map_size").longValue();
+        // see also `Payload::Kind::kDiskMMap`
+        payload.diskMapped = root.path("kind").asInt(0) == 2;
         return payload;
     }
 }
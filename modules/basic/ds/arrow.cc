@@ -114,6 +114,30 @@ std::shared_ptr<ObjectBuilder> BuildSimpleArray(
   return nullptr;
 }
 
+Status BuildBuffers(Client& client,
+                    std::vector<std::shared_ptr<arrow::Buffer>> const& buffers,
+                    std::vector<std::shared_ptr<ObjectBase>>& blobs) {
+  std::vector<size_t> sizes;
+  for (auto const& buffer : buffers) {
+    if (buffer != nullptr) {
+      sizes.emplace_back(buffer->size());
+    }
+  }
+  std::vector<std::unique_ptr<BlobWriter>> writers;
+  RETURN_ON_ERROR(client.CreateBlobs(sizes, writers));
+  size_t index = 0;
+  for (auto const& buffer : buffers) {
+    if (buffer == nullptr) {
+      blobs.emplace_back(Blob::MakeEmpty(client));
+      continue;
+    }
+    auto& writer = writers[index++];
+    memcpy(writer->data(), buffer->data(), buffer->size());
+    blobs.emplace_back(std::shared_ptr<BlobWriter>(std::move(writer)));
+  }
+  return Status::OK();
+}
+
 std::shared_ptr<ObjectBuilder> BuildArray(Client& client,
                                           std::shared_ptr<arrow::Array> array) {
   if (auto arr = std::dynamic_pointer_cast<arrow::ListArray>(array)) {
@@ -40,24 +40,26 @@ std::shared_ptr<ObjectBuilder> BuildSimpleArray(
 
 std::shared_ptr<ObjectBuilder> BuildArray(Client& client,
                                           std::shared_ptr<arrow::Array> array);
-}  // namespace detail
 
-#ifndef BUILD_NULL_BITMAP
-#define BUILD_NULL_BITMAP(builder, array)                                \
-  {                                                                      \
-    if (array->null_bitmap() && array->null_count() > 0) {               \
-      std::unique_ptr<BlobWriter> bitmap_buffer_writer;                  \
-      RETURN_ON_ERROR(client.CreateBlob(array->null_bitmap()->size(),    \
-                                        bitmap_buffer_writer));          \
-      memcpy(bitmap_buffer_writer->data(), array->null_bitmap()->data(), \
-             array->null_bitmap()->size());                              \
-      builder->set_null_bitmap_(                                         \
-          std::shared_ptr<BlobWriter>(std::move(bitmap_buffer_writer))); \
-    } else {                                                             \
-      builder->set_null_bitmap_(Blob::MakeEmpty(client));                \
-    }                                                                    \
+/**
+ * @brief Copy the arrow buffers to blobs, which are created with a single
+ * request. The nullptr buffers are built as empty blobs.
+ */
+Status BuildBuffers(Client& client,
+                    std::vector<std::shared_ptr<arrow::Buffer>> const& buffers,
+                    std::vector<std::shared_ptr<ObjectBase>>& blobs);
+
+/**
+ * @brief The null bitmap to build, nullptr if the array has no nulls.
+ */
+inline std::shared_ptr<arrow::Buffer> NullBitmap(
+    std::shared_ptr<arrow::Array> const& array) {
+  if (array->null_bitmap() && array->null_count() > 0) {
+    return array->null_bitmap();
   }
-#endif
+  return nullptr;
+}
+}  // namespace detail
 
 /**
  * @brief NumericArrayBuilder is designed for building Arrow numeric arrays
@@ -81,16 +83,15 @@ class NumericArrayBuilder : public NumericArrayBaseBuilder<T> {
   std::shared_ptr<ArrayType> GetArray() { return array_; }
 
   Status Build(Client& client) override {
-    std::unique_ptr<BlobWriter> buffer_writer;
-    RETURN_ON_ERROR(client.CreateBlob(array_->values()->size(), buffer_writer));
-    memcpy(buffer_writer->data(), array_->values()->data(),
-           array_->values()->size());
+    std::vector<std::shared_ptr<ObjectBase>> blobs;
+    RETURN_ON_ERROR(detail::BuildBuffers(
+        client, {array_->values(), detail::NullBitmap(array_)}, blobs));
 
     this->set_length_(array_->length());
     this->set_null_count_(array_->null_count());
     this->set_offset_(array_->offset());
-    this->set_buffer_(std::shared_ptr<BlobWriter>(std::move(buffer_writer)));
-    BUILD_NULL_BITMAP(this, array_);
+    this->set_buffer_(blobs[0]);
+    this->set_null_bitmap_(blobs[1]);
     return Status::OK();
   }
 
@@ -131,16 +132,15 @@ class BooleanArrayBuilder : public BooleanArrayBaseBuilder {
   std::shared_ptr<ArrayType> GetArray() { return array_; }
 
   Status Build(Client& client) override {
-    std::unique_ptr<BlobWriter> buffer_writer;
-    RETURN_ON_ERROR(client.CreateBlob(array_->values()->size(), buffer_writer));
-    memcpy(buffer_writer->data(), array_->values()->data(),
-           array_->values()->size());
+    std::vector<std::shared_ptr<ObjectBase>> blobs;
+    RETURN_ON_ERROR(detail::BuildBuffers(
+        client, {array_->values(), detail::NullBitmap(array_)}, blobs));
 
     this->set_length_(array_->length());
     this->set_null_count_(array_->null_count());
     this->set_offset_(array_->offset());
-    this->set_buffer_(std::shared_ptr<BlobWriter>(std::move(buffer_writer)));
-    BUILD_NULL_BITMAP(this, array_);
+    this->set_buffer_(blobs[0]);
+    this->set_null_bitmap_(blobs[1]);
     return Status::OK();
   }
 
@@ -167,30 +167,19 @@ class BaseBinaryArrayBuilder : public BaseBinaryArrayBaseBuilder<ArrayType> {
   std::shared_ptr<ArrayType> GetArray() { return array_; }
 
   Status Build(Client& client) override {
-    {
-      std::unique_ptr<BlobWriter> buffer_writer;
-      RETURN_ON_ERROR(
-          client.CreateBlob(array_->value_offsets()->size(), buffer_writer));
-      memcpy(buffer_writer->data(), array_->value_offsets()->data(),
-             array_->value_offsets()->size());
-
-      this->set_buffer_offsets_(
-          std::shared_ptr<BlobWriter>(std::move(buffer_writer)));
-    }
-    {
-      std::unique_ptr<BlobWriter> buffer_writer;
-      RETURN_ON_ERROR(
-          client.CreateBlob(array_->value_data()->size(), buffer_writer));
-      memcpy(buffer_writer->data(), array_->value_data()->data(),
-             array_->value_data()->size());
-
-      this->set_buffer_data_(
-          std::shared_ptr<BlobWriter>(std::move(buffer_writer)));
-    }
+    std::vector<std::shared_ptr<ObjectBase>> blobs;
+    RETURN_ON_ERROR(detail::BuildBuffers(client,
+                                         {array_->value_offsets(),
+                                          array_->value_data(),
+                                          detail::NullBitmap(array_)},
+                                         blobs));
+
+    this->set_buffer_offsets_(blobs[0]);
+    this->set_buffer_data_(blobs[1]);
     this->set_length_(array_->length());
     this->set_null_count_(array_->null_count());
     this->set_offset_(array_->offset());
-    BUILD_NULL_BITMAP(this, array_);
+    this->set_null_bitmap_(blobs[2]);
     return Status::OK();
   }
 
@@ -230,17 +219,16 @@ class FixedSizeBinaryArrayBuilder : public FixedSizeBinaryArrayBaseBuilder {
     VINEYARD_ASSERT(array_->length() == 0 || array_->values()->size() != 0,
                     "Invalid array values");
 
-    std::unique_ptr<BlobWriter> buffer_writer;
-    RETURN_ON_ERROR(client.CreateBlob(array_->values()->size(), buffer_writer));
-    memcpy(buffer_writer->data(), array_->values()->data(),
-           array_->values()->size());
+    std::vector<std::shared_ptr<ObjectBase>> blobs;
+    RETURN_ON_ERROR(detail::BuildBuffers(
+        client, {array_->values(), detail::NullBitmap(array_)}, blobs));
 
     this->set_byte_width_(array_->byte_width());
     this->set_length_(array_->length());
     this->set_null_count_(array_->null_count());
     this->set_offset_(array_->offset());
-    this->set_buffer_(std::shared_ptr<BlobWriter>(std::move(buffer_writer)));
-    BUILD_NULL_BITMAP(this, array_);
+    this->set_buffer_(blobs[0]);
+    this->set_null_bitmap_(blobs[1]);
     return Status::OK();
   }
 
@@ -287,14 +275,12 @@ class BaseListArrayBuilder : public BaseListArrayBaseBuilder<ArrayType> {
 
   Status Build(Client& client) override {
     {
-      std::unique_ptr<BlobWriter> buffer_writer;
-      RETURN_ON_ERROR(
-          client.CreateBlob(array_->value_offsets()->size(), buffer_writer));
-      memcpy(buffer_writer->data(), array_->value_offsets()->data(),
-             array_->value_offsets()->size());
-
-      this->set_buffer_offsets_(
-          std::shared_ptr<BlobWriter>(std::move(buffer_writer)));
+      std::vector<std::shared_ptr<ObjectBase>> blobs;
+      RETURN_ON_ERROR(detail::BuildBuffers(
+          client, {array_->value_offsets(), detail::NullBitmap(array_)},
+          blobs));
+      this->set_buffer_offsets_(blobs[0]);
+      this->set_null_bitmap_(blobs[1]);
     }
     {
       // Assuming the list is not nested.
@@ -305,7 +291,6 @@ class BaseListArrayBuilder : public BaseListArrayBaseBuilder<ArrayType> {
     this->set_length_(array_->length());
     this->set_null_count_(array_->null_count());
     this->set_offset_(array_->offset());
-    BUILD_NULL_BITMAP(this, array_);
     return Status::OK();
   }
 
@@ -345,8 +330,6 @@ class FixedSizeListArrayBuilder : public FixedSizeListArrayBaseBuilder {
   std::shared_ptr<arrow::FixedSizeListArray> array_;
 };
 
-#undef BUILD_NULL_BITMAP
-
 /**
  * @brief SchemaProxyBuilder is used for initiating proxies for the schemas
  *
@@ -382,6 +382,23 @@ void bind_client(py::module& mod) {
              throw_on_error(self->Debug(detail::to_json(debug), result));
              return detail::from_json(result);
            })
+      .def(
+          "enable_meta_cache",
+          [](ClientBase* self, const size_t capacity) {
+            throw_on_error(self->EnableMetaCache(capacity));
+          },
+          "capacity"_a)
+      .def("disable_meta_cache", &ClientBase::DisableMetaCache)
+      .def_property_readonly(
+          "meta_cache_stats",
+          [](ClientBase* self) -> std::map<std::string, size_t> {
+            auto stats = self->GetMetaCacheStats();
+            return {{"capacity", stats.capacity},
+                    {"size", stats.size},
+                    {"hits", stats.hits},
+                    {"misses", stats.misses},
+                    {"invalidations", stats.invalidations}};
+          })
       .def_property_readonly("ipc_socket", &ClientBase::IPCSocket)
       .def_property_readonly("rpc_endpoint", &ClientBase::RPCEndpoint)
       .def_property_readonly("version", &ClientBase::Version);
@@ -637,6 +654,16 @@ void bind_client(py::module& mod) {
             return remote_blob;
           },
           "object_id"_a, py::arg("unsafe") = false)
+      .def(
+          "get_remote_blob_range",
+          [](RPCClient* self, const ObjectIDWrapper object_id,
+             const size_t offset, const size_t length, const bool unsafe) {
+            std::shared_ptr<RemoteBlob> remote_blob;
+            throw_on_error(self->GetRemoteBlobRange(object_id, offset, length,
+                                                    unsafe, remote_blob));
+            return remote_blob;
+          },
+          "object_id"_a, "offset"_a, "length"_a, py::arg("unsafe") = false)
       .def(
           "get_remote_blobs",
           [](RPCClient* self, std::vector<ObjectIDWrapper> object_ids,
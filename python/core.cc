@@ -541,6 +541,8 @@ void bind_blobs(py::module& mod) {
           [](RemoteBlob* self) -> InstanceID { return self->instance_id(); })
       .def_property_readonly("size", &RemoteBlob::size)
       .def_property_readonly("allocated_size", &RemoteBlob::allocated_size)
+      .def_property_readonly("offset", &RemoteBlob::offset)
+      .def_property_readonly("blob_size", &RemoteBlob::blob_size)
       .def_property_readonly(
           "is_empty",
           [](RemoteBlob* self) { return self->allocated_size() == 0; })
@@ -16,16 +16,26 @@ limitations under the License.
 #include "client/client.h"
 
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <future>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <mutex>
 #include <set>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -35,12 +45,23 @@ limitations under the License.
 #include "client/rpc_client.h"
 #include "client/utils.h"
 #include "common/memory/fling.h"
+#include "common/util/env.h"
 #include "common/util/protocols.h"
 #include "common/util/status.h"
 #include "common/util/uuid.h"
 
 namespace vineyard {
 
+namespace {
+
+std::future<Status> ready_future(Status const& status) {
+  std::promise<Status> promise;
+  promise.set_value(status);
+  return promise.get_future();
+}
+
+}  // namespace
+
 BasicIPCClient::BasicIPCClient() : shm_(new detail::SharedMemoryManager(-1)) {}
 
 Status BasicIPCClient::Connect(const std::string& ipc_socket,
@@ -53,16 +74,29 @@ Status BasicIPCClient::Connect(const std::string& ipc_socket,
   ipc_socket_ = ipc_socket;
   RETURN_ON_ERROR(connect_ipc_socket_retry(ipc_socket, vineyard_conn_));
   std::string message_out;
-  WriteRegisterRequest(message_out, store_type);
+  std::string binary_protocol_env = read_env("VINEYARD_IPC_BINARY_PROTOCOL");
+  bool binary_protocol = store_type == StoreType::kDefault &&
+                         binary_protocol_env != "0" &&
+                         binary_protocol_env != "false";
+  std::string shm_channel_env = read_env("VINEYARD_IPC_SHM_CHANNEL");
+  bool shm_channel = binary_protocol && shm_channel_env != "0" &&
+                     shm_channel_env != "false";
+  WriteRegisterRequest(message_out, store_type, get_numa_node(),
+                       binary_protocol, shm_channel);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
-  std::string ipc_socket_value, rpc_endpoint_value;
+  std::string ipc_socket_value, rpc_endpoint_value, compression;
   bool store_match;
-  RETURN_ON_ERROR(ReadRegisterReply(message_in, ipc_socket_value,
-                                    rpc_endpoint_value, instance_id_,
-                                    session_id_, server_version_, store_match));
+  RETURN_ON_ERROR(ReadRegisterReply(
+      message_in, ipc_socket_value, rpc_endpoint_value, instance_id_,
+      session_id_, server_version_, store_match, binary_protocol_,
+      shm_channel, compression));
   rpc_endpoint_ = rpc_endpoint_value;
+  channel_.reset();
+  if (shm_channel) {
+    RETURN_ON_ERROR(openChannel());
+  }
   connected_ = true;
 
   if (!compatible_server(server_version_)) {
@@ -104,6 +138,51 @@ Status BasicIPCClient::Open(std::string const& ipc_socket,
   return Status::OK();
 }
 
+Status BasicIPCClient::openConnection(int& conn) {
+  return connect_ipc_socket_retry(ipc_socket_, conn);
+}
+
+Status BasicIPCClient::openChannel() {
+  // the shared memory segment and the eventfds follow the register reply
+  int fds[3] = {-1, -1, -1};
+  for (int& fd : fds) {
+    fd = recv_fd(vineyard_conn_);
+    if (fd < 0) {
+      for (int received : fds) {
+        if (received >= 0) {
+          close(received);
+        }
+      }
+      return Status::IOError(
+          "Failed to receive the shared memory channel from the socket");
+    }
+  }
+  auto status = ShmChannel::Open(fds[0], fds[1], fds[2], channel_);
+  if (!status.ok()) {
+    std::clog << "[warn] Failed to open the shared memory channel, falling "
+                 "back to the socket: "
+              << status.ToString() << std::endl;
+  }
+  return Status::OK();
+}
+
+Status BasicIPCClient::doBinaryRequest(const std::string& message_out,
+                                       std::string& message_in) {
+  if (channel_ == nullptr ||
+      message_out.size() > ShmChannel::kMaxRequestSize) {
+    RETURN_ON_ERROR(doWrite(message_out));
+    return doRead(message_in);
+  }
+  auto status = channel_->SendRequest(message_out);
+  if (status.ok()) {
+    status = channel_->ReceiveReply(vineyard_conn_, message_in);
+  }
+  if (!status.ok()) {
+    connected_ = false;
+  }
+  return status;
+}
+
 Client::~Client() { Disconnect(); }
 
 Status Client::Connect() {
@@ -116,17 +195,24 @@ Status Client::Connect() {
 }
 
 void Client::Disconnect() {
+  stopReleaseFlusher();
+  stopReader();
   std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  // the server releases the blobs held by the connection on disconnecting
+  deferred_releases_.clear();
   this->ClearCache();
   ClientBase::Disconnect();
+  channel_.reset();
 }
 
 Status Client::Connect(const std::string& ipc_socket) {
-  return BasicIPCClient::Connect(ipc_socket, StoreType::kDefault);
+  RETURN_ON_ERROR(BasicIPCClient::Connect(ipc_socket, StoreType::kDefault));
+  return deferReleaseFromEnv();
 }
 
 Status Client::Open(std::string const& ipc_socket) {
-  return BasicIPCClient::Open(ipc_socket, StoreType::kDefault);
+  RETURN_ON_ERROR(BasicIPCClient::Open(ipc_socket, StoreType::kDefault));
+  return deferReleaseFromEnv();
 }
 
 Status Client::Fork(Client& client) {
@@ -200,17 +286,96 @@ Status Client::GetMetaData(const std::vector<ObjectID>& ids,
   return Status::OK();
 }
 
+std::future<Status> Client::GetMetaDataAsync(const ObjectID id,
+                                             ObjectMeta& meta,
+                                             const bool sync_remote) {
+  std::string message_out;
+  WriteGetDataRequest(id, sync_remote, false, message_out);
+  std::future<Status> done;
+  auto status = requestAsync(
+      message_out,
+      [this, &meta](json const& reply) -> Status {
+        json tree;
+        RETURN_ON_ERROR(ReadGetDataReply(reply, tree));
+        ENSURE_CONNECTED(this);
+        meta.Reset();
+        meta.SetMetaData(this, tree);
+
+        std::map<ObjectID, std::shared_ptr<arrow::Buffer>> buffers;
+        RETURN_ON_ERROR(
+            GetBuffers(meta.GetBufferSet()->AllBufferIds(), buffers));
+        for (auto const& id : meta.GetBufferSet()->AllBufferIds()) {
+          const auto& buffer = buffers.find(id);
+          if (buffer != buffers.end()) {
+            meta.SetBuffer(id, buffer->second);
+          }
+        }
+        return Status::OK();
+      },
+      done);
+  if (!status.ok()) {
+    return ready_future(status);
+  }
+  return done;
+}
+
 Status Client::CreateBlob(size_t size, std::unique_ptr<BlobWriter>& blob) {
+  return this->CreateBlob(size, -1, blob);
+}
+
+Status Client::CreateBlob(size_t size, int numa_node,
+                          std::unique_ptr<BlobWriter>& blob) {
   ENSURE_CONNECTED(this);
 
   ObjectID object_id = InvalidObjectID();
   Payload object;
   std::shared_ptr<arrow::MutableBuffer> buffer = nullptr;
-  RETURN_ON_ERROR(CreateBuffer(size, object_id, object, buffer));
+  RETURN_ON_ERROR(CreateBuffer(size, object_id, object, buffer, numa_node));
   blob.reset(new BlobWriter(object_id, object, buffer));
   return Status::OK();
 }
 
+std::future<Status> Client::CreateBlobAsync(size_t size,
+                                            std::unique_ptr<BlobWriter>& blob) {
+  struct Created {
+    ObjectID object_id = InvalidObjectID();
+    Payload object;
+    std::shared_ptr<arrow::MutableBuffer> buffer = nullptr;
+  };
+  auto created = std::make_shared<Created>();
+  std::string message_out;
+  WriteCreateBufferRequest(size, message_out);
+  std::future<Status> done;
+  auto status = requestAsync(
+      message_out,
+      [this, size, created, &blob](json const& reply) -> Status {
+        RETURN_ON_ERROR(onBufferCreated(size, reply, created->object_id,
+                                        created->object, created->buffer));
+        blob.reset(new BlobWriter(created->object_id, created->object,
+                                  created->buffer));
+        return Status::OK();
+      },
+      done);
+  if (!status.ok()) {
+    return ready_future(status);
+  }
+  return done;
+}
+
+Status Client::CreateBlobs(const std::vector<size_t>& sizes,
+                           std::vector<std::unique_ptr<BlobWriter>>& blobs) {
+  ENSURE_CONNECTED(this);
+
+  std::vector<ObjectID> object_ids;
+  std::vector<Payload> objects;
+  std::vector<std::shared_ptr<arrow::MutableBuffer>> buffers;
+  RETURN_ON_ERROR(CreateBuffers(sizes, object_ids, objects, buffers));
+  for (size_t i = 0; i < object_ids.size(); ++i) {
+    blobs.emplace_back(new BlobWriter(object_ids[i], objects[i], buffers[i]));
+  }
+  return Status::OK();
+}
+
 Status Client::GetBlob(ObjectID const id, std::shared_ptr<Blob>& blob) {
   return this->GetBlob(id, false, blob);
 }
@@ -237,6 +402,58 @@ Status Client::GetBlobs(std::vector<ObjectID> const ids, const bool unsafe,
   std::set<ObjectID> id_set(ids.begin(), ids.end());
   std::map<ObjectID, std::shared_ptr<arrow::Buffer>> buffers;
   RETURN_ON_ERROR(this->GetBuffers(id_set, unsafe, buffers));
+  makeBlobs(ids, buffers, blobs);
+  return Status::OK();
+}
+
+std::future<Status> Client::GetBlobsAsync(
+    std::vector<ObjectID> const ids,
+    std::vector<std::shared_ptr<Blob>>& blobs) {
+  std::set<ObjectID> id_set(ids.begin(), ids.end());
+  std::string message_out;
+  WriteGetBuffersRequest(id_set, false, message_out);
+  std::future<Status> done;
+  auto status = flushPendingSeals();
+  if (status.ok()) {
+    status = requestAsync(
+        message_out,
+        [this, ids, &blobs](json const& reply) -> Status {
+          std::vector<Payload> payloads;
+          std::vector<int> fd_sent, fd_recv;
+          std::set<int> fd_recv_dedup;
+          RETURN_ON_ERROR(ReadGetBuffersReply(reply, payloads, fd_sent));
+          ENSURE_CONNECTED(this);
+          for (auto const& item : payloads) {
+            if (item.data_size > 0) {
+              shm_->PreMmap(item.store_fd, fd_recv, fd_recv_dedup);
+            }
+          }
+          if (reply.contains("fds") && !fdsMatched(fd_sent, fd_recv)) {
+            json error = json::object();
+            error["error"] =
+                "GetBlobs: the fd set is not matched between client and server";
+            error["fd_sent"] = fd_sent;
+            error["fd_recv"] = fd_recv;
+            error["response"] = reply;
+            return Status::UnknownError(error.dump());
+          }
+          std::map<ObjectID, std::shared_ptr<arrow::Buffer>> buffers;
+          RETURN_ON_ERROR(mmapBuffers(payloads, buffers));
+          makeBlobs(ids, buffers, blobs);
+          return Status::OK();
+        },
+        done);
+  }
+  if (!status.ok()) {
+    return ready_future(status);
+  }
+  return done;
+}
+
+void Client::makeBlobs(
+    std::vector<ObjectID> const& ids,
+    std::map<ObjectID, std::shared_ptr<arrow::Buffer>> const& buffers,
+    std::vector<std::shared_ptr<Blob>>& blobs) {
   // clear the result container
   blobs.clear();
   for (auto const& id : ids) {
@@ -255,7 +472,6 @@ Status Client::GetBlobs(std::vector<ObjectID> const ids, const bool unsafe,
       blobs.emplace_back(nullptr /* shouldn't happen */);
     }
   }
-  return Status::OK();
 }
 
 Status Client::CreateDiskBlob(size_t size, const std::string& path,
@@ -277,7 +493,7 @@ Status Client::CreateDiskBlob(size_t size, const std::string& path,
   uint8_t *shared = nullptr, *dist = nullptr;
   if (payload.data_size > 0) {
     fd_recv = shm_->PreMmap(payload.store_fd);
-    if (message_in.contains("fd") && fd_recv != fd_sent) {
+    if (message_in.contains("fd") && !fdsMatched(fd_sent, fd_recv)) {
       json error = json::object();
       error["error"] =
           "CreateDiskBuffer: the fd is not matched between client and server";
@@ -295,7 +511,7 @@ Status Client::CreateDiskBlob(size_t size, const std::string& path,
   }
   auto buffer = std::make_shared<arrow::MutableBuffer>(dist, payload.data_size);
   blob.reset(new BlobWriter(object_id, payload, buffer));
-  RETURN_ON_ERROR(AddUsage(object_id, payload));
+  RETURN_ON_ERROR(addUsage(object_id, payload));
   return Status::OK();
 }
 
@@ -315,7 +531,7 @@ Status Client::GetNextStreamChunk(ObjectID const id, size_t const size,
   uint8_t *mmapped_ptr = nullptr, *dist = nullptr;
   if (object.data_size > 0) {
     fd_recv = shm_->PreMmap(object.store_fd);
-    if (message_in.contains("fd") && fd_recv != fd_sent) {
+    if (message_in.contains("fd") && !fdsMatched(fd_sent, fd_recv)) {
       json error = json::object();
       error["error"] =
           "GetNextStreamChunk: the fd is not matched between client and server";
@@ -497,12 +713,24 @@ std::vector<std::shared_ptr<Object>> Client::ListObjects(
 Status Client::migrateBuffers(RPCClient& remote, const std::set<ObjectID> blobs,
                               std::map<ObjectID, ObjectID>& results) {
   ENSURE_CONNECTED(this);
+  size_t streams =
+      std::strtoull(read_env("VINEYARD_MIGRATION_STREAMS", "1").c_str(),
+                    nullptr, 10);
+  if (streams > 1) {
+    size_t chunk_size = std::strtoull(
+        read_env("VINEYARD_MIGRATION_CHUNK_SIZE", "").c_str(), nullptr, 10);
+    if (chunk_size == 0) {
+      chunk_size = 64 * 1024 * 1024;
+    }
+    return migrateBuffersStriped(remote, blobs, streams, chunk_size, results);
+  }
 
   std::vector<Payload> payloads;
   std::vector<int> fd_sent;
 
   std::string message_out;
-  WriteGetRemoteBuffersRequest(blobs, false, message_out);
+  WriteGetRemoteBuffersRequest(blobs, false, remote.compression(),
+                               message_out);
   RETURN_ON_ERROR(remote.doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(remote.doRead(message_in));
@@ -512,18 +740,157 @@ Status Client::migrateBuffers(RPCClient& remote, const std::set<ObjectID> blobs,
                        std::to_string(payloads.size()) + " vs. " +
                        std::to_string(blobs.size()));
 
+  // create the local blobs with a single request, then receive the content,
+  // which the remote server sends back to back, into them directly
+  std::vector<size_t> sizes;
   for (auto const& payload : payloads) {
     if (payload.data_size == 0) {
       results[payload.object_id] = EmptyBlobID();
-      continue;
+    } else {
+      sizes.emplace_back(payload.data_size);
     }
-    std::unique_ptr<BlobWriter> blob_writer;
-    RETURN_ON_ERROR(this->CreateBlob(payload.data_size, blob_writer));
-    RETURN_ON_ERROR(recv_bytes(remote.vineyard_conn_, blob_writer->data(),
-                               payload.data_size));
-    results[payload.object_id] = blob_writer->Seal(*this)->id();
   }
-  return Status::OK();
+  if (sizes.empty()) {
+    return Status::OK();
+  }
+  std::vector<std::unique_ptr<BlobWriter>> blob_writers;
+  RETURN_ON_ERROR(this->CreateBlobs(sizes, blob_writers));
+  std::vector<std::pair<void*, size_t>> buffers;
+  for (auto const& blob_writer : blob_writers) {
+    buffers.emplace_back(blob_writer->data(), blob_writer->size());
+  }
+  auto status = remote.recvBuffers(buffers);
+  if (!status.ok()) {
+    for (auto const& blob_writer : blob_writers) {
+      VINEYARD_DISCARD(blob_writer->Abort(*this));
+    }
+    return status;
+  }
+
+  BatchGuard batch(*this);
+  size_t index = 0;
+  for (auto const& payload : payloads) {
+    if (payload.data_size > 0) {
+      results[payload.object_id] = blob_writers[index++]->Seal(*this)->id();
+    }
+  }
+  return batch.End();
+}
+
+Status Client::migrateBuffersStriped(RPCClient& remote,
+                                     const std::set<ObjectID>& blobs,
+                                     const size_t streams,
+                                     const size_t chunk_size,
+                                     std::map<ObjectID, ObjectID>& results) {
+  // the retries of a stripe, each on a new connection
+  constexpr int kMaxRetries = 3;
+  // bounds the size of the request of a stripe that packs small blobs
+  constexpr size_t kMaxChunksPerStripe = 4096;
+
+  ENSURE_CONNECTED(this);
+  std::vector<ObjectID> ids(blobs.begin(), blobs.end());
+  std::vector<Payload> payloads;
+  RETURN_ON_ERROR(remote.getBufferChunks(ids, {}, {}, false, payloads));
+  RETURN_ON_ASSERT(payloads.size() == blobs.size(),
+                   "The result size doesn't match with the requested sizes: " +
+                       std::to_string(payloads.size()) + " vs. " +
+                       std::to_string(blobs.size()));
+
+  std::vector<ObjectID> sources;
+  std::vector<size_t> sizes;
+  for (auto const& payload : payloads) {
+    if (payload.data_size == 0) {
+      results[payload.object_id] = EmptyBlobID();
+    } else {
+      sources.emplace_back(payload.object_id);
+      sizes.emplace_back(payload.data_size);
+    }
+  }
+  if (sizes.empty()) {
+    return Status::OK();
+  }
+  std::vector<std::unique_ptr<BlobWriter>> blob_writers;
+  RETURN_ON_ERROR(this->CreateBlobs(sizes, blob_writers));
+
+  struct Stripe {
+    std::vector<BufferChunk> chunks;
+    std::vector<void*> targets;
+  };
+  std::vector<Stripe> stripes(1);
+  size_t stripe_size = 0;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    size_t offset = 0;
+    while (offset < sizes[i]) {
+      if (stripe_size >= chunk_size ||
+          stripes.back().chunks.size() >= kMaxChunksPerStripe) {
+        stripes.emplace_back();
+        stripe_size = 0;
+      }
+      size_t length = std::min(sizes[i] - offset, chunk_size - stripe_size);
+      stripes.back().chunks.emplace_back(
+          BufferChunk{sources[i], offset, length});
+      stripes.back().targets.emplace_back(blob_writers[i]->data() + offset);
+      stripe_size += length;
+      offset += length;
+    }
+  }
+
+  // the workers take stripes in order, each on its own connection
+  std::string const endpoint = remote.rpc_endpoint_;
+  std::atomic<size_t> next_stripe(0);
+  std::atomic<bool> failed(false);
+  std::vector<Status> statuses(std::min(streams, stripes.size()));
+  std::vector<std::thread> workers;
+  for (size_t worker = 0; worker < statuses.size(); ++worker) {
+    workers.emplace_back([&, worker]() {
+      std::unique_ptr<RPCClient> rpc_client;
+      while (!failed.load()) {
+        size_t index = next_stripe.fetch_add(1);
+        if (index >= stripes.size()) {
+          return;
+        }
+        Status status;
+        for (int attempt = 0; attempt <= kMaxRetries; ++attempt) {
+          if (rpc_client == nullptr) {
+            rpc_client.reset(new RPCClient());
+            status = rpc_client->Connect(endpoint);
+          }
+          if (status.ok()) {
+            std::vector<Payload> unused;
+            status = rpc_client->getBufferChunks({}, stripes[index].chunks,
+                                                 stripes[index].targets,
+                                                 false, unused);
+          }
+          if (status.ok()) {
+            break;
+          }
+          // the connection may stop in the middle of a reply
+          rpc_client.reset();
+        }
+        if (!status.ok()) {
+          statuses[worker] = status;
+          failed.store(true);
+        }
+      }
+    });
+  }
+  Status status;
+  for (size_t worker = 0; worker < workers.size(); ++worker) {
+    workers[worker].join();
+    status += statuses[worker];
+  }
+  if (!status.ok()) {
+    for (auto const& blob_writer : blob_writers) {
+      VINEYARD_DISCARD(blob_writer->Abort(*this));
+    }
+    return status;
+  }
+
+  BatchGuard batch(*this);
+  for (size_t i = 0; i < sources.size(); ++i) {
+    results[sources[i]] = blob_writers[i]->Seal(*this)->id();
+  }
+  return batch.End();
 }
 
 bool Client::IsSharedMemory(const void* target) const {
@@ -591,21 +958,69 @@ Status Client::ReleaseArena(const int fd, std::vector<size_t> const& offsets,
 }
 
 Status Client::CreateBuffer(const size_t size, ObjectID& id, Payload& payload,
-                            std::shared_ptr<arrow::MutableBuffer>& buffer) {
+                            std::shared_ptr<arrow::MutableBuffer>& buffer,
+                            const int numa_node) {
   ENSURE_CONNECTED(this);
   std::string message_out;
-  WriteCreateBufferRequest(size, message_out);
-  RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   int fd_sent = -1, fd_recv = -1;
-  RETURN_ON_ERROR(doRead(message_in));
-  RETURN_ON_ERROR(ReadCreateBufferReply(message_in, id, payload, fd_sent));
-  RETURN_ON_ASSERT(static_cast<size_t>(payload.data_size) == size);
+  bool check_fd = true;
+  if (binary_protocol_) {
+    WriteCreateBufferRequestBinary(size, numa_node, message_out);
+    std::string binary_message_in;
+    RETURN_ON_ERROR(doBinaryRequest(message_out, binary_message_in));
+    RETURN_ON_ERROR(
+        ReadCreateBufferReplyBinary(binary_message_in, id, payload, fd_sent));
+  } else {
+    WriteCreateBufferRequest(size, message_out, numa_node);
+    RETURN_ON_ERROR(doWrite(message_out));
+    RETURN_ON_ERROR(doRead(message_in));
+    RETURN_ON_ERROR(ReadCreateBufferReply(message_in, id, payload, fd_sent));
+    check_fd = message_in.contains("fd");
+  }
 
-  uint8_t *shared = nullptr, *dist = nullptr;
   if (payload.data_size > 0) {
     fd_recv = shm_->PreMmap(payload.store_fd);
-    if (message_in.contains("fd") && fd_recv != fd_sent) {
+    if (check_fd && !fdsMatched(fd_sent, fd_recv)) {
+      json error = json::object();
+      error["error"] =
+          "CreateBuffer: the fd is not matched between client and server";
+      error["fd_sent"] = fd_sent;
+      error["fd_recv"] = fd_recv;
+      error["response"] = message_in;
+      return Status::Invalid(error.dump());
+    }
+  }
+  return mmapCreatedBuffer(size, id, payload, buffer);
+}
+
+std::future<Status> Client::CreateBufferAsync(
+    const size_t size, ObjectID& id, Payload& payload,
+    std::shared_ptr<arrow::MutableBuffer>& buffer, const int numa_node) {
+  std::string message_out;
+  WriteCreateBufferRequest(size, message_out, numa_node);
+  std::future<Status> done;
+  auto status = requestAsync(
+      message_out,
+      [this, size, &id, &payload, &buffer](json const& reply) -> Status {
+        return onBufferCreated(size, reply, id, payload, buffer);
+      },
+      done);
+  if (!status.ok()) {
+    return ready_future(status);
+  }
+  return done;
+}
+
+Status Client::onBufferCreated(const size_t size, json const& message_in,
+                               ObjectID& id, Payload& payload,
+                               std::shared_ptr<arrow::MutableBuffer>& buffer) {
+  int fd_sent = -1, fd_recv = -1;
+  RETURN_ON_ERROR(ReadCreateBufferReply(message_in, id, payload, fd_sent));
+  ENSURE_CONNECTED(this);
+  if (payload.data_size > 0) {
+    fd_recv = shm_->PreMmap(payload.store_fd);
+    if (message_in.contains("fd") && !fdsMatched(fd_sent, fd_recv)) {
       json error = json::object();
       error["error"] =
           "CreateBuffer: the fd is not matched between client and server";
@@ -614,16 +1029,27 @@ Status Client::CreateBuffer(const size_t size, ObjectID& id, Payload& payload,
       error["response"] = message_in;
       return Status::Invalid(error.dump());
     }
+  }
+  return mmapCreatedBuffer(size, id, payload, buffer);
+}
 
+Status Client::mmapCreatedBuffer(
+    const size_t size, ObjectID const id, Payload const& payload,
+    std::shared_ptr<arrow::MutableBuffer>& buffer) {
+  RETURN_ON_ASSERT(static_cast<size_t>(payload.data_size) == size);
+
+  uint8_t *shared = nullptr, *dist = nullptr;
+  if (payload.data_size > 0) {
     RETURN_ON_ERROR(shm_->Mmap(
         payload.store_fd, payload.object_id, payload.map_size,
         payload.data_size, payload.data_offset,
-        payload.pointer - payload.data_offset, false, true, &shared));
+        payload.pointer - payload.data_offset, false,
+        payload.RequiresRealign(), &shared));
     dist = shared + payload.data_offset;
   }
   buffer = std::make_shared<arrow::MutableBuffer>(dist, payload.data_size);
 
-  RETURN_ON_ERROR(AddUsage(id, payload));
+  RETURN_ON_ERROR(addUsage(id, payload));
   return Status::OK();
 }
 
@@ -678,6 +1104,59 @@ Status Client::GetBuffer(const ObjectID id,
   return Status::OK();
 }
 
+Status Client::CreateBuffers(
+    const std::vector<size_t>& sizes, std::vector<ObjectID>& ids,
+    std::vector<Payload>& payloads,
+    std::vector<std::shared_ptr<arrow::MutableBuffer>>& buffers,
+    const int numa_node) {
+  if (sizes.empty()) {
+    return Status::OK();
+  }
+  ENSURE_CONNECTED(this);
+  std::string message_out;
+  WriteCreateBuffersRequest(sizes, message_out, numa_node);
+  RETURN_ON_ERROR(doWrite(message_out));
+  json message_in;
+  RETURN_ON_ERROR(doRead(message_in));
+  std::vector<int> fd_sent, fd_recv;
+  std::set<int> fd_recv_dedup;
+  RETURN_ON_ERROR(ReadCreateBuffersReply(message_in, ids, payloads, fd_sent));
+  RETURN_ON_ASSERT(ids.size() == sizes.size() &&
+                   payloads.size() == sizes.size());
+
+  for (auto const& item : payloads) {
+    if (item.data_size > 0) {
+      shm_->PreMmap(item.store_fd, fd_recv, fd_recv_dedup);
+    }
+  }
+  if (!fdsMatched(fd_sent, fd_recv)) {
+    json error = json::object();
+    error["error"] =
+        "CreateBuffers: the fd set is not matched between client and server";
+    error["fd_sent"] = fd_sent;
+    error["fd_recv"] = fd_recv;
+    error["response"] = message_in;
+    return Status::UnknownError(error.dump());
+  }
+
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    auto const& item = payloads[i];
+    RETURN_ON_ASSERT(static_cast<size_t>(item.data_size) == sizes[i]);
+    uint8_t *shared = nullptr, *dist = nullptr;
+    if (item.data_size > 0) {
+      RETURN_ON_ERROR(shm_->Mmap(item.store_fd, item.object_id, item.map_size,
+                                 item.data_size, item.data_offset,
+                                 item.pointer - item.data_offset, false,
+                                 item.RequiresRealign(), &shared));
+      dist = shared + item.data_offset;
+    }
+    buffers.emplace_back(
+        std::make_shared<arrow::MutableBuffer>(dist, item.data_size));
+    RETURN_ON_ERROR(addUsage(ids[i], item));
+  }
+  return Status::OK();
+}
+
 Status Client::GetBuffers(
     const std::set<ObjectID>& ids,
     std::map<ObjectID, std::shared_ptr<arrow::Buffer>>& buffers) {
@@ -692,16 +1171,36 @@ Status Client::GetBuffers(
   }
   ENSURE_CONNECTED(this);
 
+  /// resume the blobs whose releases are still pending, as the server holds
+  /// them for this client
+  const std::set<ObjectID>* remote_ids = &ids;
+  std::set<ObjectID> unresolved_ids;
+  if (!deferred_releases_.empty()) {
+    std::vector<Payload> resumed;
+    for (auto const& id : ids) {
+      auto deferred = deferred_releases_.find(id);
+      if (deferred != deferred_releases_.end() &&
+          (unsafe || deferred->second.IsSealed())) {
+        resumed.emplace_back(deferred->second);
+      } else {
+        unresolved_ids.emplace(id);
+      }
+    }
+    RETURN_ON_ERROR(mmapBuffers(resumed, buffers));
+    if (unresolved_ids.empty()) {
+      return Status::OK();
+    }
+    remote_ids = &unresolved_ids;
+  }
+
   /// lookup in server-side store
-  std::string message_out;
-  WriteGetBuffersRequest(ids, unsafe, message_out);
-  RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
-  RETURN_ON_ERROR(doRead(message_in));
   std::vector<Payload> payloads;
   std::vector<int> fd_sent, fd_recv;
   std::set<int> fd_recv_dedup;
-  RETURN_ON_ERROR(ReadGetBuffersReply(message_in, payloads, fd_sent));
+  bool check_fds = true;
+  RETURN_ON_ERROR(requestBuffers(*remote_ids, unsafe, payloads, fd_sent,
+                                 message_in, check_fds));
 
   for (auto const& item : payloads) {
     if (item.data_size > 0) {
@@ -709,7 +1208,7 @@ Status Client::GetBuffers(
     }
   }
 
-  if (message_in.contains("fds") && fd_sent != fd_recv) {
+  if (check_fds && !fdsMatched(fd_sent, fd_recv)) {
     json error = json::object();
     error["error"] =
         "GetBuffers: the fd set is not matched between client and server";
@@ -718,21 +1217,26 @@ Status Client::GetBuffers(
     error["response"] = message_in;
     return Status::UnknownError(error.dump());
   }
+  return mmapBuffers(payloads, buffers);
+}
 
+Status Client::mmapBuffers(
+    std::vector<Payload> const& payloads,
+    std::map<ObjectID, std::shared_ptr<arrow::Buffer>>& buffers) {
   for (auto const& item : payloads) {
     std::shared_ptr<arrow::Buffer> buffer = nullptr;
     uint8_t *shared = nullptr, *dist = nullptr;
     if (item.data_size > 0) {
       VINEYARD_CHECK_OK(shm_->Mmap(item.store_fd, item.object_id, item.map_size,
                                    item.data_size, item.data_offset,
-                                   item.pointer - item.data_offset, true, true,
-                                   &shared));
+                                   item.pointer - item.data_offset, true,
+                                   item.RequiresRealign(), &shared));
       dist = shared + item.data_offset;
     }
     buffer = std::make_shared<arrow::Buffer>(dist, item.data_size);
     buffers.emplace(item.object_id, buffer);
     /// Add reference count of buffers
-    RETURN_ON_ERROR(AddUsage(item.object_id, item));
+    RETURN_ON_ERROR(addUsage(item.object_id, item));
   }
   return Status::OK();
 }
@@ -757,6 +1261,8 @@ Status Client::PostSeal(ObjectMeta const& meta) {
   for (auto bid : bids) {
     auto s = IncreaseReferenceCount(bid);
     if (!s.ok()) {
+      // the pending release would drop the reference increased below
+      deferred_releases_.erase(bid);
       remote_bids.push_back(bid);
     }
   }
@@ -774,9 +1280,36 @@ Status Client::PostSeal(ObjectMeta const& meta) {
 
 // If reference count reaches 0, send Release request to server.
 Status Client::OnRelease(ObjectID const& id) {
+  ENSURE_CONNECTED(this);
+  if (max_deferred_releases_ > 0) {
+    return deferRelease(id);
+  }
+  auto batch = batches_.find(std::this_thread::get_id());
+  if (batch != batches_.end()) {
+    batch->second.releases.emplace_back(id);
+    return Status::OK();
+  }
+  return releaseBuffers({id});
+}
+
+Status Client::releaseBuffers(std::vector<ObjectID> const& ids) {
+  if (ids.empty()) {
+    return Status::OK();
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
-  WriteReleaseRequest(id, message_out);
+  if (ids.size() == 1 && binary_protocol_) {
+    WriteReleaseRequestBinary(ids[0], message_out);
+    std::string message_in;
+    RETURN_ON_ERROR(doBinaryRequest(message_out, message_in));
+    RETURN_ON_ERROR(ReadReleaseReplyBinary(message_in));
+    return Status::OK();
+  }
+  if (ids.size() == 1) {
+    WriteReleaseRequest(ids[0], message_out);
+  } else {
+    WriteReleaseRequest(ids, message_out);
+  }
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
@@ -784,6 +1317,140 @@ Status Client::OnRelease(ObjectID const& id) {
   return Status::OK();
 }
 
+Status Client::deferRelease(ObjectID const& id) {
+  // the usage is still there, see `UsageTracker::OnRelease`
+  Payload payload;
+  if (FetchOnLocal(id, payload).IsObjectNotExists()) {
+    return releaseBuffers({id});
+  }
+  if (release_delay_.count() > 0 && !release_flusher_.joinable()) {
+    release_flusher_ = std::thread(&Client::flushReleasesPeriodically, this);
+  }
+  if (deferred_releases_.empty()) {
+    deferred_since_ = std::chrono::steady_clock::now();
+    release_cv_.notify_all();
+  }
+  deferred_releases_[id] = payload;
+  if (deferred_releases_.size() >= max_deferred_releases_) {
+    return FlushReleases();
+  }
+  return Status::OK();
+}
+
+Status Client::addUsage(ObjectID const& id, Payload const& payload) {
+  if (!deferred_releases_.empty()) {
+    deferred_releases_.erase(id);
+  }
+  return AddUsage(id, payload);
+}
+
+Status Client::DeferRelease(const size_t max_pending,
+                            const int64_t max_delay_ms) {
+  ENSURE_CONNECTED(this);
+  max_deferred_releases_ = max_pending;
+  release_delay_ =
+      std::chrono::milliseconds(std::max<int64_t>(max_delay_ms, 0));
+  release_cv_.notify_all();
+  if (max_deferred_releases_ == 0) {
+    return FlushReleases();
+  }
+  return Status::OK();
+}
+
+Status Client::FlushReleases() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  if (deferred_releases_.empty()) {
+    return Status::OK();
+  }
+  std::vector<ObjectID> ids;
+  ids.reserve(deferred_releases_.size());
+  for (auto const& item : deferred_releases_) {
+    ids.emplace_back(item.first);
+  }
+  deferred_releases_.clear();
+  return releaseBuffers(ids);
+}
+
+Status Client::deferReleaseFromEnv() {
+  auto delay = read_env("VINEYARD_RELEASE_DELAY_MS");
+  if (delay.empty()) {
+    return Status::OK();
+  }
+  int64_t max_delay_ms = 0;
+  try {
+    max_delay_ms = std::stoll(delay);
+  } catch (std::exception const&) {
+    return Status::Invalid("Invalid VINEYARD_RELEASE_DELAY_MS: " + delay);
+  }
+  // bounds the size of the release request as well
+  constexpr size_t kMaxDeferredReleases = 4096;
+  return DeferRelease(kMaxDeferredReleases, max_delay_ms);
+}
+
+void Client::flushReleasesPeriodically() {
+  std::unique_lock<std::recursive_mutex> lock(client_mutex_);
+  while (!stop_release_flusher_) {
+    if (deferred_releases_.empty() || release_delay_.count() == 0) {
+      release_cv_.wait(lock);
+      continue;
+    }
+    auto deadline = deferred_since_ + release_delay_;
+    if (std::chrono::steady_clock::now() < deadline) {
+      release_cv_.wait_until(lock, deadline);
+      continue;
+    }
+    auto status = FlushReleases();
+    if (!status.ok()) {
+      std::clog << "[warn] Failed to send the deferred releases: "
+                << status.ToString() << std::endl;
+    }
+  }
+}
+
+void Client::stopReleaseFlusher() {
+  {
+    std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+    if (!release_flusher_.joinable()) {
+      return;
+    }
+    stop_release_flusher_ = true;
+    release_cv_.notify_all();
+  }
+  release_flusher_.join();
+  stop_release_flusher_ = false;
+}
+
+void Client::beginBatch() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  batches_[std::this_thread::get_id()].depth += 1;
+}
+
+Status Client::endBatch() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  auto iter = batches_.find(std::this_thread::get_id());
+  RETURN_ON_ASSERT(iter != batches_.end(), "The batch has not been started");
+  if (--iter->second.depth > 0) {
+    return Status::OK();
+  }
+  Batch batch = std::move(iter->second);
+  batches_.erase(iter);
+  Status status;
+  status += Seal(batch.seals);
+  status += releaseBuffers(batch.releases);
+  return status;
+}
+
+Status Client::flushPendingSeals() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  auto iter = batches_.find(std::this_thread::get_id());
+  if (iter == batches_.end() || iter->second.seals.empty()) {
+    return Status::OK();
+  }
+  std::vector<ObjectID> seals;
+  std::swap(seals, iter->second.seals);
+  return Seal(seals);
+}
+
 // TODO(mengke): If reference count reaches 0 and marked as to be deleted, send
 // DelData request to server.
 Status Client::OnDelete(ObjectID const& id) {
@@ -792,10 +1459,18 @@ Status Client::OnDelete(ObjectID const& id) {
 }
 
 Status Client::Release(std::vector<ObjectID> const& ids) {
+  ENSURE_CONNECTED(this);
+  // blobs that reach zero are released with a single request
+  BatchGuard batch(*this);
+  Status status;
   for (auto id : ids) {
-    RETURN_ON_ERROR(Release(id));
+    status = Release(id);
+    if (!status.ok()) {
+      break;
+    }
   }
-  return Status::OK();
+  status += batch.End();
+  return status;
 }
 
 // Released by users.
@@ -804,10 +1479,21 @@ Status Client::Release(ObjectID const& id) {
   if (!IsBlob(id)) {
     std::set<ObjectID> bids;
     RETURN_ON_ERROR(GetDependency(id, bids));
+    BatchGuard batch(*this);
+    Status status;
     for (auto const& bid : bids) {
-      RETURN_ON_ASSERT(IsBlob(bid));
-      RETURN_ON_ERROR(RemoveUsage(bid));
+      if (!IsBlob(bid)) {
+        status = Status::AssertionFailed("Expect a blob id: " +
+                                         ObjectIDToString(bid));
+        break;
+      }
+      status = RemoveUsage(bid);
+      if (!status.ok()) {
+        break;
+      }
     }
+    status += batch.End();
+    RETURN_ON_ERROR(status);
   } else {
     RETURN_ON_ERROR(RemoveUsage(id));
   }
@@ -825,6 +1511,8 @@ Status Client::DelData(const std::vector<ObjectID>& ids, const bool force,
     // May contain duplicated blob ids.
     VINEYARD_DISCARD(Release(id));
   }
+  // the server deletes blobs that are not in use only
+  RETURN_ON_ERROR(FlushReleases());
   std::string message_out;
   WriteDelDataWithFeedbacksRequest(ids, force, deep, /*fastpath=*/false,
                                    message_out);
@@ -853,22 +1541,20 @@ Status Client::GetBufferSizes(const std::set<ObjectID>& ids, const bool unsafe,
     return Status::OK();
   }
   ENSURE_CONNECTED(this);
-  std::string message_out;
-  WriteGetBuffersRequest(ids, unsafe, message_out);
-  RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
-  RETURN_ON_ERROR(doRead(message_in));
   std::vector<Payload> payloads;
   std::vector<int> fd_sent, fd_recv;
   std::set<int> fd_recv_dedup;
-  RETURN_ON_ERROR(ReadGetBuffersReply(message_in, payloads, fd_sent));
+  bool check_fds = true;
+  RETURN_ON_ERROR(requestBuffers(ids, unsafe, payloads, fd_sent, message_in,
+                                 check_fds));
 
   for (auto const& item : payloads) {
     if (item.data_size > 0) {
       shm_->PreMmap(item.store_fd, fd_recv, fd_recv_dedup);
     }
   }
-  if (message_in.contains("fds") && fd_sent != fd_recv) {
+  if (check_fds && !fdsMatched(fd_sent, fd_recv)) {
     json error = json::object();
     error["error"] =
         "GetBufferSizes: the fd set is not matched between client and server";
@@ -883,14 +1569,214 @@ Status Client::GetBufferSizes(const std::set<ObjectID>& ids, const bool unsafe,
     if (item.data_size > 0) {
       VINEYARD_CHECK_OK(shm_->Mmap(item.store_fd, item.object_id, item.map_size,
                                    item.data_size, item.data_offset,
-                                   item.pointer - item.data_offset, true, true,
-                                   &shared));
+                                   item.pointer - item.data_offset, true,
+                                   item.RequiresRealign(), &shared));
     }
     sizes.emplace(item.object_id, item.data_size);
   }
   return Status::OK();
 }
 
+Status Client::requestBuffers(const std::set<ObjectID>& ids, const bool unsafe,
+                              std::vector<Payload>& payloads,
+                              std::vector<int>& fd_sent, json& message_in,
+                              bool& check_fds) {
+  // the blobs sealed in the ongoing batch should be visible
+  RETURN_ON_ERROR(flushPendingSeals());
+  std::string message_out;
+  if (binary_protocol_) {
+    WriteGetBuffersRequestBinary(ids, unsafe, message_out);
+    std::string binary_message_in;
+    RETURN_ON_ERROR(doBinaryRequest(message_out, binary_message_in));
+    RETURN_ON_ERROR(
+        ReadGetBuffersReplyBinary(binary_message_in, payloads, fd_sent));
+    check_fds = true;
+    return Status::OK();
+  }
+  WriteGetBuffersRequest(ids, unsafe, message_out);
+  RETURN_ON_ERROR(doWrite(message_out));
+  RETURN_ON_ERROR(doRead(message_in));
+  RETURN_ON_ERROR(ReadGetBuffersReply(message_in, payloads, fd_sent));
+  check_fds = message_in.contains("fds");
+  return Status::OK();
+}
+
+bool Client::fdsMatched(std::vector<int> const& fd_sent,
+                        std::vector<int> const& fd_recv) {
+  if (!async_) {
+    return fd_sent == fd_recv;
+  }
+  // the fds may come with the replies of other pipelined requests, and have
+  // been received by the reader thread
+  for (int fd : fd_recv) {
+    if (!shm_->Received(fd)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Client::fdsMatched(int fd_sent, int fd_recv) {
+  if (!async_) {
+    return fd_sent == fd_recv;
+  }
+  return fd_recv == -1 || shm_->Received(fd_recv);
+}
+
+Status Client::requestAsync(std::string& message_out,
+                            std::function<Status(json const&)> on_reply,
+                            std::future<Status>& done) {
+  ENSURE_CONNECTED(this);
+  RETURN_ON_ERROR(startReader());
+  PendingReply pending;
+  pending.on_reply = std::move(on_reply);
+  done = pending.done.get_future();
+  uint64_t request_id = 0;
+  {
+    std::lock_guard<std::mutex> guard(reply_mutex_);
+    if (reader_stopped_) {
+      return reader_status_;
+    }
+    request_id = next_request_id_++;
+    pending_replies_.emplace(request_id, std::move(pending));
+  }
+  AttachRequestId(request_id, message_out);
+  auto status = doWrite(message_out);
+  if (!status.ok()) {
+    std::lock_guard<std::mutex> guard(reply_mutex_);
+    pending_replies_.erase(request_id);
+  }
+  return status;
+}
+
+Status Client::startReader() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  if (async_) {
+    return Status::OK();
+  }
+  // the reader thread only understands JSON replies
+  if (binary_protocol_) {
+    std::clog << "[warn] The binary protocol and the shared memory channel "
+                 "are disabled after switching to the async mode"
+              << std::endl;
+    binary_protocol_ = false;
+  }
+  shm_->StartReceiving();
+  {
+    std::lock_guard<std::mutex> guard(reply_mutex_);
+    reader_stopped_ = false;
+    reader_status_ = Status::OK();
+    sync_replies_.clear();
+  }
+  reader_ = std::thread(&Client::readReplies, this);
+  completer_ = std::thread(&Client::completeReplies, this);
+  async_ = true;
+  return Status::OK();
+}
+
+void Client::stopReader() {
+  {
+    std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+    if (!reader_.joinable()) {
+      return;
+    }
+    // wake up the reader thread, the exit request can still be sent
+    shutdown(vineyard_conn_, SHUT_RD);
+  }
+  // the completions wait for the client mutex, don't hold it when joining
+  reader_.join();
+  completer_.join();
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  async_ = false;
+}
+
+void Client::readReplies() {
+  while (true) {
+    std::string message_in;
+    json root;
+    auto status = recv_message(vineyard_conn_, message_in);
+    if (status.ok()) {
+      CATCH_JSON_ERROR(root, status, json::parse(message_in));
+    }
+    // receive the fds sent right after the reply, before dispatching it
+    if (status.ok() && root.contains("fds")) {
+      for (int fd : root["fds"].get<std::vector<int>>()) {
+        status += shm_->Receive(fd);
+      }
+    } else if (status.ok() && root.contains("fd")) {
+      int fd = root["fd"].get<int>();
+      if (fd != -1) {
+        status += shm_->Receive(fd);
+      }
+    }
+
+    std::lock_guard<std::mutex> guard(reply_mutex_);
+    if (!status.ok()) {
+      reader_stopped_ = true;
+      reader_status_ = status;
+      for (auto& pending : pending_replies_) {
+        pending.second.done.set_value(status);
+      }
+      pending_replies_.clear();
+      reply_cv_.notify_all();
+      return;
+    }
+    uint64_t request_id = ReadRequestId(root);
+    if (request_id == 0) {
+      sync_replies_.emplace_back(std::move(root));
+      reply_cv_.notify_all();
+      continue;
+    }
+    auto pending = pending_replies_.find(request_id);
+    if (pending != pending_replies_.end()) {
+      completions_.emplace_back(std::move(pending->second), std::move(root));
+      pending_replies_.erase(pending);
+      reply_cv_.notify_all();
+    }
+  }
+}
+
+void Client::completeReplies() {
+  while (true) {
+    std::pair<PendingReply, json> completion;
+    {
+      std::unique_lock<std::mutex> lock(reply_mutex_);
+      reply_cv_.wait(lock, [this]() {
+        return !completions_.empty() || reader_stopped_;
+      });
+      if (completions_.empty()) {
+        return;
+      }
+      completion = std::move(completions_.front());
+      completions_.pop_front();
+    }
+    Status status;
+    try {
+      status = completion.first.on_reply(completion.second);
+    } catch (std::exception const& ex) {
+      status = Status::UnknownError(ex.what());
+    }
+    completion.first.done.set_value(status);
+  }
+}
+
+Status Client::doRead(json& root) {
+  if (!async_) {
+    return ClientBase::doRead(root);
+  }
+  std::unique_lock<std::mutex> lock(reply_mutex_);
+  reply_cv_.wait(lock, [this]() {
+    return !sync_replies_.empty() || reader_stopped_;
+  });
+  if (sync_replies_.empty()) {
+    connected_ = false;
+    return reader_status_;
+  }
+  root = std::move(sync_replies_.front());
+  sync_replies_.pop_front();
+  return Status::OK();
+}
+
 Status Client::DropBuffer(const ObjectID id, const int fd) {
   ENSURE_CONNECTED(this);
 
@@ -911,20 +1797,48 @@ Status Client::DropBuffer(const ObjectID id, const int fd) {
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   RETURN_ON_ERROR(ReadDropBufferReply(message_in));
+  deferred_releases_.erase(id);
   RETURN_ON_ERROR(DeleteUsage(id));
   return Status::OK();
 }
 
 Status Client::Seal(ObjectID const& object_id) {
   ENSURE_CONNECTED(this);
-  std::string message_out;
-  WriteSealRequest(object_id, message_out);
-  RETURN_ON_ERROR(doWrite(message_out));
+  auto batch = batches_.find(std::this_thread::get_id());
+  if (batch != batches_.end()) {
+    batch->second.seals.emplace_back(object_id);
+    return Status::OK();
+  }
+  return Seal(std::vector<ObjectID>{object_id});
+}
 
-  json message_in;
-  RETURN_ON_ERROR(doRead(message_in));
-  RETURN_ON_ERROR(ReadSealReply(message_in));
-  RETURN_ON_ERROR(SealUsage(object_id));
+Status Client::Seal(std::vector<ObjectID> const& object_ids) {
+  if (object_ids.empty()) {
+    return Status::OK();
+  }
+  ENSURE_CONNECTED(this);
+  std::string message_out;
+  if (object_ids.size() == 1 && binary_protocol_) {
+    WriteSealRequestBinary(object_ids[0], message_out);
+    std::string message_in;
+    RETURN_ON_ERROR(doBinaryRequest(message_out, message_in));
+    RETURN_ON_ERROR(ReadSealReplyBinary(message_in));
+  } else if (object_ids.size() == 1) {
+    WriteSealRequest(object_ids[0], message_out);
+    RETURN_ON_ERROR(doWrite(message_out));
+    json message_in;
+    RETURN_ON_ERROR(doRead(message_in));
+    RETURN_ON_ERROR(ReadSealReply(message_in));
+  } else {
+    WriteSealBlobsRequest(object_ids, message_out);
+    RETURN_ON_ERROR(doWrite(message_out));
+    json message_in;
+    RETURN_ON_ERROR(doRead(message_in));
+    RETURN_ON_ERROR(ReadSealBlobsReply(message_in));
+  }
+  for (auto const& object_id : object_ids) {
+    RETURN_ON_ERROR(SealUsage(object_id));
+  }
   return Status::OK();
 }
 
@@ -1016,6 +1930,7 @@ Status Client::ShallowCopy(PlasmaID const plasma_id, ObjectID& target_id,
 
 Status Client::IsInUse(ObjectID const& id, bool& is_in_use) {
   ENSURE_CONNECTED(this);
+  RETURN_ON_ERROR(FlushReleases());
 
   std::string message_out;
   WriteIsInUseRequest(id, message_out);
@@ -1189,7 +2104,8 @@ Status PlasmaClient::GetBuffers(
       VINEYARD_CHECK_OK(this->shm_->Mmap(
           item.second.store_fd, item.second.object_id, item.second.map_size,
           item.second.data_size, item.second.data_offset,
-          item.second.pointer - item.second.data_offset, true, true, &shared));
+          item.second.pointer - item.second.data_offset, true,
+          item.second.RequiresRealign(), &shared));
       dist = shared + item.second.data_offset;
     }
     buffer = std::make_shared<arrow::Buffer>(dist, item.second.data_size);
@@ -1304,6 +2220,10 @@ MmapEntry::MmapEntry(int fd, int64_t map_size, uint8_t* pointer, bool readonly,
   } else {
     length_ = map_size;
   }
+  // the mapped length of the shared memory backed by huge pages must be
+  // aligned to the huge page size.
+  size_t page_size = static_cast<size_t>(file_page_size(fd));
+  length_ = (length_ + page_size - 1) / page_size * page_size;
 }
 
 MmapEntry::~MmapEntry() {
@@ -1357,8 +2277,17 @@ Status SharedMemoryManager::Mmap(int fd, int64_t map_size, uint8_t* pointer,
                                  bool readonly, bool realign, uint8_t** ptr) {
   auto entry = mmap_table_.find(fd);
   if (entry == mmap_table_.end()) {
-    int client_fd = recv_fd(vineyard_conn_);
-    if (fd <= 0) {
+    int client_fd = -1;
+    if (receiving_) {
+      std::lock_guard<std::mutex> guard(received_mutex_);
+      auto received = received_fds_.find(fd);
+      if (received != received_fds_.end()) {
+        client_fd = received->second;
+      }
+    } else {
+      client_fd = recv_fd(vineyard_conn_);
+    }
+    if (client_fd <= 0) {
       return Status::IOError(
           "Failed to receieve file descriptor from the socket");
     }
@@ -1404,6 +2333,36 @@ void SharedMemoryManager::PreMmap(int fd, std::vector<int>& fds,
   }
 }
 
+void SharedMemoryManager::StartReceiving() {
+  std::lock_guard<std::mutex> guard(received_mutex_);
+  for (auto const& entry : mmap_table_) {
+    received_fds_.emplace(entry.first, entry.second->fd());
+  }
+  receiving_ = true;
+}
+
+bool SharedMemoryManager::Received(int fd) {
+  if (mmap_table_.find(fd) != mmap_table_.end()) {
+    return true;
+  }
+  std::lock_guard<std::mutex> guard(received_mutex_);
+  return received_fds_.find(fd) != received_fds_.end();
+}
+
+Status SharedMemoryManager::Receive(int fd) {
+  std::lock_guard<std::mutex> guard(received_mutex_);
+  if (received_fds_.find(fd) != received_fds_.end()) {
+    return Status::OK();
+  }
+  int client_fd = recv_fd(vineyard_conn_);
+  if (client_fd <= 0) {
+    return Status::IOError(
+        "Failed to receieve file descriptor from the socket");
+  }
+  received_fds_.emplace(fd, client_fd);
+  return Status::OK();
+}
+
 bool SharedMemoryManager::Exists(const uintptr_t target) {
   ObjectID id;
   return Exists(target, id);
@@ -1543,9 +2502,11 @@ template <typename ID, typename P, typename Der>
 Status UsageTracker<ID, P, Der>::OnRelease(ID const& id) {
   // N.B.: Once reference count reaches zero, the accessibility of the object
   // cannot be guaranteed (may trigger spilling in server-side), thus this
-  // blob should be regard as not-in-use.
-  RETURN_ON_ERROR(DeleteUsage(id));
-  return this->self().OnRelease(id);
+  // blob should be regard as not-in-use. The usage is deleted after
+  // `OnRelease`, as the derived class may still inspect the payload.
+  auto status = this->self().OnRelease(id);
+  status += DeleteUsage(id);
+  return status;
 }
 
 template <typename ID, typename P, typename Der>
@@ -16,11 +16,18 @@ limitations under the License.
 #ifndef SRC_CLIENT_CLIENT_H_
 #define SRC_CLIENT_CLIENT_H_
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -30,6 +37,7 @@ limitations under the License.
 #include "client/ds/object_meta.h"
 #include "common/memory/gpu/unified_memory.h"
 #include "common/memory/payload.h"
+#include "common/memory/shm_channel.h"
 #include "common/util/lifecycle.h"
 #include "common/util/protocols.h"
 #include "common/util/status.h"
@@ -107,6 +115,24 @@ class SharedMemoryManager {
   // compute the set of fds that needs to `recv` from the server
   void PreMmap(int fd, std::vector<int>& fds, std::set<int>& dedup);
 
+  /**
+   * @brief Receive the fds along with the replies rather than in `Mmap`, for
+   * pipelined requests, where the replies are read by a reader thread.
+   */
+  void StartReceiving();
+
+  /**
+   * @brief Receive the given server-side fd from the server, if it hasn't been
+   * received yet.
+   */
+  Status Receive(int fd);
+
+  /**
+   * @brief Whether the given server-side fd has been mapped, or received by
+   * `Receive()`.
+   */
+  bool Received(int fd);
+
   bool Exists(const uintptr_t target);
 
   bool Exists(const void* target);
@@ -127,6 +153,12 @@ class SharedMemoryManager {
 
   // sorted shm segments for fast "if exists" query
   std::map<uintptr_t, std::pair<size_t, ObjectID>> segments_;
+
+  // the fds received by `Receive()`, from the server-side fd to the
+  // client-side fd
+  bool receiving_ = false;
+  std::mutex received_mutex_;
+  std::unordered_map<int, int> received_fds_;
 };
 
 /**
@@ -232,8 +264,40 @@ class BasicIPCClient : public ClientBase {
    */
   Status Open(std::string const& ipc_socket, StoreType const& bulk_store_type);
 
+  /**
+   * @brief Whether the blob commands go through the shared memory channel,
+   * which is negotiated when connecting.
+   */
+  bool ShmChannelEnabled() const {
+    return binary_protocol_ && channel_ != nullptr;
+  }
+
  protected:
+  /**
+   * @brief Send a binary encoded request and read the reply, over the shared
+   * memory channel if it has been negotiated, otherwise over the socket.
+   */
+  Status doBinaryRequest(const std::string& message_out,
+                         std::string& message_in);
+
   std::shared_ptr<detail::SharedMemoryManager> shm_;
+
+  // whether the blob commands are encoded in binary, negotiated when
+  // registering, and can be disabled by `VINEYARD_IPC_BINARY_PROTOCOL=0`.
+  bool binary_protocol_ = false;
+
+  // the shared memory control channel for the binary encoded commands,
+  // negotiated when registering, and can be disabled by
+  // `VINEYARD_IPC_SHM_CHANNEL=0`.
+  std::unique_ptr<ShmChannel> channel_;
+
+ private:
+  /**
+   * @brief Receive the shared memory channel sent after the register reply.
+   */
+  Status openChannel();
+
+  Status openConnection(int& conn) override;
 };
 
 class Client;
@@ -350,6 +414,33 @@ class Client final : public BasicIPCClient,
    */
   Status CreateBlob(size_t size, std::unique_ptr<BlobWriter>& blob);
 
+  /**
+   * @brief Create a blob in vineyard server, and prefer placing its memory on
+   * the given NUMA node. By default, blobs are placed on the NUMA node where
+   * the client runs.
+   *
+   * @param size The size of requested blob.
+   * @param numa_node The preferred NUMA node, -1 means the node of the client.
+   * @param blob The result mutable blob will be set in `blob`.
+   *
+   * @return Status that indicates whether the create action has succeeded.
+   */
+  Status CreateBlob(size_t size, int numa_node,
+                    std::unique_ptr<BlobWriter>& blob);
+
+  /**
+   * @brief Create a list of blobs in vineyard server with a single request,
+   * see also `CreateBlob`.
+   *
+   * @param sizes The sizes of requested blobs.
+   * @param blobs The result mutable blobs will be set in `blobs`, in the same
+   * order of `sizes`.
+   *
+   * @return Status that indicates whether the create action has succeeded.
+   */
+  Status CreateBlobs(const std::vector<size_t>& sizes,
+                     std::vector<std::unique_ptr<BlobWriter>>& blobs);
+
   /**
    * @brief Get a blob from vineyard server.
    *
@@ -390,6 +481,56 @@ class Client final : public BasicIPCClient,
   Status GetBlobs(std::vector<ObjectID> const ids, const bool unsafe,
                   std::vector<std::shared_ptr<Blob>>& blobs);
 
+  /**
+   * @brief Obtain metadata from vineyard server without waiting for the reply,
+   * the requests can be pipelined on the connection and the replies are
+   * dispatched by a reader thread, see also `GetMetaData`.
+   *
+   * The first asynchronous request switches the client into the async mode,
+   * where the blob commands are always encoded in JSON. Synchronous methods
+   * can still be used in the async mode.
+   *
+   * @param id The object id to get.
+   * @param meta_data The result metadata will be store in `meta_data` when the
+   * returned future is ready, it must outlive the future.
+   * @param sync_remote Whether to trigger an immediate remote metadata
+   *        synchronization before get specific metadata. Default is false.
+   *
+   * @return A future of the status that indicates whether the get action has
+   * succeeded. The future gets ready once the reply has arrived and the blobs
+   * have been mapped, without waiting for `get()`.
+   */
+  std::future<Status> GetMetaDataAsync(const ObjectID id, ObjectMeta& meta_data,
+                                       const bool sync_remote = false);
+
+  /**
+   * @brief Create a blob in vineyard server without waiting for the reply, see
+   * also `CreateBlob` and `GetMetaDataAsync`.
+   *
+   * @param size The size of requested blob.
+   * @param blob The result mutable blob will be set in `blob` when the
+   * returned future is ready, it must outlive the future.
+   *
+   * @return A future of the status that indicates whether the create action
+   * has succeeded.
+   */
+  std::future<Status> CreateBlobAsync(size_t size,
+                                      std::unique_ptr<BlobWriter>& blob);
+
+  /**
+   * @brief Get blobs from vineyard server without waiting for the reply, see
+   * also `GetBlobs` and `GetMetaDataAsync`.
+   *
+   * @param ids The blobs to get.
+   * @param blobs The result blobs will be set in `blobs` when the returned
+   * future is ready, it must outlive the future.
+   *
+   * @return A future of the status that indicates whether the get action has
+   * succeeded.
+   */
+  std::future<Status> GetBlobsAsync(std::vector<ObjectID> const ids,
+                                    std::vector<std::shared_ptr<Blob>>& blobs);
+
   /**
    * @brief Claim a shared blob that backed by a file on disk. Users need to
    * provide either a filename to mmap, or an expected size to allocate the
@@ -716,6 +857,25 @@ class Client final : public BasicIPCClient,
 
   Status Release(ObjectID const& id) override;
 
+  /**
+   * @brief Defer the `ReleaseRequest` of blobs whose reference count reaches
+   * zero: the pending releases are sent with a single request when there are
+   * `max_pending` of them, or when the earliest one has been pending for
+   * `max_delay_ms` milliseconds. The pending release of a blob is canceled if
+   * the blob is got again before being sent, without asking the server.
+   *
+   * Releases are sent immediately when `max_pending` is zero, which is the
+   * default unless the environment variable `VINEYARD_RELEASE_DELAY_MS` is
+   * set on connecting. The pending releases are only bounded by count when
+   * `max_delay_ms` is zero.
+   */
+  Status DeferRelease(const size_t max_pending, const int64_t max_delay_ms);
+
+  /**
+   * @brief Send the deferred releases to the server, see also `DeferRelease`.
+   */
+  Status FlushReleases();
+
   /**
    * @brief Delete metadata in vineyard. When the object is a used by other
    * object, it will be deleted only when the `force` parameter is specified.
@@ -786,7 +946,22 @@ class Client final : public BasicIPCClient,
   Status GetDependency(ObjectID const& id, std::set<ObjectID>& bids);
 
   Status CreateBuffer(const size_t size, ObjectID& id, Payload& payload,
-                      std::shared_ptr<arrow::MutableBuffer>& buffer);
+                      std::shared_ptr<arrow::MutableBuffer>& buffer,
+                      const int numa_node = -1);
+
+  Status CreateBuffers(
+      const std::vector<size_t>& sizes, std::vector<ObjectID>& ids,
+      std::vector<Payload>& payloads,
+      std::vector<std::shared_ptr<arrow::MutableBuffer>>& buffers,
+      const int numa_node = -1);
+
+  /**
+   * @brief Create a blob without waiting for the reply, the outputs are set
+   * when the returned future is ready. See also `GetMetaDataAsync`.
+   */
+  std::future<Status> CreateBufferAsync(
+      const size_t size, ObjectID& id, Payload& payload,
+      std::shared_ptr<arrow::MutableBuffer>& buffer, const int numa_node = -1);
 
   /**
    * @brief Get a blob from vineyard server. When obtaining blobs from vineyard
@@ -839,7 +1014,90 @@ class Client final : public BasicIPCClient,
    */
   Status Seal(ObjectID const& object_id);
 
+  /**
+   * @brief mark a list of blobs as sealed with a single request.
+   */
+  Status Seal(std::vector<ObjectID> const& object_ids);
+
  private:
+  /**
+   * @brief Start a batch on the calling thread: the seal and release requests
+   * of blobs are deferred until the end of the batch, and then sent as a
+   * single request. Batches can be nested, and the pending requests are sent
+   * when the outermost batch ends.
+   */
+  void beginBatch();
+
+  Status endBatch();
+
+  /**
+   * @brief Starts a batch on construction, and ends it on destruction unless
+   * it has been ended by `End()`, e.g., when an exception is thrown.
+   */
+  class BatchGuard {
+   public:
+    explicit BatchGuard(Client& client) : client_(client) {
+      client_.beginBatch();
+    }
+
+    ~BatchGuard() {
+      if (!ended_) {
+        VINEYARD_DISCARD(client_.endBatch());
+      }
+    }
+
+    Status End() {
+      ended_ = true;
+      return client_.endBatch();
+    }
+
+   private:
+    Client& client_;
+    bool ended_ = false;
+  };
+
+  /**
+   * @brief Send the pending seal requests of the calling thread, before
+   * getting blobs from the server or creating metadata.
+   */
+  Status flushPendingSeals() override;
+
+  /**
+   * @brief Send the `ReleaseRequest` of blobs whose reference count reaches
+   * zero.
+   */
+  Status releaseBuffers(std::vector<ObjectID> const& ids);
+
+  /**
+   * @brief Keep the payload of the blob whose reference count reaches zero,
+   * and defer its release, see also `DeferRelease`.
+   */
+  Status deferRelease(ObjectID const& id);
+
+  /**
+   * @brief Track the usage of a blob that is got or created, and cancel its
+   * pending release, if any, as the server still holds the blob for this
+   * client.
+   */
+  Status addUsage(ObjectID const& id, Payload const& payload);
+
+  /**
+   * @brief Apply the `VINEYARD_RELEASE_DELAY_MS` environment variable.
+   */
+  Status deferReleaseFromEnv();
+
+  /**
+   * @brief The flusher thread, which sends the deferred releases when the
+   * earliest one has been pending for the configured delay.
+   */
+  void flushReleasesPeriodically();
+
+  /**
+   * @brief Stop the flusher thread, must not be called with the client mutex
+   * held, as the flusher thread waits on it.
+   */
+  void stopReleaseFlusher();
+
   Status GetBuffers(
       const std::set<ObjectID>& ids, const bool unsafe,
       std::map<ObjectID, std::shared_ptr<arrow::Buffer>>& buffers);
@@ -847,9 +1105,153 @@ class Client final : public BasicIPCClient,
   Status GetBufferSizes(const std::set<ObjectID>& ids, const bool unsafe,
                         std::map<ObjectID, size_t>& sizes);
 
+  /**
+   * @brief Send the `GetBuffersRequest` in the negotiated encoding. The
+   * `message_in` is only filled for JSON replies, and `check_fds` tells
+   * whether the `fd_sent` should be checked against the received fds.
+   */
+  Status requestBuffers(const std::set<ObjectID>& ids, const bool unsafe,
+                        std::vector<Payload>& payloads,
+                        std::vector<int>& fd_sent, json& message_in,
+                        bool& check_fds);
+
+  /**
+   * @brief Whether the fds to mmap match the fds sent along with the reply.
+   * In the async mode the fds are received by the reader thread, possibly
+   * along with the replies of other requests, thus the fds to mmap are
+   * checked against the received ones instead.
+   */
+  bool fdsMatched(std::vector<int> const& fd_sent,
+                  std::vector<int> const& fd_recv);
+
+  bool fdsMatched(int fd_sent, int fd_recv);
+
+  /**
+   * @brief Read the reply of the `CreateBufferRequest`, then map the created
+   * blob into the client.
+   */
+  Status onBufferCreated(const size_t size, json const& message_in,
+                         ObjectID& id, Payload& payload,
+                         std::shared_ptr<arrow::MutableBuffer>& buffer);
+
+  /**
+   * @brief Map the created blob into the client and track its usage.
+   */
+  Status mmapCreatedBuffer(const size_t size, ObjectID const id,
+                           Payload const& payload,
+                           std::shared_ptr<arrow::MutableBuffer>& buffer);
+
+  /**
+   * @brief Map the blobs got from the server into the client and track their
+   * usages.
+   */
+  Status mmapBuffers(
+      std::vector<Payload> const& payloads,
+      std::map<ObjectID, std::shared_ptr<arrow::Buffer>>& buffers);
+
+  void makeBlobs(
+      std::vector<ObjectID> const& ids,
+      std::map<ObjectID, std::shared_ptr<arrow::Buffer>> const& buffers,
+      std::vector<std::shared_ptr<Blob>>& blobs);
+
+  /**
+   * @brief Send the request tagged with a new request id. Once the reply
+   * arrives, `on_reply` is run by the completion thread and its result is
+   * set to `done`.
+   */
+  Status requestAsync(std::string& message_out,
+                      std::function<Status(json const&)> on_reply,
+                      std::future<Status>& done);
+
+  /**
+   * @brief Start the reader thread if the client is not in the async mode.
+   */
+  Status startReader();
+
+  void stopReader();
+
+  /**
+   * @brief The reader thread, which receives the fds sent along with the
+   * replies, and dispatches the replies by their request ids. Replies without
+   * request ids are read by the synchronous requests in order.
+   */
+  void readReplies();
+
+  /**
+   * @brief The completion thread, which runs the `on_reply` of requests in
+   * the order of their replies. The completions take the client mutex, thus
+   * they cannot be run by the reader thread, which the synchronous requests
+   * wait for while holding the mutex.
+   */
+  void completeReplies();
+
+  /**
+   * @brief Read the reply of the synchronous request from the reader thread
+   * in the async mode.
+   */
+  Status doRead(json& root) override;
+
+  using ClientBase::doRead;
+
   Status migrateBuffers(RPCClient& remote, const std::set<ObjectID> blobs,
                         std::map<ObjectID, ObjectID>& results) override;
 
+  /**
+   * @brief Migrate the blobs over `streams` parallel RPC connections: large
+   * blobs are split into chunks of `chunk_size` bytes and small blobs are
+   * packed together, and each stripe is retried on a new connection when it
+   * fails.
+   *
+   * Enabled by the environment variable `VINEYARD_MIGRATION_STREAMS`, and the
+   * chunk size could be tuned by `VINEYARD_MIGRATION_CHUNK_SIZE`.
+   */
+  Status migrateBuffersStriped(RPCClient& remote,
+                               const std::set<ObjectID>& blobs,
+                               const size_t streams, const size_t chunk_size,
+                               std::map<ObjectID, ObjectID>& results);
+
+  struct Batch {
+    int depth = 0;
+    std::vector<ObjectID> seals;
+    std::vector<ObjectID> releases;
+  };
+  // the ongoing batches of each thread
+  std::unordered_map<std::thread::id, Batch> batches_;
+
+  // the deferred releases, see also `DeferRelease`
+  size_t max_deferred_releases_ = 0;
+  std::chrono::milliseconds release_delay_{0};
+  // the payloads of blobs whose releases are pending, to resume the blobs
+  // when they are got again
+  std::unordered_map<ObjectID, Payload> deferred_releases_;
+  // when the earliest pending release was deferred
+  std::chrono::steady_clock::time_point deferred_since_;
+  std::thread release_flusher_;
+  // waits on the client mutex
+  std::condition_variable_any release_cv_;
+  bool stop_release_flusher_ = false;
+
+  // whether the requests are pipelined, see also `GetMetaDataAsync`
+  bool async_ = false;
+  std::thread reader_;
+  std::mutex reply_mutex_;
+  std::condition_variable reply_cv_;
+  uint64_t next_request_id_ = 1;
+  struct PendingReply {
+    std::function<Status(json const&)> on_reply;
+    std::promise<Status> done;
+  };
+  // the requests that are waiting for replies, by request ids
+  std::unordered_map<uint64_t, PendingReply> pending_replies_;
+  // the replies that are waiting for the completion thread
+  std::deque<std::pair<PendingReply, json>> completions_;
+  std::thread completer_;
+  // the replies of synchronous requests
+  std::deque<json> sync_replies_;
+  // the status of the reader thread after it stops
+  bool reader_stopped_ = false;
+  Status reader_status_;
+
   friend class Blob;
   friend class BlobWriter;
   friend class ObjectBuilder;
@@ -15,11 +15,16 @@ limitations under the License.
 
 #include "client/client_base.h"
 
+#include <poll.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
+#include <cerrno>
 #include <future>
 #include <iostream>
+#include <map>
 #include <set>
+#include <string>
 #include <utility>
 
 #include "client/client.h"
@@ -32,15 +37,28 @@ namespace vineyard {
 
 ClientBase::ClientBase() : connected_(false), vineyard_conn_(0) {}
 
+ClientBase::~ClientBase() { DisableMetaCache(); }
+
 Status ClientBase::GetData(const ObjectID id, json& tree,
                            const bool sync_remote, const bool wait) {
   ENSURE_CONNECTED(this);
+  // the metadata of blobs is not cached, as the deletion of local blobs
+  // doesn't go through the metadata service
+  const bool cacheable =
+      meta_cache_ && !sync_remote && !IsBlob(id) && !metaNotificationPending();
+  if (cacheable && meta_cache_->Get(id, tree)) {
+    return Status::OK();
+  }
+  const uint64_t generation = cacheable ? meta_cache_->Generation() : 0;
   std::string message_out;
   WriteGetDataRequest(id, sync_remote, wait, message_out);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   RETURN_ON_ERROR(ReadGetDataReply(message_in, tree));
+  if (cacheable) {
+    meta_cache_->Put(id, tree, generation);
+  }
   return Status::OK();
 }
 
@@ -48,13 +66,34 @@ Status ClientBase::GetData(const std::vector<ObjectID>& ids,
                            std::vector<json>& trees, const bool sync_remote,
                            const bool wait) {
   ENSURE_CONNECTED(this);
-  std::string message_out;
-  WriteGetDataRequest(ids, sync_remote, wait, message_out);
-  RETURN_ON_ERROR(doWrite(message_out));
-  json message_in;
-  RETURN_ON_ERROR(doRead(message_in));
+  const bool cacheable =
+      meta_cache_ && !sync_remote && !metaNotificationPending();
+  const uint64_t generation = cacheable ? meta_cache_->Generation() : 0;
   std::unordered_map<ObjectID, json> meta_trees;
-  RETURN_ON_ERROR(ReadGetDataReply(message_in, meta_trees));
+  std::vector<ObjectID> missed_ids;
+  for (auto const& id : ids) {
+    json tree;
+    if (cacheable && !IsBlob(id) && meta_cache_->Get(id, tree)) {
+      meta_trees.emplace(id, std::move(tree));
+    } else {
+      missed_ids.emplace_back(id);
+    }
+  }
+  if (!missed_ids.empty()) {
+    std::string message_out;
+    WriteGetDataRequest(missed_ids, sync_remote, wait, message_out);
+    RETURN_ON_ERROR(doWrite(message_out));
+    json message_in;
+    RETURN_ON_ERROR(doRead(message_in));
+    std::unordered_map<ObjectID, json> missed_trees;
+    RETURN_ON_ERROR(ReadGetDataReply(message_in, missed_trees));
+    for (auto& item : missed_trees) {
+      if (cacheable && !IsBlob(item.first)) {
+        meta_cache_->Put(item.first, item.second, generation);
+      }
+      meta_trees[item.first] = std::move(item.second);
+    }
+  }
   trees.reserve(ids.size());
   for (auto const& id : ids) {
     trees.emplace_back(meta_trees.at(id));
@@ -65,6 +104,8 @@ Status ClientBase::GetData(const std::vector<ObjectID>& ids,
 Status ClientBase::CreateData(const json& tree, ObjectID& id,
                               Signature& signature, InstanceID& instance_id) {
   ENSURE_CONNECTED(this);
+  // the blobs that are members of the metadata should have been sealed
+  RETURN_ON_ERROR(flushPendingSeals());
   std::string message_out;
   WriteCreateDataRequest(tree, message_out);
   RETURN_ON_ERROR(doWrite(message_out));
@@ -129,6 +170,11 @@ Status ClientBase::DelData(const std::vector<ObjectID>& ids, const bool force,
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   RETURN_ON_ERROR(ReadDelDataReply(message_in));
+  // the dependents that are deleted as well are invalidated by the
+  // notification from the server
+  if (meta_cache_) {
+    meta_cache_->Invalidate(ids);
+  }
   return Status::OK();
 }
 
@@ -228,6 +274,9 @@ Status ClientBase::Persist(const ObjectID id) {
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   RETURN_ON_ERROR(ReadPersistReply(message_in));
+  if (meta_cache_) {
+    meta_cache_->Invalidate({id});
+  }
   return Status::OK();
 }
 
@@ -284,6 +333,9 @@ Status ClientBase::PutName(const ObjectID id, std::string const& name) {
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   RETURN_ON_ERROR(ReadPutNameReply(message_in));
+  if (meta_cache_) {
+    meta_cache_->Invalidate({id});
+  }
   return Status::OK();
 }
 
@@ -439,6 +491,7 @@ bool ClientBase::Connected() const {
 
 void ClientBase::Disconnect() {
   std::lock_guard<std::recursive_mutex> __guard(this->client_mutex_);
+  DisableMetaCache();
   if (!this->connected_) {
     return;
   }
@@ -451,6 +504,7 @@ void ClientBase::Disconnect() {
 
 void ClientBase::CloseSession() {
   std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  DisableMetaCache();
   if (!Connected()) {
     return;
   }
@@ -463,6 +517,98 @@ void ClientBase::CloseSession() {
   connected_ = false;
 }
 
+Status ClientBase::EnableMetaCache(const size_t capacity) {
+  ENSURE_CONNECTED(this);
+  DisableMetaCache();
+  int conn = -1;
+  RETURN_ON_ERROR(openConnection(conn));
+  std::string message_out;
+  WriteSubscribeMetaRequest(message_out);
+  auto status = send_message(conn, message_out);
+  while (status.ok()) {
+    std::string message_in;
+    json root;
+    status = recv_message(conn, message_in);
+    if (status.ok()) {
+      CATCH_JSON_ERROR(root, status, json::parse(message_in));
+    }
+    // the server subscribes before replying, the notifications that precede
+    // the reply are skipped as nothing has been cached yet
+    if (status.ok() &&
+        root.value("type", "") != "invalidate_meta_notification") {
+      status = ReadSubscribeMetaReply(root);
+      break;
+    }
+  }
+  if (!status.ok()) {
+    close(conn);
+    return status;
+  }
+
+  auto cache = std::make_shared<MetaCache>(capacity);
+  meta_cache_ = cache;
+  meta_notifier_conn_ = conn;
+  meta_notifier_ = std::thread([cache, conn]() {
+    while (true) {
+      std::string message_in;
+      json root;
+      std::vector<ObjectID> ids;
+      // the cache misses from the moment the notification is readable, see
+      // also `metaNotificationPending`
+      struct pollfd readable = {conn, POLLIN, 0};
+      if (poll(&readable, 1, -1) < 0 && errno == EINTR) {
+        continue;
+      }
+      cache->Receiving();
+      auto status = recv_message(conn, message_in);
+      if (status.ok()) {
+        CATCH_JSON_ERROR(root, status, json::parse(message_in));
+      }
+      if (status.ok()) {
+        status = ReadInvalidateMetaNotification(root, ids);
+      }
+      if (!status.ok()) {
+        // the cache has been disabled, or the notifications are lost
+        cache->Close();
+        return;
+      }
+      cache->Invalidate(ids);
+    }
+  });
+  return Status::OK();
+}
+
+void ClientBase::DisableMetaCache() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  if (meta_notifier_conn_ != -1) {
+    // wake up the notifier thread
+    shutdown(meta_notifier_conn_, SHUT_RDWR);
+  }
+  if (meta_notifier_.joinable()) {
+    meta_notifier_.join();
+  }
+  if (meta_notifier_conn_ != -1) {
+    close(meta_notifier_conn_);
+    meta_notifier_conn_ = -1;
+  }
+  meta_cache_.reset();
+}
+
+bool ClientBase::metaNotificationPending() const {
+  // the notifications are written before the replies of the deletions, see
+  // also `VineyardServer::AfterMetaNotified`
+  struct pollfd readable = {meta_notifier_conn_, POLLIN, 0};
+  return poll(&readable, 1, 0) != 0;
+}
+
+MetaCacheStats ClientBase::GetMetaCacheStats() {
+  std::lock_guard<std::recursive_mutex> guard(client_mutex_);
+  if (meta_cache_) {
+    return meta_cache_->Stats();
+  }
+  return MetaCacheStats();
+}
+
 Status ClientBase::doWrite(const std::string& message_out) {
   auto status = send_message(vineyard_conn_, message_out);
   if (!status.ok()) {
@@ -548,11 +694,35 @@ Status ClientBase::Debug(const json& debug, json& result) {
   return Status::OK();
 }
 
+static std::map<int, size_t> parse_numa_usage(const json& tree) {
+  std::map<int, size_t> usage;
+  if (tree.contains("numa_usage") && tree["numa_usage"].is_object()) {
+    for (auto const& item : tree["numa_usage"].items()) {
+      usage[std::stoi(item.key())] = item.value().get<size_t>();
+    }
+  }
+  return usage;
+}
+
 InstanceStatus::InstanceStatus(const json& tree)
     : instance_id(tree["instance_id"].get<InstanceID>()),
       deployment(tree["deployment"].get_ref<const std::string&>()),
       memory_usage(tree["memory_usage"].get<size_t>()),
       memory_limit(tree["memory_limit"].get<size_t>()),
+      spill_bytes(tree.value("spill_bytes", static_cast<size_t>(0))),
+      spill_stored_bytes(
+          tree.value("spill_stored_bytes", static_cast<size_t>(0))),
+      spill_write_throughput(
+          tree.value("spill_write_throughput", static_cast<size_t>(0))),
+      allocation_stall_count(
+          tree.value("allocation_stall_count", static_cast<size_t>(0))),
+      allocation_stall_us(
+          tree.value("allocation_stall_us", static_cast<size_t>(0))),
+      compaction_moved_bytes(
+          tree.value("compaction_moved_bytes", static_cast<size_t>(0))),
+      compaction_reclaimed_bytes(
+          tree.value("compaction_reclaimed_bytes", static_cast<size_t>(0))),
+      numa_usage(parse_numa_usage(tree)),
       deferred_requests(tree["deferred_requests"].get<size_t>()),
       ipc_connections(tree["ipc_connections"].get<size_t>()),
       rpc_connections(tree["rpc_connections"].get<size_t>()) {}
@@ -21,10 +21,12 @@ limitations under the License.
 #include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "client/ds/object_meta.h"
+#include "client/meta_cache.h"
 #include "common/util/status.h"
 #include "common/util/uuid.h"
 #include "common/util/version.h"
@@ -52,7 +54,7 @@ struct InstanceStatus;
 class ClientBase {
  public:
   ClientBase();
-  virtual ~ClientBase() {}
+  virtual ~ClientBase();
 
   virtual Status Release(ObjectID const& id) { return Status::OK(); }
 
@@ -72,6 +74,9 @@ class ClientBase {
    *        been created on vineyard by other clients. Default is false.
    *
    * @return Status that indicates whether the get action succeeds.
+   *
+   * The metadata is served from the cache if it has been enabled by
+   * `EnableMetaCache`, unless `sync_remote` is true.
    */
   Status GetData(const ObjectID id, json& tree, const bool sync_remote = false,
                  const bool wait = false);
@@ -516,12 +521,53 @@ class ClientBase {
    */
   Status Debug(const json& debug, json& tree);
 
+  /**
+   * @brief Cache the metadata of at most `capacity` objects (except blobs) in
+   * the client, to save the round trips of `GetData` and `GetMetaData` for
+   * objects that are accessed repeatedly.
+   *
+   * The client subscribes the invalidation notifications from the server over
+   * a dedicated connection. The server replies a deletion only after the
+   * notification has been written to the subscribers, and the cache is
+   * bypassed while a notification is pending, thus an object is never served
+   * from the cache once the `DelData` that deletes it returns, whichever
+   * client issues it. The cache stops serving once the notifications are
+   * lost.
+   *
+   * @param capacity The maximum number of cached objects.
+   *
+   * @return Status that indicates whether the subscription has succeeded.
+   */
+  Status EnableMetaCache(const size_t capacity);
+
+  /**
+   * @brief Drop the metadata cache and the subscription, the cache is
+   * disabled by default.
+   */
+  void DisableMetaCache();
+
+  /**
+   * @brief The counters of the metadata cache, all zeros if the cache is not
+   * enabled.
+   */
+  MetaCacheStats GetMetaCacheStats();
+
  protected:
   Status doWrite(const std::string& message_out);
 
   Status doRead(std::string& message_in);
 
-  Status doRead(json& root);
+  /**
+   * @brief Read the reply of the request, which could be dispatched by the
+   * reader thread when requests are pipelined, see also `Client`.
+   */
+  virtual Status doRead(json& root);
+
+  /**
+   * @brief Send the seal requests of blobs that are deferred by the ongoing
+   * batch, before creating the metadata that may refer to the blobs.
+   */
+  virtual Status flushPendingSeals() { return Status::OK(); }
 
   /**
    * @brief Migrate remote buffers to connected instance.
@@ -538,6 +584,12 @@ class ClientBase {
 
   Status collectRemoteBlobs(const json& tree, std::set<ObjectID>& blobs);
 
+  /**
+   * @brief Open another connection to the connected server, which receives
+   * the invalidation notifications of the metadata cache.
+   */
+  virtual Status openConnection(int& conn) = 0;
+
   Status recreateMetadata(ClientBase& client, ObjectMeta const& metadata,
                           ObjectMeta& target,
                           std::map<ObjectID, ObjectID> result_blobs);
@@ -552,6 +604,16 @@ class ClientBase {
 
   // A mutex which protects the client.
   std::recursive_mutex client_mutex_;
+
+  // whether an invalidation notification has arrived but not been applied
+  // yet, the cache is bypassed then
+  bool metaNotificationPending() const;
+
+  // the metadata cache, see also `EnableMetaCache`
+  std::shared_ptr<MetaCache> meta_cache_;
+  // the connection and the thread that receive the invalidation notifications
+  int meta_notifier_conn_ = -1;
+  std::thread meta_notifier_;
 };
 
 struct InstanceStatus {
@@ -563,6 +625,23 @@ struct InstanceStatus {
   const size_t memory_usage;
   /// The memory upper bound of this vineyard server, in bytes.
   const size_t memory_limit;
+  /// How many bytes have been spilled to disk.
+  const size_t spill_bytes;
+  /// How many bytes the spilled blobs take on disk, i.e., after compression.
+  const size_t spill_stored_bytes;
+  /// The throughput of writing spilled blobs to disk, in bytes per second,
+  /// i.e., over the time spent in spilling rather than the wall time.
+  const size_t spill_write_throughput;
+  /// How many allocations are blocked until cold blobs get spilled.
+  const size_t allocation_stall_count;
+  /// The total time allocations being blocked by spilling, in microseconds.
+  const size_t allocation_stall_us;
+  /// How many bytes of cold blobs have been moved by the compaction.
+  const size_t compaction_moved_bytes;
+  /// How many contiguous bytes have been freed by the compaction.
+  const size_t compaction_reclaimed_bytes;
+  /// How many bytes of the shared memory reside on each NUMA node.
+  const std::map<int, size_t> numa_usage;
   /// How many requests are deferred in the queue.
   const size_t deferred_requests;
   /// How many Client connects to this vineyard server.
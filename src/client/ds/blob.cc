@@ -246,7 +246,8 @@ std::shared_ptr<Object> BlobWriter::_Seal(Client& client) {
     VINEYARD_CHECK_OK(client.shm_->Mmap(
         payload_.store_fd, payload_.object_id, payload_.map_size,
         payload_.data_size, payload_.data_offset,
-        payload_.pointer - payload_.data_offset, false, true, &mmapped_ptr));
+        payload_.pointer - payload_.data_offset, false,
+        payload_.RequiresRealign(), &mmapped_ptr));
     dist = mmapped_ptr + payload_.data_offset;
   }
   auto buffer = arrow::Buffer::Wrap(dist, payload_.data_size);
@@ -58,7 +58,11 @@ bool const Object::IsPersist() const {
 bool const Object::IsGlobal() const { return meta_.IsGlobal(); }
 
 std::shared_ptr<Object> ObjectBuilder::Seal(Client& client) {
+  // the blobs of each (sub-)object are sealed with a single request, before
+  // the metadata of the object is created
+  Client::BatchGuard batch(client);
   auto object = this->_Seal(client);
+  VINEYARD_CHECK_OK(batch.End());
   VINEYARD_CHECK_OK(client.PostSeal(object->meta()));
   return object;
 }
@@ -20,6 +20,7 @@ limitations under the License.
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <string>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -39,6 +40,10 @@ size_t RemoteBlob::size() const { return allocated_size(); }
 
 size_t RemoteBlob::allocated_size() const { return size_; }
 
+size_t RemoteBlob::offset() const { return offset_; }
+
+size_t RemoteBlob::blob_size() const { return blob_size_; }
+
 const char* RemoteBlob::data() const {
   if (size_ == 0) {
     return nullptr;
@@ -62,6 +67,24 @@ const std::shared_ptr<arrow::Buffer>& RemoteBlob::Buffer() const {
   return buffer_;
 }
 
+Status RemoteBlob::Slice(const size_t offset, const size_t length,
+                         std::shared_ptr<RemoteBlob>& slice) const {
+  if (offset > size_ || length > size_ - offset) {
+    return Status::Invalid("The slice is out of the range of remote blob " +
+                           ObjectIDToString(id_) + ": offset = " +
+                           std::to_string(offset) + ", length = " +
+                           std::to_string(length) + ", size = " +
+                           std::to_string(size_));
+  }
+  slice = std::shared_ptr<RemoteBlob>(
+      new RemoteBlob(id_, instance_id_, 0, offset_ + offset, blob_size_));
+  slice->size_ = length;
+  if (length > 0) {
+    slice->buffer_ = arrow::SliceBuffer(this->Buffer(), offset, length);
+  }
+  return Status::OK();
+}
+
 void RemoteBlob::Dump() const {
 #ifndef NDEBUG
   std::stringstream ss;
@@ -81,7 +104,16 @@ void RemoteBlob::Dump() const {
 
 RemoteBlob::RemoteBlob(const ObjectID id, const InstanceID instance_id,
                        const size_t size)
-    : id_(id), instance_id_(instance_id), size_(size) {
+    : RemoteBlob(id, instance_id, size, 0, size) {}
+
+RemoteBlob::RemoteBlob(const ObjectID id, const InstanceID instance_id,
+                       const size_t size, const size_t offset,
+                       const size_t blob_size)
+    : id_(id),
+      instance_id_(instance_id),
+      size_(size),
+      offset_(offset),
+      blob_size_(blob_size) {
   if (size > 0) {
     auto r = arrow::AllocateBuffer(size_, arrow::default_memory_pool());
     VINEYARD_ASSERT(r.ok(), "Failed to create an arrow buffer");
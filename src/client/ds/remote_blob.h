@@ -71,6 +71,24 @@ class RemoteBlob {
    */
   size_t allocated_size() const;
 
+  /**
+   * @brief Get the offset of the data payload in the blob, which is non-zero
+   * only if the remote blob is a view over a sub-range of the blob, see also
+   * `RPCClient::GetRemoteBlobRange()`.
+   *
+   * @return The offset of the data payload in the blob.
+   */
+  size_t offset() const;
+
+  /**
+   * @brief Get the size of the whole blob in the vineyard server, which is
+   * the same as `allocated_size()` unless the remote blob is a view over a
+   * sub-range of the blob.
+   *
+   * @return The size of the whole blob.
+   */
+  size_t blob_size() const;
+
   /**
    * @brief Get the const data pointer of the data payload in the blob.
    *
@@ -86,6 +104,17 @@ class RemoteBlob {
    */
   const std::shared_ptr<arrow::Buffer>& Buffer() const;
 
+  /**
+   * @brief Get a view over `length` bytes starting from `offset` of the data
+   * payload, which shares the payload rather than copying it.
+   *
+   * @param offset The offset relative to the data payload of this remote blob.
+   * @param length The number of bytes of the view.
+   * @param slice The result remote blob.
+   */
+  Status Slice(const size_t offset, const size_t length,
+               std::shared_ptr<RemoteBlob>& slice) const;
+
   /**
    * @brief Dump the buffer for debugging.
    */
@@ -95,11 +124,17 @@ class RemoteBlob {
   RemoteBlob(const ObjectID id, const InstanceID instance_id,
              const size_t size);
 
+  RemoteBlob(const ObjectID id, const InstanceID instance_id,
+             const size_t size, const size_t offset, const size_t blob_size);
+
   char* mutable_data() const;
 
   ObjectID id_;
   InstanceID instance_id_;
   size_t size_ = 0;
+  // the sub-range of the blob that the data payload holds
+  size_t offset_ = 0;
+  size_t blob_size_ = 0;
   std::shared_ptr<arrow::Buffer> buffer_ = nullptr;
 
   friend class RPCClient;
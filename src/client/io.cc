@@ -20,10 +20,17 @@ limitations under the License.
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 namespace vineyard {
 
@@ -204,6 +211,208 @@ Status recv_bytes(int fd, void* data, size_t length) {
   return Status::OK();
 }
 
+Status recv_buffers(int fd,
+                    std::vector<std::pair<void*, size_t>> const& buffers) {
+  std::vector<struct iovec> iovs;
+  iovs.reserve(buffers.size());
+  for (auto const& buffer : buffers) {
+    if (buffer.second > 0) {
+      iovs.push_back({buffer.first, buffer.second});
+    }
+  }
+  size_t index = 0;
+  while (index < iovs.size()) {
+    int count = static_cast<int>(
+        std::min(iovs.size() - index, static_cast<size_t>(IOV_MAX)));
+    ssize_t nbytes = readv(fd, &iovs[index], count);
+    if (nbytes < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        continue;
+      }
+      return Status::IOError("Receive message failed: " +
+                             std::string(strerror(errno)));
+    } else if (nbytes == 0) {
+      return Status::IOError(
+          "Receive message failed: encountered unexpected EOF");
+    }
+    // skip the filled buffers, and advance the partially filled one
+    size_t bytes_left = nbytes;
+    while (bytes_left > 0 && bytes_left >= iovs[index].iov_len) {
+      bytes_left -= iovs[index].iov_len;
+      index += 1;
+    }
+    if (bytes_left > 0) {
+      iovs[index].iov_base =
+          static_cast<char*>(iovs[index].iov_base) + bytes_left;
+      iovs[index].iov_len -= bytes_left;
+    }
+  }
+  return Status::OK();
+}
+
+namespace {
+
+/**
+ * Encodes or decodes the frames of a `send_frames` or `recv_frames` call, one
+ * task at a time, on a thread that lives as long as the call. The thread is
+ * started by the first task, thus transfers that consist of tiny frames only
+ * never start it.
+ */
+class FrameWorker {
+ public:
+  FrameWorker() = default;
+
+  ~FrameWorker() {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+      }
+      cv_.notify_all();
+      thread_.join();
+    }
+  }
+
+  /**
+   * Runs the task on the worker, after the previous task finishes. The status
+   * of the previous task is returned by the next `Wait()`.
+   */
+  void Submit(std::function<Status()>&& task) {
+    if (!thread_.joinable()) {
+      thread_ = std::thread([this]() { run(); });
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !task_; });
+    task_ = std::move(task);
+    busy_ = true;
+    cv_.notify_all();
+  }
+
+  /**
+   * Waits the submitted task, if any, and returns the first error of the
+   * tasks.
+   */
+  Status Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !busy_; });
+    Status status = status_;
+    status_ = Status::OK();
+    return status;
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this]() { return stopped_ || task_; });
+      if (!task_) {
+        return;
+      }
+      std::function<Status()> task = std::move(task_);
+      task_ = nullptr;
+      lock.unlock();
+      Status status = task();
+      lock.lock();
+      if (status_.ok()) {
+        status_ = status;
+      }
+      busy_ = static_cast<bool>(task_);
+      cv_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::function<Status()> task_;
+  bool busy_ = false;
+  bool stopped_ = false;
+  Status status_;
+  std::thread thread_;
+};
+
+}  // namespace
+
+Status send_frames(int fd, std::shared_ptr<FrameCodec> const& codec,
+                   std::vector<std::pair<const void*, size_t>> const& buffers) {
+  std::vector<std::pair<const uint8_t*, size_t>> ranges;
+  ranges.reserve(buffers.size());
+  for (auto const& buffer : buffers) {
+    ranges.emplace_back(static_cast<const uint8_t*>(buffer.first),
+                        buffer.second);
+  }
+  FrameEncoder encoder(codec, std::move(ranges));
+  std::string frames[2];
+  size_t current = 0;
+  FrameWorker worker;
+  encoder.Next(frames[current]);
+  while (!frames[current].empty()) {
+    std::string& frame = frames[current];
+    std::string& next = frames[1 - current];
+    if (frame.size() < FrameCodec::kMinCompressSize) {
+      // not worthy to overlap with the send of tiny frames
+      RETURN_ON_ERROR(send_bytes(fd, frame.data(), frame.size()));
+      encoder.Next(next);
+    } else {
+      worker.Submit([&encoder, &next]() {
+        encoder.Next(next);
+        return Status::OK();
+      });
+      auto status = send_bytes(fd, frame.data(), frame.size());
+      VINEYARD_DISCARD(worker.Wait());
+      RETURN_ON_ERROR(status);
+    }
+    current = 1 - current;
+  }
+  return Status::OK();
+}
+
+Status recv_frames(int fd, std::shared_ptr<FrameCodec> const& codec,
+                   std::vector<std::pair<void*, size_t>> const& buffers) {
+  std::string stored[2];
+  size_t current = 0;
+  // decompresses the last compressed frame, from the other one of `stored`
+  FrameWorker worker;
+  for (auto const& buffer : buffers) {
+    uint8_t* data = static_cast<uint8_t*>(buffer.first);
+    size_t offset = 0;
+    while (offset < buffer.second) {
+      uint8_t header[FrameCodec::kHeaderSize];
+      size_t raw_size = 0, stored_size = 0;
+      auto status = recv_bytes(fd, header, FrameCodec::kHeaderSize);
+      if (status.ok()) {
+        status = codec->ReadHeader(header, buffer.second - offset, raw_size,
+                                   stored_size);
+      }
+      if (status.ok() && stored_size == raw_size) {
+        // raw frames are received into the buffer directly
+        status = recv_bytes(fd, data + offset, raw_size);
+      } else if (status.ok()) {
+        stored[current].resize(stored_size);
+        status = recv_bytes(fd, &stored[current][0], stored_size);
+        if (status.ok()) {
+          // the previous decoding still reads the other one of `stored`
+          status = worker.Wait();
+        }
+        if (status.ok()) {
+          const uint8_t* source =
+              reinterpret_cast<const uint8_t*>(stored[current].data());
+          uint8_t* target = data + offset;
+          worker.Submit([&codec, source, stored_size, target, raw_size]() {
+            return codec->Decode(source, stored_size, target, raw_size);
+          });
+          current = 1 - current;
+        }
+      }
+      if (!status.ok()) {
+        VINEYARD_DISCARD(worker.Wait());
+        return status;
+      }
+      offset += raw_size;
+    }
+  }
+  return worker.Wait();
+}
+
 Status recv_message(int fd, std::string& msg) {
   size_t length;
   RETURN_ON_ERROR(recv_bytes(fd, &length, sizeof(size_t)));
@@ -16,8 +16,12 @@ limitations under the License.
 #ifndef SRC_CLIENT_IO_H_
 #define SRC_CLIENT_IO_H_
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "common/util/compression.h"
 #include "common/util/status.h"
 
 namespace vineyard {
@@ -38,6 +42,27 @@ Status send_message(int fd, const std::string& msg);
 
 Status recv_bytes(int fd, void* data, size_t length);
 
+/**
+ * @brief Receive the bytes into the buffers one after another, with scatter
+ * reads, i.e., `readv`, which fill many small buffers with a single syscall.
+ */
+Status recv_buffers(int fd,
+                    std::vector<std::pair<void*, size_t>> const& buffers);
+
+/**
+ * @brief Send the buffers one after another as frames of `codec`, the next
+ * frame is compressed while the current one is being sent.
+ */
+Status send_frames(int fd, std::shared_ptr<FrameCodec> const& codec,
+                   std::vector<std::pair<const void*, size_t>> const& buffers);
+
+/**
+ * @brief Receive the frames of `codec` into the buffers one after another, a
+ * compressed frame is decompressed while the next one is being received.
+ */
+Status recv_frames(int fd, std::shared_ptr<FrameCodec> const& codec,
+                   std::vector<std::pair<void*, size_t>> const& buffers);
+
 Status recv_message(int fd, std::string& msg);
 
 Status check_fd(int fd);
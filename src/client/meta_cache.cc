@@ -0,0 +1,98 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "client/meta_cache.h"
+
+namespace vineyard {
+
+MetaCache::MetaCache(const size_t capacity) : capacity_(capacity) {}
+
+bool MetaCache::Get(const ObjectID id, json& tree) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto iter = index_.find(id);
+  if (receiving_ || iter == index_.end()) {
+    misses_ += 1;
+    return false;
+  }
+  hits_ += 1;
+  entries_.splice(entries_.begin(), entries_, iter->second);
+  tree = iter->second->second;
+  return true;
+}
+
+void MetaCache::Put(const ObjectID id, const json& tree,
+                    const uint64_t generation) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (closed_ || capacity_ == 0 || generation != generation_) {
+    return;
+  }
+  auto iter = index_.find(id);
+  if (iter != index_.end()) {
+    iter->second->second = tree;
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return;
+  }
+  if (entries_.size() >= capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(id, tree);
+  index_.emplace(id, entries_.begin());
+}
+
+uint64_t MetaCache::Generation() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return generation_;
+}
+
+void MetaCache::Receiving() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  receiving_ = true;
+}
+
+void MetaCache::Invalidate(const std::vector<ObjectID>& ids) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  receiving_ = false;
+  generation_ += 1;
+  for (auto const& id : ids) {
+    auto iter = index_.find(id);
+    if (iter != index_.end()) {
+      entries_.erase(iter->second);
+      index_.erase(iter);
+      invalidations_ += 1;
+    }
+  }
+}
+
+void MetaCache::Close() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  closed_ = true;
+  generation_ += 1;
+  entries_.clear();
+  index_.clear();
+}
+
+MetaCacheStats MetaCache::Stats() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  MetaCacheStats stats;
+  stats.capacity = capacity_;
+  stats.size = entries_.size();
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.invalidations = invalidations_;
+  return stats;
+}
+
+}  // namespace vineyard
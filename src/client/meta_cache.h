@@ -0,0 +1,97 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_CLIENT_META_CACHE_H_
+#define SRC_CLIENT_META_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/util/json.h"
+#include "common/util/uuid.h"
+
+namespace vineyard {
+
+/**
+ * @brief The counters of the metadata cache of a client.
+ */
+struct MetaCacheStats {
+  size_t capacity = 0;
+  size_t size = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // the entries that were dropped by the notifications from the server
+  uint64_t invalidations = 0;
+};
+
+/**
+ * @brief MetaCache is a bounded LRU cache of the metadata trees of objects,
+ * keyed by the object id.
+ *
+ * The metadata of sealed objects doesn't change, except being deleted or
+ * persisted, which the server notifies, see also `ClientBase::EnableMetaCache`.
+ * To not cache a tree that has been invalidated while it was being fetched,
+ * `Put` takes the `Generation()` before the fetch, and skips the tree if
+ * there are invalidations since then.
+ */
+class MetaCache {
+ public:
+  explicit MetaCache(const size_t capacity);
+
+  bool Get(const ObjectID id, json& tree);
+
+  void Put(const ObjectID id, const json& tree, const uint64_t generation);
+
+  uint64_t Generation() const;
+
+  /**
+   * @brief A notification is being received, the cache misses until it has
+   * been applied by `Invalidate`.
+   */
+  void Receiving();
+
+  void Invalidate(const std::vector<ObjectID>& ids);
+
+  /**
+   * @brief Drop all entries and stop caching, e.g., when the notifications
+   * from the server are lost.
+   */
+  void Close();
+
+  MetaCacheStats Stats() const;
+
+ private:
+  using entry_t = std::pair<ObjectID, json>;
+
+  const size_t capacity_;
+  // the most recently used entry is at the front
+  std::list<entry_t> entries_;
+  std::unordered_map<ObjectID, std::list<entry_t>::iterator> index_;
+  bool closed_ = false;
+  bool receiving_ = false;
+  uint64_t generation_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t invalidations_ = 0;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_CLIENT_META_CACHE_H_
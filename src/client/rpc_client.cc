@@ -15,13 +15,16 @@ limitations under the License.
 
 #include "client/rpc_client.h"
 
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "client/ds/object_factory.h"
@@ -66,17 +69,35 @@ Status RPCClient::Connect(const std::string& host, uint32_t port) {
   }
   rpc_endpoint_ = rpc_endpoint;
   RETURN_ON_ERROR(connect_rpc_socket_retry(host, port, vineyard_conn_));
+  std::string compression = read_env("VINEYARD_RPC_COMPRESSION");
+  if (!compression.empty() && compression != "none" &&
+      !FrameCodec::IsAvailable(compression)) {
+    std::clog << "[warn] Compression '" << compression
+              << "' is not supported, blobs will be sent without compression"
+              << std::endl;
+  }
+  if (!FrameCodec::IsAvailable(compression)) {
+    compression.clear();
+  }
   std::string message_out;
-  WriteRegisterRequest(message_out, StoreType::kDefault);
+  WriteRegisterRequest(message_out, StoreType::kDefault, -1, false, false,
+                       compression);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   std::string ipc_socket_value, rpc_endpoint_value;
-  bool store_match;
-  RETURN_ON_ERROR(ReadRegisterReply(message_in, ipc_socket_value,
-                                    rpc_endpoint_value, remote_instance_id_,
-                                    session_id_, server_version_, store_match));
+  bool store_match, binary_protocol, shm_channel;
+  RETURN_ON_ERROR(ReadRegisterReply(
+      message_in, ipc_socket_value, rpc_endpoint_value, remote_instance_id_,
+      session_id_, server_version_, store_match, binary_protocol, shm_channel,
+      compression));
   ipc_socket_ = ipc_socket_value;
+  codec_.reset();
+  if (!compression.empty()) {
+    std::unique_ptr<FrameCodec> codec;
+    RETURN_ON_ERROR(FrameCodec::Create(compression, codec));
+    codec_ = std::move(codec);
+  }
   connected_ = true;
 
   if (!compatible_server(server_version_)) {
@@ -212,6 +233,14 @@ std::vector<std::shared_ptr<Object>> RPCClient::ListObjects(
   return objects;
 }
 
+Status RPCClient::openConnection(int& conn) {
+  size_t pos = rpc_endpoint_.rfind(":");
+  RETURN_ON_ASSERT(pos != std::string::npos);
+  return connect_rpc_socket_retry(
+      rpc_endpoint_.substr(0, pos),
+      static_cast<uint32_t>(std::stoul(rpc_endpoint_.substr(pos + 1))), conn);
+}
+
 Status RPCClient::migrateBuffers(RPCClient& remote,
                                  const std::set<ObjectID> blobs,
                                  std::map<ObjectID, ObjectID>& results) {
@@ -220,8 +249,15 @@ Status RPCClient::migrateBuffers(RPCClient& remote,
   std::vector<Payload> payloads;
   std::vector<int> fd_sent;
 
+  // the frames are forwarded as they are when both sides negotiated the same
+  // codec, otherwise the content is forwarded raw
+  std::string compression = this->compression();
+  if (compression != remote.compression()) {
+    compression.clear();
+  }
+
   std::string message_out;
-  WriteGetRemoteBuffersRequest(blobs, false, message_out);
+  WriteGetRemoteBuffersRequest(blobs, false, compression, message_out);
   RETURN_ON_ERROR(remote.doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(remote.doRead(message_in));
@@ -231,22 +267,99 @@ Status RPCClient::migrateBuffers(RPCClient& remote,
                        std::to_string(payloads.size()) + " vs. " +
                        std::to_string(blobs.size()));
 
+  // forward the content from the remote server to the local server through
+  // a bounded chunk, rather than buffering each blob as a whole
+  constexpr size_t kChunkSize = 4 * 1024 * 1024;
+  std::unique_ptr<uint8_t[]> chunk;
   for (auto const& payload : payloads) {
     if (payload.data_size == 0) {
       results[payload.object_id] = EmptyBlobID();
       continue;
     }
-    auto remote_blob_writer = std::shared_ptr<RemoteBlobWriter>(
-        new RemoteBlobWriter(payload.data_size));
-    RETURN_ON_ERROR(recv_bytes(remote.vineyard_conn_,
-                               remote_blob_writer->data(), payload.data_size));
+    if (chunk == nullptr) {
+      chunk.reset(new uint8_t[kChunkSize]);
+    }
+    std::string message_out;
+    WriteCreateRemoteBufferRequest(payload.data_size, compression,
+                                   message_out);
+    RETURN_ON_ERROR(doWrite(message_out));
+    size_t offset = 0;
+    while (offset < static_cast<size_t>(payload.data_size)) {
+      size_t length = std::min(kChunkSize, payload.data_size - offset);
+      size_t forward = length;
+      if (!compression.empty()) {
+        // a frame carries at most `FrameCodec::kFrameSize` bytes
+        size_t stored_size = 0;
+        RETURN_ON_ERROR(recv_bytes(remote.vineyard_conn_, chunk.get(),
+                                   FrameCodec::kHeaderSize));
+        RETURN_ON_ERROR(codec_->ReadHeader(
+            chunk.get(), payload.data_size - offset, length, stored_size));
+        RETURN_ON_ERROR(recv_bytes(remote.vineyard_conn_,
+                                   chunk.get() + FrameCodec::kHeaderSize,
+                                   stored_size));
+        forward = FrameCodec::kHeaderSize + stored_size;
+      } else {
+        RETURN_ON_ERROR(
+            recv_bytes(remote.vineyard_conn_, chunk.get(), length));
+      }
+      RETURN_ON_ERROR(send_bytes(vineyard_conn_, chunk.get(), forward));
+      offset += length;
+    }
+    json message_in;
+    Payload created;
+    int fd_sent = -1;
     ObjectID target_blob_id = InvalidObjectID();
-    RETURN_ON_ERROR(this->CreateRemoteBlob(remote_blob_writer, target_blob_id));
+    RETURN_ON_ERROR(doRead(message_in));
+    RETURN_ON_ERROR(
+        ReadCreateBufferReply(message_in, target_blob_id, created, fd_sent));
     results[payload.object_id] = target_blob_id;
   }
   return Status::OK();
 }
 
+Status RPCClient::getBufferChunks(std::vector<ObjectID> const& ids,
+                                  std::vector<BufferChunk> const& chunks,
+                                  std::vector<void*> const& targets,
+                                  const bool unsafe,
+                                  std::vector<Payload>& payloads) {
+  ENSURE_CONNECTED(this);
+  RETURN_ON_ASSERT(chunks.size() == targets.size(),
+                   "Expects a target for each chunk");
+  RETURN_ON_ERROR(requestBufferChunks(ids, chunks, unsafe, payloads));
+  return recvBufferChunks(chunks, targets);
+}
+
+Status RPCClient::requestBufferChunks(std::vector<ObjectID> const& ids,
+                                      std::vector<BufferChunk> const& chunks,
+                                      const bool unsafe,
+                                      std::vector<Payload>& payloads) {
+  ENSURE_CONNECTED(this);
+  std::string message_out;
+  WriteGetRemoteBufferChunksRequest(ids, chunks, unsafe, compression(),
+                                    message_out);
+  RETURN_ON_ERROR(doWrite(message_out));
+  json message_in;
+  RETURN_ON_ERROR(doRead(message_in));
+  return ReadGetRemoteBufferChunksReply(message_in, payloads);
+}
+
+Status RPCClient::recvBufferChunks(std::vector<BufferChunk> const& chunks,
+                                   std::vector<void*> const& targets) {
+  std::vector<std::pair<void*, size_t>> buffers;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    buffers.emplace_back(targets[i], chunks[i].size);
+  }
+  return recvBuffers(buffers);
+}
+
+Status RPCClient::recvBuffers(
+    std::vector<std::pair<void*, size_t>> const& buffers) {
+  if (codec_ != nullptr) {
+    return recv_frames(vineyard_conn_, codec_, buffers);
+  }
+  return recv_buffers(vineyard_conn_, buffers);
+}
+
 Status RPCClient::CreateRemoteBlob(
     std::shared_ptr<RemoteBlobWriter> const& buffer, ObjectID& id) {
   ENSURE_CONNECTED(this);
@@ -256,10 +369,15 @@ Status RPCClient::CreateRemoteBlob(
   int fd_sent = -1;
 
   std::string message_out;
-  WriteCreateRemoteBufferRequest(buffer->size(), message_out);
+  WriteCreateRemoteBufferRequest(buffer->size(), compression(), message_out);
   RETURN_ON_ERROR(doWrite(message_out));
   // send the actual payload
-  RETURN_ON_ERROR(send_bytes(vineyard_conn_, buffer->data(), buffer->size()));
+  if (codec_ != nullptr) {
+    RETURN_ON_ERROR(send_frames(vineyard_conn_, codec_,
+                                {{buffer->data(), buffer->size()}}));
+  } else {
+    RETURN_ON_ERROR(send_bytes(vineyard_conn_, buffer->data(), buffer->size()));
+  }
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
   RETURN_ON_ERROR(ReadCreateBufferReply(message_in, id, payload, fd_sent));
@@ -282,7 +400,8 @@ Status RPCClient::GetRemoteBlob(const ObjectID& id, const bool unsafe,
   std::vector<int> fd_sent;
 
   std::string message_out;
-  WriteGetRemoteBuffersRequest(std::set<ObjectID>{id}, unsafe, message_out);
+  WriteGetRemoteBuffersRequest(std::set<ObjectID>{id}, unsafe, compression(),
+                               message_out);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
@@ -292,8 +411,8 @@ Status RPCClient::GetRemoteBlob(const ObjectID& id, const bool unsafe,
   // read the actual payload
   buffer = std::shared_ptr<RemoteBlob>(new RemoteBlob(
       payloads[0].object_id, remote_instance_id_, payloads[0].data_size));
-  RETURN_ON_ERROR(recv_bytes(vineyard_conn_, buffer->mutable_data(),
-                             payloads[0].data_size));
+  RETURN_ON_ERROR(
+      recvBuffers({{buffer->mutable_data(), payloads[0].data_size}}));
   return Status::OK();
 }
 Status RPCClient::GetRemoteBlobs(
@@ -312,7 +431,7 @@ Status RPCClient::GetRemoteBlobs(
   std::vector<int> fd_sent;
 
   std::string message_out;
-  WriteGetRemoteBuffersRequest(id_set, unsafe, message_out);
+  WriteGetRemoteBuffersRequest(id_set, unsafe, compression(), message_out);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
@@ -322,14 +441,16 @@ Status RPCClient::GetRemoteBlobs(
                        std::to_string(payloads.size()) + " vs. " +
                        std::to_string(id_set.size()));
 
+  // the server sends the blobs back to back, receive them with scatter reads
   std::unordered_map<ObjectID, std::shared_ptr<RemoteBlob>> id_payload_map;
+  std::vector<std::pair<void*, size_t>> buffers;
   for (auto const& payload : payloads) {
     auto remote_blob = std::shared_ptr<RemoteBlob>(new RemoteBlob(
         payload.object_id, remote_instance_id_, payload.data_size));
-    RETURN_ON_ERROR(recv_bytes(vineyard_conn_, remote_blob->mutable_data(),
-                               payload.data_size));
+    buffers.emplace_back(remote_blob->mutable_data(), payload.data_size);
     id_payload_map[payload.object_id] = remote_blob;
   }
+  RETURN_ON_ERROR(recvBuffers(buffers));
   // clear the result container
   remote_blobs.clear();
   for (auto const& id : ids) {
@@ -343,4 +464,74 @@ Status RPCClient::GetRemoteBlobs(
   return Status::OK();
 }
 
+Status RPCClient::GetRemoteBlobRange(const ObjectID& id, const size_t offset,
+                                     const size_t length,
+                                     std::shared_ptr<RemoteBlob>& buffer) {
+  return this->GetRemoteBlobRange(id, offset, length, false, buffer);
+}
+
+Status RPCClient::GetRemoteBlobRange(const ObjectID& id, const size_t offset,
+                                     const size_t length, const bool unsafe,
+                                     std::shared_ptr<RemoteBlob>& buffer) {
+  std::vector<std::shared_ptr<RemoteBlob>> remote_blobs;
+  RETURN_ON_ERROR(this->GetRemoteBlobRanges({BufferChunk{id, offset, length}},
+                                            unsafe, remote_blobs));
+  buffer = remote_blobs[0];
+  return Status::OK();
+}
+
+Status RPCClient::GetRemoteBlobRanges(
+    std::vector<BufferChunk> const& ranges,
+    std::vector<std::shared_ptr<RemoteBlob>>& remote_blobs) {
+  return this->GetRemoteBlobRanges(ranges, false, remote_blobs);
+}
+
+Status RPCClient::GetRemoteBlobRanges(
+    std::vector<BufferChunk> const& ranges, const bool unsafe,
+    std::vector<std::shared_ptr<RemoteBlob>>& remote_blobs) {
+  ENSURE_CONNECTED(this);
+
+  // the payloads of the blobs tell the sizes of the whole blobs
+  std::vector<ObjectID> ids;
+  std::unordered_set<ObjectID> id_set;
+  for (auto const& range : ranges) {
+    if (id_set.emplace(range.id).second) {
+      ids.emplace_back(range.id);
+    }
+  }
+  std::vector<Payload> payloads;
+  RETURN_ON_ERROR(requestBufferChunks(ids, ranges, unsafe, payloads));
+  RETURN_ON_ASSERT(payloads.size() == ids.size(),
+                   "The result size doesn't match with the requested sizes: " +
+                       std::to_string(payloads.size()) + " vs. " +
+                       std::to_string(ids.size()));
+  std::unordered_map<ObjectID, size_t> blob_sizes;
+  for (auto const& payload : payloads) {
+    blob_sizes[payload.object_id] = payload.data_size;
+  }
+  // the ranges are validated before allocating the buffers for them
+  for (auto const& range : ranges) {
+    auto iter = blob_sizes.find(range.id);
+    if (iter == blob_sizes.end() || range.offset > iter->second ||
+        range.size > iter->second - range.offset) {
+      return Status::Invalid("The chunk is out of the range of blob " +
+                             ObjectIDToString(range.id) + ": offset = " +
+                             std::to_string(range.offset) +
+                             ", size = " + std::to_string(range.size));
+    }
+  }
+  std::vector<std::shared_ptr<RemoteBlob>> buffers;
+  std::vector<void*> targets;
+  for (auto const& range : ranges) {
+    auto remote_blob = std::shared_ptr<RemoteBlob>(
+        new RemoteBlob(range.id, remote_instance_id_, range.size,
+                       range.offset, blob_sizes[range.id]));
+    targets.emplace_back(remote_blob->mutable_data());
+    buffers.emplace_back(remote_blob);
+  }
+  RETURN_ON_ERROR(recvBufferChunks(ranges, targets));
+  remote_blobs = std::move(buffers);
+  return Status::OK();
+}
+
 }  // namespace vineyard
@@ -20,12 +20,16 @@ limitations under the License.
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "client/client_base.h"
 #include "client/ds/i_object.h"
 #include "client/ds/object_meta.h"
 #include "client/ds/remote_blob.h"
+#include "common/memory/payload.h"
+#include "common/util/compression.h"
+#include "common/util/protocols.h"
 #include "common/util/status.h"
 #include "common/util/uuid.h"
 
@@ -42,6 +46,10 @@ class RPCClient final : public ClientBase {
    * @brief Connect to vineyard using the TCP endpoint specified by
    *        the environment variable `VINEYARD_RPC_ENDPOINT`.
    *
+   * The content of blobs is compressed on the wire with the codec specified
+   * by the environment variable `VINEYARD_RPC_COMPRESSION`, i.e., "lz4" or
+   * "zstd", if the server supports it as well.
+   *
    * @return Status that indicates whether the connect has succeeded.
    */
   Status Connect();
@@ -231,6 +239,14 @@ class RPCClient final : public ClientBase {
     return remote_instance_id_;
   }
 
+  /**
+   * @brief The codec negotiated with the server that compresses the content
+   * of blobs on the wire, or empty if the content is sent raw.
+   */
+  const std::string compression() const {
+    return codec_ == nullptr ? std::string() : codec_->name();
+  }
+
   Status CreateRemoteBlob(std::shared_ptr<RemoteBlobWriter> const& buffer,
                           ObjectID& id);
 
@@ -268,12 +284,81 @@ class RPCClient final : public ClientBase {
   Status GetRemoteBlobs(std::vector<ObjectID> const& ids, const bool unsafe,
                         std::vector<std::shared_ptr<RemoteBlob>>& remote_blobs);
 
+  /**
+   * @brief Get `length` bytes starting from `offset` of the remote blob,
+   * rather than the whole blob, using the RPC socket.
+   *
+   * The result remote blob is a view over the sub-range, see also
+   * `RemoteBlob::offset()` and `RemoteBlob::blob_size()`. Requesting a range
+   * that exceeds the blob is an error.
+   */
+  Status GetRemoteBlobRange(const ObjectID& id, const size_t offset,
+                            const size_t length,
+                            std::shared_ptr<RemoteBlob>& buffer);
+
+  /**
+   * @brief Get a sub-range of the remote blob, and optionally bypass the
+   * "seal" check.
+   */
+  Status GetRemoteBlobRange(const ObjectID& id, const size_t offset,
+                            const size_t length, const bool unsafe,
+                            std::shared_ptr<RemoteBlob>& buffer);
+
+  /**
+   * @brief Get many sub-ranges of remote blobs with a single request, the
+   * i-th remote blob in `remote_blobs` is the view over `ranges[i]`.
+   */
+  Status GetRemoteBlobRanges(
+      std::vector<BufferChunk> const& ranges,
+      std::vector<std::shared_ptr<RemoteBlob>>& remote_blobs);
+
+  /**
+   * @brief Get many sub-ranges of remote blobs with a single request, and
+   * optionally bypass the "seal" check.
+   */
+  Status GetRemoteBlobRanges(
+      std::vector<BufferChunk> const& ranges, const bool unsafe,
+      std::vector<std::shared_ptr<RemoteBlob>>& remote_blobs);
+
  private:
   InstanceID remote_instance_id_;
 
+  // compresses the content of blobs on the wire if not null
+  std::shared_ptr<FrameCodec> codec_;
+
   Status migrateBuffers(RPCClient& remote, const std::set<ObjectID> blobs,
                         std::map<ObjectID, ObjectID>& results) override;
 
+  Status openConnection(int& conn) override;
+
+  /**
+   * @brief Get the payloads of blobs `ids`, and receive the content of
+   * `chunks` into `targets` respectively.
+   */
+  Status getBufferChunks(std::vector<ObjectID> const& ids,
+                         std::vector<BufferChunk> const& chunks,
+                         std::vector<void*> const& targets, const bool unsafe,
+                         std::vector<Payload>& payloads);
+
+  /**
+   * @brief Get the payloads of blobs `ids`, the content of `chunks` follows
+   * the reply and must be received by `recvBufferChunks()`.
+   */
+  Status requestBufferChunks(std::vector<ObjectID> const& ids,
+                             std::vector<BufferChunk> const& chunks,
+                             const bool unsafe, std::vector<Payload>& payloads);
+
+  /**
+   * @brief Receive the content of `chunks` into `targets` respectively.
+   */
+  Status recvBufferChunks(std::vector<BufferChunk> const& chunks,
+                          std::vector<void*> const& targets);
+
+  /**
+   * @brief Receive the content of blobs sent by the server back to back.
+   */
+  Status recvBuffers(std::vector<std::pair<void*, size_t>> const& buffers);
+
   friend class Client;
 };
 
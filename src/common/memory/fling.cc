@@ -28,7 +28,11 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
 #include <unistd.h>
 
 #include <iostream>
@@ -152,3 +156,17 @@ int recv_fd(int conn) {
 
   return found_fd;
 }
+
+int64_t file_page_size(int fd) {
+#ifdef __linux__
+  const int64_t kHugetlbfsMagic = 0x958458f6;
+  struct statfs fs;
+  struct stat st;
+  if (fstatfs(fd, &fs) == 0 &&
+      static_cast<int64_t>(fs.f_type) == kHugetlbfsMagic &&
+      fstat(fd, &st) == 0 && st.st_blksize > 0) {
+    return st.st_blksize;
+  }
+#endif
+  return sysconf(_SC_PAGESIZE);
+}
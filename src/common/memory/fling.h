@@ -36,6 +36,7 @@
 #ifndef SRC_COMMON_MEMORY_FLING_H_
 #define SRC_COMMON_MEMORY_FLING_H_
 
+#include <stdint.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 
@@ -65,6 +66,14 @@ int send_fd(int conn, int fd);
 // @return File descriptor or a value < 0 on failure.
 int recv_fd(int conn);
 
+// The page size of the memory file behind the file descriptor, i.e., the huge
+// page size for files on hugetlbfs, the mapped length of which must be
+// aligned to it.
+//
+// @param fd File descriptor of the memory file.
+// @return The page size in bytes.
+int64_t file_page_size(int fd);
+
 #ifdef __cplusplus
 }
 #endif
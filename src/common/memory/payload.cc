@@ -36,6 +36,7 @@ void Payload::ToJSON(json& tree) const {
   tree["is_sealed"] = is_sealed;
   tree["is_owner"] = is_owner;
   tree["is_gpu"] = is_gpu;
+  tree["kind"] = static_cast<int>(kind);
 }
 
 void Payload::FromJSON(const json& tree) {
@@ -48,6 +49,8 @@ void Payload::FromJSON(const json& tree) {
   is_sealed = tree.value("is_sealed", false);
   is_owner = tree.value("is_owner", true);
   is_gpu = tree.value("is_gpu", false);
+  kind = static_cast<Kind>(
+      tree.value("kind", static_cast<int>(Kind::kMalloc)));
 }
 
 Payload Payload::FromJSON1(const json& tree) {
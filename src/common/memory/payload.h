@@ -118,6 +118,13 @@ struct Payload {
 
   inline bool IsGPU() { return is_gpu; }
 
+  /**
+   * The map size of the arenas of the allocator includes a gap that the
+   * client trims before mapping, see also `MmapEntry`, while the files
+   * mapped from disk are mapped as they are.
+   */
+  inline bool RequiresRealign() const { return kind != Kind::kDiskMMap; }
+
   json ToJSON() const;
 
   void ToJSON(json& tree) const;
@@ -0,0 +1,324 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "common/memory/shm_channel.h"
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <string>
+
+namespace vineyard {
+
+namespace {
+
+// How long the client spins on the reply ring before sleeping, which covers
+// the processing of blob commands in the server. The spinning is bounded by
+// time rather than by iterations, as the latency of the pause instruction
+// differs by an order of magnitude across CPUs.
+constexpr std::chrono::microseconds kReplySpinTime(50);
+
+// How long the server spins on the request ring after processing requests,
+// which covers the gap between the back-to-back requests of a client. The
+// server spins on the IO thread, thus it is kept short.
+constexpr std::chrono::microseconds kRequestSpinTime(10);
+
+constexpr size_t kHeaderSize = 4096;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+inline size_t align8(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// The header of a ring in the shared memory, the positions grows monotonically
+// and the offset in the ring is the position modulo the capacity.
+struct RingHeader {
+  // the position to read, written by the consumer
+  alignas(64) std::atomic<uint64_t> head;
+  // the position to write, written by the producer
+  alignas(64) std::atomic<uint64_t> tail;
+  // whether the consumer sleeps, or is going to sleep, on the eventfd
+  alignas(64) std::atomic<uint32_t> sleeping;
+};
+
+static_assert(2 * sizeof(RingHeader) <= kHeaderSize,
+              "The ring headers must fit in the header page");
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "The atomics in shared memory must be lock-free");
+static_assert((ShmChannel::kCapacity & (ShmChannel::kCapacity - 1)) == 0,
+              "The capacity of rings must be a power of two");
+
+}  // namespace
+
+constexpr size_t ShmChannel::kCapacity;
+constexpr size_t ShmChannel::kMaxRequestSize;
+
+struct ShmChannel::Ring {
+  RingHeader* header;
+  uint8_t* data;
+  int event;
+
+  void copy_in(uint64_t position, const void* source, size_t size) {
+    size_t offset = position & (kCapacity - 1);
+    size_t first = std::min(size, kCapacity - offset);
+    memcpy(data + offset, source, first);
+    memcpy(data, static_cast<const uint8_t*>(source) + first, size - first);
+  }
+
+  void copy_out(uint64_t position, void* target, size_t size) const {
+    size_t offset = position & (kCapacity - 1);
+    size_t first = std::min(size, kCapacity - offset);
+    memcpy(target, data + offset, first);
+    memcpy(static_cast<uint8_t*>(target) + first, data, size - first);
+  }
+
+  Status Push(const std::string& message) {
+    uint64_t tail = header->tail.load(std::memory_order_relaxed);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    uint64_t length = message.size();
+    size_t required = sizeof(uint64_t) + align8(length);
+    if (tail - head > kCapacity || required > kCapacity - (tail - head)) {
+      return Status::NotEnoughMemory(
+          "No enough space in the shared memory channel for a message of " +
+          std::to_string(length) + " bytes");
+    }
+    copy_in(tail, &length, sizeof(uint64_t));
+    copy_in(tail + sizeof(uint64_t), message.data(), length);
+    // pairs with the store of `sleeping` in `Wait()`: either the consumer
+    // sees the message, or the producer sees the consumer sleeping.
+    header->tail.store(tail + required, std::memory_order_seq_cst);
+    if (header->sleeping.load(std::memory_order_seq_cst)) {
+#if defined(__linux__)
+      if (eventfd_write(event, 1) != 0) {
+        return Status::IOError("Failed to wake up the shared memory channel: " +
+                               std::string(strerror(errno)));
+      }
+#endif
+    }
+    return Status::OK();
+  }
+
+  Status Pop(std::string& message) {
+    message.clear();
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    uint64_t tail = header->tail.load(std::memory_order_acquire);
+    if (head == tail) {
+      return Status::OK();
+    }
+    // the peer may be malicious, validate the positions and the length
+    uint64_t length = 0;
+    if (tail - head < sizeof(uint64_t) || tail - head > kCapacity) {
+      return Status::Invalid("Corrupted shared memory channel");
+    }
+    copy_out(head, &length, sizeof(uint64_t));
+    if (length == 0 || length > tail - head - sizeof(uint64_t)) {
+      return Status::Invalid("Corrupted message in the shared memory channel");
+    }
+    message.resize(length);
+    copy_out(head + sizeof(uint64_t), &message[0], length);
+    header->head.store(head + sizeof(uint64_t) + align8(length),
+                       std::memory_order_release);
+    return Status::OK();
+  }
+
+  // spin for at most `duration` until a message arrives, the message is
+  // empty if none arrives
+  Status Spin(std::chrono::microseconds duration, std::string& message) {
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    for (int spin = 1;; ++spin) {
+      RETURN_ON_ERROR(Pop(message));
+      if (!message.empty()) {
+        return Status::OK();
+      }
+      if (spin % 64 == 0 && std::chrono::steady_clock::now() >= deadline) {
+        return Status::OK();
+      }
+      cpu_relax();
+    }
+  }
+
+  // spin as an awake consumer, thus the producer doesn't signal the eventfd,
+  // and mark the consumer sleeping again if no message arrives
+  Status Poll(std::chrono::microseconds duration, std::string& message) {
+    header->sleeping.store(0, std::memory_order_seq_cst);
+    auto status = Spin(duration, message);
+    if (!status.ok() || !message.empty()) {
+      return status;
+    }
+    header->sleeping.store(1, std::memory_order_seq_cst);
+    // the message pushed before the store above is not signaled
+    return Pop(message);
+  }
+
+  Status Wait(int conn, std::string& message) {
+    RETURN_ON_ERROR(Spin(kReplySpinTime, message));
+    if (!message.empty()) {
+      return Status::OK();
+    }
+    header->sleeping.store(1, std::memory_order_seq_cst);
+    while (true) {
+      auto status = Pop(message);
+      if (!status.ok() || !message.empty()) {
+        header->sleeping.store(0, std::memory_order_relaxed);
+        return status;
+      }
+      // a hung up socket means the server has gone, no events are required
+      // for the socket as POLLHUP and POLLERR are always reported.
+      struct pollfd fds[2] = {{event, POLLIN, 0}, {conn, 0, 0}};
+      if (poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        header->sleeping.store(0, std::memory_order_relaxed);
+        return Status::IOError(
+            "Failed to wait for the shared memory channel: " +
+            std::string(strerror(errno)));
+      }
+      if (fds[1].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+        header->sleeping.store(0, std::memory_order_relaxed);
+        return Status::ConnectionError(
+            "The connection to vineyard server has been closed");
+      }
+#if defined(__linux__)
+      if (fds[0].revents & POLLIN) {
+        eventfd_t value;
+        // the eventfd is non-blocking, and could have been drained already
+        (void) eventfd_read(event, &value);
+      }
+#endif
+    }
+  }
+};
+
+ShmChannel::ShmChannel(uint8_t* base, int fd, int request_event,
+                       int reply_event)
+    : base_(base),
+      fd_(fd),
+      request_event_(request_event),
+      reply_event_(reply_event) {}
+
+ShmChannel::~ShmChannel() {
+  if (base_ != nullptr) {
+    munmap(base_, MappedSize());
+  }
+  for (int fd : {fd_, request_event_, reply_event_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+size_t ShmChannel::MappedSize() { return kHeaderSize + 2 * kCapacity; }
+
+Status ShmChannel::Create(int fd, std::unique_ptr<ShmChannel>& channel) {
+#if defined(__linux__)
+  void* base = mmap(nullptr, MappedSize(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return Status::IOError("Failed to mmap the shared memory channel: " +
+                           std::string(strerror(errno)));
+  }
+  int request_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  int reply_event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  channel.reset(new ShmChannel(static_cast<uint8_t*>(base), fd, request_event,
+                               reply_event));
+  if (request_event == -1 || reply_event == -1) {
+    channel.reset();
+    return Status::IOError("Failed to create the eventfd: " +
+                           std::string(strerror(errno)));
+  }
+  auto request_header = channel->request_ring().header;
+  auto reply_header = channel->reply_ring().header;
+  new (request_header) RingHeader();
+  new (reply_header) RingHeader();
+  // the server waits for the first request on the eventfd
+  request_header->sleeping.store(1);
+  return Status::OK();
+#else
+  close(fd);
+  return Status::NotImplemented(
+      "The shared memory channel is only supported on Linux");
+#endif
+}
+
+Status ShmChannel::Open(int fd, int request_event, int reply_event,
+                        std::unique_ptr<ShmChannel>& channel) {
+#if defined(__linux__)
+  void* base = mmap(nullptr, MappedSize(), PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, 0);
+  if (base == MAP_FAILED) {
+    base = nullptr;
+  }
+  channel.reset(new ShmChannel(static_cast<uint8_t*>(base), fd, request_event,
+                               reply_event));
+  if (base == nullptr) {
+    channel.reset();
+    return Status::IOError("Failed to mmap the shared memory channel: " +
+                           std::string(strerror(errno)));
+  }
+  return Status::OK();
+#else
+  for (int event : {fd, request_event, reply_event}) {
+    close(event);
+  }
+  return Status::NotImplemented(
+      "The shared memory channel is only supported on Linux");
+#endif
+}
+
+Status ShmChannel::SendRequest(const std::string& message) {
+  return request_ring().Push(message);
+}
+
+Status ShmChannel::ReceiveReply(int conn, std::string& message) {
+  return reply_ring().Wait(conn, message);
+}
+
+Status ShmChannel::ReceiveRequest(std::string& message) {
+  return request_ring().Poll(kRequestSpinTime, message);
+}
+
+Status ShmChannel::SendReply(const std::string& message) {
+  return reply_ring().Push(message);
+}
+
+ShmChannel::Ring ShmChannel::request_ring() {
+  return Ring{reinterpret_cast<RingHeader*>(base_), base_ + kHeaderSize,
+              request_event_};
+}
+
+ShmChannel::Ring ShmChannel::reply_ring() {
+  return Ring{reinterpret_cast<RingHeader*>(base_) + 1,
+              base_ + kHeaderSize + kCapacity, reply_event_};
+}
+
+}  // namespace vineyard
@@ -0,0 +1,130 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_COMMON_MEMORY_SHM_CHANNEL_H_
+#define SRC_COMMON_MEMORY_SHM_CHANNEL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/util/status.h"
+
+namespace vineyard {
+
+/**
+ * @brief ShmChannel is a control channel between an IPC client and the server
+ * on the same host, made of two single-producer single-consumer rings in a
+ * shared memory segment: one for the requests and one for the replies.
+ *
+ * The segment is created by the server and sent to the client over the UNIX
+ * domain socket after the register reply, along with two eventfds that wake
+ * up the consumer of each ring. The client spins on the reply ring for a short
+ * while before sleeping on the eventfd, and so does the server on the request
+ * ring after processing requests. The producer of a ring only signals the
+ * eventfd when its consumer sleeps.
+ *
+ * The channel carries the binary encoded blob commands only, file descriptors
+ * are still sent over the UNIX domain socket, before the reply that refers to
+ * them. Requests must be sent one at a time, i.e., the reply of a request must
+ * be received before sending the next request.
+ *
+ * The channel is only available on Linux.
+ */
+class ShmChannel {
+ public:
+  // the capacity of each ring, in bytes
+  static constexpr size_t kCapacity = 256 * 1024;
+
+  // The largest request the channel accepts. The replies of blob commands are
+  // at most nine times as large as the requests, thus they always fit in the
+  // ring, larger requests should be sent over the socket.
+  static constexpr size_t kMaxRequestSize = kCapacity / 16;
+
+  ~ShmChannel();
+
+  /**
+   * @brief The size of the shared memory segment that backs the channel.
+   */
+  static size_t MappedSize();
+
+  /**
+   * @brief Map the channel at the server side from the shared memory file `fd`
+   * of `MappedSize()` bytes, and create the eventfds. The channel takes the
+   * ownership of `fd`.
+   */
+  static Status Create(int fd, std::unique_ptr<ShmChannel>& channel);
+
+  /**
+   * @brief Map the channel at the client side from the file descriptors
+   * received from the server. The channel takes the ownership of the fds.
+   */
+  static Status Open(int fd, int request_event, int reply_event,
+                     std::unique_ptr<ShmChannel>& channel);
+
+  int fd() const { return fd_; }
+
+  int request_event() const { return request_event_; }
+
+  int reply_event() const { return reply_event_; }
+
+  /**
+   * @brief Send a request to the server, used by the client.
+   */
+  Status SendRequest(const std::string& message);
+
+  /**
+   * @brief Wait for the reply of the last request, used by the client.
+   *
+   * @param conn The socket connected to the server, the wait fails when the
+   * socket is hung up.
+   */
+  Status ReceiveReply(int conn, std::string& message);
+
+  /**
+   * @brief Receive a request from the client, used by the server. The server
+   * spins on the request ring for a short while, during which the client
+   * doesn't signal the eventfd for its requests. The message is empty if no
+   * request arrives, and then the server is expected to wait on the eventfd.
+   */
+  Status ReceiveRequest(std::string& message);
+
+  /**
+   * @brief Send a reply to the client, used by the server.
+   */
+  Status SendReply(const std::string& message);
+
+ private:
+  struct Ring;
+
+  ShmChannel(uint8_t* base, int fd, int request_event, int reply_event);
+
+  Ring request_ring();
+
+  Ring reply_ring();
+
+  uint8_t* base_;
+  int fd_;
+  // wakes up the server when requests arrive
+  int request_event_;
+  // wakes up the client when replies arrive
+  int reply_event_;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_COMMON_MEMORY_SHM_CHANNEL_H_
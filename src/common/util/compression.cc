@@ -0,0 +1,167 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "common/util/compression.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "arrow/util/compression.h"
+
+namespace vineyard {
+
+namespace {
+
+// the size of the sample that decides whether a buffer is compressed
+constexpr size_t kSampleSize = 16 * 1024;
+
+// buffers whose sample doesn't shrink below this ratio are sent raw
+constexpr double kMaxSampleRatio = 0.9;
+
+bool codec_type(const std::string& name, arrow::Compression::type& type) {
+  if (name == "lz4") {
+    type = arrow::Compression::LZ4_FRAME;
+    return true;
+  }
+  if (name == "zstd") {
+    type = arrow::Compression::ZSTD;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+constexpr size_t FrameCodec::kFrameSize;
+constexpr size_t FrameCodec::kHeaderSize;
+constexpr size_t FrameCodec::kMinCompressSize;
+
+FrameCodec::FrameCodec(const std::string& name,
+                       std::unique_ptr<arrow::util::Codec> codec)
+    : name_(name), codec_(std::move(codec)) {}
+
+FrameCodec::~FrameCodec() = default;
+
+bool FrameCodec::IsAvailable(const std::string& name) {
+  arrow::Compression::type type;
+  return codec_type(name, type) && arrow::util::Codec::IsAvailable(type);
+}
+
+Status FrameCodec::Create(const std::string& name,
+                          std::unique_ptr<FrameCodec>& codec) {
+  arrow::Compression::type type;
+  if (!codec_type(name, type)) {
+    return Status::Invalid("Unknown compression codec: '" + name + "'");
+  }
+  if (!arrow::util::Codec::IsAvailable(type)) {
+    return Status::NotImplemented("Compression codec '" + name +
+                                  "' is not supported by the arrow library");
+  }
+  auto r = arrow::util::Codec::Create(type);
+  if (!r.ok()) {
+    return Status::ArrowError(r.status());
+  }
+  codec.reset(new FrameCodec(name, std::move(r).ValueOrDie()));
+  return Status::OK();
+}
+
+bool FrameCodec::Compressible(const uint8_t* data, size_t size) const {
+  if (size < kMinCompressSize) {
+    return false;
+  }
+  // the middle of the buffer is less likely to be a header or padding
+  size_t sample_size = std::min(size, kSampleSize);
+  const uint8_t* sample = data + (size - sample_size) / 2;
+  int64_t bound = codec_->MaxCompressedLen(sample_size, sample);
+  std::unique_ptr<uint8_t[]> compressed(new uint8_t[bound]);
+  auto r = codec_->Compress(sample_size, sample, bound, compressed.get());
+  return r.ok() && static_cast<double>(*r) < sample_size * kMaxSampleRatio;
+}
+
+void FrameCodec::Encode(const uint8_t* data, size_t size, const bool compress,
+                        std::string& frame) const {
+  uint64_t header[2] = {size, size};
+  if (compress) {
+    int64_t bound = codec_->MaxCompressedLen(size, data);
+    frame.resize(kHeaderSize + bound);
+    uint8_t* stored = reinterpret_cast<uint8_t*>(&frame[kHeaderSize]);
+    auto r = codec_->Compress(size, data, bound, stored);
+    // keep the raw content if it cannot be compressed
+    if (r.ok() && static_cast<size_t>(*r) < size) {
+      header[1] = static_cast<uint64_t>(*r);
+      frame.resize(kHeaderSize + header[1]);
+      memcpy(&frame[0], header, kHeaderSize);
+      return;
+    }
+  }
+  frame.resize(kHeaderSize + size);
+  memcpy(&frame[0], header, kHeaderSize);
+  memcpy(&frame[kHeaderSize], data, size);
+}
+
+Status FrameCodec::Decode(const uint8_t* stored, size_t stored_size,
+                          uint8_t* data, size_t size) const {
+  auto r = codec_->Decompress(stored_size, stored, size, data);
+  if (!r.ok()) {
+    return Status::ArrowError(r.status());
+  }
+  if (static_cast<size_t>(*r) != size) {
+    return Status::IOError("Failed to decompress the frame: expects " +
+                           std::to_string(size) + " bytes, but got " +
+                           std::to_string(*r) + " bytes");
+  }
+  return Status::OK();
+}
+
+Status FrameCodec::ReadHeader(const uint8_t* header, size_t remaining,
+                              size_t& raw_size, size_t& stored_size) const {
+  uint64_t sizes[2];
+  memcpy(sizes, header, kHeaderSize);
+  if (sizes[0] == 0 || sizes[0] > std::min(remaining, kFrameSize) ||
+      sizes[1] == 0 || sizes[1] > sizes[0]) {
+    return Status::IOError("Invalid frame of compressed buffers: raw size = " +
+                           std::to_string(sizes[0]) + ", stored size = " +
+                           std::to_string(sizes[1]) + ", remaining size = " +
+                           std::to_string(remaining));
+  }
+  raw_size = sizes[0];
+  stored_size = sizes[1];
+  return Status::OK();
+}
+
+FrameEncoder::FrameEncoder(
+    std::shared_ptr<FrameCodec> codec,
+    std::vector<std::pair<const uint8_t*, size_t>> buffers)
+    : codec_(std::move(codec)), buffers_(std::move(buffers)) {}
+
+void FrameEncoder::Next(std::string& frame) {
+  while (index_ < buffers_.size() && offset_ == buffers_[index_].second) {
+    index_ += 1;
+    offset_ = 0;
+  }
+  if (index_ == buffers_.size()) {
+    frame.clear();
+    return;
+  }
+  auto const& buffer = buffers_[index_];
+  if (offset_ == 0) {
+    compress_ = codec_->Compressible(buffer.first, buffer.second);
+  }
+  size_t size = std::min(FrameCodec::kFrameSize, buffer.second - offset_);
+  codec_->Encode(buffer.first + offset_, size, compress_, frame);
+  offset_ += size;
+}
+
+}  // namespace vineyard
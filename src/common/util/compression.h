@@ -0,0 +1,136 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_COMMON_UTIL_COMPRESSION_H_
+#define SRC_COMMON_UTIL_COMPRESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/util/status.h"
+
+namespace arrow {
+namespace util {
+class Codec;
+}  // namespace util
+}  // namespace arrow
+
+namespace vineyard {
+
+/**
+ * @brief FrameCodec compresses the content of blobs on the wire between the
+ * RPC client and the server.
+ *
+ * The content of each buffer is sent as a sequence of frames of at most
+ * `kFrameSize` raw bytes, and frames never span over buffers:
+ *
+ *    - raw_size: uint64, the size of the content of the frame
+ *    - stored_size: uint64, the size of the bytes that follow the header,
+ *      equals to `raw_size` if the content is stored as it is, and is always
+ *      less than `raw_size` otherwise
+ *    - the (compressed) content
+ *
+ * The sender compresses a frame while the previous one is on the wire, and
+ * the receiver decompresses a frame while receiving the next one. Small
+ * buffers, and buffers whose sample doesn't shrink enough, are sent raw.
+ *
+ * Supported codecs are "lz4" (fast) and "zstd" (better ratio), depending on
+ * the arrow library.
+ */
+class FrameCodec {
+ public:
+  static constexpr size_t kFrameSize = 1024 * 1024;
+  static constexpr size_t kHeaderSize = 2 * sizeof(uint64_t);
+  // buffers smaller than this are always sent raw
+  static constexpr size_t kMinCompressSize = 4096;
+
+  ~FrameCodec();
+
+  /**
+   * @brief Whether the codec `name` is supported, the empty name and "none"
+   * mean no compression and are not "available".
+   */
+  static bool IsAvailable(const std::string& name);
+
+  static Status Create(const std::string& name,
+                       std::unique_ptr<FrameCodec>& codec);
+
+  const std::string& name() const { return name_; }
+
+  /**
+   * @brief Compresses a sample of the buffer to tell whether it is worthy to
+   * compress the whole buffer.
+   */
+  bool Compressible(const uint8_t* data, size_t size) const;
+
+  /**
+   * @brief Encode at most `kFrameSize` bytes as a frame in `frame`, the
+   * content is stored as it is if `compress` is false, or it doesn't shrink.
+   */
+  void Encode(const uint8_t* data, size_t size, const bool compress,
+              std::string& frame) const;
+
+  /**
+   * @brief Decompress the `stored_size` bytes that follow a frame header into
+   * the `size` bytes of `data`.
+   */
+  Status Decode(const uint8_t* stored, size_t stored_size, uint8_t* data,
+                size_t size) const;
+
+  /**
+   * @brief Validate the header of a frame that is expected to carry at most
+   * `remaining` bytes.
+   */
+  Status ReadHeader(const uint8_t* header, size_t remaining, size_t& raw_size,
+                    size_t& stored_size) const;
+
+ private:
+  FrameCodec(const std::string& name,
+             std::unique_ptr<arrow::util::Codec> codec);
+
+  std::string name_;
+  std::unique_ptr<arrow::util::Codec> codec_;
+};
+
+/**
+ * @brief Split the buffers into frames, one frame at a time.
+ */
+class FrameEncoder {
+ public:
+  FrameEncoder(std::shared_ptr<FrameCodec> codec,
+               std::vector<std::pair<const uint8_t*, size_t>> buffers);
+
+  /**
+   * @brief Encode the next frame into `frame`, which is left empty after all
+   * the buffers have been encoded.
+   */
+  void Next(std::string& frame);
+
+ private:
+  std::shared_ptr<FrameCodec> codec_;
+  std::vector<std::pair<const uint8_t*, size_t>> buffers_;
+  size_t index_ = 0;
+  size_t offset_ = 0;
+  // whether the current buffer is compressed
+  bool compress_ = false;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_COMMON_UTIL_COMPRESSION_H_
@@ -29,6 +29,7 @@ limitations under the License.
     defined(__gnu_linux__)
 #include <fcntl.h>
 #include <sys/statvfs.h>
+#include <sys/syscall.h>
 #endif
 #endif
 
@@ -42,6 +43,7 @@ limitations under the License.
 #endif
 
 #include <iostream>
+#include <string>
 
 namespace vineyard {
 
@@ -154,4 +156,28 @@ int64_t get_maximum_shared_memory() {
   return shmmax;
 }
 
+int get_numa_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned int cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return -1;
+}
+
+int get_numa_node_count() {
+  static int node_count = []() {
+    int count = 0;
+#ifdef __linux__
+    std::string prefix = "/sys/devices/system/node/node";
+    while (access((prefix + std::to_string(count)).c_str(), F_OK) == 0) {
+      count += 1;
+    }
+#endif
+    return count == 0 ? 1 : count;
+  }();
+  return node_count;
+}
+
 }  // namespace vineyard
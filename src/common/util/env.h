@@ -100,6 +100,17 @@ size_t get_peek_rss();
  */
 int64_t get_maximum_shared_memory();
 
+/**
+ * @brief Return the NUMA node that the calling thread is running on, or -1 if
+ * unknown.
+ */
+int get_numa_node();
+
+/**
+ * @brief Return the number of NUMA nodes of this machine.
+ */
+int get_numa_node_count();
+
 }  // namespace vineyard
 
 #endif  // SRC_COMMON_UTIL_ENV_H_
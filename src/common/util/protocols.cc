@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "common/util/protocols.h"
 
+#include <cstring>
 #include <sstream>
 #include <unordered_set>
 
@@ -143,6 +144,14 @@ CommandType ParseCommandType(const std::string& str_type) {
     return CommandType::CreateGPUBufferRequest;
   } else if (str_type == "get_gpu_buffers_request") {
     return CommandType::GetGPUBuffersRequest;
+  } else if (str_type == "create_buffers_request") {
+    return CommandType::CreateBuffersRequest;
+  } else if (str_type == "seal_blobs_request") {
+    return CommandType::SealBlobsRequest;
+  } else if (str_type == "get_remote_buffer_chunks_request") {
+    return CommandType::GetRemoteBufferChunksRequest;
+  } else if (str_type == "subscribe_meta_request") {
+    return CommandType::SubscribeMetaRequest;
   } else {
     return CommandType::NullCommand;
   }
@@ -156,17 +165,47 @@ void WriteErrorReply(Status const& status, std::string& msg) {
   encode_msg(status.ToJSON(), msg);
 }
 
-void WriteRegisterRequest(std::string& msg, StoreType const& store_type) {
+void AttachRequestId(const uint64_t request_id, std::string& msg) {
+  static const std::string key = "{\"request_id\":";
+  if (request_id == 0 || msg.empty() || msg[0] != '{' ||
+      msg.compare(0, key.size(), key) == 0) {
+    return;
+  }
+  std::string tag = key + std::to_string(request_id);
+  if (msg.size() > 2) {
+    // the message is not "{}"
+    tag += ",";
+  }
+  msg.replace(0, 1, tag);
+}
+
+uint64_t ReadRequestId(const json& root) {
+  if (!root.is_object()) {
+    return 0;
+  }
+  return root.value("request_id", static_cast<uint64_t>(0));
+}
+
+void WriteRegisterRequest(std::string& msg, StoreType const& store_type,
+                          const int numa_node, const bool binary_protocol,
+                          const bool shm_channel,
+                          const std::string& compression) {
   json root;
   root["type"] = "register_request";
   root["version"] = vineyard_version();
   root["store_type"] = store_type;
+  root["numa_node"] = numa_node;
+  root["binary_protocol"] = binary_protocol;
+  root["shm_channel"] = shm_channel;
+  root["compression"] = compression;
 
   encode_msg(root, msg);
 }
 
 Status ReadRegisterRequest(const json& root, std::string& version,
-                           StoreType& store_type) {
+                           StoreType& store_type, int& numa_node,
+                           bool& binary_protocol, bool& shm_channel,
+                           std::string& compression) {
   RETURN_ON_ASSERT(root["type"] == "register_request");
 
   // When the "version" field is missing from the client, we treat it
@@ -187,6 +226,14 @@ Status ReadRegisterRequest(const json& root, std::string& version,
       }
     }
   }
+  // The NUMA node where the client runs, -1 means unknown.
+  numa_node = root.value("numa_node", -1);
+  // Whether the client supports the binary encoding of hot commands.
+  binary_protocol = root.value("binary_protocol", false);
+  // Whether the client wants the shared memory control channel.
+  shm_channel = root.value("shm_channel", false);
+  // The codec that compresses the blobs on the wire, for RPC clients.
+  compression = root.value("compression", std::string(""));
   return Status::OK();
 }
 
@@ -194,7 +241,8 @@ void WriteRegisterReply(const std::string& ipc_socket,
                         const std::string& rpc_endpoint,
                         const InstanceID instance_id,
                         const SessionID session_id, bool& store_match,
-                        std::string& msg) {
+                        const bool binary_protocol, const bool shm_channel,
+                        const std::string& compression, std::string& msg) {
   json root;
   root["type"] = "register_reply";
   root["ipc_socket"] = ipc_socket;
@@ -203,13 +251,17 @@ void WriteRegisterReply(const std::string& ipc_socket,
   root["session_id"] = session_id;
   root["version"] = vineyard_version();
   root["store_match"] = store_match;
+  root["binary_protocol"] = binary_protocol;
+  root["shm_channel"] = shm_channel;
+  root["compression"] = compression;
   encode_msg(root, msg);
 }
 
 Status ReadRegisterReply(const json& root, std::string& ipc_socket,
                          std::string& rpc_endpoint, InstanceID& instance_id,
                          SessionID& session_id, std::string& version,
-                         bool& store_match) {
+                         bool& store_match, bool& binary_protocol,
+                         bool& shm_channel, std::string& compression) {
   CHECK_IPC_ERROR(root, "register_reply");
   ipc_socket = root["ipc_socket"].get_ref<std::string const&>();
   rpc_endpoint = root["rpc_endpoint"].get_ref<std::string const&>();
@@ -220,6 +272,10 @@ Status ReadRegisterReply(const json& root, std::string& ipc_socket,
   // as default unknown version number: 0.0.0.
   version = root.value<std::string>("version", std::string("0.0.0"));
   store_match = root["store_match"].get<bool>();
+  // Servers that don't know the binary encoding won't set this field.
+  binary_protocol = root.value("binary_protocol", false);
+  shm_channel = root.value("shm_channel", false);
+  compression = root.value("compression", std::string(""));
   return Status::OK();
 }
 
@@ -311,17 +367,20 @@ Status ReadListDataRequest(const json& root, std::string& pattern, bool& regex,
   return Status::OK();
 }
 
-void WriteCreateBufferRequest(const size_t size, std::string& msg) {
+void WriteCreateBufferRequest(const size_t size, std::string& msg,
+                              const int numa_node) {
   json root;
   root["type"] = "create_buffer_request";
   root["size"] = size;
+  root["numa_node"] = numa_node;
 
   encode_msg(root, msg);
 }
 
-Status ReadCreateBufferRequest(const json& root, size_t& size) {
+Status ReadCreateBufferRequest(const json& root, size_t& size, int& numa_node) {
   RETURN_ON_ASSERT(root["type"] == "create_buffer_request");
   size = root["size"].get<size_t>();
+  numa_node = root.value("numa_node", -1);
   return Status::OK();
 }
 
@@ -349,6 +408,57 @@ Status ReadCreateBufferReply(const json& root, ObjectID& id, Payload& object,
   return Status::OK();
 }
 
+void WriteCreateBuffersRequest(const std::vector<size_t>& sizes,
+                               std::string& msg, const int numa_node) {
+  json root;
+  root["type"] = "create_buffers_request";
+  root["sizes"] = sizes;
+  root["numa_node"] = numa_node;
+
+  encode_msg(root, msg);
+}
+
+Status ReadCreateBuffersRequest(const json& root, std::vector<size_t>& sizes,
+                                int& numa_node) {
+  RETURN_ON_ASSERT(root["type"] == "create_buffers_request");
+  sizes = root["sizes"].get<std::vector<size_t>>();
+  numa_node = root.value("numa_node", -1);
+  return Status::OK();
+}
+
+void WriteCreateBuffersReply(
+    const std::vector<ObjectID>& ids,
+    const std::vector<std::shared_ptr<Payload>>& objects,
+    const std::vector<int>& fd_to_send, std::string& msg) {
+  json root;
+  root["type"] = "create_buffers_reply";
+  root["ids"] = ids;
+  for (size_t i = 0; i < objects.size(); ++i) {
+    json tree;
+    objects[i]->ToJSON(tree);
+    root[std::to_string(i)] = tree;
+  }
+  root["fds"] = fd_to_send;
+  root["num"] = objects.size();
+
+  encode_msg(root, msg);
+}
+
+Status ReadCreateBuffersReply(const json& root, std::vector<ObjectID>& ids,
+                              std::vector<Payload>& objects,
+                              std::vector<int>& fd_sent) {
+  CHECK_IPC_ERROR(root, "create_buffers_reply");
+  ids = root["ids"].get<std::vector<ObjectID>>();
+  for (size_t i = 0; i < root.value("num", static_cast<size_t>(0)); ++i) {
+    json tree = root[std::to_string(i)];
+    Payload object;
+    object.FromJSON(tree);
+    objects.emplace_back(object);
+  }
+  fd_sent = root["fds"].get<std::vector<int>>();
+  return Status::OK();
+}
+
 void WriteCreateDiskBufferRequest(const size_t size, const std::string& path,
                                   std::string& msg) {
   json root;
@@ -496,17 +606,22 @@ Status ReadGetGPUBuffersReply(const json& root, std::vector<Payload>& objects,
   return Status::OK();
 }
 
-void WriteCreateRemoteBufferRequest(const size_t size, std::string& msg) {
+void WriteCreateRemoteBufferRequest(const size_t size,
+                                    const std::string& compression,
+                                    std::string& msg) {
   json root;
   root["type"] = "create_remote_buffer_request";
   root["size"] = size;
+  root["compression"] = compression;
 
   encode_msg(root, msg);
 }
 
-Status ReadCreateRemoteBufferRequest(const json& root, size_t& size) {
+Status ReadCreateRemoteBufferRequest(const json& root, size_t& size,
+                                     std::string& compression) {
   RETURN_ON_ASSERT(root["type"] == "create_remote_buffer_request");
   size = root["size"].get<size_t>();
+  compression = root.value("compression", std::string(""));
   return Status::OK();
 }
 
@@ -582,7 +697,9 @@ Status ReadGetBuffersReply(const json& root, std::vector<Payload>& objects,
 }
 
 void WriteGetRemoteBuffersRequest(const std::set<ObjectID>& ids,
-                                  const bool unsafe, std::string& msg) {
+                                  const bool unsafe,
+                                  const std::string& compression,
+                                  std::string& msg) {
   json root;
   root["type"] = "get_remote_buffers_request";
   int idx = 0;
@@ -591,12 +708,15 @@ void WriteGetRemoteBuffersRequest(const std::set<ObjectID>& ids,
   }
   root["num"] = ids.size();
   root["unsafe"] = unsafe;
+  root["compression"] = compression;
 
   encode_msg(root, msg);
 }
 
 void WriteGetRemoteBuffersRequest(const std::unordered_set<ObjectID>& ids,
-                                  const bool unsafe, std::string& msg) {
+                                  const bool unsafe,
+                                  const std::string& compression,
+                                  std::string& msg) {
   json root;
   root["type"] = "get_remote_buffers_request";
   int idx = 0;
@@ -605,18 +725,82 @@ void WriteGetRemoteBuffersRequest(const std::unordered_set<ObjectID>& ids,
   }
   root["num"] = ids.size();
   root["unsafe"] = unsafe;
+  root["compression"] = compression;
 
   encode_msg(root, msg);
 }
 
 Status ReadGetRemoteBuffersRequest(const json& root, std::vector<ObjectID>& ids,
-                                   bool& unsafe) {
+                                   bool& unsafe, std::string& compression) {
   RETURN_ON_ASSERT(root["type"] == "get_remote_buffers_request");
   size_t num = root["num"].get<size_t>();
   for (size_t i = 0; i < num; ++i) {
     ids.push_back(root[std::to_string(i)].get<ObjectID>());
   }
   unsafe = root.value("unsafe", false);
+  compression = root.value("compression", std::string(""));
+  return Status::OK();
+}
+
+void WriteGetRemoteBufferChunksRequest(const std::vector<ObjectID>& ids,
+                                       const std::vector<BufferChunk>& chunks,
+                                       const bool unsafe,
+                                       const std::string& compression,
+                                       std::string& msg) {
+  json root;
+  root["type"] = "get_remote_buffer_chunks_request";
+  root["ids"] = ids;
+  json chunk_list = json::array();
+  for (auto const& chunk : chunks) {
+    chunk_list.push_back({chunk.id, chunk.offset, chunk.size});
+  }
+  root["chunks"] = chunk_list;
+  root["unsafe"] = unsafe;
+  root["compression"] = compression;
+
+  encode_msg(root, msg);
+}
+
+Status ReadGetRemoteBufferChunksRequest(const json& root,
+                                        std::vector<ObjectID>& ids,
+                                        std::vector<BufferChunk>& chunks,
+                                        bool& unsafe,
+                                        std::string& compression) {
+  RETURN_ON_ASSERT(root["type"] == "get_remote_buffer_chunks_request");
+  ids = root["ids"].get<std::vector<ObjectID>>();
+  for (auto const& chunk : root["chunks"]) {
+    chunks.emplace_back(BufferChunk{chunk[0].get<ObjectID>(),
+                                    chunk[1].get<size_t>(),
+                                    chunk[2].get<size_t>()});
+  }
+  unsafe = root.value("unsafe", false);
+  compression = root.value("compression", std::string(""));
+  return Status::OK();
+}
+
+void WriteGetRemoteBufferChunksReply(
+    const std::vector<std::shared_ptr<Payload>>& objects, std::string& msg) {
+  json root;
+  root["type"] = "get_remote_buffer_chunks_reply";
+  json payloads = json::array();
+  for (auto const& object : objects) {
+    json tree;
+    object->ToJSON(tree);
+    payloads.push_back(tree);
+  }
+  root["payloads"] = payloads;
+
+  encode_msg(root, msg);
+}
+
+Status ReadGetRemoteBufferChunksReply(const json& root,
+                                      std::vector<Payload>& objects) {
+  CHECK_IPC_ERROR(root, "get_remote_buffer_chunks_reply");
+  for (auto const& tree : root["payloads"]) {
+    Payload object;
+    object.FromJSON(tree);
+    objects.emplace_back(object);
+  }
   return Status::OK();
 }
 
@@ -1328,6 +1512,44 @@ Status ReadDebugReply(const json& root, json& result) {
   return Status::OK();
 }
 
+void WriteSubscribeMetaRequest(std::string& msg) {
+  json root;
+  root["type"] = "subscribe_meta_request";
+
+  encode_msg(root, msg);
+}
+
+Status ReadSubscribeMetaRequest(const json& root) {
+  RETURN_ON_ASSERT(root["type"] == "subscribe_meta_request");
+  return Status::OK();
+}
+
+void WriteSubscribeMetaReply(std::string& msg) {
+  json root;
+  root["type"] = "subscribe_meta_reply";
+  encode_msg(root, msg);
+}
+
+Status ReadSubscribeMetaReply(const json& root) {
+  CHECK_IPC_ERROR(root, "subscribe_meta_reply");
+  return Status::OK();
+}
+
+void WriteInvalidateMetaNotification(const std::vector<ObjectID>& ids,
+                                     std::string& msg) {
+  json root;
+  root["type"] = "invalidate_meta_notification";
+  root["ids"] = ids;
+  encode_msg(root, msg);
+}
+
+Status ReadInvalidateMetaNotification(const json& root,
+                                      std::vector<ObjectID>& ids) {
+  CHECK_IPC_ERROR(root, "invalidate_meta_notification");
+  ids = root["ids"].get<std::vector<ObjectID>>();
+  return Status::OK();
+}
+
 void WriteNewSessionRequest(std::string& msg,
                             StoreType const& bulk_store_type) {
   json root;
@@ -1507,6 +1729,32 @@ Status ReadSealReply(json const& root) {
   return Status::OK();
 }
 
+void WriteSealBlobsRequest(std::vector<ObjectID> const& object_ids,
+                           std::string& msg) {
+  json root;
+  root["type"] = "seal_blobs_request";
+  root["object_ids"] = object_ids;
+  encode_msg(root, msg);
+}
+
+Status ReadSealBlobsRequest(json const& root,
+                            std::vector<ObjectID>& object_ids) {
+  RETURN_ON_ASSERT(root["type"] == "seal_blobs_request");
+  object_ids = root["object_ids"].get<std::vector<ObjectID>>();
+  return Status::OK();
+}
+
+void WriteSealBlobsReply(std::string& msg) {
+  json root;
+  root["type"] = "seal_blobs_reply";
+  encode_msg(root, msg);
+}
+
+Status ReadSealBlobsReply(json const& root) {
+  CHECK_IPC_ERROR(root, "seal_blobs_reply");
+  return Status::OK();
+}
+
 void WritePlasmaReleaseRequest(PlasmaID const& plasma_id, std::string& msg) {
   json root;
   root["type"] = "plasma_release_request";
@@ -1634,6 +1882,24 @@ Status ReadReleaseRequest(json const& root, ObjectID& object_id) {
   return Status::OK();
 }
 
+void WriteReleaseRequest(std::vector<ObjectID> const& object_ids,
+                         std::string& msg) {
+  json root;
+  root["type"] = "release_request";
+  root["object_ids"] = object_ids;
+  encode_msg(root, msg);
+}
+
+Status ReadReleaseRequest(json const& root, std::vector<ObjectID>& object_ids) {
+  RETURN_ON_ASSERT(root["type"] == "release_request");
+  if (root.contains("object_ids")) {
+    object_ids = root["object_ids"].get<std::vector<ObjectID>>();
+  } else {
+    object_ids = {root["object_id"].get<ObjectID>()};
+  }
+  return Status::OK();
+}
+
 void WriteReleaseReply(std::string& msg) {
   json root;
   root["type"] = "release_reply";
@@ -1765,4 +2031,290 @@ Status ReadIncreaseReferenceCountReply(json const& root) {
   return Status::OK();
 }
 
+namespace {
+
+/**
+ * The fixed-layout header of binary messages.
+ */
+struct BinaryMessageHeader {
+  uint8_t magic;
+  uint8_t flags;
+  int16_t type;
+  uint32_t reserved;
+};
+
+/**
+ * The fixed-layout representation of `Payload` in binary messages.
+ */
+struct BinaryPayload {
+  ObjectID object_id;
+  int32_t store_fd;
+  uint8_t is_sealed;
+  uint8_t is_owner;
+  uint8_t is_gpu;
+  uint8_t reserved;
+  int64_t data_offset;
+  int64_t data_size;
+  int64_t map_size;
+  uint64_t pointer;
+};
+
+constexpr uint8_t kBinaryFlagUnsafe = 1;
+
+class BinaryWriter {
+ public:
+  BinaryWriter(std::string& msg, CommandType type, uint8_t flags = 0)
+      : msg_(msg) {
+    msg_.clear();
+    BinaryMessageHeader header{kBinaryMessageMagic, flags,
+                               static_cast<int16_t>(type), 0};
+    Append(header);
+  }
+
+  template <typename T>
+  void Append(T const& value) {
+    msg_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void Append(Payload const& object) {
+    BinaryPayload payload{object.object_id,
+                          object.store_fd,
+                          object.is_sealed,
+                          object.is_owner,
+                          object.is_gpu,
+                          0,
+                          object.data_offset,
+                          object.data_size,
+                          object.map_size,
+                          reinterpret_cast<uintptr_t>(object.pointer)};
+    Append(payload);
+  }
+
+ private:
+  std::string& msg_;
+};
+
+class BinaryReader {
+ public:
+  explicit BinaryReader(const std::string& msg) : msg_(msg), offset_(0) {}
+
+  /**
+   * @brief Check the header of the message, the JSON error replies are
+   * translated to the corresponding status.
+   */
+  Status ReadHeader(CommandType type, uint8_t& flags) {
+    if (!IsBinaryMessage(msg_)) {
+      json root;
+      Status status;
+      CATCH_JSON_ERROR(root, status, json::parse(msg_.c_str()));
+      RETURN_ON_ERROR(status);
+      if (root.contains("code")) {
+        RETURN_ON_ERROR(
+            Status(static_cast<StatusCode>(root.value("code", 0)),
+                   root.value("message", "")));
+      }
+      return Status::AssertionFailed("Unexpected message: " + root.dump());
+    }
+    BinaryMessageHeader header;
+    RETURN_ON_ERROR(Read(header));
+    RETURN_ON_ASSERT(header.type == static_cast<int16_t>(type));
+    flags = header.flags;
+    return Status::OK();
+  }
+
+  Status ReadHeader(CommandType type) {
+    uint8_t flags = 0;
+    return ReadHeader(type, flags);
+  }
+
+  template <typename T>
+  Status Read(T& value) {
+    if (offset_ + sizeof(T) > msg_.size()) {
+      return Status::AssertionFailed("Truncated binary message");
+    }
+    memcpy(&value, msg_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return Status::OK();
+  }
+
+  Status Read(Payload& object) {
+    BinaryPayload payload;
+    RETURN_ON_ERROR(Read(payload));
+    object.object_id = payload.object_id;
+    object.store_fd = payload.store_fd;
+    object.data_offset = payload.data_offset;
+    object.data_size = payload.data_size;
+    object.map_size = payload.map_size;
+    object.pointer = reinterpret_cast<uint8_t*>(payload.pointer);
+    object.is_sealed = payload.is_sealed;
+    object.is_owner = payload.is_owner;
+    object.is_gpu = payload.is_gpu;
+    return Status::OK();
+  }
+
+ private:
+  const std::string& msg_;
+  size_t offset_;
+};
+
+}  // namespace
+
+bool IsBinaryMessage(const std::string& msg) {
+  return msg.size() >= sizeof(BinaryMessageHeader) &&
+         static_cast<uint8_t>(msg[0]) == kBinaryMessageMagic;
+}
+
+CommandType ParseBinaryCommandType(const std::string& msg) {
+  if (!IsBinaryMessage(msg)) {
+    return CommandType::NullCommand;
+  }
+  BinaryMessageHeader header;
+  memcpy(&header, msg.data(), sizeof(BinaryMessageHeader));
+  return static_cast<CommandType>(header.type);
+}
+
+void WriteCreateBufferRequestBinary(const size_t size, const int numa_node,
+                                    std::string& msg) {
+  BinaryWriter writer(msg, CommandType::CreateBufferRequest);
+  writer.Append(static_cast<uint64_t>(size));
+  writer.Append(static_cast<int64_t>(numa_node));
+}
+
+Status ReadCreateBufferRequestBinary(const std::string& msg, size_t& size,
+                                     int& numa_node) {
+  BinaryReader reader(msg);
+  RETURN_ON_ERROR(reader.ReadHeader(CommandType::CreateBufferRequest));
+  uint64_t value = 0;
+  int64_t node = -1;
+  RETURN_ON_ERROR(reader.Read(value));
+  RETURN_ON_ERROR(reader.Read(node));
+  size = static_cast<size_t>(value);
+  numa_node = static_cast<int>(node);
+  return Status::OK();
+}
+
+void WriteCreateBufferReplyBinary(const ObjectID id,
+                                  const std::shared_ptr<Payload>& object,
+                                  const int fd_to_send, std::string& msg) {
+  BinaryWriter writer(msg, CommandType::CreateBufferRequest);
+  writer.Append(id);
+  writer.Append(static_cast<int64_t>(fd_to_send));
+  writer.Append(*object);
+}
+
+Status ReadCreateBufferReplyBinary(const std::string& msg, ObjectID& id,
+                                   Payload& object, int& fd_sent) {
+  BinaryReader reader(msg);
+  RETURN_ON_ERROR(reader.ReadHeader(CommandType::CreateBufferRequest));
+  int64_t fd = -1;
+  RETURN_ON_ERROR(reader.Read(id));
+  RETURN_ON_ERROR(reader.Read(fd));
+  RETURN_ON_ERROR(reader.Read(object));
+  fd_sent = static_cast<int>(fd);
+  return Status::OK();
+}
+
+void WriteGetBuffersRequestBinary(const std::set<ObjectID>& ids,
+                                  const bool unsafe, std::string& msg) {
+  BinaryWriter writer(msg, CommandType::GetBuffersRequest,
+                      unsafe ? kBinaryFlagUnsafe : 0);
+  writer.Append(static_cast<uint64_t>(ids.size()));
+  for (auto const& id : ids) {
+    writer.Append(id);
+  }
+}
+
+Status ReadGetBuffersRequestBinary(const std::string& msg,
+                                   std::vector<ObjectID>& ids, bool& unsafe) {
+  BinaryReader reader(msg);
+  uint8_t flags = 0;
+  RETURN_ON_ERROR(reader.ReadHeader(CommandType::GetBuffersRequest, flags));
+  uint64_t num = 0;
+  RETURN_ON_ERROR(reader.Read(num));
+  RETURN_ON_ASSERT(num <= msg.size() / sizeof(ObjectID));
+  ids.resize(num);
+  for (uint64_t i = 0; i < num; ++i) {
+    RETURN_ON_ERROR(reader.Read(ids[i]));
+  }
+  unsafe = (flags & kBinaryFlagUnsafe) != 0;
+  return Status::OK();
+}
+
+void WriteGetBuffersReplyBinary(
+    const std::vector<std::shared_ptr<Payload>>& objects,
+    const std::vector<int>& fd_to_send, std::string& msg) {
+  BinaryWriter writer(msg, CommandType::GetBuffersRequest);
+  writer.Append(static_cast<uint64_t>(objects.size()));
+  writer.Append(static_cast<uint64_t>(fd_to_send.size()));
+  for (auto const& object : objects) {
+    writer.Append(*object);
+  }
+  for (int const fd : fd_to_send) {
+    writer.Append(static_cast<int32_t>(fd));
+  }
+}
+
+Status ReadGetBuffersReplyBinary(const std::string& msg,
+                                 std::vector<Payload>& objects,
+                                 std::vector<int>& fd_sent) {
+  BinaryReader reader(msg);
+  RETURN_ON_ERROR(reader.ReadHeader(CommandType::GetBuffersRequest));
+  uint64_t num = 0, num_fds = 0;
+  RETURN_ON_ERROR(reader.Read(num));
+  RETURN_ON_ERROR(reader.Read(num_fds));
+  RETURN_ON_ASSERT(num <= msg.size() / sizeof(BinaryPayload) &&
+                   num_fds <= msg.size() / sizeof(int32_t));
+  objects.resize(num);
+  for (uint64_t i = 0; i < num; ++i) {
+    RETURN_ON_ERROR(reader.Read(objects[i]));
+  }
+  fd_sent.resize(num_fds);
+  for (uint64_t i = 0; i < num_fds; ++i) {
+    int32_t fd = -1;
+    RETURN_ON_ERROR(reader.Read(fd));
+    fd_sent[i] = fd;
+  }
+  return Status::OK();
+}
+
+void WriteSealRequestBinary(ObjectID const& object_id, std::string& msg) {
+  BinaryWriter writer(msg, CommandType::SealRequest);
+  writer.Append(object_id);
+}
+
+Status ReadSealRequestBinary(const std::string& msg, ObjectID& object_id) {
+  BinaryReader reader(msg);
+  RETURN_ON_ERROR(reader.ReadHeader(CommandType::SealRequest));
+  return reader.Read(object_id);
+}
+
+void WriteSealReplyBinary(std::string& msg) {
+  BinaryWriter writer(msg, CommandType::SealRequest);
+}
+
+Status ReadSealReplyBinary(const std::string& msg) {
+  BinaryReader reader(msg);
+  return reader.ReadHeader(CommandType::SealRequest);
+}
+
+void WriteReleaseRequestBinary(ObjectID const& object_id, std::string& msg) {
+  BinaryWriter writer(msg, CommandType::ReleaseRequest);
+  writer.Append(object_id);
+}
+
+Status ReadReleaseRequestBinary(const std::string& msg, ObjectID& object_id) {
+  BinaryReader reader(msg);
+  RETURN_ON_ERROR(reader.ReadHeader(CommandType::ReleaseRequest));
+  return reader.Read(object_id);
+}
+
+void WriteReleaseReplyBinary(std::string& msg) {
+  BinaryWriter writer(msg, CommandType::ReleaseRequest);
+}
+
+Status ReadReleaseReplyBinary(const std::string& msg) {
+  BinaryReader reader(msg);
+  return reader.ReadHeader(CommandType::ReleaseRequest);
+}
+
 }  // namespace vineyard
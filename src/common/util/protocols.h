@@ -89,6 +89,10 @@ enum class CommandType {
   CreateGPUBufferRequest = 56,
   GetGPUBuffersRequest = 57,
   CreateDiskBufferRequest = 58,
+  CreateBuffersRequest = 59,
+  SealBlobsRequest = 60,
+  GetRemoteBufferChunksRequest = 61,
+  SubscribeMetaRequest = 62,
 };
 
 enum class StoreType {
@@ -100,21 +104,50 @@ CommandType ParseCommandType(const std::string& str_type);
 
 void WriteErrorReply(Status const& status, std::string& msg);
 
-void WriteRegisterRequest(std::string& msg, StoreType const& bulk_store_type);
+/**
+ * @brief Tag an encoded JSON request with a request id, to pipeline requests
+ * on a single connection. The server echoes the request id in the reply, and
+ * the client matches replies with requests by the id rather than by order.
+ * Zero means untagged, and tagged messages are left as they are.
+ */
+void AttachRequestId(const uint64_t request_id, std::string& msg);
+
+/**
+ * @brief The request id of a message, or zero if it is untagged.
+ */
+uint64_t ReadRequestId(const json& root);
+
+void WriteRegisterRequest(std::string& msg, StoreType const& bulk_store_type,
+                          const int numa_node = -1,
+                          const bool binary_protocol = false,
+                          const bool shm_channel = false,
+                          const std::string& compression = "");
 
 Status ReadRegisterRequest(const json& msg, std::string& version,
-                           StoreType& bulk_store_type);
-
+                           StoreType& bulk_store_type, int& numa_node,
+                           bool& binary_protocol, bool& shm_channel,
+                           std::string& compression);
+
+/**
+ * When `shm_channel` is true, the server sends the shared memory segment and
+ * the two eventfds of the channel, in order, right after the reply, see also
+ * `ShmChannel`.
+ *
+ * `compression` is the codec requested by the client if the server supports
+ * it, or empty, see also `FrameCodec`.
+ */
 void WriteRegisterReply(const std::string& ipc_socket,
                         const std::string& rpc_endpoint,
                         const InstanceID instance_id,
                         const SessionID session_id, bool& store_match,
-                        std::string& msg);
+                        const bool binary_protocol, const bool shm_channel,
+                        const std::string& compression, std::string& msg);
 
 Status ReadRegisterReply(const json& msg, std::string& ipc_socket,
                          std::string& rpc_endpoint, InstanceID& instance_id,
                          SessionID& sessionid, std::string& version,
-                         bool& store_match);
+                         bool& store_match, bool& binary_protocol,
+                         bool& shm_channel, std::string& compression);
 
 void WriteExitRequest(std::string& msg);
 
@@ -205,9 +238,10 @@ void WriteInstanceStatusReply(const json& content, std::string& msg);
 
 Status ReadInstanceStatusReply(const json& root, json& content);
 
-void WriteCreateBufferRequest(const size_t size, std::string& msg);
+void WriteCreateBufferRequest(const size_t size, std::string& msg,
+                              const int numa_node = -1);
 
-Status ReadCreateBufferRequest(const json& root, size_t& size);
+Status ReadCreateBufferRequest(const json& root, size_t& size, int& numa_node);
 
 void WriteCreateBufferReply(const ObjectID id,
                             const std::shared_ptr<Payload>& object,
@@ -216,6 +250,21 @@ void WriteCreateBufferReply(const ObjectID id,
 Status ReadCreateBufferReply(const json& root, ObjectID& id, Payload& object,
                              int& fd_sent);
 
+void WriteCreateBuffersRequest(const std::vector<size_t>& sizes,
+                               std::string& msg, const int numa_node = -1);
+
+Status ReadCreateBuffersRequest(const json& root, std::vector<size_t>& sizes,
+                                int& numa_node);
+
+void WriteCreateBuffersReply(
+    const std::vector<ObjectID>& ids,
+    const std::vector<std::shared_ptr<Payload>>& objects,
+    const std::vector<int>& fd_to_send, std::string& msg);
+
+Status ReadCreateBuffersReply(const json& root, std::vector<ObjectID>& ids,
+                              std::vector<Payload>& objects,
+                              std::vector<int>& fd_sent);
+
 void WriteCreateGPUBufferRequest(const size_t size, std::string& msg);
 
 Status ReadCreateGPUBufferRequest(const json& root, size_t& size);
@@ -254,9 +303,16 @@ void WriteGetGPUBuffersReply(
 Status ReadGetGPUBuffersReply(const json& root, std::vector<Payload>& objects,
                               std::vector<GPUUnifiedAddress>& uva_sent);
 
-void WriteCreateRemoteBufferRequest(const size_t size, std::string& msg);
+/**
+ * The content follows the request as frames of `compression`, or raw bytes
+ * if `compression` is empty.
+ */
+void WriteCreateRemoteBufferRequest(const size_t size,
+                                    const std::string& compression,
+                                    std::string& msg);
 
-Status ReadCreateRemoteBufferRequest(const json& root, size_t& size);
+Status ReadCreateRemoteBufferRequest(const json& root, size_t& size,
+                                     std::string& compression);
 
 void WriteGetBuffersRequest(const std::set<ObjectID>& ids, const bool unsafe,
                             std::string& msg);
@@ -273,14 +329,52 @@ void WriteGetBuffersReply(const std::vector<std::shared_ptr<Payload>>& objects,
 Status ReadGetBuffersReply(const json& root, std::vector<Payload>& objects,
                            std::vector<int>& fd_sent);
 
+/**
+ * The content of blobs is sent after the reply as frames of `compression`,
+ * or raw bytes if `compression` is empty.
+ */
 void WriteGetRemoteBuffersRequest(const std::set<ObjectID>& ids,
-                                  const bool unsafe, std::string& msg);
+                                  const bool unsafe,
+                                  const std::string& compression,
+                                  std::string& msg);
 
 void WriteGetRemoteBuffersRequest(const std::unordered_set<ObjectID>& ids,
-                                  const bool unsafe, std::string& msg);
+                                  const bool unsafe,
+                                  const std::string& compression,
+                                  std::string& msg);
 
 Status ReadGetRemoteBuffersRequest(const json& root, std::vector<ObjectID>& ids,
-                                   bool& unsafe);
+                                   bool& unsafe, std::string& compression);
+
+/**
+ * @brief A byte range of a blob, i.e., `size` bytes starting from `offset`.
+ */
+struct BufferChunk {
+  ObjectID id;
+  size_t offset;
+  size_t size;
+};
+
+/**
+ * @brief Request the payloads of blobs `ids`, and the content of `chunks`,
+ * which are sent back to back after the reply. Either of them could be empty.
+ */
+void WriteGetRemoteBufferChunksRequest(const std::vector<ObjectID>& ids,
+                                       const std::vector<BufferChunk>& chunks,
+                                       const bool unsafe,
+                                       const std::string& compression,
+                                       std::string& msg);
+
+Status ReadGetRemoteBufferChunksRequest(const json& root,
+                                        std::vector<ObjectID>& ids,
+                                        std::vector<BufferChunk>& chunks,
+                                        bool& unsafe, std::string& compression);
+
+void WriteGetRemoteBufferChunksReply(
+    const std::vector<std::shared_ptr<Payload>>& objects, std::string& msg);
+
+Status ReadGetRemoteBufferChunksReply(const json& root,
+                                      std::vector<Payload>& objects);
 
 void WriteDropBufferRequest(const ObjectID id, std::string& msg);
 
@@ -439,6 +533,25 @@ void WriteDebugReply(const json& result, std::string& msg);
 
 Status ReadDebugReply(const json& root, json& result);
 
+/**
+ * After the reply, the server pushes an invalidation notification to the
+ * connection whenever the metadata of objects is deleted or modified, and
+ * the connection serves no further requests.
+ */
+void WriteSubscribeMetaRequest(std::string& msg);
+
+Status ReadSubscribeMetaRequest(const json& root);
+
+void WriteSubscribeMetaReply(std::string& msg);
+
+Status ReadSubscribeMetaReply(const json& root);
+
+void WriteInvalidateMetaNotification(const std::vector<ObjectID>& ids,
+                                     std::string& msg);
+
+Status ReadInvalidateMetaNotification(const json& root,
+                                      std::vector<ObjectID>& ids);
+
 void WriteNewSessionRequest(std::string& msg, StoreType const& bulk_store_type);
 
 Status ReadNewSessionRequest(json const& root, StoreType& bulk_store_type);
@@ -495,6 +608,16 @@ void WriteSealReply(std::string& msg);
 
 Status ReadSealReply(json const& root);
 
+void WriteSealBlobsRequest(std::vector<ObjectID> const& object_ids,
+                           std::string& msg);
+
+Status ReadSealBlobsRequest(json const& root,
+                            std::vector<ObjectID>& object_ids);
+
+void WriteSealBlobsReply(std::string& msg);
+
+Status ReadSealBlobsReply(json const& root);
+
 void WritePlasmaReleaseRequest(PlasmaID const& plasma_id,
                                std::string& message_out);
 
@@ -552,6 +675,15 @@ void WriteReleaseRequest(ObjectID const& object_id, std::string& msg);
 
 Status ReadReleaseRequest(json const& root, ObjectID& object_id);
 
+void WriteReleaseRequest(std::vector<ObjectID> const& object_ids,
+                         std::string& msg);
+
+/**
+ * @brief Read the blobs to release, the request may carry either a single
+ * "object_id" or a list of "object_ids".
+ */
+Status ReadReleaseRequest(json const& root, std::vector<ObjectID>& object_ids);
+
 void WriteReleaseReply(std::string& msg);
 
 Status ReadReleaseReply(json const& root);
@@ -596,6 +728,64 @@ void WriteIncreaseReferenceCountReply(std::string& msg);
 
 Status ReadIncreaseReferenceCountReply(json const& root);
 
+/**
+ * The hot commands of IPC clients, i.e., creating, getting, sealing and
+ * releasing blobs, can be encoded as fixed-layout binary messages rather than
+ * JSON, if both sides agree on it in the register request and reply.
+ *
+ * A binary message starts with `kBinaryMessageMagic`, which never starts a
+ * JSON message, followed by the command type. Errors are still replied as
+ * JSON messages, and the `Read*ReplyBinary` functions accept both.
+ */
+constexpr uint8_t kBinaryMessageMagic = 0xb7;
+
+bool IsBinaryMessage(const std::string& msg);
+
+CommandType ParseBinaryCommandType(const std::string& msg);
+
+void WriteCreateBufferRequestBinary(const size_t size, const int numa_node,
+                                    std::string& msg);
+
+Status ReadCreateBufferRequestBinary(const std::string& msg, size_t& size,
+                                     int& numa_node);
+
+void WriteCreateBufferReplyBinary(const ObjectID id,
+                                  const std::shared_ptr<Payload>& object,
+                                  const int fd_to_send, std::string& msg);
+
+Status ReadCreateBufferReplyBinary(const std::string& msg, ObjectID& id,
+                                   Payload& object, int& fd_sent);
+
+void WriteGetBuffersRequestBinary(const std::set<ObjectID>& ids,
+                                  const bool unsafe, std::string& msg);
+
+Status ReadGetBuffersRequestBinary(const std::string& msg,
+                                   std::vector<ObjectID>& ids, bool& unsafe);
+
+void WriteGetBuffersReplyBinary(
+    const std::vector<std::shared_ptr<Payload>>& objects,
+    const std::vector<int>& fd_to_send, std::string& msg);
+
+Status ReadGetBuffersReplyBinary(const std::string& msg,
+                                 std::vector<Payload>& objects,
+                                 std::vector<int>& fd_sent);
+
+void WriteSealRequestBinary(ObjectID const& object_id, std::string& msg);
+
+Status ReadSealRequestBinary(const std::string& msg, ObjectID& object_id);
+
+void WriteSealReplyBinary(std::string& msg);
+
+Status ReadSealReplyBinary(const std::string& msg);
+
+void WriteReleaseRequestBinary(ObjectID const& object_id, std::string& msg);
+
+Status ReadReleaseRequestBinary(const std::string& msg, ObjectID& object_id);
+
+void WriteReleaseReplyBinary(std::string& msg);
+
+Status ReadReleaseReplyBinary(const std::string& msg);
+
 }  // namespace vineyard
 
 #endif  // SRC_COMMON_UTIL_PROTOCOLS_H_
@@ -15,9 +15,15 @@ limitations under the License.
 
 #include "server/async/socket_server.h"
 
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -25,9 +31,11 @@ limitations under the License.
 
 #include "common/memory/fling.h"
 #include "common/util/callback.h"
+#include "common/util/compression.h"
 #include "common/util/functions.h"
 #include "common/util/json.h"
 #include "common/util/protocols.h"
+#include "server/memory/malloc.h"
 #include "server/server/vineyard_server.h"
 #include "server/util/metrics.h"
 
@@ -39,7 +47,9 @@ SocketConnection::SocketConnection(
     : socket_(std::move(socket)),
       server_ptr_(server_ptr),
       socket_server_ptr_(socket_server_ptr),
-      conn_id_(conn_id) {
+      conn_id_(conn_id),
+      numa_node_(-1),
+      channel_event_value_(0) {
   // hold the references of bulkstore using `shared_from_this()`.
   auto bulk_store = server_ptr_->GetBulkStore();
   if (bulk_store != nullptr) {
@@ -85,6 +95,9 @@ bool SocketConnection::Stop() {
   socket_.cancel(ec);
   socket_.shutdown(stream_protocol::socket::shutdown_both, ec);
   socket_.close(ec);
+  if (channel_event_) {
+    channel_event_->close(ec);
+  }
 
   return true;
 }
@@ -190,7 +203,49 @@ void SocketConnection::doReadBody() {
   } while (0)
 #endif  // RESPONSE_ON_ERROR
 
+namespace {
+
+// the request id of the message being processed on this thread, replies
+// written by `doWrite()` are tagged with it, see also `AttachRequestId()`.
+thread_local uint64_t current_request_id = 0;
+
+/**
+ * Tag the replies written in the scope with the given request id, which is
+ * also used by the asynchronous callbacks that reply on other threads.
+ */
+class RequestIdScope {
+ public:
+  explicit RequestIdScope(const uint64_t request_id)
+      : saved_(current_request_id) {
+    current_request_id = request_id;
+  }
+
+  ~RequestIdScope() { current_request_id = saved_; }
+
+ private:
+  uint64_t saved_;
+};
+
+// whether the message being processed on this thread comes from the shared
+// memory channel, replies written by `doWrite()` go back to the channel.
+thread_local bool replying_to_channel = false;
+
+class ChannelScope {
+ public:
+  ChannelScope() : saved_(replying_to_channel) { replying_to_channel = true; }
+
+  ~ChannelScope() { replying_to_channel = saved_; }
+
+ private:
+  bool saved_;
+};
+
+}  // namespace
+
 bool SocketConnection::processMessage(const std::string& message_in) {
+  if (IsBinaryMessage(message_in)) {
+    return processBinaryMessage(message_in);
+  }
   json root;
   std::istringstream is(message_in);
 
@@ -199,6 +254,7 @@ bool SocketConnection::processMessage(const std::string& message_in) {
 
   std::string const& type = root["type"].get_ref<std::string const&>();
   CommandType cmd = ParseCommandType(type);
+  RequestIdScope request_id_scope(ReadRequestId(root));
   switch (cmd) {
   case CommandType::RegisterRequest: {
     return doRegister(root);
@@ -209,6 +265,9 @@ bool SocketConnection::processMessage(const std::string& message_in) {
   case CommandType::GetRemoteBuffersRequest: {
     return doGetRemoteBuffers(root);
   }
+  case CommandType::GetRemoteBufferChunksRequest: {
+    return doGetRemoteBufferChunks(root);
+  }
   case CommandType::CreateBufferRequest: {
     return doCreateBuffer(root);
   }
@@ -290,6 +349,9 @@ bool SocketConnection::processMessage(const std::string& message_in) {
   case CommandType::ClearRequest: {
     return doClear(root);
   }
+  case CommandType::SubscribeMetaRequest: {
+    return doSubscribeMeta(root);
+  }
   case CommandType::DebugCommand: {
     return doDebug(root);
   }
@@ -344,8 +406,43 @@ bool SocketConnection::processMessage(const std::string& message_in) {
   case CommandType::GetGPUBuffersRequest: {
     return doGetGPUBuffers(root);
   }
+  case CommandType::CreateBuffersRequest: {
+    return doCreateBuffers(root);
+  }
+  case CommandType::SealBlobsRequest: {
+    return doSealBlobs(root);
+  }
+  default: {
+    // reply the error, otherwise the client waits for the reply forever
+    auto self(shared_from_this());
+    RESPONSE_ON_ERROR(
+        Status::NotImplemented("Got unexpected command: " + type));
+    return false;
+  }
+  }
+}
+
+bool SocketConnection::processBinaryMessage(const std::string& message_in) {
+  switch (ParseBinaryCommandType(message_in)) {
+  case CommandType::GetBuffersRequest: {
+    return doGetBuffersBinary(message_in);
+  }
+  case CommandType::CreateBufferRequest: {
+    return doCreateBufferBinary(message_in);
+  }
+  case CommandType::SealRequest: {
+    return doSealBlobBinary(message_in);
+  }
+  case CommandType::ReleaseRequest: {
+    return doReleaseBinary(message_in);
+  }
   default: {
-    LOG(ERROR) << "Got unexpected command: " << type;
+    // the error reply goes back to the shared memory channel as well if the
+    // message comes from it
+    auto self(shared_from_this());
+    RESPONSE_ON_ERROR(Status::NotImplemented(
+        "Got unexpected binary command: " +
+        std::to_string(static_cast<int>(ParseBinaryCommandType(message_in)))));
     return false;
   }
   }
@@ -353,41 +450,292 @@ bool SocketConnection::processMessage(const std::string& message_in) {
 
 bool SocketConnection::doRegister(const json& root) {
   auto self(shared_from_this());
-  std::string client_version, message_out;
+  std::string client_version, compression, message_out;
   StoreType bulk_store_type;
-  TRY_READ_REQUEST(ReadRegisterRequest, root, client_version, bulk_store_type);
+  bool binary_protocol = false, shm_channel = false;
+  TRY_READ_REQUEST(ReadRegisterRequest, root, client_version, bulk_store_type,
+                   numa_node_, binary_protocol, shm_channel, compression);
   bool store_match = (bulk_store_type == server_ptr_->GetBulkStoreType());
+  // the binary encoding is only available for the commands of blobs
+  binary_protocol = binary_protocol && bulk_store_type == StoreType::kDefault;
+  // the channel carries the binary encoded messages only
+  shm_channel = shm_channel && binary_protocol && channel_ == nullptr;
+  if (shm_channel) {
+    auto status = createChannel();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to create the shared memory channel, falling "
+                      "back to the socket: "
+                   << status.ToString();
+      shm_channel = false;
+    }
+  }
+  // accept the codec that compresses the remote buffers on the wire only if
+  // it is supported by the server as well
+  if (!FrameCodec::IsAvailable(compression)) {
+    compression.clear();
+  }
   WriteRegisterReply(server_ptr_->IPCSocket(), server_ptr_->RPCEndpoint(),
                      server_ptr_->instance_id(), server_ptr_->session_id(),
-                     store_match, message_out);
-  doWrite(message_out);
+                     store_match, binary_protocol, shm_channel, compression,
+                     message_out);
+  if (!shm_channel) {
+    doWrite(message_out);
+    return false;
+  }
+  doWrite(message_out, [self](const Status& status) {
+    for (int fd : {self->channel_->fd(), self->channel_->request_event(),
+                   self->channel_->reply_event()}) {
+      if (send_fd(self->nativeHandle(), fd) < 0) {
+        return Status::IOError("Failed to send the shared memory channel");
+      }
+    }
+    return Status::OK();
+  });
+  doReadChannel();
   return false;
 }
 
-void SocketConnection::sendRemoteBufferHelper(
-    std::vector<std::shared_ptr<Payload>> const& objects, size_t index,
-    boost::system::error_code const ec, callback_t<> callback_after_finish) {
+Status SocketConnection::createChannel() {
+  // file descriptors can only be passed over UNIX domain sockets
+  boost::system::error_code ec;
+  auto endpoint = socket_.local_endpoint(ec);
+  if (ec || endpoint.protocol().family() != AF_UNIX) {
+    return Status::Invalid(
+        "The shared memory channel requires a UNIX domain socket");
+  }
+  // the channel is small, don't take huge pages from the reserved pool
+  int fd = memory::create_buffer(ShmChannel::MappedSize(), true, false);
+  if (fd == -1) {
+    return Status::IOError("Failed to create the shared memory segment");
+  }
+  RETURN_ON_ERROR(ShmChannel::Create(fd, channel_));
+  int event = dup(channel_->request_event());
+  if (event == -1) {
+    channel_.reset();
+    return Status::IOError("Failed to duplicate the eventfd");
+  }
+  channel_event_.reset(
+      new asio::posix::stream_descriptor(server_ptr_->GetContext(), event));
+  return Status::OK();
+}
+
+void SocketConnection::doReadChannel() {
+  auto self(shared_from_this());
+  channel_event_->async_read_some(
+      asio::buffer(&channel_event_value_, sizeof(uint64_t)),
+      [this, self](boost::system::error_code ec, std::size_t) {
+        // the disconnection is handled by the socket
+        if (ec || !running_.load()) {
+          return;
+        }
+        // drain the ring, the client signals again for requests pushed after
+        // the eventfd has been read
+        std::string message_in;
+        while (true) {
+          auto status = channel_->ReceiveRequest(message_in);
+          if (!status.ok()) {
+            LOG(ERROR) << "Failed to read the shared memory channel: "
+                       << status.ToString();
+            doStop();
+            return;
+          }
+          if (message_in.empty()) {
+            break;
+          }
+          ChannelScope channel_scope;
+          processBinaryMessage(message_in);
+        }
+        doReadChannel();
+      });
+}
+
+struct SocketConnection::FrameWriter {
+  FrameWriter(std::shared_ptr<FrameCodec> const& codec,
+              std::vector<std::pair<const uint8_t*, size_t>>&& buffers)
+      : encoder(codec, std::move(buffers)) {}
+
+  FrameEncoder encoder;
+  // the frame being written, and the next frame being encoded
+  std::string frames[2];
+  size_t current = 0;
+  // counts down the write of the current frame and the encoding of the next
+  // frame, whichever finishes last moves on
+  std::atomic<int> pending{0};
+  boost::system::error_code ec;
+};
+
+struct SocketConnection::FrameReader {
+  static constexpr size_t kAll = 2;
+
+  explicit FrameReader(std::shared_ptr<FrameCodec> const& codec)
+      : codec(codec) {}
+
+  /**
+   * Returns false if the buffer `index` (or any buffer, for `kAll`) is still
+   * being decompressed, `resume` is then posted once a decompression
+   * finishes.
+   */
+  bool Wait(size_t index, std::function<void()> const& resume) {
+    std::lock_guard<std::mutex> locked(mutex);
+    bool busy = index == kAll ? (decoding[0] || decoding[1]) : decoding[index];
+    if (busy) {
+      waiting = resume;
+    }
+    return !busy;
+  }
+
+  void Decoding(size_t index) {
+    std::lock_guard<std::mutex> locked(mutex);
+    decoding[index] = true;
+  }
+
+  // returns the continuation that waits for the decompression, if any
+  std::function<void()> Decoded(size_t index, Status const& status) {
+    std::lock_guard<std::mutex> locked(mutex);
+    decoding[index] = false;
+    if (result.ok()) {
+      result = status;
+    }
+    std::function<void()> resume;
+    resume.swap(waiting);
+    return resume;
+  }
+
+  void Fail(Status const& status) {
+    std::lock_guard<std::mutex> locked(mutex);
+    if (result.ok()) {
+      result = status;
+    }
+  }
+
+  bool Failed() {
+    std::lock_guard<std::mutex> locked(mutex);
+    return !result.ok();
+  }
+
+  Status Result() {
+    std::lock_guard<std::mutex> locked(mutex);
+    return result;
+  }
+
+  std::shared_ptr<FrameCodec> codec;
+  uint8_t header[FrameCodec::kHeaderSize];
+  // a compressed frame is received into one buffer while the previous frame
+  // is being decompressed from the other one
+  std::string stored[2];
+  size_t current = 0;
+
+ private:
+  // guards the following members, which are updated by the decompression on
+  // the IO workers as well
+  std::mutex mutex;
+  bool decoding[2] = {false, false};
+  // the first error of receiving or decompressing the frames
+  Status result;
+  std::function<void()> waiting;
+};
+
+Status SocketConnection::createFrameCodec(const std::string& compression,
+                                          std::shared_ptr<FrameCodec>& codec) {
+  if (compression.empty()) {
+    return Status::OK();
+  }
+  std::unique_ptr<FrameCodec> frame_codec;
+  RETURN_ON_ERROR(FrameCodec::Create(compression, frame_codec));
+  codec = std::move(frame_codec);
+  return Status::OK();
+}
+
+void SocketConnection::sendRemoteBuffers(
+    std::vector<std::shared_ptr<Payload>> const& objects,
+    std::shared_ptr<FrameCodec> const& codec,
+    callback_t<> callback_after_finish) {
+  std::vector<boost::asio::const_buffer> buffers;
+  buffers.reserve(objects.size());
+  for (auto const& object : objects) {
+    if (object->data_size > 0) {
+      buffers.emplace_back(object->pointer, object->data_size);
+    }
+  }
+  sendRemoteBuffers(objects, buffers, codec, callback_after_finish);
+}
+
+void SocketConnection::sendRemoteBuffers(
+    std::vector<std::shared_ptr<Payload>> const& objects,
+    std::vector<boost::asio::const_buffer> const& buffers,
+    std::shared_ptr<FrameCodec> const& codec,
+    callback_t<> callback_after_finish) {
   auto self(shared_from_this());
-  if (!ec && index < objects.size()) {
-    while (objects[index]->data_size == 0) {
-      index += 1;
+  if (codec != nullptr) {
+    std::vector<std::pair<const uint8_t*, size_t>> ranges;
+    ranges.reserve(buffers.size());
+    for (auto const& buffer : buffers) {
+      ranges.emplace_back(static_cast<const uint8_t*>(buffer.data()),
+                          buffer.size());
     }
-    boost::asio::async_write(
-        socket_,
-        boost::asio::buffer(objects[index]->pointer, objects[index]->data_size),
-        [self, callback_after_finish, objects, index](
-            boost::system::error_code ec, std::size_t) {
-          self->sendRemoteBufferHelper(objects, index + 1, ec,
-                                       callback_after_finish);
+    auto writer = std::make_shared<FrameWriter>(codec, std::move(ranges));
+    // the frames are compressed on the IO workers, rather than the threads
+    // that serve the sockets
+    server_ptr_->GetIOContext().post(
+        [self, objects, writer, callback_after_finish]() {
+          writer->encoder.Next(writer->frames[0]);
+          self->server_ptr_->GetContext().post(
+              [self, objects, writer, callback_after_finish]() {
+                self->sendRemoteFrames(objects, writer, callback_after_finish);
+              });
         });
-  } else {
-    if (ec) {
+    return;
+  }
+  // asio issues a `writev` for each batch of the buffers, rather than a round
+  // of the event loop for each blob
+  boost::asio::async_write(
+      socket_, buffers,
+      [self, callback_after_finish, objects](boost::system::error_code ec,
+                                             std::size_t) {
+        if (ec) {
+          VINEYARD_DISCARD(callback_after_finish(Status::IOError(
+              "Failed to write buffer to client: " + ec.message())));
+        } else {
+          VINEYARD_DISCARD(callback_after_finish(Status::OK()));
+        }
+      });
+}
+
+void SocketConnection::sendRemoteFrames(
+    std::vector<std::shared_ptr<Payload>> const& objects,
+    std::shared_ptr<FrameWriter> const& writer,
+    callback_t<> callback_after_finish) {
+  auto self(shared_from_this());
+  std::string& frame = writer->frames[writer->current];
+  if (frame.empty()) {
+    VINEYARD_DISCARD(callback_after_finish(Status::OK()));
+    return;
+  }
+  auto proceed = [self, objects, writer, callback_after_finish]() {
+    if (writer->ec) {
       VINEYARD_DISCARD(callback_after_finish(Status::IOError(
-          "Failed to write buffer to client: " + ec.message())));
-    } else {
-      VINEYARD_DISCARD(callback_after_finish(Status::OK()));
+          "Failed to write buffer to client: " + writer->ec.message())));
+      return;
     }
-  }
+    writer->current = 1 - writer->current;
+    self->sendRemoteFrames(objects, writer, callback_after_finish);
+  };
+  writer->pending.store(2);
+  boost::asio::async_write(
+      socket_, boost::asio::buffer(frame),
+      [self, writer, proceed](boost::system::error_code ec, std::size_t) {
+        writer->ec = ec;
+        if (writer->pending.fetch_sub(1) == 1) {
+          proceed();
+        }
+      });
+  // compress the next frame while the current one is on the wire
+  server_ptr_->GetIOContext().post([self, writer, proceed]() {
+    writer->encoder.Next(writer->frames[1 - writer->current]);
+    if (writer->pending.fetch_sub(1) == 1) {
+      self->server_ptr_->GetContext().post(proceed);
+    }
+  });
 }
 
 void SocketConnection::recvRemoteBufferHelper(
@@ -428,14 +776,151 @@ void SocketConnection::recvRemoteBufferHelper(
       });
 }
 
+void SocketConnection::recvRemoteFrames(
+    std::shared_ptr<Payload> const& object, size_t offset,
+    std::shared_ptr<FrameReader> const& reader,
+    callback_t<std::shared_ptr<Payload> const&> callback_after_finish) {
+  auto self(shared_from_this());
+  if (offset == static_cast<size_t>(object->data_size)) {
+    finishRemoteFrames(object, reader, Status::OK(), callback_after_finish);
+    return;
+  }
+  boost::asio::async_read(
+      socket_, boost::asio::buffer(reader->header, FrameCodec::kHeaderSize),
+      [self, object, offset, reader, callback_after_finish](
+          boost::system::error_code ec, std::size_t) {
+        if (ec) {
+          self->finishRemoteFrames(
+              object, reader,
+              Status::IOError("Failed to read buffer from client: " +
+                              ec.message()),
+              callback_after_finish);
+          return;
+        }
+        size_t raw_size = 0, stored_size = 0;
+        auto status = reader->codec->ReadHeader(
+            reader->header, object->data_size - offset, raw_size, stored_size);
+        if (!status.ok()) {
+          self->finishRemoteFrames(object, reader, status,
+                                   callback_after_finish);
+          return;
+        }
+        if (stored_size != raw_size) {
+          self->recvRemoteFrame(object, offset, reader, raw_size, stored_size,
+                                callback_after_finish);
+          return;
+        }
+        // raw frames are received into the blob directly
+        boost::asio::async_read(
+            self->socket_,
+            boost::asio::buffer(object->pointer + offset, raw_size),
+            [self, object, offset, reader, callback_after_finish, raw_size](
+                boost::system::error_code ec, std::size_t) {
+              if (ec) {
+                self->finishRemoteFrames(
+                    object, reader,
+                    Status::IOError("Failed to read buffer from client: " +
+                                    ec.message()),
+                    callback_after_finish);
+                return;
+              }
+              self->recvRemoteFrames(object, offset + raw_size, reader,
+                                     callback_after_finish);
+            });
+      });
+}
+
+void SocketConnection::recvRemoteFrame(
+    std::shared_ptr<Payload> const& object, size_t offset,
+    std::shared_ptr<FrameReader> const& reader, size_t raw_size,
+    size_t stored_size,
+    callback_t<std::shared_ptr<Payload> const&> callback_after_finish) {
+  auto self(shared_from_this());
+  const size_t index = reader->current;
+  // the buffer may still be decompressed from the frame before last
+  if (!reader->Wait(index, [self, object, offset, reader, raw_size,
+                            stored_size, callback_after_finish]() {
+        self->recvRemoteFrame(object, offset, reader, raw_size, stored_size,
+                              callback_after_finish);
+      })) {
+    return;
+  }
+  if (reader->Failed()) {
+    finishRemoteFrames(object, reader, Status::OK(), callback_after_finish);
+    return;
+  }
+  reader->stored[index].resize(stored_size);
+  boost::asio::async_read(
+      socket_, boost::asio::buffer(&reader->stored[index][0], stored_size),
+      [self, object, offset, reader, callback_after_finish, raw_size,
+       stored_size, index](boost::system::error_code ec, std::size_t) {
+        if (ec) {
+          self->finishRemoteFrames(
+              object, reader,
+              Status::IOError("Failed to read buffer from client: " +
+                              ec.message()),
+              callback_after_finish);
+          return;
+        }
+        auto decode = [self, object, offset, reader, raw_size, stored_size,
+                       index]() {
+          auto status = reader->codec->Decode(
+              reinterpret_cast<const uint8_t*>(reader->stored[index].data()),
+              stored_size, object->pointer + offset, raw_size);
+          auto resume = reader->Decoded(index, status);
+          if (resume) {
+            self->server_ptr_->GetContext().post(resume);
+          }
+        };
+        reader->Decoding(index);
+        reader->current = 1 - index;
+        // decompresses on the IO workers, while the next frame is received
+        // into the other buffer
+        self->server_ptr_->GetIOContext().post(decode);
+        self->recvRemoteFrames(object, offset + raw_size, reader,
+                               callback_after_finish);
+      });
+}
+
+void SocketConnection::finishRemoteFrames(
+    std::shared_ptr<Payload> const& object,
+    std::shared_ptr<FrameReader> const& reader, Status const& status,
+    callback_t<std::shared_ptr<Payload> const&> callback_after_finish) {
+  auto self(shared_from_this());
+  reader->Fail(status);
+  // the blob is not ready until the last frame has been decompressed
+  if (!reader->Wait(FrameReader::kAll, [self, object, reader,
+                                        callback_after_finish]() {
+        self->finishRemoteFrames(object, reader, Status::OK(),
+                                 callback_after_finish);
+      })) {
+    return;
+  }
+  VINEYARD_DISCARD(callback_after_finish(reader->Result(), object));
+}
+
 bool SocketConnection::doGetBuffers(const json& root) {
   auto self(shared_from_this());
   std::vector<ObjectID> ids;
   bool unsafe = false;
+  TRY_READ_REQUEST(ReadGetBuffersRequest, root, ids, unsafe);
+  return doGetBuffers(ids, unsafe, false);
+}
+
+bool SocketConnection::doGetBuffersBinary(const std::string& message_in) {
+  auto self(shared_from_this());
+  std::vector<ObjectID> ids;
+  bool unsafe = false;
+  TRY_READ_REQUEST(ReadGetBuffersRequestBinary, message_in, ids, unsafe);
+  return doGetBuffers(ids, unsafe, true);
+}
+
+bool SocketConnection::doGetBuffers(std::vector<ObjectID> const& ids,
+                                    const bool unsafe, const bool binary) {
+  auto self(shared_from_this());
   std::vector<std::shared_ptr<Payload>> objects;
   std::string message_out;
 
-  TRY_READ_REQUEST(ReadGetBuffersRequest, root, ids, unsafe);
   RESPONSE_ON_ERROR(bulk_store_->GetUnsafe(ids, unsafe, objects));
   RESPONSE_ON_ERROR(bulk_store_->AddDependency(
       std::unordered_set<ObjectID>(ids.begin(), ids.end()), this->getConnId()));
@@ -448,7 +933,11 @@ bool SocketConnection::doGetBuffers(const json& root) {
       fd_to_send.emplace_back(object->store_fd);
     }
   }
-  WriteGetBuffersReply(objects, fd_to_send, message_out);
+  if (binary) {
+    WriteGetBuffersReplyBinary(objects, fd_to_send, message_out);
+  } else {
+    WriteGetBuffersReply(objects, fd_to_send, message_out);
+  }
 
   /* NOTE: Here we send the file descriptor after the objects.
    *       We are using sendmsg to send the file descriptor
@@ -474,18 +963,22 @@ bool SocketConnection::doGetRemoteBuffers(const json& root) {
   auto self(shared_from_this());
   std::vector<ObjectID> ids;
   bool unsafe = false;
+  std::string compression;
   std::vector<std::shared_ptr<Payload>> objects;
   std::string message_out;
 
-  TRY_READ_REQUEST(ReadGetRemoteBuffersRequest, root, ids, unsafe);
+  TRY_READ_REQUEST(ReadGetRemoteBuffersRequest, root, ids, unsafe,
+                   compression);
+  std::shared_ptr<FrameCodec> codec;
+  RESPONSE_ON_ERROR(createFrameCodec(compression, codec));
   RESPONSE_ON_ERROR(bulk_store_->GetUnsafe(ids, unsafe, objects));
   RESPONSE_ON_ERROR(bulk_store_->AddDependency(
       std::unordered_set<ObjectID>(ids.begin(), ids.end()), this->getConnId()));
   WriteGetBuffersReply(objects, {}, message_out);
 
-  this->doWrite(message_out, [this, self, objects](const Status& status) {
-    boost::system::error_code ec;
-    sendRemoteBufferHelper(objects, 0, ec, [self](const Status& status) {
+  this->doWrite(message_out, [this, self, objects,
+                              codec](const Status& status) {
+    sendRemoteBuffers(objects, codec, [self](const Status& status) {
       if (!status.ok()) {
         LOG(ERROR) << "Failed to send buffers to remote client: "
                    << status.ToString();
@@ -497,15 +990,93 @@ bool SocketConnection::doGetRemoteBuffers(const json& root) {
   return false;
 }
 
+bool SocketConnection::doGetRemoteBufferChunks(const json& root) {
+  auto self(shared_from_this());
+  std::vector<ObjectID> ids;
+  std::vector<BufferChunk> chunks;
+  bool unsafe = false;
+  std::string compression;
+  std::vector<std::shared_ptr<Payload>> objects, chunk_objects;
+  std::string message_out;
+
+  TRY_READ_REQUEST(ReadGetRemoteBufferChunksRequest, root, ids, chunks,
+                   unsafe, compression);
+  std::shared_ptr<FrameCodec> codec;
+  RESPONSE_ON_ERROR(createFrameCodec(compression, codec));
+  RESPONSE_ON_ERROR(bulk_store_->GetUnsafe(ids, unsafe, objects));
+  std::vector<ObjectID> chunk_ids;
+  for (auto const& chunk : chunks) {
+    chunk_ids.emplace_back(chunk.id);
+  }
+  RESPONSE_ON_ERROR(bulk_store_->GetUnsafe(chunk_ids, unsafe, chunk_objects));
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    auto const& object = chunk_objects[i];
+    if (chunks[i].offset > static_cast<size_t>(object->data_size) ||
+        chunks[i].size > object->data_size - chunks[i].offset) {
+      RESPONSE_ON_ERROR(Status::Invalid(
+          "The chunk is out of the range of blob " +
+          ObjectIDToString(chunks[i].id) + ": offset = " +
+          std::to_string(chunks[i].offset) +
+          ", size = " + std::to_string(chunks[i].size)));
+    }
+  }
+  // reloads the spilled blobs and pins them in memory, thus the pointers are
+  // valid until the buffers have been sent
+  std::unordered_set<ObjectID> dependencies(ids.begin(), ids.end());
+  dependencies.insert(chunk_ids.begin(), chunk_ids.end());
+  RESPONSE_ON_ERROR(
+      bulk_store_->AddDependency(dependencies, this->getConnId()));
+  std::vector<boost::asio::const_buffer> buffers;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (chunks[i].size > 0) {
+      buffers.emplace_back(chunk_objects[i]->pointer + chunks[i].offset,
+                           chunks[i].size);
+    }
+  }
+  WriteGetRemoteBufferChunksReply(objects, message_out);
+
+  this->doWrite(message_out, [this, self, chunk_objects, buffers,
+                              codec](const Status& status) {
+    sendRemoteBuffers(
+        chunk_objects, buffers, codec, [self](const Status& status) {
+          if (!status.ok()) {
+            LOG(ERROR) << "Failed to send buffer chunks to remote client: "
+                       << status.ToString();
+          }
+          return Status::OK();
+        });
+    return Status::OK();
+  });
+  return false;
+}
+
 bool SocketConnection::doCreateBuffer(const json& root) {
   auto self(shared_from_this());
   size_t size;
+  int numa_node;
+  TRY_READ_REQUEST(ReadCreateBufferRequest, root, size, numa_node);
+  return doCreateBuffer(size, numa_node, false);
+}
+
+bool SocketConnection::doCreateBufferBinary(const std::string& message_in) {
+  auto self(shared_from_this());
+  size_t size;
+  int numa_node;
+  TRY_READ_REQUEST(ReadCreateBufferRequestBinary, message_in, size, numa_node);
+  return doCreateBuffer(size, numa_node, true);
+}
+
+bool SocketConnection::doCreateBuffer(const size_t size, int numa_node,
+                                      const bool binary) {
+  auto self(shared_from_this());
   std::shared_ptr<Payload> object;
   std::string message_out;
 
-  TRY_READ_REQUEST(ReadCreateBufferRequest, root, size);
+  if (numa_node == -1) {
+    numa_node = numa_node_;
+  }
   ObjectID object_id;
-  RESPONSE_ON_ERROR(bulk_store_->Create(size, object_id, object));
+  RESPONSE_ON_ERROR(bulk_store_->Create(size, object_id, object, numa_node));
 
   int fd_to_send = -1;
   if (object->data_size > 0 &&
@@ -514,7 +1085,11 @@ bool SocketConnection::doCreateBuffer(const json& root) {
     fd_to_send = object->store_fd;
   }
 
-  WriteCreateBufferReply(object_id, object, fd_to_send, message_out);
+  if (binary) {
+    WriteCreateBufferReplyBinary(object_id, object, fd_to_send, message_out);
+  } else {
+    WriteCreateBufferReply(object_id, object, fd_to_send, message_out);
+  }
 
   this->doWrite(message_out, [this, self, fd_to_send](const Status& status) {
     if (fd_to_send != -1) {
@@ -600,35 +1175,91 @@ bool SocketConnection::doCreateGPUBuffer(json const& root) {
   return false;
 }
 
+bool SocketConnection::doCreateBuffers(const json& root) {
+  auto self(shared_from_this());
+  std::vector<size_t> sizes;
+  int numa_node;
+  TRY_READ_REQUEST(ReadCreateBuffersRequest, root, sizes, numa_node);
+  if (numa_node == -1) {
+    numa_node = numa_node_;
+  }
+
+  std::vector<ObjectID> object_ids;
+  std::vector<std::shared_ptr<Payload>> objects;
+  for (size_t const size : sizes) {
+    ObjectID object_id;
+    std::shared_ptr<Payload> object;
+    Status status = bulk_store_->Create(size, object_id, object, numa_node);
+    if (!status.ok()) {
+      // don't leak the blobs that have been created by this request
+      for (auto const& id : object_ids) {
+        VINEYARD_DISCARD(bulk_store_->Delete(id));
+      }
+      RESPONSE_ON_ERROR(status);
+    }
+    object_ids.emplace_back(object_id);
+    objects.emplace_back(object);
+  }
+
+  // all fds are sent in a single pass after the reply
+  std::vector<int> fd_to_send;
+  for (auto const& object : objects) {
+    if (object->data_size > 0 &&
+        self->used_fds_.find(object->store_fd) == self->used_fds_.end()) {
+      self->used_fds_.emplace(object->store_fd);
+      fd_to_send.emplace_back(object->store_fd);
+    }
+  }
+
+  std::string message_out;
+  WriteCreateBuffersReply(object_ids, objects, fd_to_send, message_out);
+  this->doWrite(message_out, [this, self, fd_to_send](const Status& status) {
+    for (int store_fd : fd_to_send) {
+      send_fd(self->nativeHandle(), store_fd);
+    }
+    LOG_SUMMARY("instances_memory_usage_bytes", server_ptr_->instance_id(),
+                bulk_store_->Footprint());
+    return Status::OK();
+  });
+  return false;
+}
+
 bool SocketConnection::doCreateRemoteBuffer(const json& root) {
   auto self(shared_from_this());
   size_t size;
+  std::string compression;
   std::shared_ptr<Payload> object;
 
-  TRY_READ_REQUEST(ReadCreateRemoteBufferRequest, root, size);
+  TRY_READ_REQUEST(ReadCreateRemoteBufferRequest, root, size, compression);
+  std::shared_ptr<FrameCodec> codec;
+  RESPONSE_ON_ERROR(createFrameCodec(compression, codec));
   ObjectID object_id;
   RESPONSE_ON_ERROR(bulk_store_->Create(size, object_id, object));
   RESPONSE_ON_ERROR(bulk_store_->Seal(object_id));
 
-  boost::system::error_code ec;
-  this->recvRemoteBufferHelper(
-      object, 0, ec,
-      [self](const Status& status,
-             std::shared_ptr<Payload> const& object) -> Status {
-        std::string message_out;
-        if (status.ok()) {
-          WriteCreateBufferReply(object->object_id, object, -1, message_out);
-        } else {
-          // cleanup
-          VINEYARD_DISCARD(self->bulk_store_->Delete(object->object_id));
-          WriteErrorReply(status, message_out);
-        }
-        self->doWrite(message_out);
-        LOG_SUMMARY("instances_memory_usage_bytes",
-                    self->server_ptr_->instance_id(),
-                    self->bulk_store_->Footprint());
-        return Status::OK();
-      });
+  auto callback = [self](const Status& status,
+                         std::shared_ptr<Payload> const& object) -> Status {
+    std::string message_out;
+    if (status.ok()) {
+      WriteCreateBufferReply(object->object_id, object, -1, message_out);
+    } else {
+      // cleanup
+      VINEYARD_DISCARD(self->bulk_store_->Delete(object->object_id));
+      WriteErrorReply(status, message_out);
+    }
+    self->doWrite(message_out);
+    LOG_SUMMARY("instances_memory_usage_bytes",
+                self->server_ptr_->instance_id(),
+                self->bulk_store_->Footprint());
+    return Status::OK();
+  };
+  if (codec != nullptr) {
+    this->recvRemoteFrames(object, 0, std::make_shared<FrameReader>(codec),
+                           callback);
+  } else {
+    boost::system::error_code ec;
+    this->recvRemoteBufferHelper(object, 0, ec, callback);
+  }
   return false;
 }
 
@@ -694,9 +1325,11 @@ bool SocketConnection::doGetData(const json& root) {
   double startTime = GetCurrentTime();
   TRY_READ_REQUEST(ReadGetDataRequest, root, ids, sync_remote, wait);
   json tree;
+  uint64_t request_id = current_request_id;
   RESPONSE_ON_ERROR(server_ptr_->GetData(
       ids, sync_remote, wait, [self]() { return self->running_.load(); },
-      [self, startTime](const Status& status, const json& tree) {
+      [self, startTime, request_id](const Status& status, const json& tree) {
+        RequestIdScope request_id_scope(request_id);
         std::string message_out;
         if (status.ok()) {
           WriteGetDataReply(tree, message_out);
@@ -1176,6 +1809,19 @@ bool SocketConnection::doClear(const json& root) {
   return false;
 }
 
+bool SocketConnection::doSubscribeMeta(const json& root) {
+  auto self(shared_from_this());
+  std::string message_out;
+
+  TRY_READ_REQUEST(ReadSubscribeMetaRequest, root);
+  // subscribe before replying, to not miss the invalidations that happen
+  // after the client receives the reply
+  socket_server_ptr_->SubscribeMeta(conn_id_);
+  WriteSubscribeMetaReply(message_out);
+  this->doWrite(message_out);
+  return false;
+}
+
 bool SocketConnection::doDebug(const json& root) {
   std::string message_out;
   json result;
@@ -1293,10 +1939,40 @@ bool SocketConnection::doSealBlob(json const& root) {
   auto self(shared_from_this());
   ObjectID id;
   TRY_READ_REQUEST(ReadSealRequest, root, id);
+  return doSealBlob(id, false);
+}
+
+bool SocketConnection::doSealBlobBinary(const std::string& message_in) {
+  auto self(shared_from_this());
+  ObjectID id;
+  TRY_READ_REQUEST(ReadSealRequestBinary, message_in, id);
+  return doSealBlob(id, true);
+}
+
+bool SocketConnection::doSealBlob(ObjectID const id, const bool binary) {
+  auto self(shared_from_this());
   RESPONSE_ON_ERROR(bulk_store_->Seal(id));
   RESPONSE_ON_ERROR(bulk_store_->AddDependency(id, getConnId()));
   std::string message_out;
-  WriteSealReply(message_out);
+  if (binary) {
+    WriteSealReplyBinary(message_out);
+  } else {
+    WriteSealReply(message_out);
+  }
+  this->doWrite(message_out);
+  return false;
+}
+
+bool SocketConnection::doSealBlobs(json const& root) {
+  auto self(shared_from_this());
+  std::vector<ObjectID> ids;
+  TRY_READ_REQUEST(ReadSealBlobsRequest, root, ids);
+  for (auto const& id : ids) {
+    RESPONSE_ON_ERROR(bulk_store_->Seal(id));
+    RESPONSE_ON_ERROR(bulk_store_->AddDependency(id, getConnId()));
+  }
+  std::string message_out;
+  WriteSealBlobsReply(message_out);
   this->doWrite(message_out);
   return false;
 }
@@ -1411,11 +2087,28 @@ Status SocketConnection::MoveBuffers(
 
 bool SocketConnection::doRelease(json const& root) {
   auto self(shared_from_this());
-  ObjectID id;  // Must be a blob id.
-  TRY_READ_REQUEST(ReadReleaseRequest, root, id);
-  RESPONSE_ON_ERROR(bulk_store_->Release(id, getConnId()));
+  std::vector<ObjectID> ids;  // Must be blob ids.
+  TRY_READ_REQUEST(ReadReleaseRequest, root, ids);
+  return doRelease(ids, false);
+}
+
+bool SocketConnection::doReleaseBinary(const std::string& message_in) {
+  auto self(shared_from_this());
+  ObjectID id;
+  TRY_READ_REQUEST(ReadReleaseRequestBinary, message_in, id);
+  return doRelease(std::vector<ObjectID>{id}, true);
+}
+
+bool SocketConnection::doRelease(std::vector<ObjectID> const& ids,
+                                 const bool binary) {
+  auto self(shared_from_this());
+  RESPONSE_ON_ERROR(bulk_store_->Release(ids, getConnId()));
   std::string message_out;
-  WriteReleaseReply(message_out);
+  if (binary) {
+    WriteReleaseReplyBinary(message_out);
+  } else {
+    WriteReleaseReply(message_out);
+  }
   this->doWrite(message_out);
   return false;
 }
@@ -1491,24 +2184,28 @@ bool SocketConnection::doIncreaseReferenceCount(json const& root) {
 }
 
 void SocketConnection::doWrite(const std::string& buf) {
-  std::string to_send;
-  size_t length = buf.size();
-  to_send.resize(length + sizeof(size_t));
-  char* ptr = &to_send[0];
-  memcpy(ptr, &length, sizeof(size_t));
-  ptr += sizeof(size_t);
-  memcpy(ptr, buf.data(), length);
-  doAsyncWrite(std::move(to_send));
+  doWrite(buf, nullptr);
 }
 
 void SocketConnection::doWrite(const std::string& buf, callback_t<> callback) {
+  if (replying_to_channel) {
+    doAsyncWrite(std::string(buf), callback, true);
+    return;
+  }
+  std::string tagged;
+  const std::string* message = &buf;
+  if (current_request_id != 0 && !IsBinaryMessage(buf)) {
+    tagged = buf;
+    AttachRequestId(current_request_id, tagged);
+    message = &tagged;
+  }
   std::string to_send;
-  size_t length = buf.size();
+  size_t length = message->size();
   to_send.resize(length + sizeof(size_t));
   char* ptr = &to_send[0];
   memcpy(ptr, &length, sizeof(size_t));
   ptr += sizeof(size_t);
-  memcpy(ptr, buf.data(), length);
+  memcpy(ptr, message->data(), length);
   doAsyncWrite(std::move(to_send), callback);
 }
 
@@ -1516,6 +2213,15 @@ void SocketConnection::doWrite(std::string&& buf) {
   doAsyncWrite(std::move(buf));
 }
 
+void SocketConnection::Notify(std::string&& message,
+                              std::shared_ptr<void> const& written) {
+  if (running_.load()) {
+    // the callback is released once the message leaves the write queue
+    doAsyncWrite(std::move(message),
+                 [written](const Status&) { return Status::OK(); });
+  }
+}
+
 void SocketConnection::doStop() {
   if (this->Stop()) {
     // drop connection
@@ -1524,37 +2230,75 @@ void SocketConnection::doStop() {
 }
 
 void SocketConnection::doAsyncWrite(std::string&& buf) {
-  std::shared_ptr<std::string> payload =
-      std::make_shared<std::string>(std::move(buf));
+  doAsyncWrite(std::move(buf), nullptr);
+}
+
+void SocketConnection::doAsyncWrite(std::string&& buf, callback_t<> callback,
+                                    const bool to_channel) {
+  // replies of pipelined requests can be written from the IO threads and the
+  // meta service concurrently, queue them to avoid interleaving the messages
+  // and the file descriptors sent by the callbacks.
+  std::lock_guard<std::mutex> guard(write_mutex_);
+  write_queue_.push_back(PendingWrite{
+      std::make_shared<std::string>(std::move(buf)), callback, to_channel});
+  if (write_queue_.size() == 1) {
+    doAsyncWriteFront();
+  }
+}
+
+void SocketConnection::doAsyncWriteFront() {
+  // replies to the shared memory channel are pushed in place, the file
+  // descriptors are sent over the socket before the reply that refers to them
+  while (!write_queue_.empty() && write_queue_.front().to_channel) {
+    auto const& front = write_queue_.front();
+    Status status;
+    if (front.callback) {
+      status = front.callback(Status::OK());
+    }
+    if (status.ok()) {
+      status = channel_->SendReply(*front.payload);
+    }
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to reply to the shared memory channel: "
+                 << status.ToString();
+      write_queue_.clear();
+      doStop();
+      return;
+    }
+    write_queue_.pop_front();
+  }
+  if (write_queue_.empty()) {
+    return;
+  }
+  std::shared_ptr<std::string> payload = write_queue_.front().payload;
   auto self(shared_from_this());
   asio::async_write(
       socket_, boost::asio::buffer(payload->data(), payload->length()),
-      [this, self, payload](boost::system::error_code ec, std::size_t) {
-        if (ec) {
+      [this, self](boost::system::error_code ec, std::size_t) {
+        callback_t<> callback;
+        {
+          std::lock_guard<std::mutex> guard(write_mutex_);
+          callback = write_queue_.front().callback;
+        }
+        // the message stays at the front until the callback finishes, thus
+        // the following messages won't be written before the file descriptors
+        bool failed = static_cast<bool>(ec);
+        if (!failed && callback) {
+          failed = !callback(Status::OK()).ok();
+        }
+        std::lock_guard<std::mutex> guard(write_mutex_);
+        if (failed) {
+          write_queue_.clear();
           doStop();
+          return;
+        }
+        write_queue_.pop_front();
+        if (!write_queue_.empty()) {
+          doAsyncWriteFront();
         }
       });
 }
 
-void SocketConnection::doAsyncWrite(std::string&& buf, callback_t<> callback) {
-  std::shared_ptr<std::string> payload =
-      std::make_shared<std::string>(std::move(buf));
-  auto self(shared_from_this());
-  asio::async_write(socket_,
-                    boost::asio::buffer(payload->data(), payload->length()),
-                    [this, self, payload, callback](
-                        boost::system::error_code ec, std::size_t) {
-                      if (!ec) {
-                        auto status = callback(Status::OK());
-                        if (!status.ok()) {
-                          doStop();
-                        }
-                      } else {
-                        doStop();
-                      }
-                    });
-}
-
 SocketServer::SocketServer(std::shared_ptr<VineyardServer> vs_ptr)
     : vs_ptr_(vs_ptr), next_conn_id_(0) {}
 
@@ -1588,6 +2332,7 @@ void SocketServer::RemoveConnection(int conn_id) {
     if (conn != connections_.end()) {
       connections_.erase(conn);
     }
+    meta_subscribers_.erase(conn_id);
 
     if (AliveConnections() == 0 && closable_.load()) {
       VINEYARD_CHECK_OK(vs_ptr_->GetRunner()->Delete(vs_ptr_->session_id()));
@@ -1603,6 +2348,7 @@ void SocketServer::CloseConnection(int conn_id) {
       conn->second->Stop();
       connections_.erase(conn);
     }
+    meta_subscribers_.erase(conn_id);
   }
 
   if (AliveConnections() == 0 && closable_.load()) {
@@ -1615,4 +2361,35 @@ size_t SocketServer::AliveConnections() const {
   return connections_.size();
 }
 
+void SocketServer::SubscribeMeta(int conn_id) {
+  std::lock_guard<std::recursive_mutex> scope_lock(this->connections_mutex_);
+  if (connections_.find(conn_id) != connections_.end()) {
+    meta_subscribers_.emplace(conn_id);
+  }
+}
+
+void SocketServer::NotifyMetaInvalidation(
+    std::vector<ObjectID> const& ids, std::shared_ptr<void> const& written) {
+  if (ids.empty()) {
+    return;
+  }
+  std::vector<std::shared_ptr<SocketConnection>> subscribers;
+  {
+    std::lock_guard<std::recursive_mutex> scope_lock(this->connections_mutex_);
+    for (int conn_id : meta_subscribers_) {
+      auto conn = connections_.find(conn_id);
+      if (conn != connections_.end()) {
+        subscribers.emplace_back(conn->second);
+      }
+    }
+  }
+  // notify outside the lock, as a failed write removes the connection from
+  // the pool with the write lock of the connection held
+  std::string message_out;
+  WriteInvalidateMetaNotification(ids, message_out);
+  for (auto& conn : subscribers) {
+    conn->Notify(std::string(message_out), written);
+  }
+}
+
 }  // namespace vineyard
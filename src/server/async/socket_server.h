@@ -25,12 +25,15 @@ limitations under the License.
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "common/memory/gpu/unified_memory.h"
 #include "common/memory/payload.h"
+#include "common/memory/shm_channel.h"
 #include "common/util/asio.h"
 #include "common/util/callback.h"
+#include "common/util/compression.h"
 #include "common/util/logging.h"
 #include "common/util/protocols.h"
 #include "common/util/uuid.h"
@@ -65,19 +68,66 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
    */
   bool Stop();
 
+  /**
+   * @brief Push a message that is not a reply of any request to the client,
+   * e.g., the invalidation notifications of the metadata. The reference
+   * `written` is held until the message has been written, or dropped.
+   */
+  void Notify(std::string&& message, std::shared_ptr<void> const& written);
+
  protected:
   bool doRegister(json const& root);
 
+  /**
+   * @brief Create the shared memory control channel for the client, see also
+   * `ShmChannel`.
+   */
+  Status createChannel();
+
+  /**
+   * @brief Create the codec of frames for remote buffers, or leave `codec`
+   * null if `compression` is empty.
+   */
+  Status createFrameCodec(const std::string& compression,
+                          std::shared_ptr<FrameCodec>& codec);
+
+  /**
+   * @brief Wait for the requests in the shared memory channel, and process
+   * them once the client wakes up the server.
+   */
+  void doReadChannel();
+
   bool doGetBuffers(json const& root);
 
+  bool doGetBuffersBinary(std::string const& message_in);
+
+  bool doGetBuffers(std::vector<ObjectID> const& ids, const bool unsafe,
+                    const bool binary);
+
   /**
    * @brief doGetRemoteBuffers differs from doGetRemoteBuffers, that the
    * content of blob is in the response body, rather than via memory sharing.
    */
   bool doGetRemoteBuffers(json const& root);
 
+  /**
+   * @brief doGetRemoteBufferChunks sends byte ranges of blobs in the response
+   * body, which lets a migration stripe large blobs over many connections.
+   */
+  bool doGetRemoteBufferChunks(json const& root);
+
   bool doCreateBuffer(json const& root);
 
+  bool doCreateBufferBinary(std::string const& message_in);
+
+  bool doCreateBuffer(const size_t size, int numa_node, const bool binary);
+
+  /**
+   * @brief Create a list of blobs in a single request, the fds of these blobs
+   * are sent in a single pass after the reply.
+   */
+  bool doCreateBuffers(json const& root);
+
   /**
    * @brief doCreateBuffer differs from doCreateRemoteBuffer, that the content
    * of blob is in the request body, rather than via memory sharing.
@@ -134,6 +184,12 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   bool doClear(json const& root);
 
+  /**
+   * @brief Subscribe the invalidation notifications of the metadata on this
+   * connection, see also `SocketServer::NotifyMetaInvalidation`.
+   */
+  bool doSubscribeMeta(json const& root);
+
   bool doDebug(json const& root);
 
   bool doNewSession(json const& root);
@@ -146,6 +202,12 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   bool doSealBlob(json const& root);
 
+  bool doSealBlobBinary(std::string const& message_in);
+
+  bool doSealBlob(ObjectID const id, const bool binary);
+
+  bool doSealBlobs(json const& root);
+
   bool doSealPlasmaBlob(json const& root);
 
   bool doPlasmaRelease(json const& root);
@@ -156,6 +218,10 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   bool doRelease(json const& root);
 
+  bool doReleaseBinary(std::string const& message_in);
+
+  bool doRelease(std::vector<ObjectID> const& ids, const bool binary);
+
   bool doDelDataWithFeedbacks(json const& root);
 
   bool doIsInUse(json const& root);
@@ -186,6 +252,11 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
    */
   bool processMessage(const std::string& message_in);
 
+  /**
+   * @brief Process the binary encoded messages, see also `IsBinaryMessage()`.
+   */
+  bool processBinaryMessage(const std::string& message_in);
+
   void doReadHeader();
 
   void doReadBody();
@@ -206,16 +277,81 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   void doAsyncWrite(std::string&& buf);
 
-  void doAsyncWrite(std::string&& buf, callback_t<> callback);
+  /**
+   * The message is pushed to the shared memory channel rather than written to
+   * the socket if `to_channel` is true, after the messages queued before it.
+   */
+  void doAsyncWrite(std::string&& buf, callback_t<> callback,
+                    const bool to_channel = false);
+
+  /**
+   * Write the message at the front of the write queue, the caller must hold
+   * the `write_mutex_`.
+   */
+  void doAsyncWriteFront();
+
+  struct FrameWriter;
+  struct FrameReader;
+
+  /**
+   * Write the content of blobs to the remote client back to back, with a
+   * single scatter-gather write over all the blobs, or as frames of `codec`
+   * if it is not null.
+   */
+  void sendRemoteBuffers(std::vector<std::shared_ptr<Payload>> const& objects,
+                         std::shared_ptr<FrameCodec> const& codec,
+                         callback_t<> callback_after_finish);
+
+  /**
+   * Write the given ranges of blobs, `objects` keeps the blobs alive until
+   * the write finishes.
+   */
+  void sendRemoteBuffers(std::vector<std::shared_ptr<Payload>> const& objects,
+                         std::vector<boost::asio::const_buffer> const& buffers,
+                         std::shared_ptr<FrameCodec> const& codec,
+                         callback_t<> callback_after_finish);
+
+  /**
+   * Write the frames one after another, the next frame is compressed while
+   * the current one is being written.
+   */
+  void sendRemoteFrames(std::vector<std::shared_ptr<Payload>> const& objects,
+                        std::shared_ptr<FrameWriter> const& writer,
+                        callback_t<> callback_after_finish);
 
-  void sendRemoteBufferHelper(
-      std::vector<std::shared_ptr<Payload>> const& objects, size_t index,
-      boost::system::error_code const ec, callback_t<> callback_after_finish);
   void recvRemoteBufferHelper(
       std::shared_ptr<Payload> const& object, size_t offset,
       boost::system::error_code const ec,
       callback_t<std::shared_ptr<Payload> const&> callback_after_finish);
 
+  /**
+   * Receive the content of the blob as frames, and decompress them into the
+   * blob. A frame is decompressed while the next one is being received.
+   */
+  void recvRemoteFrames(
+      std::shared_ptr<Payload> const& object, size_t offset,
+      std::shared_ptr<FrameReader> const& reader,
+      callback_t<std::shared_ptr<Payload> const&> callback_after_finish);
+
+  /**
+   * Receive a compressed frame into a free buffer of the `reader`, and
+   * decompress it on the IO workers.
+   */
+  void recvRemoteFrame(
+      std::shared_ptr<Payload> const& object, size_t offset,
+      std::shared_ptr<FrameReader> const& reader, size_t raw_size,
+      size_t stored_size,
+      callback_t<std::shared_ptr<Payload> const&> callback_after_finish);
+
+  /**
+   * Finish the receiving with the first error, after the decompressions in
+   * flight finish.
+   */
+  void finishRemoteFrames(
+      std::shared_ptr<Payload> const& object,
+      std::shared_ptr<FrameReader> const& reader, Status const& status,
+      callback_t<std::shared_ptr<Payload> const&> callback_after_finish);
+
   stream_protocol::socket socket_;
   std::shared_ptr<VineyardServer> server_ptr_;
   std::shared_ptr<SocketServer> socket_server_ptr_;
@@ -227,6 +363,9 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
   int conn_id_;
   std::atomic_bool running_;
 
+  // the NUMA node where the client runs, -1 if unknown
+  int numa_node_;
+
   asio::streambuf buf_;
 
   std::unordered_set<int> used_fds_;
@@ -235,6 +374,21 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   size_t read_msg_header_;
   std::string read_msg_body_;
+
+  struct PendingWrite {
+    std::shared_ptr<std::string> payload;
+    callback_t<> callback;
+    bool to_channel;
+  };
+
+  // the pending replies and the callbacks after they are written
+  std::mutex write_mutex_;
+  std::deque<PendingWrite> write_queue_;
+
+  // the shared memory control channel, if negotiated when registering
+  std::unique_ptr<ShmChannel> channel_;
+  std::unique_ptr<asio::posix::stream_descriptor> channel_event_;
+  uint64_t channel_event_value_;
 };
 
 /**
@@ -285,6 +439,19 @@ class SocketServer {
    */
   size_t AliveConnections() const;
 
+  /**
+   * Subscribe the invalidation notifications of the metadata for the
+   * connection @conn_id@, the subscription lasts until the connection closes.
+   */
+  void SubscribeMeta(int conn_id);
+
+  /**
+   * Notify the subscribed connections that the metadata of the objects has
+   * been deleted or modified, see also `SocketConnection::Notify`.
+   */
+  void NotifyMetaInvalidation(std::vector<ObjectID> const& ids,
+                              std::shared_ptr<void> const& written);
+
  protected:
   std::atomic_bool stopped_;  // if the socket server being stopped.
 
@@ -293,6 +460,9 @@ class SocketServer {
   int next_conn_id_;
   std::unordered_map<int, std::shared_ptr<SocketConnection>> connections_;
   mutable std::recursive_mutex connections_mutex_;  // protect `connections_`
+  // the connections that subscribe the invalidation of metadata, protected by
+  // `connections_mutex_` as well
+  std::unordered_set<int> meta_subscribers_;
 
  private:
   virtual void doAccept() = 0;
@@ -32,9 +32,14 @@ https://github.com/apache/arrow/blob/master/cpp/src/plasma/plasma_allocator.cc
 #include <sys/mount.h>
 #endif
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/util/env.h"
 #include "common/util/logging.h"
@@ -46,9 +51,51 @@ https://github.com/apache/arrow/blob/master/cpp/src/plasma/plasma_allocator.cc
 
 namespace vineyard {
 
+namespace {
+
+// Size classes of small blobs are multiples of the block size, and grow by
+// about 1.5x to bound the internal fragmentation.
+constexpr size_t kSizeClasses[] = {64,   128,  192,  256,  384,  512,
+                                   768,  1024, 1536, 2048, 3072, 4096,
+                                   6144, 8192, 12288, 16384};
+constexpr size_t kNumSizeClasses = sizeof(kSizeClasses) / sizeof(size_t);
+
+struct Slab {
+  uint32_t capacity = 0;
+  uint32_t used = 0;
+  // chunks starting from `next` have never been allocated
+  uint32_t next = 0;
+  std::vector<uint32_t> free_chunks;
+};
+
+struct SizeClass {
+  std::mutex mutex;
+  std::unordered_map<uintptr_t, Slab> slabs;
+  // slabs that have free chunks, the ones at lower addresses are used first to
+  // pack small blobs into as few slabs as possible
+  std::set<uintptr_t> available;
+  // at most one empty slab is kept to avoid allocating and freeing slabs
+  // repeatedly
+  uintptr_t empty = 0;
+};
+
+SizeClass size_classes[kNumSizeClasses];
+
+size_t size_class_index(size_t bytes) {
+  return std::lower_bound(kSizeClasses, kSizeClasses + kNumSizeClasses,
+                          bytes) -
+         kSizeClasses;
+}
+
+}  // namespace
+
+constexpr size_t BulkAllocator::kSlabSize;
+constexpr size_t BulkAllocator::kMaxSizeClass;
+
 bool BulkAllocator::use_mimalloc_ = false;
+size_t BulkAllocator::small_blob_threshold_ = 0;
 int64_t BulkAllocator::footprint_limit_ = 0;
-int64_t BulkAllocator::allocated_ = 0;
+std::atomic<int64_t> BulkAllocator::allocated_{0};
 
 void* BulkAllocator::Init(const size_t size, std::string const& allocator) {
 #if __linux__
@@ -95,30 +142,117 @@ void* BulkAllocator::Init(const size_t size, std::string const& allocator) {
 }
 
 void* BulkAllocator::Memalign(const size_t bytes, const size_t alignment) {
-  if (allocated_ + static_cast<int64_t>(bytes) > footprint_limit_) {
-    return nullptr;
-  }
-
+  // the footprint counts what is taken from the backend, i.e., whole slabs
+  // rather than the chunks of small blobs in them
   void* mem = nullptr;
-  if (use_mimalloc_) {
-    mem = MimallocAllocator::Allocate(bytes, alignment);
-
-  } else {
-    mem = DLmallocAllocator::Allocate(bytes, alignment);
+  if (bytes <= small_blob_threshold_ &&
+      alignment <= static_cast<size_t>(memory::kBlockSize)) {
+    mem = AllocateSmall(bytes);
   }
-  if (mem != nullptr) {
-    allocated_ += bytes;
+  if (mem == nullptr) {
+    if (allocated_ + static_cast<int64_t>(bytes) > footprint_limit_) {
+      return nullptr;
+    }
+    mem = AllocateFromBackend(bytes, alignment);
+    if (mem != nullptr) {
+      allocated_ += bytes;
+    }
   }
   return mem;
 }
 
 void BulkAllocator::Free(void* mem, size_t bytes) {
+  // check the slabs even if the threshold is zero, as the threshold may have
+  // been changed after the blob is allocated
+  if (bytes > kMaxSizeClass || !FreeSmall(mem, bytes)) {
+    FreeToBackend(mem, bytes);
+    allocated_ -= bytes;
+  }
+}
+
+void* BulkAllocator::AllocateFromBackend(size_t bytes, size_t alignment) {
+  if (use_mimalloc_) {
+    return MimallocAllocator::Allocate(bytes, alignment);
+  } else {
+    return DLmallocAllocator::Allocate(bytes, alignment);
+  }
+}
+
+void BulkAllocator::FreeToBackend(void* mem, size_t bytes) {
   if (use_mimalloc_) {
     MimallocAllocator::Free(mem, bytes);
   } else {
     DLmallocAllocator::Free(mem, bytes);
   }
-  allocated_ -= bytes;
+}
+
+void* BulkAllocator::AllocateSmall(size_t bytes) {
+  size_t index = size_class_index(bytes);
+  size_t chunk_size = kSizeClasses[index];
+  SizeClass& size_class = size_classes[index];
+
+  std::lock_guard<std::mutex> guard(size_class.mutex);
+  if (size_class.available.empty()) {
+    if (allocated_ + static_cast<int64_t>(kSlabSize) > footprint_limit_) {
+      return nullptr;
+    }
+    // slabs are aligned to their size, then the slab of a chunk can be found
+    // by masking the address
+    void* mem = AllocateFromBackend(kSlabSize, kSlabSize);
+    if (mem == nullptr) {
+      return nullptr;
+    }
+    allocated_ += kSlabSize;
+    uintptr_t base = reinterpret_cast<uintptr_t>(mem);
+    size_class.slabs[base].capacity = kSlabSize / chunk_size;
+    size_class.available.emplace(base);
+  }
+  uintptr_t base = *size_class.available.begin();
+  Slab& slab = size_class.slabs[base];
+  uint32_t chunk = 0;
+  if (slab.free_chunks.empty()) {
+    chunk = slab.next++;
+  } else {
+    chunk = slab.free_chunks.back();
+    slab.free_chunks.pop_back();
+  }
+  slab.used += 1;
+  if (slab.used == slab.capacity) {
+    size_class.available.erase(base);
+  }
+  if (size_class.empty == base) {
+    size_class.empty = 0;
+  }
+  return reinterpret_cast<void*>(base + chunk * chunk_size);
+}
+
+bool BulkAllocator::FreeSmall(void* mem, size_t bytes) {
+  size_t index = size_class_index(bytes);
+  size_t chunk_size = kSizeClasses[index];
+  SizeClass& size_class = size_classes[index];
+  uintptr_t pointer = reinterpret_cast<uintptr_t>(mem);
+  uintptr_t base = pointer & ~(kSlabSize - 1);
+
+  std::lock_guard<std::mutex> guard(size_class.mutex);
+  auto iter = size_class.slabs.find(base);
+  if (iter == size_class.slabs.end()) {
+    return false;
+  }
+  Slab& slab = iter->second;
+  slab.free_chunks.push_back((pointer - base) / chunk_size);
+  slab.used -= 1;
+  if (slab.used == 0) {
+    if (size_class.empty != 0 && size_class.empty != base) {
+      size_class.available.erase(base);
+      size_class.slabs.erase(iter);
+      FreeToBackend(reinterpret_cast<void*>(base), kSlabSize);
+      allocated_ -= kSlabSize;
+      return true;
+    }
+    size_class.empty = base;
+  }
+  size_class.available.emplace(base);
+  return true;
 }
 
 void BulkAllocator::SetFootprintLimit(size_t bytes) {
@@ -127,6 +261,12 @@ void BulkAllocator::SetFootprintLimit(size_t bytes) {
 
 int64_t BulkAllocator::GetFootprintLimit() { return footprint_limit_; }
 
-int64_t BulkAllocator::Allocated() { return allocated_; }
+int64_t BulkAllocator::Allocated() { return allocated_.load(); }
+
+void BulkAllocator::SetSmallBlobThreshold(size_t bytes) {
+  small_blob_threshold_ = std::min(bytes, kMaxSizeClass);
+}
+
+size_t BulkAllocator::GetSmallBlobThreshold() { return small_blob_threshold_; }
 
 }  // namespace vineyard
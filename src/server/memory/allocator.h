@@ -29,6 +29,7 @@
 #ifndef SRC_SERVER_MEMORY_ALLOCATOR_H_
 #define SRC_SERVER_MEMORY_ALLOCATOR_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <string>
@@ -81,16 +82,48 @@ class BulkAllocator {
   /// \return Plasma memory footprint limit in bytes.
   static int64_t GetFootprintLimit();
 
-  /// Get the number of bytes allocated by Plasma so far.
+  /// Get the number of bytes allocated by Plasma so far, the slabs of small
+  /// blobs are counted as a whole.
   /// \return Number of bytes allocated by Plasma so far.
   static int64_t Allocated();
 
+  /// Sets the size threshold of small blobs, which are packed into slabs of
+  /// the same size class rather than allocated from the underlying allocator
+  /// one by one. Zero disables the slab layer.
+  ///
+  /// \param bytes Size threshold of small blobs, at most kMaxSizeClass.
+  static void SetSmallBlobThreshold(size_t bytes);
+
+  /// Get the size threshold of small blobs.
+  ///
+  /// \return Size threshold of small blobs in bytes.
+  static size_t GetSmallBlobThreshold();
+
+  /// The size of slabs, slabs are aligned to their size.
+  static constexpr size_t kSlabSize = 64 * 1024;
+
+  /// The largest size class.
+  static constexpr size_t kMaxSizeClass = kSlabSize / 4;
+
   using DLmallocAllocator = vineyard::memory::DLmallocAllocator;
   using MimallocAllocator = vineyard::memory::MimallocAllocator;
 
  private:
+  static void* AllocateFromBackend(size_t bytes, size_t alignment);
+
+  static void FreeToBackend(void* mem, size_t bytes);
+
+  /// Allocates a chunk from the slabs, a new slab is taken from the backend
+  /// and counted in the footprint when no slab has free chunks.
+  static void* AllocateSmall(size_t bytes);
+
+  /// Frees a chunk to its slab, returns false if the memory is not in any
+  /// slab. Empty slabs are given back to the backend except for the last one.
+  static bool FreeSmall(void* mem, size_t bytes);
+
   static bool use_mimalloc_;
-  static int64_t allocated_;
+  static size_t small_blob_threshold_;
+  static std::atomic<int64_t> allocated_;
   static int64_t footprint_limit_;
 };
 
@@ -0,0 +1,340 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_SERVER_MEMORY_EVICTION_H_
+#define SRC_SERVER_MEMORY_EVICTION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vineyard {
+
+namespace detail {
+
+/**
+ * @brief EvictionPolicy decides which cold blob will be spilled first. The
+ * candidates are the blobs that are not in use by any client:
+ *  - `Add(ID)` a blob becomes a candidate, i.e., it has been released.
+ *  - `Remove(ID)` a blob is no longer a candidate, i.e., it has been accessed
+ *    again, spilled or deleted.
+ *  - `Access(ID)` a blob is accessed by clients, no matter whether it is a
+ *    candidate, which is used by the frequency-based policies.
+ *  - `Victim(ID&)` choose the candidate to spill, without removing it.
+ *
+ * The policies are not thread-safe, and are protected by the cold object list
+ * in `ColdObjectTracker`.
+ */
+template <typename ID>
+class EvictionPolicy {
+ public:
+  virtual ~EvictionPolicy() = default;
+
+  virtual void Add(ID const& id) = 0;
+
+  virtual void Remove(ID const& id) = 0;
+
+  virtual void Access(ID const& id) {}
+
+  virtual bool Victim(ID& id) const = 0;
+
+  virtual size_t Size() const = 0;
+
+  /**
+   * @brief Create the policy by name, can be one of "lru" and "wtinylfu".
+   * Return nullptr for unknown policies.
+   */
+  static std::unique_ptr<EvictionPolicy<ID>> Make(std::string const& name);
+};
+
+/**
+ * @brief A list of ids ordered by the recency, the most recent one is at the
+ * front.
+ */
+template <typename ID>
+class RecencyList {
+ public:
+  void PushFront(ID const& id) {
+    list_.emplace_front(id);
+    map_[id] = list_.begin();
+  }
+
+  bool Erase(ID const& id) {
+    auto iter = map_.find(id);
+    if (iter == map_.end()) {
+      return false;
+    }
+    list_.erase(iter->second);
+    map_.erase(iter);
+    return true;
+  }
+
+  ID const& Back() const { return list_.back(); }
+
+  ID PopBack() {
+    ID id = list_.back();
+    map_.erase(id);
+    list_.pop_back();
+    return id;
+  }
+
+  bool Empty() const { return list_.empty(); }
+
+  size_t Size() const { return map_.size(); }
+
+ private:
+  std::list<ID> list_;
+  std::unordered_map<ID, typename std::list<ID>::iterator> map_;
+};
+
+/**
+ * @brief Spill the least recently released blob.
+ */
+template <typename ID>
+class LRUPolicy : public EvictionPolicy<ID> {
+ public:
+  void Add(ID const& id) override {
+    list_.Erase(id);
+    list_.PushFront(id);
+  }
+
+  void Remove(ID const& id) override { list_.Erase(id); }
+
+  bool Victim(ID& id) const override {
+    if (list_.Empty()) {
+      return false;
+    }
+    id = list_.Back();
+    return true;
+  }
+
+  size_t Size() const override { return list_.Size(); }
+
+ private:
+  RecencyList<ID> list_;
+};
+
+/**
+ * @brief A count-min sketch with 4-bit-like saturated counters that estimates
+ * the access frequency of blobs. The counters are halved periodically to let
+ * the history fade out.
+ */
+template <typename ID>
+class FrequencySketch {
+ public:
+  FrequencySketch() { Resize(kMinWidth); }
+
+  void Increment(ID const& id) {
+    uint64_t hash = Mix(std::hash<ID>()(id));
+    for (size_t row = 0; row < kDepth; ++row) {
+      uint8_t& counter = table_[row * width_ + Index(hash, row)];
+      if (counter < kMaxCount) {
+        counter += 1;
+      }
+    }
+    if (++additions_ >= width_ * 10) {
+      Age();
+    }
+  }
+
+  uint8_t Frequency(ID const& id) const {
+    uint64_t hash = Mix(std::hash<ID>()(id));
+    uint8_t frequency = kMaxCount;
+    for (size_t row = 0; row < kDepth; ++row) {
+      frequency =
+          std::min(frequency, table_[row * width_ + Index(hash, row)]);
+    }
+    return frequency;
+  }
+
+  /**
+   * @brief Grow the sketch to keep the error rate low when much more blobs are
+   * tracked. The history is discarded, thus the sketch starts with a table that
+   * is large enough for most workloads.
+   */
+  void EnsureCapacity(size_t capacity) {
+    size_t width = kMinWidth;
+    while (width < capacity) {
+      width <<= 1;
+    }
+    if (width > width_) {
+      Resize(width);
+    }
+  }
+
+ private:
+  static constexpr size_t kDepth = 4;
+  static constexpr size_t kMinWidth = 16384;
+  static constexpr uint8_t kMaxCount = 15;
+
+  static uint64_t Mix(uint64_t hash) {
+    // splitmix64
+    hash += 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+  }
+
+  // double hashing, the odd step keeps the rows of an id apart
+  size_t Index(uint64_t hash, size_t row) const {
+    uint64_t h1 = hash & 0xffffffffULL, h2 = (hash >> 32) | 1;
+    return static_cast<size_t>(h1 + row * h2) & (width_ - 1);
+  }
+
+  void Resize(size_t width) {
+    width_ = width;
+    additions_ = 0;
+    table_.assign(kDepth * width_, 0);
+  }
+
+  void Age() {
+    for (auto& counter : table_) {
+      counter >>= 1;
+    }
+    additions_ /= 2;
+  }
+
+  size_t width_ = 0;
+  size_t additions_ = 0;
+  std::vector<uint8_t> table_;
+};
+
+/**
+ * @brief W-TinyLFU: a small LRU window absorbs the newly released blobs, and
+ * the main space is a segmented LRU of a probation and a protected segment.
+ * Blobs that have been accessed more than once are released into the
+ * protected segment.
+ *
+ * Blobs leaving the window are admitted into the main space only if they are
+ * used more frequently than the victim of the main space, otherwise they will
+ * be spilled first. Thus a large scan, where every blob is accessed only once,
+ * won't flush the blobs that are reused frequently.
+ */
+template <typename ID>
+class WTinyLFUPolicy : public EvictionPolicy<ID> {
+ public:
+  void Add(ID const& id) override {
+    Remove(id);
+    sketch_.EnsureCapacity(Size() + 1);
+    if (sketch_.Frequency(id) > 1) {
+      protected_.PushFront(id);
+    } else {
+      window_.PushFront(id);
+    }
+    Rebalance();
+  }
+
+  void Remove(ID const& id) override {
+    if (!window_.Erase(id) && !probation_.Erase(id) && !protected_.Erase(id)) {
+      rejected_.Erase(id);
+    }
+  }
+
+  void Access(ID const& id) override { sketch_.Increment(id); }
+
+  bool Victim(ID& id) const override {
+    if (!rejected_.Empty()) {
+      id = rejected_.Back();
+      return true;
+    }
+    bool has_main = !probation_.Empty() || !protected_.Empty();
+    if (window_.Empty() && !has_main) {
+      return false;
+    }
+    if (!has_main) {
+      id = window_.Back();
+      return true;
+    }
+    ID const& main_victim =
+        probation_.Empty() ? protected_.Back() : probation_.Back();
+    if (window_.Empty()) {
+      id = main_victim;
+      return true;
+    }
+    // the blob in the window is preferred on ties
+    ID const& window_victim = window_.Back();
+    if (sketch_.Frequency(window_victim) <= sketch_.Frequency(main_victim)) {
+      id = window_victim;
+    } else {
+      id = main_victim;
+    }
+    return true;
+  }
+
+  size_t Size() const override {
+    return window_.Size() + probation_.Size() + protected_.Size() +
+           rejected_.Size();
+  }
+
+ private:
+  // window takes 1% of the candidates, and the protected segment takes at
+  // most 80% of the main space.
+  void Rebalance() {
+    size_t window_capacity = std::max<size_t>(1, Size() / 100);
+    while (window_.Size() > window_capacity) {
+      ID candidate = window_.PopBack();
+      if (Admit(candidate)) {
+        probation_.PushFront(candidate);
+      } else {
+        rejected_.PushFront(candidate);
+      }
+    }
+    size_t protected_capacity =
+        (probation_.Size() + protected_.Size()) * 4 / 5;
+    while (protected_.Size() > protected_capacity) {
+      probation_.PushFront(protected_.PopBack());
+    }
+  }
+
+  bool Admit(ID const& candidate) const {
+    if (probation_.Empty() && protected_.Empty()) {
+      return true;
+    }
+    ID const& main_victim =
+        probation_.Empty() ? protected_.Back() : probation_.Back();
+    return sketch_.Frequency(candidate) > sketch_.Frequency(main_victim);
+  }
+
+  RecencyList<ID> window_;
+  RecencyList<ID> probation_;
+  RecencyList<ID> protected_;
+  // blobs that are not admitted into the main space
+  RecencyList<ID> rejected_;
+  FrequencySketch<ID> sketch_;
+};
+
+template <typename ID>
+std::unique_ptr<EvictionPolicy<ID>> EvictionPolicy<ID>::Make(
+    std::string const& name) {
+  if (name == "lru") {
+    return std::unique_ptr<EvictionPolicy<ID>>(new LRUPolicy<ID>());
+  }
+  if (name == "wtinylfu") {
+    return std::unique_ptr<EvictionPolicy<ID>>(new WTinyLFUPolicy<ID>());
+  }
+  return nullptr;
+}
+
+}  // namespace detail
+
+}  // namespace vineyard
+
+#endif  // SRC_SERVER_MEMORY_EVICTION_H_
@@ -30,11 +30,24 @@
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include <unistd.h>
 
 #include <stddef.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "common/memory/fling.h"
 #include "common/util/flags.h"
 #include "common/util/logging.h"
 
@@ -57,7 +70,22 @@ constexpr int64_t kMmapRegionsGap = sizeof(size_t);
 // environment, pre-populate will archive a win.
 DEFINE_bool(reserve_memory, false, "Pre-reserving enough memory pages");
 
+// Backing the shared memory with huge pages reduces the page table size and
+// TLB misses when scanning large blobs, in both the server and clients. The
+// huge pages need to be reserved by the administrator in advance, e.g., via
+// `/proc/sys/vm/nr_hugepages`, otherwise we fall back to normal pages.
+DEFINE_string(reserve_huge_pages, "",
+              "Back the shared memory with huge pages, can be 2M or 1G");
+
+#if defined(__linux__) && !defined(MFD_HUGETLB)
+#define MFD_HUGETLB 0x0004U
+#endif
+#if defined(__linux__) && !defined(MFD_HUGE_SHIFT)
+#define MFD_HUGE_SHIFT 26
+#endif
+
 std::unordered_map<void*, MmapRecord> mmap_records;
+std::mutex mmap_records_mutex;
 
 static void* pointer_advance(void* p, ptrdiff_t n) {
   return (unsigned char*) p + n;
@@ -71,10 +99,78 @@ static ptrdiff_t pointer_distance(void const* pfrom, void const* pto) {
   return (unsigned char const*) pto - (unsigned char const*) pfrom;
 }
 
+static int64_t align_up(int64_t size, int64_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// The huge page size requested by `--reserve_huge_pages`, zero means huge
+// pages are not used.
+static int64_t requested_huge_page_size() {
+  static int64_t huge_page_size = []() -> int64_t {
+    std::string const& value = FLAGS_reserve_huge_pages;
+    if (value.empty()) {
+      return 0;
+    }
+    if (value == "2M" || value == "2Mi" || value == "2MB") {
+      return 2LL << 20;
+    }
+    if (value == "1G" || value == "1Gi" || value == "1GB") {
+      return 1LL << 30;
+    }
+    LOG(WARNING) << "Unsupported huge page size '" << value
+                 << "', expects 2M or 1G, falling back to normal pages";
+    return 0;
+  }();
+  return huge_page_size;
+}
+
+// Create a buffer backed by huge pages, return -1 if huge pages are not
+// available.
+static int create_huge_page_buffer(int64_t size) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+  int64_t huge_page_size = requested_huge_page_size();
+  if (huge_page_size == 0) {
+    return -1;
+  }
+  unsigned int flags = MFD_HUGETLB;
+  flags |= (huge_page_size == (1LL << 30) ? 30U : 21U) << MFD_HUGE_SHIFT;
+  int fd = static_cast<int>(syscall(SYS_memfd_create, "vineyard-bulk", flags));
+  if (fd < 0) {
+    LOG(WARNING) << "Failed to create huge page backed memory, falling back "
+                    "to normal pages: "
+                 << strerror(errno);
+    return -1;
+  }
+  // the file size on hugetlbfs must be a multiple of the huge page size, and
+  // the huge pages are allocated eagerly to find out whether there are enough
+  // huge pages in the pool, rather than failing later in mmap.
+  if (fallocate(fd, 0, 0, (off_t) align_up(size, huge_page_size)) != 0) {
+    LOG(WARNING) << "Failed to reserve " << size
+                 << " bytes of huge pages, falling back to normal pages: "
+                 << strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+#else
+  if (requested_huge_page_size() != 0) {
+    LOG(WARNING) << "Huge pages are not supported on this platform, falling "
+                    "back to normal pages";
+  }
+  return -1;
+#endif
+}
+
 // Create a buffer. This is creating a temporary file and then
 // immediately unlinking it so we do not leave traces in the system.
-int create_buffer(int64_t size, bool memory) {
+int create_buffer(int64_t size, bool memory, bool huge_pages) {
   int fd = -1;
+  if (memory && huge_pages) {
+    fd = create_huge_page_buffer(size);
+    if (fd != -1) {
+      return fd;
+    }
+  }
 #ifdef _WIN32
   if (!CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
                          (DWORD)((uint64_t) size >> (CHAR_BIT * sizeof(DWORD))),
@@ -145,7 +241,7 @@ void* mmap_buffer(int64_t size, bool* is_committed, bool* is_zero) {
   // fake_mmap are never contiguous.
   size += kMmapRegionsGap;
 
-  int fd = create_buffer(size);
+  int fd = create_buffer(size, true, true);
   return mmap_buffer(fd, size, is_committed, is_zero);
 }
 
@@ -160,6 +256,11 @@ void* mmap_buffer(int fd, int64_t size, bool* is_committed, bool* is_zero) {
   // pauses
   // when mmapping the files. Only supported on Linux.
 
+  // the mapped size of huge pages must be aligned, and clients are expected
+  // to align it in the same way, see also `MmapEntry`.
+  int64_t page_size = file_page_size(fd);
+  size = align_up(size, page_size);
+
   int mmap_flag = MAP_SHARED;
   if (FLAGS_reserve_memory) {
 #ifdef __linux__
@@ -174,9 +275,11 @@ void* mmap_buffer(int fd, int64_t size, bool* is_committed, bool* is_zero) {
     return pointer;
   }
 
+  std::lock_guard<std::mutex> guard(mmap_records_mutex);
   MmapRecord& record = mmap_records[pointer];
   record.fd = fd;
   record.size = size;
+  record.page_size = page_size;
 
   // We lie to dlmalloc/mimalloc about where mapped memory actually lives.
   pointer = pointer_advance(pointer, kMmapRegionsGap);
@@ -187,15 +290,17 @@ int munmap_buffer(void* addr, int64_t size) {
   addr = pointer_retreat(addr, kMmapRegionsGap);
   size += kMmapRegionsGap;
 
+  std::lock_guard<std::mutex> guard(mmap_records_mutex);
   auto entry = mmap_records.find(addr);
 
-  if (entry == mmap_records.end() || entry->second.size != size) {
+  if (entry == mmap_records.end() ||
+      entry->second.size != align_up(size, entry->second.page_size)) {
     // Reject requests to munmap that don't directly match previous
     // calls to mmap, to prevent dlmalloc from trimming.
     return -1;
   }
 
-  int r = munmap(addr, size);
+  int r = munmap(addr, entry->second.size);
   if (r == 0) {
     close(entry->second.fd);
   }
@@ -204,10 +309,94 @@ int munmap_buffer(void* addr, int64_t size) {
   return r;
 }
 
+int bind_to_numa_node(void* addr, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  constexpr int kMpolPreferred = 1;
+  constexpr unsigned int kMpolMfMove = 1 << 1;
+  constexpr int kMaxNodes = 1024;
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;  // NOLINT
+  if (node < 0 || node >= kMaxNodes) {
+    errno = EINVAL;
+    return -1;
+  }
+  uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  {
+    std::lock_guard<std::mutex> guard(mmap_records_mutex);
+    for (const auto& entry : mmap_records) {
+      if (addr >= entry.first &&
+          addr < pointer_advance(entry.first, entry.second.size)) {
+        page_size = entry.second.page_size;
+        break;
+      }
+    }
+  }
+  uintptr_t begin =
+      (reinterpret_cast<uintptr_t>(addr) + page_size - 1) & ~(page_size - 1);
+  uintptr_t end =
+      (reinterpret_cast<uintptr_t>(addr) + size) & ~(page_size - 1);
+  if (begin >= end) {
+    // no page belongs to the range alone, leave it to the first touch
+    return 0;
+  }
+  unsigned long nodemask[kMaxNodes / kBitsPerWord] = {0};  // NOLINT
+  nodemask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  if (syscall(SYS_mbind, begin, end - begin, kMpolPreferred, nodemask,
+              kMaxNodes, kMpolMfMove) != 0) {
+    return -1;
+  }
+#endif
+  return 0;
+}
+
+void GetNumaUsage(std::map<int, int64_t>& usage) {
+#ifdef __linux__
+  // each line looks like
+  //
+  //    7f0e2e600000 default file=/dev/shm/vineyard-bulk-Xb1c2d\040(deleted)
+  //        dirty=1024 mapmax=2 N0=768 N1=256 kernelpagesize_kB=4
+  std::set<void*> mappings;
+  {
+    std::lock_guard<std::mutex> guard(mmap_records_mutex);
+    for (const auto& entry : mmap_records) {
+      mappings.emplace(entry.first);
+    }
+  }
+  std::ifstream numa_maps("/proc/self/numa_maps");
+  std::string line;
+  while (std::getline(numa_maps, line)) {
+    std::istringstream fields(line);
+    std::string field;
+    fields >> field;
+    void* address = reinterpret_cast<void*>(std::stoull(field, nullptr, 16));
+    if (mappings.find(address) == mappings.end()) {
+      continue;
+    }
+    int64_t page_size = 4096;
+    std::map<int, int64_t> pages;
+    while (fields >> field) {
+      size_t pos = field.find('=');
+      if (pos == std::string::npos) {
+        continue;
+      }
+      if (field[0] == 'N' && std::isdigit(field[1])) {
+        pages[std::stoi(field.substr(1, pos - 1))] +=
+            std::stoll(field.substr(pos + 1));
+      } else if (field.compare(0, pos, "kernelpagesize_kB") == 0) {
+        page_size = std::stoll(field.substr(pos + 1)) * 1024;
+      }
+    }
+    for (auto const& item : pages) {
+      usage[item.first] += item.second * page_size;
+    }
+  }
+#endif
+}
+
 void GetMallocMapinfo(void* addr, int* fd, int64_t* map_size,
                       ptrdiff_t* offset) {
   // About the efficiences: the records size usually small, thus linear search
   // is enough.
+  std::lock_guard<std::mutex> guard(mmap_records_mutex);
   for (const auto& entry : mmap_records) {
     if (addr >= entry.first &&
         addr < pointer_advance(entry.first, entry.second.size)) {
@@ -32,6 +32,8 @@
 #include <inttypes.h>
 #include <stddef.h>
 
+#include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -48,6 +50,9 @@ void GetMallocMapinfo(void* addr, int* fd, int64_t* map_length,
 struct MmapRecord {
   int fd = -1;
   int64_t size = -1;
+  // the page size of the mapping, which is larger than the system page size
+  // when backed by huge pages.
+  int64_t page_size = 4096;
 };
 
 /// Hashtable that contains one entry per segment that we got from the OS
@@ -55,11 +60,17 @@ struct MmapRecord {
 /// and size.
 extern std::unordered_map<void*, MmapRecord> mmap_records;
 
+/// Guards `mmap_records`, which is read by the status reports concurrently
+/// with the allocations.
+extern std::mutex mmap_records_mutex;
+
 // Create a buffer. This is creating a temporary file and then
 // immediately unlinking it so we do not leave traces in the system.
 //
-// Returns a fd as expected.
-int create_buffer(int64_t size, bool memory = true);
+// Returns a fd as expected. Memory-backed buffers are backed by huge pages
+// if `huge_pages` is true and `--reserve_huge_pages` is set, the mapped length
+// of which must be aligned to the huge page size.
+int create_buffer(int64_t size, bool memory = true, bool huge_pages = false);
 
 // Returns a fd of the corresponding path as expected.
 int create_buffer(int64_t size, std::string const& path);
@@ -73,6 +84,20 @@ void* mmap_buffer(int fd, int64_t size, bool* is_committed, bool* is_zero);
 // Unmap the buffer.
 int munmap_buffer(void* addr, int64_t size);
 
+// Prefer placing the pages of the given range on the NUMA node, the pages that
+// have been touched are migrated if possible.
+//
+// Only the pages that lie entirely inside the range are bound, i.e., the range
+// is shrunk to the page size of the mapping (the huge page size for mappings
+// backed by huge pages), thus the pages shared with the neighbouring blobs
+// are never moved.
+//
+// Returns 0 on success, or -1 with `errno` set when `mbind` fails.
+int bind_to_numa_node(void* addr, size_t size, int node);
+
+// Collect how many bytes of the mapped shared memory reside on each NUMA node.
+void GetNumaUsage(std::map<int, int64_t>& usage);
+
 }  // namespace memory
 
 }  // namespace vineyard
@@ -31,7 +31,9 @@
 #include <sys/mman.h>
 
 #include <algorithm>
+#include <cerrno>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <map>
 #include <memory>
@@ -39,6 +41,7 @@
 #include <string>
 #include <vector>
 
+#include "common/util/env.h"
 #include "common/util/logging.h"
 #include "common/util/status.h"
 #include "server/memory/allocator.h"
@@ -453,6 +456,7 @@ Status BulkStoreBase<ID, P>::FinalizeArena(const int fd,
   { memory::recycle_arena(mmap_base, mmap_size, offsets, sizes); }
   // make it available for mmap record
   {
+    std::lock_guard<std::mutex> guard(memory::mmap_records_mutex);
     memory::MmapRecord& record =
         memory::mmap_records[reinterpret_cast<void*>(mmap_base)];
     record.fd = fd;
@@ -505,7 +509,8 @@ template class BulkStoreBase<PlasmaID, PlasmaPayload>;
 
 // implementation for BulkStore
 Status BulkStore::Create(const size_t data_size, ObjectID& object_id,
-                         std::shared_ptr<Payload>& object) {
+                         std::shared_ptr<Payload>& object,
+                         const int numa_node) {
   if (data_size == 0) {
     object_id = EmptyBlobID<ObjectID>();
     object = Payload::MakeEmpty();
@@ -523,6 +528,11 @@ Status BulkStore::Create(const size_t data_size, ObjectID& object_id,
         std::to_string(FootprintLimit()) + ", and " +
         std::to_string(Footprint()) + " are already in use");
   }
+  if (numa_node >= 0 && get_numa_node_count() > 1 &&
+      memory::bind_to_numa_node(pointer, data_size, numa_node) != 0) {
+    LOG(WARNING) << "Failed to bind the blob of size " << data_size
+                 << " to NUMA node " << numa_node << ": " << strerror(errno);
+  }
   object_id = GenerateBlobID<ObjectID>(pointer);
   object = std::make_shared<Payload>(object_id, data_size, pointer, fd,
                                      map_size, offset);
@@ -544,6 +554,14 @@ Status BulkStore::Release(ObjectID const& id, int conn) {
   return this->RemoveDependency(id, conn);
 }
 
+Status BulkStore::Release(std::vector<ObjectID> const& ids, int conn) {
+  Status status;
+  for (auto const& id : ids) {
+    status += this->RemoveDependency(id, conn);
+  }
+  return status;
+}
+
 Status BulkStore::FetchAndModify(const ObjectID& id, int64_t& ref_cnt,
                                  int64_t changes) {
   typename object_map_t::const_accessor accessor;
@@ -148,10 +148,11 @@ class BulkStore
       public std::enable_shared_from_this<BulkStore> {
  public:
   /*
-   * @brief Allocate space for a new blob.
+   * @brief Allocate space for a new blob, the pages are preferred to be placed
+   * on the given NUMA node if `numa_node` is not -1.
    */
   Status Create(const size_t size, ObjectID& object_id,
-                std::shared_ptr<Payload>& object);
+                std::shared_ptr<Payload>& object, const int numa_node = -1);
 
   /*
    * @brief Decrease the reference count of a blob, when its reference count
@@ -159,6 +160,12 @@ class BulkStore
    */
   Status Release(ObjectID const& id, int conn);
 
+  /*
+   * @brief Decrease the reference count of a list of blobs, the rest blobs are
+   * still released when some of them fail.
+   */
+  Status Release(std::vector<ObjectID> const& ids, int conn);
+
   /*
    * @brief Allocate space for a new blob on gpu.
    */
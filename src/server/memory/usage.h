@@ -16,7 +16,11 @@ limitations under the License.
 #ifndef SRC_SERVER_MEMORY_USAGE_H_
 #define SRC_SERVER_MEMORY_USAGE_H_
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <list>
 #include <map>
 #include <memory>
@@ -24,6 +28,7 @@ limitations under the License.
 #include <set>
 #include <shared_mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -37,6 +42,7 @@ limitations under the License.
 #include "common/util/logging.h"
 #include "common/util/status.h"
 #include "server/memory/allocator.h"
+#include "server/memory/eviction.h"
 #include "server/util/file_io_adaptor.h"
 #include "server/util/spill_file.h"
 
@@ -184,45 +190,64 @@ class ColdObjectTracker
     : public DependencyTracker<ID, P, ColdObjectTracker<ID, P, Der>> {
  public:
   /*
-   * @brief LRU is a tracker of least recent used blob ID, it has two methods:
+   * @brief ColdObjectList tracks the blobs that are not in use, and spills
+   * them in the order decided by the eviction policy, see `EvictionPolicy`:
    * - `Ref(ID id)` Add the id if not exists. (Actually here we shouldn't expect
    *    a redundant Ref, because no Object will be insert twice). But in current
    *    implementation, we will overwrite the previous one.
-   * - `Unref(ID id)` Remove the designated id from lru.
-   * - `PopLeastUsed()` Get the least used blob id. If no object in structure,
-   * then statu will be Invalids.
+   * - `Unref(ID id)` Remove the designated id from the list.
+   * - `Spill(size_t sz)` Spill the victims until enough memory is released.
    * - `CheckExist(ID id)` Check the existence of id.
+   *
+   * The blobs are sharded by the hash of ID, and each shard has its own lock
+   * and eviction policy, thus releasing and getting blobs from many clients
+   * won't be serialized on a single lock. Spilling takes victims from shards
+   * in turn, i.e., the order is approximately global.
    */
-  class LRU {
+  class ColdObjectList {
    public:
-    using value_t = std::pair<ID, std::shared_ptr<P>>;
-    using lru_map_t =
-        std::unordered_map<ID, typename std::list<value_t>::iterator>;
-    using lru_list_t = std::list<value_t>;
+    explicit ColdObjectList(std::string const& policy = "lru") {
+      for (auto& shard : shards_) {
+        shard.policy = EvictionPolicy<ID>::Make(policy);
+      }
+    }
+    ~ColdObjectList() = default;
 
-    LRU() = default;
-    ~LRU() = default;
+    /**
+     * @brief Switch to another eviction policy, the tracked blobs are kept.
+     */
+    Status SetPolicy(std::string const& policy) {
+      for (auto& shard : shards_) {
+        auto policy_ptr = EvictionPolicy<ID>::Make(policy);
+        if (policy_ptr == nullptr) {
+          return Status::Invalid("Unknown eviction policy: " + policy);
+        }
+        std::lock_guard<decltype(shard.mu)> locked(shard.mu);
+        for (auto const& item : shard.map) {
+          policy_ptr->Add(item.first);
+        }
+        shard.policy = std::move(policy_ptr);
+      }
+      return Status::OK();
+    }
 
     void Ref(ID id, std::shared_ptr<P> payload) {
-      std::lock_guard<decltype(mu_)> locked(mu_);
-      auto it = map_.find(id);
-      if (it == map_.end()) {
-        list_.emplace_front(id, payload);
-        map_.emplace(id, list_.begin());
-      } else {
-        list_.erase(it->second);
-        list_.emplace_front(id, payload);
-        it->second = list_.begin();
-      }
+      auto& shard = ShardOf(id);
+      std::unique_lock<decltype(shard.mu)> locked(shard.mu);
+      WaitForTransit(shard, locked, id);
+      shard.map[id] = payload;
+      shard.policy->Add(id);
     }
 
     bool CheckExist(ID id) const {
-      std::lock_guard<decltype(mu_)> locked(mu_);
-      return map_.find(id) != map_.end();
+      auto& shard = ShardOf(id);
+      std::unique_lock<decltype(shard.mu)> locked(shard.mu);
+      WaitForTransit(shard, locked, id);
+      return shard.map.find(id) != shard.map.end();
     }
 
     /**
-     * @brief Here we have two actions: 1. delete from lru_list
+     * @brief Here we have two actions: 1. delete from the cold list
      *        2. delete from spilled_obj_
      * @param id is the objectID
      * @param fast_delete indicates if we directly remove the spilled object
@@ -232,76 +257,272 @@ class ColdObjectTracker
      */
     Status Unref(const ID& id, bool fast_delete,
                  std::shared_ptr<Der> store_ptr) {
-      std::lock_guard<decltype(mu_)> locked(mu_);
-      auto it = map_.find(id);
-      if (it == map_.end()) {
-        auto it = spilled_obj_.find(id);
-        if (it == spilled_obj_.end()) {
+      auto& shard = ShardOf(id);
+      std::unique_lock<decltype(shard.mu)> locked(shard.mu);
+      WaitForTransit(shard, locked, id);
+      if (!fast_delete) {
+        shard.policy->Access(id);
+      }
+      auto it = shard.map.find(id);
+      if (it == shard.map.end()) {
+        auto it = shard.spilled_obj.find(id);
+        if (it == shard.spilled_obj.end()) {
+          if (fast_delete) {
+            // the blob may be in use while being served from the spill file
+            return store_ptr->DeletePayloadFile(id);
+          }
           return Status::OK();
         }
-        if (!fast_delete) {
-          RETURN_ON_ERROR(store_ptr->ReloadPayload(id, it->second));
-        } else {
+        if (fast_delete) {
           RETURN_ON_ERROR(store_ptr->DeletePayloadFile(id));
+          shard.spilled_obj.erase(it);
+          return Status::OK();
         }
-        spilled_obj_.erase(it);
-        return Status::OK();
+        auto payload = it->second;
+        auto status = Transit(shard, locked, id, [&]() {
+          return store_ptr->ReloadPayload(id, payload);
+        });
+        if (status.ok()) {
+          shard.spilled_obj.erase(id);
+        }
+        return status;
       } else {
-        list_.erase(it->second);
-        map_.erase(it);
+        auto payload = it->second;
+        shard.policy->Remove(id);
+        shard.map.erase(it);
+        if (store_ptr->IsMapped(payload)) {
+          if (!fast_delete) {
+            // the blob becomes hot again
+            return Transit(shard, locked, id, [&]() {
+              return store_ptr->PromotePayload(id, payload);
+            });
+          }
+          return store_ptr->DeletePayloadFile(id);
+        }
         return Status::OK();
       }
     }
 
-    Status Spill(size_t sz, std::shared_ptr<Der> bulk_store_ptr) {
-      std::lock_guard<decltype(mu_)> locked(mu_);
+    /**
+     * @brief Spill the victims chosen by the eviction policy until at least
+     * `sz` bytes have been spilled, or no cold blob is left.
+     *
+     * The lock of a shard is only held for choosing a victim, the victim is
+     * written to disk without it, see `Transit()`, thus `Ref` and `Unref` of
+     * other blobs won't be blocked by a long running spill. Shards that are
+     * locked by others are skipped rather than waited for.
+     */
+    Status Spill(size_t sz, ColdObjectTracker* tracker) {
       size_t spilled_sz = 0;
-      auto st = Status::OK();
-      auto it = list_.rbegin();
-      while (it != list_.rend()) {
-        st = bulk_store_ptr->SpillPayload(it->second);
-        if (!st.ok()) {
-          LOG(ERROR) << st.ToString();
-          break;
+      int retries = 0;
+      while (spilled_sz < sz) {
+        bool progress = false, busy = false;
+        for (size_t i = 0; i < kShards && spilled_sz < sz; ++i) {
+          auto& shard = shards_[spill_cursor_.fetch_add(1) % kShards];
+          std::unique_lock<decltype(shard.mu)> locked(shard.mu,
+                                                      std::try_to_lock);
+          if (!locked.owns_lock()) {
+            busy = true;
+            continue;
+          }
+          ID id;
+          if (!shard.policy->Victim(id)) {
+            continue;
+          }
+          if (shard.in_transit.find(id) != shard.in_transit.end()) {
+            // being relocated by the compaction
+            busy = true;
+            continue;
+          }
+          auto victim = shard.map.at(id);
+          shard.policy->Remove(id);
+          shard.map.erase(id);
+          // blobs served from the spill file don't occupy memory
+          bool is_mapped = tracker->IsMapped(victim);
+          auto st = Transit(shard, locked, id,
+                            [&]() { return tracker->SpillPayload(victim); });
+          if (!st.ok()) {
+            // still cold, and the next spilling may retry it
+            shard.map[id] = victim;
+            shard.policy->Add(id);
+            LOG(ERROR) << st.ToString();
+            return st;
+          }
+          if (!is_mapped) {
+            spilled_sz += victim->data_size;
+          }
+          shard.spilled_obj.emplace(id, victim);
+          progress = true;
         }
-        spilled_sz += it->second->data_size;
-        spilled_obj_.emplace(it->first, it->second);
-        map_.erase(it->first);
-        it++;
-        if (sz <= spilled_sz) {
-          break;
+        if (!progress) {
+          if (!busy || ++retries > kSpillRetries) {
+            break;
+          }
+          std::this_thread::yield();
         }
       }
-      auto poped_size = std::distance(list_.rbegin(), it);
-      while (poped_size-- > 0) {
-        list_.pop_back();
-      }
-      if (st.ok() && spilled_sz == 0) {
+      if (spilled_sz == 0) {
         return Status::NotEnoughMemory("Nothing spilled");
       }
-      return st;
+      return Status::OK();
     }
 
     bool CheckSpilled(const ID& id) {
-      std::lock_guard<decltype(mu_)> locked(mu_);
-      return spilled_obj_.find(id) != spilled_obj_.end();
+      auto& shard = ShardOf(id);
+      std::unique_lock<decltype(shard.mu)> locked(shard.mu);
+      WaitForTransit(shard, locked, id);
+      return shard.spilled_obj.find(id) != shard.spilled_obj.end();
+    }
+
+    /**
+     * @brief Relocate the cold blobs that reside in memory, starting from the
+     * one at the highest address, until `budget` bytes have been moved. As the
+     * underlying allocators prefer the lower addresses, moving the blobs at
+     * the top downwards packs them together and frees contiguous space.
+     *
+     * Cold blobs are not held by any client, and getting a blob needs to
+     * remove it from the list first, which waits until the blob has been
+     * moved, see `Transit()`. The allocation and the copy are done without
+     * the lock of the shard.
+     *
+     * @param moved The bytes that have been moved.
+     * @param reclaimed How much the top of the cold blobs has been lowered.
+     */
+    Status Compact(size_t budget, ColdObjectTracker* tracker, size_t& moved,
+                   size_t& reclaimed) {
+      std::vector<std::pair<uintptr_t, ID>> candidates;
+      for (auto& shard : shards_) {
+        std::lock_guard<decltype(shard.mu)> locked(shard.mu);
+        for (auto const& item : shard.map) {
+          if (tracker->IsRelocatable(item.second) &&
+              static_cast<size_t>(item.second->data_size) <= budget) {
+            candidates.emplace_back(
+                reinterpret_cast<uintptr_t>(item.second->pointer), item.first);
+          }
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(),
+                [](std::pair<uintptr_t, ID> const& lhs,
+                   std::pair<uintptr_t, ID> const& rhs) {
+                  return lhs.first > rhs.first;
+                });
+
+      moved = 0;
+      reclaimed = 0;
+      uintptr_t top = 0, new_top = 0;
+      for (auto const& candidate : candidates) {
+        auto& shard = ShardOf(candidate.second);
+        std::unique_lock<decltype(shard.mu)> locked(shard.mu,
+                                                    std::try_to_lock);
+        if (!locked.owns_lock()) {
+          continue;
+        }
+        auto iter = shard.map.find(candidate.second);
+        if (iter == shard.map.end() ||
+            reinterpret_cast<uintptr_t>(iter->second->pointer) !=
+                candidate.first) {
+          continue;
+        }
+        auto payload = iter->second;
+        uintptr_t end = candidate.first + payload->data_size;
+        top = std::max(top, end);
+        if (moved + static_cast<size_t>(payload->data_size) > budget) {
+          new_top = std::max(new_top, end);
+          break;
+        }
+        // the blob is kept in the list while being copied, but won't be
+        // chosen as a victim
+        bool relocated = false;
+        RETURN_ON_ERROR(Transit(shard, locked, candidate.second, [&]() {
+          return tracker->RelocatePayload(payload, relocated);
+        }));
+        if (relocated) {
+          moved += payload->data_size;
+          end = reinterpret_cast<uintptr_t>(payload->pointer) +
+                payload->data_size;
+        }
+        new_top = std::max(new_top, end);
+      }
+      if (new_top < top) {
+        reclaimed = top - new_top;
+      }
+      return Status::OK();
     }
 
    private:
-    mutable std::recursive_mutex mu_;
-    // protected by mu_
-    lru_map_t map_;
-    lru_list_t list_;
-    std::unordered_map<ID, std::shared_ptr<P>> spilled_obj_;
+    static constexpr size_t kShards = 16;
+    static constexpr int kSpillRetries = 64;
+
+    struct Shard {
+      mutable std::recursive_mutex mu;
+      // notified when blobs finish the transit
+      mutable std::condition_variable_any transit_cv;
+      // protected by mu
+      std::unique_ptr<EvictionPolicy<ID>> policy;
+      std::unordered_map<ID, std::shared_ptr<P>> map;
+      std::unordered_map<ID, std::shared_ptr<P>> spilled_obj;
+      // the blobs that are being moved without the lock: the blobs being
+      // spilled, reloaded or promoted are neither in `map` nor in
+      // `spilled_obj`, and the blobs being compacted are kept in `map`.
+      std::unordered_set<ID> in_transit;
+    };
+
+    static void WaitForTransit(
+        Shard const& shard, std::unique_lock<decltype(Shard::mu)>& locked,
+        ID const& id) {
+      shard.transit_cv.wait(locked, [&shard, &id]() {
+        return shard.in_transit.find(id) == shard.in_transit.end();
+      });
+    }
+
+    /**
+     * @brief Run the disk IO, the allocation and the copy of moving the blob
+     * without holding the lock of the shard, other accesses to the blob wait
+     * until it finishes.
+     */
+    template <typename F>
+    static Status Transit(Shard& shard,
+                          std::unique_lock<decltype(Shard::mu)>& locked,
+                          ID const& id, F&& move) {
+      shard.in_transit.emplace(id);
+      locked.unlock();
+      auto status = move();
+      locked.lock();
+      shard.in_transit.erase(id);
+      shard.transit_cv.notify_all();
+      return status;
+    }
+
+    Shard& ShardOf(ID const& id) { return shards_[ShardIndex(id)]; }
+
+    Shard const& ShardOf(ID const& id) const { return shards_[ShardIndex(id)]; }
+
+    static size_t ShardIndex(ID const& id) {
+      // blob ids come from the timestamp counter, i.e., the ids created
+      // around the same time share the high bits, thus mix all the bits.
+      uint64_t hash = std::hash<ID>()(id);
+      hash ^= hash >> 33;
+      hash *= 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 33;
+      return static_cast<size_t>(hash % kShards);
+    }
+
+    Shard shards_[kShards];
+    std::atomic<size_t> spill_cursor_{0};
   };
 
+  using LRU = ColdObjectList;
+
  public:
   using cold_object_map_t = tbb::concurrent_hash_map<ID, std::shared_ptr<P>>;
   using base_t = DependencyTracker<ID, P, ColdObjectTracker<ID, P, Der>>;
-  using lru_t = LRU;
+  using cold_list_t = ColdObjectList;
 
   ColdObjectTracker() {}
   ~ColdObjectTracker() {
+    StopCompactionWorker();
+    StopSpillWorker();
+    spill_store_.reset();
     if (!spill_path_.empty()) {
       util::FileIOAdaptor io_adaptor(spill_path_);
       DISCARD_ARROW_ERROR(io_adaptor.DeleteDir());
@@ -374,15 +595,15 @@ class ColdObjectTracker
   }
 
   /**
-   * @brief Only triggered when detected OOM, this function will spill cold-obj
-   * to disk till memory usage back to allowed watermark.
+   * @brief Spill cold objects to disk until at least `sz` bytes have been
+   * released.
    * @param sz spilled size
    */
   Status SpillColdObject(int64_t sz) {
     if (sz <= 0) {
       return Status::NotEnoughMemory("Nothing will be spilled");
     }
-    return cold_obj_lru_.Spill(sz, shared_from_self());
+    return cold_obj_lru_.Spill(sz, this);
   }
 
   /**
@@ -393,6 +614,9 @@ class ColdObjectTracker
    * whatever we got
    *  - If spill is allowed, then we shall conduct spilling and trying to give a
    * non-nullptr pointer
+   *
+   * Crossing the upper watermark only wakes up the background spill worker,
+   * the allocation blocks on spilling only when the memory is exhausted.
    */
   uint8_t* AllocateMemoryWithSpill(size_t size, int* fd, int64_t* map_size,
                                    ptrdiff_t* offset) {
@@ -402,28 +626,69 @@ class ColdObjectTracker
     if (spill_path_.empty()) {
       return pointer;
     }
-    if (pointer == nullptr ||
-        BulkAllocator::Allocated() >=
-            static_cast<int64_t>(self().mem_spill_upper_bound_)) {
-      std::unique_lock<std::mutex> locked(spill_mu_);
-      // if already got someone spilled, then we should allocate normally
-      if (pointer == nullptr)
+    if (pointer == nullptr) {
+      auto start = std::chrono::steady_clock::now();
+      {
+        std::unique_lock<std::mutex> locked(spill_mu_);
+        // if already got someone spilled, then we should allocate normally
         pointer = self().AllocateMemory(size, fd, map_size, offset);
-
-      if (pointer == nullptr ||
-          BulkAllocator::Allocated() >=
-              static_cast<int64_t>(self().mem_spill_upper_bound_)) {
-        int64_t spill_size =
-            BulkAllocator::Allocated() - self().mem_spill_lower_bound_;
-        if (SpillColdObject(spill_size).ok()) {
-          pointer = pointer ? pointer
-                            : self().AllocateMemory(size, fd, map_size, offset);
+        if (pointer == nullptr) {
+          int64_t spill_size = std::max(
+              BulkAllocator::Allocated() -
+                  static_cast<int64_t>(self().mem_spill_lower_bound_),
+              static_cast<int64_t>(size));
+          if (SpillColdObject(spill_size).ok()) {
+            pointer = self().AllocateMemory(size, fd, map_size, offset);
+          }
         }
       }
+      allocation_stall_count_ += 1;
+      allocation_stall_ns_ +=
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+    }
+    if (BulkAllocator::Allocated() >=
+        static_cast<int64_t>(self().mem_spill_upper_bound_)) {
+      // set the predicate under the lock, otherwise the notification is lost
+      // if the worker is between checking the predicate and sleeping
+      {
+        std::lock_guard<std::mutex> locked(spill_worker_mu_);
+        spill_requested_ = true;
+      }
+      spill_worker_cv_.notify_one();
     }
     return pointer;
   }
 
+  /**
+   * @brief Report the spilling counters of this tracker.
+   */
+  void SpillStatistics(json& status) const {
+    int64_t spill_ns = spill_ns_.load();
+    int64_t spill_bytes = spill_bytes_.load();
+    status["spill_objects"] = spill_objects_.load();
+    status["spill_bytes"] = spill_bytes;
+    status["spill_stored_bytes"] = spill_stored_bytes_.load();
+    // the bytes over the time spent in spilling, rather than over the
+    // wall time
+    status["spill_write_throughput"] =
+        spill_ns == 0 ? 0
+                      : static_cast<int64_t>(static_cast<double>(spill_bytes) *
+                                             1e9 / spill_ns);
+    status["allocation_stall_count"] = allocation_stall_count_.load();
+    status["allocation_stall_us"] = allocation_stall_ns_.load() / 1000;
+  }
+
+  /**
+   * @brief Report the counters of the background compaction.
+   */
+  void CompactionStatistics(json& status) const {
+    status["compaction_objects"] = compaction_objects_.load();
+    status["compaction_moved_bytes"] = compaction_moved_bytes_.load();
+    status["compaction_reclaimed_bytes"] = compaction_reclaimed_bytes_.load();
+  }
+
  public:
   Status FetchAndModify(ID const& id, int64_t& ref_cnt, int64_t changes) {
     return self().FetchAndModify(id, ref_cnt, changes);
@@ -436,29 +701,157 @@ class ColdObjectTracker
  protected:
   Status SpillPayload(std::shared_ptr<P>& payload) {
     assert(payload->is_sealed);
-    util::SpillWriteFile write_file(spill_path_);
-    RETURN_ON_ERROR(write_file.Write(payload));
-    RETURN_ON_ERROR(write_file.Sync());
+    if (payload->kind == Payload::Kind::kDiskMMap &&
+        spill_store_->Unmap(payload->object_id)) {
+      // the record is still there
+      payload->store_fd = -1;
+      payload->pointer = nullptr;
+      payload->kind = Payload::Kind::kMalloc;
+      payload->is_spilled = true;
+      return Status::OK();
+    }
+    auto start = std::chrono::steady_clock::now();
+    // only compress on the background spill worker, to avoid adding the
+    // compression latency to the allocation path.
+    const bool compress = std::this_thread::get_id() == spill_worker_.get_id();
+    size_t stored_size = 0;
+    RETURN_ON_ERROR(spill_store_->Write(payload, compress, stored_size));
     BulkAllocator::Free(payload->pointer, payload->data_size);
     payload->store_fd = -1;
     payload->pointer = nullptr;
     payload->is_spilled = true;
+    spill_objects_ += 1;
+    spill_bytes_ += payload->data_size;
+    spill_stored_bytes_ += stored_size;
+    spill_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
     return Status::OK();
   }
 
   Status ReloadPayload(const ID& id, std::shared_ptr<P>& payload) {
     assert(payload->is_spilled == true);
-    util::SpillReadFile read_file(spill_path_);
-    RETURN_ON_ERROR(read_file.Read(payload, shared_from_self()));
+    if (spill_lazy_reload_) {
+      // compressed blobs cannot be mapped and will be read instead
+      if (spill_store_->Map(payload).ok()) {
+        payload->is_spilled = false;
+        return Status::OK();
+      }
+    }
+    RETURN_ON_ERROR(spill_store_->Read(payload, shared_from_self()));
+    payload->kind = Payload::Kind::kMalloc;
+    payload->is_spilled = false;
     return Status::OK();
   }
 
-  Status DeletePayloadFile(const ID& id) {
-    util::FileIOAdaptor io_adaptor(spill_path_);
-    RETURN_ON_ERROR(io_adaptor.RemoveFile(spill_path_ + std::to_string(id)));
+  /**
+   * @brief Move a blob that is served from the spill file back to memory. The
+   * blob will be kept on disk if no memory is available.
+   */
+  Status PromotePayload(const ID& id, std::shared_ptr<P>& payload) {
+    int fd = -1;
+    int64_t map_size = 0;
+    ptrdiff_t offset = 0;
+    uint8_t* pointer =
+        AllocateMemoryWithSpill(payload->data_size, &fd, &map_size, &offset);
+    if (pointer == nullptr) {
+      return Status::OK();
+    }
+    memcpy(pointer, payload->pointer, payload->data_size);
+    auto status = spill_store_->Delete(id);
+    if (!status.ok()) {
+      BulkAllocator::Free(pointer, payload->data_size);
+      return status;
+    }
+    payload->pointer = pointer;
+    payload->store_fd = fd;
+    payload->map_size = map_size;
+    payload->data_offset = offset;
+    payload->kind = Payload::Kind::kMalloc;
+    return Status::OK();
+  }
+
+  /**
+   * @brief Whether a cold blob can be moved to another place in the shared
+   * memory, i.e., it is owned by the bulk store and resides in memory.
+   */
+  bool IsRelocatable(const std::shared_ptr<P>& payload) {
+    return payload->kind == Payload::Kind::kMalloc && payload->IsOwner() &&
+           !payload->IsSpilled() && !payload->IsGPU() &&
+           payload->arena_fd == -1 && payload->pointer != nullptr &&
+           payload->data_size > 0;
+  }
+
+  /**
+   * @brief Move a cold blob to a lower address in the shared memory. The new
+   * space is released if it isn't lower than the current one.
+   */
+  Status RelocatePayload(std::shared_ptr<P>& payload, bool& relocated) {
+    relocated = false;
+    int fd = -1;
+    int64_t map_size = 0;
+    ptrdiff_t offset = 0;
+    // never spill to make room for compaction
+    uint8_t* pointer =
+        self().AllocateMemory(payload->data_size, &fd, &map_size, &offset);
+    if (pointer == nullptr) {
+      return Status::OK();
+    }
+    if (pointer >= payload->pointer) {
+      BulkAllocator::Free(pointer, payload->data_size);
+      return Status::OK();
+    }
+    memcpy(pointer, payload->pointer, payload->data_size);
+    BulkAllocator::Free(payload->pointer, payload->data_size);
+    payload->pointer = pointer;
+    payload->store_fd = fd;
+    payload->map_size = map_size;
+    payload->data_offset = offset;
+    relocated = true;
+    compaction_objects_ += 1;
+    compaction_moved_bytes_ += payload->data_size;
     return Status::OK();
   }
 
+  bool IsMapped(const std::shared_ptr<P>& payload) {
+    return payload->kind == Payload::Kind::kDiskMMap && spill_store_ &&
+           spill_store_->IsMapped(payload->object_id);
+  }
+
+  Status DeletePayloadFile(const ID& id) {
+    if (spill_store_ == nullptr) {
+      return Status::OK();
+    }
+    return spill_store_->Delete(id);
+  }
+
+  void SetSpillSegmentSize(size_t spill_segment_size) {
+    spill_segment_size_ = spill_segment_size;
+  }
+
+  void SetSpillCompression(const std::string& spill_compression) {
+    spill_compression_ = spill_compression;
+  }
+
+  void SetSpillLazyReload(bool spill_lazy_reload) {
+    spill_lazy_reload_ = spill_lazy_reload;
+  }
+
+  Status SetEvictionPolicy(const std::string& policy) {
+    return cold_obj_lru_.SetPolicy(policy);
+  }
+
+  /**
+   * @brief Start the background compaction that moves at most `rate` bytes of
+   * cold blobs per second, zero disables the compaction.
+   */
+  void SetCompactionRate(size_t rate) {
+    compaction_rate_ = rate;
+    if (rate > 0) {
+      StartCompactionWorker();
+    }
+  }
+
   void SetSpillPath(const std::string& spill_path) {
     spill_path_ = spill_path;
     if (spill_path.empty()) {
@@ -476,6 +869,129 @@ class ColdObjectTracker
           << "Disabling spilling as the specified spill directory doesn't "
              "exist, or vineyardd doesn't have the permission to write it";
       spill_path_.clear();
+      return;
+    }
+    spill_store_.reset(
+        new util::SpillSegmentStore(spill_path_, spill_segment_size_,
+                                    spill_compression_));
+    StartSpillWorker();
+  }
+
+  /**
+   * @brief The spill worker sleeps until the memory usage crosses the upper
+   * watermark, and then spills cold objects until the usage falls below the
+   * lower watermark.
+   */
+  void StartSpillWorker() {
+    if (spill_worker_.joinable()) {
+      return;
+    }
+    spill_worker_stopped_.store(false);
+    spill_worker_ = std::thread([this]() { this->SpillWorker(); });
+  }
+
+  void SpillWorker() {
+    std::unique_lock<std::mutex> locked(spill_worker_mu_);
+    while (true) {
+      spill_worker_cv_.wait(locked, [this]() {
+        return spill_worker_stopped_.load() || spill_requested_ ||
+               BulkAllocator::Allocated() >=
+                   static_cast<int64_t>(self().mem_spill_upper_bound_);
+      });
+      if (spill_worker_stopped_.load()) {
+        break;
+      }
+      spill_requested_ = false;
+      locked.unlock();
+      bool exhausted = false;
+      while (!spill_worker_stopped_.load()) {
+        int64_t spill_size =
+            BulkAllocator::Allocated() -
+            static_cast<int64_t>(self().mem_spill_lower_bound_);
+        if (spill_size <= 0) {
+          break;
+        }
+        if (spill_size > kSpillBatchSize) {
+          spill_size = kSpillBatchSize;
+        }
+        if (!SpillColdObject(spill_size).ok()) {
+          exhausted = true;
+          break;
+        }
+      }
+      locked.lock();
+      if (exhausted && !spill_worker_stopped_.load()) {
+        // all cold blobs have been spilled, back off rather than spinning
+        // until some blobs get released.
+        spill_worker_cv_.wait_for(locked, std::chrono::milliseconds(100));
+      }
+    }
+  }
+
+  /**
+   * @brief The compaction worker wakes up every second and moves cold blobs
+   * within the budget of the rate. The blobs are moved one by one, i.e., a
+   * shard of the cold object list is blocked by at most one copy of a blob.
+   * The worker backs off when nothing could be moved.
+   */
+  void StartCompactionWorker() {
+    if (compaction_worker_.joinable()) {
+      return;
+    }
+    compaction_worker_stopped_.store(false);
+    compaction_worker_ = std::thread([this]() { this->CompactionWorker(); });
+  }
+
+  void CompactionWorker() {
+    std::unique_lock<std::mutex> locked(compaction_worker_mu_);
+    // the interval between passes when nothing can be moved grows up to one
+    // minute
+    const std::chrono::seconds min_interval(1), max_interval(60);
+    auto interval = min_interval;
+    while (!compaction_worker_stopped_.load()) {
+      compaction_worker_cv_.wait_for(locked, interval, [this]() {
+        return compaction_worker_stopped_.load();
+      });
+      if (compaction_worker_stopped_.load()) {
+        break;
+      }
+      locked.unlock();
+      size_t moved = 0, reclaimed = 0;
+      auto status =
+          cold_obj_lru_.Compact(compaction_rate_, this, moved, reclaimed);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to compact the shared memory: "
+                     << status.ToString();
+      }
+      compaction_reclaimed_bytes_ += reclaimed;
+      if (moved > 0) {
+        interval = min_interval;
+      } else {
+        interval = std::min(interval * 2, max_interval);
+      }
+      locked.lock();
+    }
+  }
+
+  void StopCompactionWorker() {
+    {
+      std::lock_guard<std::mutex> locked(compaction_worker_mu_);
+      compaction_worker_stopped_.store(true);
+    }
+    compaction_worker_cv_.notify_all();
+    if (compaction_worker_.joinable()) {
+      compaction_worker_.join();
+    }
+  }
+
+  void StopSpillWorker() {
+    {
+      std::lock_guard<std::mutex> locked(spill_worker_mu_);
+      spill_worker_stopped_.store(true);
+    }
+    spill_worker_cv_.notify_all();
+    if (spill_worker_.joinable()) {
+      spill_worker_.join();
     }
   }
 
@@ -483,9 +999,43 @@ class ColdObjectTracker
   inline Der& self() { return static_cast<Der&>(*this); }
   virtual std::shared_ptr<Der> shared_from_self() = 0;
 
-  lru_t cold_obj_lru_;
+  // spill in batches to let the synchronous spilling on the allocation path
+  // interleave with the background worker.
+  static constexpr int64_t kSpillBatchSize = 64LL * 1024 * 1024;
+
+  cold_list_t cold_obj_lru_;
   std::string spill_path_;
+  size_t spill_segment_size_ = 256 * 1024 * 1024;
+  std::string spill_compression_ = "none";
+  bool spill_lazy_reload_ = false;
+  std::unique_ptr<util::SpillSegmentStore> spill_store_;
   std::mutex spill_mu_;
+
+  std::thread spill_worker_;
+  std::mutex spill_worker_mu_;
+  std::condition_variable spill_worker_cv_;
+  std::atomic<bool> spill_worker_stopped_{false};
+  // guarded by `spill_worker_mu_`
+  bool spill_requested_ = false;
+
+  // counters of spilling, exposed by `SpillStatistics()`
+  std::atomic<int64_t> spill_objects_{0};
+  std::atomic<int64_t> spill_bytes_{0};
+  std::atomic<int64_t> spill_stored_bytes_{0};
+  std::atomic<int64_t> spill_ns_{0};
+  std::atomic<int64_t> allocation_stall_count_{0};
+  std::atomic<int64_t> allocation_stall_ns_{0};
+
+  size_t compaction_rate_ = 0;
+  std::thread compaction_worker_;
+  std::mutex compaction_worker_mu_;
+  std::condition_variable compaction_worker_cv_;
+  std::atomic<bool> compaction_worker_stopped_{false};
+
+  // counters of compaction, exposed by `CompactionStatistics()`
+  std::atomic<int64_t> compaction_objects_{0};
+  std::atomic<int64_t> compaction_moved_bytes_{0};
+  std::atomic<int64_t> compaction_reclaimed_bytes_{0};
 };
 
 }  // namespace detail
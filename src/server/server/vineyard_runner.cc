@@ -40,7 +40,7 @@ VineyardRunner::VineyardRunner(const json& spec)
 #if BOOST_VERSION < 106600
       guard_(new asio::io_service::work(context_)),
       meta_guard_(new asio::io_service::work(context_)),
-      io_guard_(new asio::io_service::work(context_))
+      io_guard_(new asio::io_service::work(io_context_))
 #else
       guard_(asio::make_work_guard(context_)),
       meta_guard_(asio::make_work_guard(meta_context_)),
@@ -75,7 +75,7 @@ Status VineyardRunner::Serve() {
 
   for (unsigned int idx = 0; idx < concurrency_; ++idx) {
     io_workers_.emplace_back(
-        boost::bind(&boost::asio::io_context::run, &context_));
+        boost::bind(&boost::asio::io_context::run, &io_context_));
   }
 
   meta_context_.run();
@@ -173,6 +173,11 @@ void VineyardRunner::Stop() {
       worker.join();
     }
   }
+  for (auto& worker : io_workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
 }
 
 }  // namespace vineyard
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <iostream>
 #include <limits>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -28,6 +29,8 @@ limitations under the License.
 #include "common/util/logging.h"
 #include "server/async/ipc_server.h"
 #include "server/async/rpc_server.h"
+#include "server/memory/allocator.h"
+#include "server/memory/malloc.h"
 #include "server/services/meta_service.h"
 #include "server/util/kubectl.h"
 #include "server/util/meta_tree.h"
@@ -103,6 +106,8 @@ Status VineyardServer::Serve(StoreType const& bulk_store_type) {
 
   auto memory_limit = spec_["bulkstore_spec"]["memory_size"].get<size_t>();
   auto allocator = spec_["bulkstore_spec"]["allocator"].get<std::string>();
+  BulkAllocator::SetSmallBlobThreshold(
+      spec_["bulkstore_spec"]["small_blob_threshold"].get<size_t>());
 
   if (bulk_store_type_ == StoreType::kPlasma) {
     plasma_bulk_store_ = std::make_shared<PlasmaBulkStore>();
@@ -122,8 +127,18 @@ Status VineyardServer::Serve(StoreType const& bulk_store_type) {
     // setup spill
     bulk_store_->SetMemSpillUpBound(memory_limit * spill_upper_bound_rate);
     bulk_store_->SetMemSpillLowBound(memory_limit * spill_lower_bound_rate);
+    bulk_store_->SetSpillSegmentSize(
+        spec_["bulkstore_spec"]["spill_segment_size"].get<size_t>());
+    bulk_store_->SetSpillCompression(
+        spec_["bulkstore_spec"]["spill_compression"].get<std::string>());
+    bulk_store_->SetSpillLazyReload(
+        spec_["bulkstore_spec"]["spill_lazy_reload"].get<bool>());
+    RETURN_ON_ERROR(bulk_store_->SetEvictionPolicy(
+        spec_["bulkstore_spec"]["spill_eviction_policy"].get<std::string>()));
     bulk_store_->SetSpillPath(
         spec_["bulkstore_spec"]["spill_path"].get<std::string>());
+    bulk_store_->SetCompactionRate(
+        spec_["bulkstore_spec"]["compaction_rate"].get<size_t>());
 
     // setup stream store
     stream_store_ = std::make_shared<StreamStore>(
@@ -244,7 +259,9 @@ Status VineyardServer::GetData(const std::vector<ObjectID>& ids,
                 exists = this->bulk_store_->Exists(id);
               } else {
                 Status status;
-                CATCH_JSON_ERROR(status, meta_tree::Exists(meta, id, exists));
+                CATCH_JSON_ERROR(
+                    status,
+                    meta_tree::Exists(meta_service_ptr_->index(), id, exists));
                 VINEYARD_SUPPRESS(status);
               }
               if (!exists) {
@@ -275,8 +292,9 @@ Status VineyardServer::GetData(const std::vector<ObjectID>& ids,
               } else {
                 Status s;
                 CATCH_JSON_ERROR(
-                    s, meta_tree::GetData(meta, this->instance_name(), id,
-                                          sub_tree, instance_id_));
+                    s, meta_tree::GetData(meta_service_ptr_->index(),
+                                          this->instance_name(), id, sub_tree,
+                                          instance_id_));
                 if (s.IsMetaTreeInvalid()) {
                   LOG(WARNING) << "Found errors in metadata: " << s.ToString();
                 }
@@ -320,8 +338,9 @@ Status VineyardServer::ListData(std::string const& pattern, bool const regex,
           json sub_tree_group;
           Status s;
           CATCH_JSON_ERROR(
-              s, meta_tree::ListData(meta, this->instance_name(), pattern,
-                                     regex, limit, sub_tree_group));
+              s, meta_tree::ListData(meta_service_ptr_->index(),
+                                     this->instance_name(), pattern, regex,
+                                     limit, sub_tree_group));
           if (!s.ok()) {
             return callback(s, sub_tree_group);
           }
@@ -376,7 +395,8 @@ Status VineyardServer::ListAllData(
         if (status.ok()) {
           std::vector<ObjectID> objects;
           Status s;
-          CATCH_JSON_ERROR(s, meta_tree::ListAllData(meta, objects));
+          CATCH_JSON_ERROR(
+              s, meta_tree::ListAllData(meta_service_ptr_->index(), objects));
           if (!s.ok()) {
             return callback(s, objects);
           }
@@ -454,33 +474,42 @@ Status VineyardServer::CreateData(
 Status VineyardServer::Persist(const ObjectID id, callback_t<> callback) {
   ENSURE_VINEYARDD_READY();
   RETURN_ON_ASSERT(!IsBlob(id), "The blobs cannot be persisted");
+  // the ready callback may be evaluated more than once when the commit
+  // conflicts, thus the CRDs are synchronized after the commit succeeds
+  auto sync_crds = std::make_shared<bool>(false);
   meta_service_ptr_->RequestToPersist(
-      [this, id](const Status& status, const json& meta,
-                 std::vector<meta_tree::op_t>& ops) {
+      [this, id, sync_crds](const Status& status, const json& meta,
+                            std::vector<meta_tree::op_t>& ops) {
         if (status.ok()) {
           Status s;
           CATCH_JSON_ERROR(
-              s, meta_tree::PersistOps(meta, this->instance_name(), id, ops));
-          if (status.ok() && !ops.empty() &&
-              this->spec_["sync_crds"].get<bool>()) {
-            json tree;
-            Status s;
-            CATCH_JSON_ERROR(
-                s, meta_tree::GetData(meta, this->instance_name(), id, tree));
-            VINEYARD_SUPPRESS(s);
-            if (tree.is_object() && !tree.empty()) {
-              auto kube = std::make_shared<Kubectl>(this->GetMetaContext());
-              kube->ApplyObject(meta["instances"], tree);
-              kube->Finish();
-            }
-          }
+              s, meta_tree::PersistOps(meta_service_ptr_->index(),
+                                       this->instance_name(), id, ops));
+          *sync_crds = s.ok() && !ops.empty() &&
+                       this->spec_["sync_crds"].get<bool>();
           return s;
         } else {
           LOG(ERROR) << status.ToString();
           return status;
         }
       },
-      callback);
+      [this, id, sync_crds, callback](const Status& status) {
+        if (status.ok() && *sync_crds) {
+          json tree;
+          Status s;
+          CATCH_JSON_ERROR(
+              s, meta_tree::GetData(meta_service_ptr_->index(),
+                                    this->instance_name(), id, tree));
+          VINEYARD_SUPPRESS(s);
+          if (tree.is_object() && !tree.empty()) {
+            auto kube = std::make_shared<Kubectl>(this->GetMetaContext());
+            kube->ApplyObject(meta_service_ptr_->index().tree()["instances"],
+                              tree);
+            kube->Finish();
+          }
+        }
+        return callback(status);
+      });
   return Status::OK();
 }
 
@@ -502,11 +531,12 @@ Status VineyardServer::IfPersist(const ObjectID id,
     return Status::OK();
   }
   meta_service_ptr_->RequestToGetData(
-      false, [id, callback](const Status& status, const json& meta) {
+      false, [this, id, callback](const Status& status, const json& meta) {
         if (status.ok()) {
           bool persist = false;
           Status s;
-          CATCH_JSON_ERROR(s, meta_tree::IfPersist(meta, id, persist));
+          CATCH_JSON_ERROR(s, meta_tree::IfPersist(meta_service_ptr_->index(),
+                                                   id, persist));
           return callback(s, persist);
         } else {
           LOG(ERROR) << status.ToString();
@@ -526,11 +556,12 @@ Status VineyardServer::Exists(const ObjectID id,
     return Status::OK();
   }
   meta_service_ptr_->RequestToGetData(
-      true, [id, callback](const Status& status, const json& meta) {
+      true, [this, id, callback](const Status& status, const json& meta) {
         if (status.ok()) {
           bool exists = false;
           Status s;
-          CATCH_JSON_ERROR(s, meta_tree::Exists(meta, id, exists));
+          CATCH_JSON_ERROR(
+              s, meta_tree::Exists(meta_service_ptr_->index(), id, exists));
           return callback(s, exists);
         } else {
           LOG(ERROR) << status.ToString();
@@ -614,7 +645,15 @@ Status VineyardServer::DelData(
           return status;
         }
       },
-      callback);
+      [this, callback](Status const& status,
+                       std::vector<ObjectID> const& deleted_ids) {
+        // reply after the clients that cache the metadata have been notified,
+        // to not serve the deleted objects from their caches
+        AfterMetaNotified([callback, status, deleted_ids]() {
+          VINEYARD_DISCARD(callback(status, deleted_ids));
+        });
+        return Status::OK();
+      });
   return Status::OK();
 }
 
@@ -625,11 +664,11 @@ Status VineyardServer::DeleteBlobBatch(const std::set<ObjectID>& ids) {
   return Status::OK();
 }
 
-Status VineyardServer::DeleteAllAt(const json& meta,
+Status VineyardServer::DeleteAllAt(const meta_tree::MetaIndex& index,
                                    InstanceID const instance_id) {
   std::vector<ObjectID> objects_to_cleanup;
   Status status;
-  CATCH_JSON_ERROR(status, meta_tree::FilterAtInstance(meta, instance_id,
+  CATCH_JSON_ERROR(status, meta_tree::FilterAtInstance(index, instance_id,
                                                        objects_to_cleanup));
   RETURN_ON_ERROR(status);
   return this->DelData(objects_to_cleanup, true, true, false /* fastpath */,
@@ -646,8 +685,8 @@ Status VineyardServer::PutName(const ObjectID object_id,
                                const std::string& name, callback_t<> callback) {
   ENSURE_VINEYARDD_READY();
   meta_service_ptr_->RequestToPersist(
-      [object_id, name](const Status& status, const json& meta,
-                        std::vector<meta_tree::op_t>& ops) {
+      [this, object_id, name](const Status& status, const json& meta,
+                              std::vector<meta_tree::op_t>& ops) {
         if (status.ok()) {
           // TODO: do proper validation:
           // 1. global objects can have name, local ones cannot.
@@ -661,7 +700,8 @@ Status VineyardServer::PutName(const ObjectID object_id,
           bool exists = false;
           {
             Status s;
-            CATCH_JSON_ERROR(s, meta_tree::Exists(meta, object_id, exists));
+            CATCH_JSON_ERROR(s, meta_tree::Exists(meta_service_ptr_->index(),
+                                                  object_id, exists));
             VINEYARD_DISCARD(s);
           }
           if (!exists) {
@@ -673,7 +713,8 @@ Status VineyardServer::PutName(const ObjectID object_id,
           bool persist = false;
           {
             Status s;
-            CATCH_JSON_ERROR(s, meta_tree::IfPersist(meta, object_id, persist));
+            CATCH_JSON_ERROR(s, meta_tree::IfPersist(meta_service_ptr_->index(),
+                                                     object_id, persist));
             VINEYARD_DISCARD(s);
           }
           if (!persist) {
@@ -703,20 +744,13 @@ Status VineyardServer::GetName(const std::string& name, const bool wait,
                                                 const Status& status,
                                                 const json& meta) {
     if (status.ok()) {
-      auto test_task = [name](const json& meta) -> bool {
-        auto names = meta.value("names", json(nullptr));
-        if (names.is_object()) {
-          return names.contains(name);
-        }
-        return false;
+      auto test_task = [this, name](const json& meta) -> bool {
+        return meta_service_ptr_->index().FindName(name) != InvalidObjectID();
       };
-      auto eval_task = [name, callback](const json& meta) -> Status {
-        auto names = meta.value("names", json(nullptr));
-        if (names.is_object() && names.contains(name)) {
-          auto entry = names[name];
-          if (!entry.is_null()) {
-            return callback(Status::OK(), entry.get<ObjectID>());
-          }
+      auto eval_task = [this, name, callback](const json& meta) -> Status {
+        ObjectID object_id = meta_service_ptr_->index().FindName(name);
+        if (object_id != InvalidObjectID()) {
+          return callback(Status::OK(), object_id);
         }
         return callback(Status::ObjectNotExists("failed to find name: " + name),
                         InvalidObjectID());
@@ -739,27 +773,24 @@ Status VineyardServer::DropName(const std::string& name,
                                 callback_t<> callback) {
   ENSURE_VINEYARDD_READY();
   meta_service_ptr_->RequestToPersist(
-      [name](const Status& status, const json& meta,
-             std::vector<meta_tree::op_t>& ops) {
+      [this, name](const Status& status, const json& meta,
+                   std::vector<meta_tree::op_t>& ops) {
         if (status.ok()) {
-          auto names = meta.value("names", json(nullptr));
-          if (names.is_object()) {
-            auto iter = names.find(name);
-            if (iter != names.end()) {
-              ops.emplace_back(meta_tree::op_t::Del("/names/" + name));
-              auto object_id = iter->get<ObjectID>();
-              // delete the name in the object meta as well.
-              bool exists = false;
-              {
-                Status s;
-                CATCH_JSON_ERROR(s, meta_tree::Exists(meta, object_id, exists));
-                VINEYARD_DISCARD(s);
-              }
+          auto const& index = meta_service_ptr_->index();
+          ObjectID object_id = index.FindName(name);
+          if (object_id != InvalidObjectID()) {
+            ops.emplace_back(meta_tree::op_t::Del("/names/" + name));
+            // delete the name in the object meta as well.
+            bool exists = false;
+            {
+              Status s;
+              CATCH_JSON_ERROR(s, meta_tree::Exists(index, object_id, exists));
+              VINEYARD_DISCARD(s);
+            }
 
-              if (exists) {
-                ops.emplace_back(meta_tree::op_t::Del(
-                    "/data/" + ObjectIDToString(object_id) + "/__name"));
-              }
+            if (exists) {
+              ops.emplace_back(meta_tree::op_t::Del(
+                  "/data/" + ObjectIDToString(object_id) + "/__name"));
             }
           }
           return Status::OK();
@@ -794,6 +825,17 @@ Status VineyardServer::InstanceStatus(callback_t<const json&> callback) {
   status["deployment"] = GetDeployment();
   status["memory_usage"] = bulk_store_->Footprint();
   status["memory_limit"] = bulk_store_->FootprintLimit();
+  bulk_store_->SpillStatistics(status);
+  bulk_store_->CompactionStatistics(status);
+  {
+    std::map<int, int64_t> usage;
+    memory::GetNumaUsage(usage);
+    json numa_usage = json::object();
+    for (auto const& item : usage) {
+      numa_usage[std::to_string(item.first)] = item.second;
+    }
+    status["numa_usage"] = numa_usage;
+  }
   status["deferred_requests"] = deferred_.size();
   if (ipc_server_ptr_) {
     status["ipc_connections"] = ipc_server_ptr_->AliveConnections();
@@ -821,6 +863,59 @@ Status VineyardServer::ProcessDeferred(const json& meta) {
   return Status::OK();
 }
 
+void VineyardServer::NotifyMetaInvalidation(const std::vector<ObjectID>& ids) {
+  uint64_t sequence = 0;
+  {
+    std::lock_guard<std::mutex> guard(meta_notify_mutex_);
+    sequence = ++meta_notify_issued_;
+    meta_notify_inflight_.emplace(sequence);
+  }
+  // every queued write holds a reference, the notification is done once the
+  // last write has finished or been dropped
+  auto self(shared_from_this());
+  std::shared_ptr<void> written(
+      nullptr, [self, sequence](void*) { self->metaNotified(sequence); });
+  if (this->ipc_server_ptr_) {
+    ipc_server_ptr_->NotifyMetaInvalidation(ids, written);
+  }
+  if (this->rpc_server_ptr_) {
+    rpc_server_ptr_->NotifyMetaInvalidation(ids, written);
+  }
+}
+
+void VineyardServer::AfterMetaNotified(std::function<void()> const& callback) {
+  {
+    std::lock_guard<std::mutex> guard(meta_notify_mutex_);
+    if (!meta_notify_inflight_.empty()) {
+      meta_notify_waiters_.emplace(meta_notify_issued_, callback);
+      return;
+    }
+  }
+  context_.post(callback);
+}
+
+void VineyardServer::metaNotified(const uint64_t sequence) {
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> guard(meta_notify_mutex_);
+    meta_notify_inflight_.erase(sequence);
+    // the waiters that started before the earliest unfinished notification
+    auto end = meta_notify_inflight_.empty()
+                   ? meta_notify_waiters_.end()
+                   : meta_notify_waiters_.lower_bound(
+                         *meta_notify_inflight_.begin());
+    for (auto iter = meta_notify_waiters_.begin(); iter != end; ++iter) {
+      callbacks.emplace_back(std::move(iter->second));
+    }
+    meta_notify_waiters_.erase(meta_notify_waiters_.begin(), end);
+  }
+  // n.b.: the last write may finish with the write lock of the subscriber
+  // held, thus the callbacks don't run in place
+  for (auto& callback : callbacks) {
+    context_.post(callback);
+  }
+}
+
 const std::string VineyardServer::IPCSocket() {
   if (this->ipc_server_ptr_) {
     return ipc_server_ptr_->Socket();
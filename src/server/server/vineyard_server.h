@@ -17,8 +17,11 @@ limitations under the License.
 #define SRC_SERVER_SERVER_VINEYARD_SERVER_H_
 
 #include <atomic>
+#include <functional>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <thread>
@@ -41,6 +44,10 @@ namespace asio = boost::asio;
 
 class IMetaService;
 
+namespace meta_tree {
+class MetaIndex;
+}  // namespace meta_tree
+
 class IPCServer;
 class RPCServer;
 
@@ -138,7 +145,8 @@ class VineyardServer : public std::enable_shared_from_this<VineyardServer> {
 
   Status DeleteBlobBatch(const std::set<ObjectID>& blobs);
 
-  Status DeleteAllAt(const json& meta, InstanceID const instance_id);
+  Status DeleteAllAt(const meta_tree::MetaIndex& index,
+                     InstanceID const instance_id);
 
   Status PutName(const ObjectID object_id, const std::string& name,
                  callback_t<> callback);
@@ -155,6 +163,19 @@ class VineyardServer : public std::enable_shared_from_this<VineyardServer> {
 
   Status ProcessDeferred(const json& meta);
 
+  /**
+   * @brief Notify the clients that cache the metadata that the metadata of
+   * these objects has been deleted or modified.
+   */
+  void NotifyMetaInvalidation(const std::vector<ObjectID>& ids);
+
+  /**
+   * @brief Run `callback` on the server context once the invalidation
+   * notifications issued so far have been written to the subscribed clients,
+   * or dropped as the subscribers are gone.
+   */
+  void AfterMetaNotified(std::function<void()> const& callback);
+
   inline SessionID session_id() const { return session_id_; }
   inline InstanceID instance_id() { return instance_id_; }
   inline std::string instance_name() { return instance_name_; }
@@ -198,6 +219,16 @@ class VineyardServer : public std::enable_shared_from_this<VineyardServer> {
 
   std::list<DeferredReq> deferred_;
 
+  // the invalidation notifications that are still being written to the
+  // subscribers, and the callbacks waiting for them, keyed by the sequence
+  // number of the latest notification when they start waiting
+  std::mutex meta_notify_mutex_;
+  uint64_t meta_notify_issued_ = 0;
+  std::set<uint64_t> meta_notify_inflight_;
+  std::multimap<uint64_t, std::function<void()>> meta_notify_waiters_;
+
+  void metaNotified(const uint64_t sequence);
+
   StoreType bulk_store_type_;
   std::shared_ptr<BulkStore> bulk_store_;
   std::shared_ptr<PlasmaBulkStore> plasma_bulk_store_;
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "server/services/etcd_meta_service.h"
 
+#include <algorithm>
 #include <chrono>
 #include <mutex>
 #include <string>
@@ -32,6 +33,9 @@ limitations under the License.
 
 #define BACKOFF_RETRY_TIME 10
 
+// the error code of etcd-cpp-apiv3 when the comparison of a txn fails
+#define ETCD_ERROR_COMPARE_FAILED 101
+
 namespace vineyard {
 
 void EtcdWatchHandler::operator()(pplx::task<etcd::Response> const& resp_task) {
@@ -228,6 +232,8 @@ void EtcdMetaService::commitUpdates(
       tx.setup_delete(prefix_ + op.kv.key);
     }
   }
+  // fails the concurrent `commitUpdatesIf` of other instances
+  tx.setup_put(prefix_ + meta_sync_revision_, server_ptr_->instance_name());
   auto self(shared_from_base());
   etcd_->txn(tx).then([self, callback_after_updated](
                           pplx::task<etcd::Response> const& resp_task) {
@@ -248,6 +254,76 @@ void EtcdMetaService::commitUpdates(
   });
 }
 
+void EtcdMetaService::commitUpdatesIf(
+    unsigned base_rev, const std::vector<op_t>& changes,
+    callback_t<size_t, unsigned> callback_after_updated) {
+  // every txn (if the changes exceed the max-txn-ops limitation) claims the
+  // revision: the first one compares with `base_rev`, and the following ones
+  // with the revision of the previous one, thus no other instance commits in
+  // between
+  commitChunkIf(static_cast<int64_t>(base_rev) + 1,
+                etcdv3::CompareResult::LESS,
+                std::make_shared<std::vector<op_t>>(changes), 0,
+                callback_after_updated);
+}
+
+void EtcdMetaService::commitChunkIf(
+    int64_t rev, etcdv3::CompareResult compare,
+    std::shared_ptr<std::vector<op_t>> const& changes, size_t offset,
+    callback_t<size_t, unsigned> callback_after_updated) {
+  size_t end = std::min(changes->size(), offset + MAX_GROUP_COMMIT_OPS);
+  etcdv3::Transaction tx(prefix_ + meta_sync_revision_);
+  tx.init_compare(rev, compare, etcdv3::CompareTarget::MOD);
+  for (size_t idx = offset; idx < end; ++idx) {
+    auto const& op = (*changes)[idx];
+    if (op.op == op_t::kPut) {
+      tx.setup_put(prefix_ + op.kv.key, op.kv.value);
+    } else if (op.op == op_t::kDel) {
+      tx.setup_delete(prefix_ + op.kv.key);
+    }
+  }
+  tx.setup_put(prefix_ + meta_sync_revision_, server_ptr_->instance_name());
+  auto self(shared_from_base());
+  etcd_->txn(tx).then([self, changes, offset, end, callback_after_updated](
+                          pplx::task<etcd::Response> const& resp_task) {
+    auto resp = resp_task.get();
+    VLOG(10) << "etcd (compare) txn use " << resp.duration().count()
+             << " microseconds";
+    LOG_SUMMARY("etcd_request_duration_microseconds", "txn",
+                resp.duration().count());
+
+    if (self->stopped_.load()) {
+      self->server_ptr_->GetMetaContext().post(
+          boost::bind(callback_after_updated,
+                      Status::AlreadyStopped("etcd metadata service"), offset,
+                      static_cast<unsigned>(resp.index())));
+      return;
+    }
+    if (resp.error_code() == ETCD_ERROR_COMPARE_FAILED) {
+      // the previous txns, if any, have been committed, and the retry catches
+      // up with them before recomputing the changes
+      self->server_ptr_->GetMetaContext().post(
+          boost::bind(callback_after_updated, Status::OK(), offset,
+                      static_cast<unsigned>(resp.index())));
+      return;
+    }
+    auto status = Status::EtcdError(resp.error_code(), resp.error_message());
+    if (!status.ok() || end == changes->size()) {
+      self->server_ptr_->GetMetaContext().post(
+          boost::bind(callback_after_updated, status,
+                      status.ok() ? end : offset,
+                      static_cast<unsigned>(resp.index())));
+      return;
+    }
+    int64_t rev = resp.index();
+    self->server_ptr_->GetMetaContext().post(
+        [self, rev, changes, end, callback_after_updated]() {
+          self->commitChunkIf(rev, etcdv3::CompareResult::EQUAL, changes, end,
+                              callback_after_updated);
+        });
+  });
+}
+
 void EtcdMetaService::requestAll(
     const std::string& prefix, unsigned base_rev,
     callback_t<const std::vector<op_t>&, unsigned> callback) {
@@ -25,6 +25,7 @@ limitations under the License.
 
 #include "boost/process.hpp"
 #include "etcd/Client.hpp"
+#include "etcd/v3/Transaction.hpp"
 
 #include "server/services/meta_service.h"
 #include "server/util/etcd_launcher.h"
@@ -150,6 +151,24 @@ class EtcdMetaService : public IMetaService {
   void commitUpdates(const std::vector<op_t>&,
                      callback_t<unsigned> callback_after_updated) override;
 
+  /**
+   * Compare the modified revision of `meta_sync_revision_` with `base_rev` in
+   * the etcd transactions, without taking the `meta_sync_lock_`.
+   */
+  void commitUpdatesIf(
+      unsigned base_rev, const std::vector<op_t>& changes,
+      callback_t<size_t, unsigned> callback_after_updated) override;
+
+  /**
+   * Commit `changes[offset:]` in txns, each of which compares the modified
+   * revision of `meta_sync_revision_` with `rev`, and the revision of the
+   * previous txn after the first one.
+   */
+  void commitChunkIf(int64_t rev, etcdv3::CompareResult compare,
+                     std::shared_ptr<std::vector<op_t>> const& changes,
+                     size_t offset,
+                     callback_t<size_t, unsigned> callback_after_updated);
+
   void startDaemonWatch(
       const std::string& prefix, unsigned since_rev,
       callback_t<const std::vector<op_t>&, unsigned, callback_t<unsigned>>
@@ -42,6 +42,14 @@ void LocalMetaService::commitUpdates(
       boost::bind(callback_after_updated, Status::OK(), 0));
 }
 
+void LocalMetaService::commitUpdatesIf(
+    unsigned base_rev, const std::vector<op_t>& changes,
+    callback_t<size_t, unsigned> callback_after_updated) {
+  // there are no other instances to conflict with
+  server_ptr_->GetMetaContext().post(boost::bind(
+      callback_after_updated, Status::OK(), changes.size(), 0));
+}
+
 void LocalMetaService::requestAll(
     const std::string& prefix, unsigned base_rev,
     callback_t<const std::vector<op_t>&, unsigned> callback) {
@@ -69,6 +69,10 @@ class LocalMetaService : public IMetaService {
   void commitUpdates(const std::vector<op_t>&,
                      callback_t<unsigned> callback_after_updated) override;
 
+  void commitUpdatesIf(
+      unsigned base_rev, const std::vector<op_t>& changes,
+      callback_t<size_t, unsigned> callback_after_updated) override;
+
   void startDaemonWatch(
       const std::string& prefix, unsigned since_rev,
       callback_t<const std::vector<op_t>&, unsigned, callback_t<unsigned>>
@@ -16,7 +16,11 @@ limitations under the License.
 #include "server/services/meta_service.h"
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "common/util/logging.h"
 
@@ -53,6 +57,256 @@ IMetaService::~IMetaService() { this->Stop(); }
 
 void IMetaService::Stop() { LOG(INFO) << "meta service is stopping ..."; }
 
+void IMetaService::commitUpdatesIf(
+    unsigned base_rev, const std::vector<op_t>& changes,
+    callback_t<size_t, unsigned> callback_after_updated) {
+  auto self(shared_from_this());
+  requestLock(meta_sync_lock_, [self, base_rev, changes,
+                                callback_after_updated](
+                                   const Status& status,
+                                   std::shared_ptr<ILock> lock) {
+    if (!status.ok()) {
+      return callback_after_updated(status, 0, self->rev_);
+    }
+    self->requestValues("", [self, base_rev, changes, callback_after_updated,
+                             lock](const Status& status, const json& meta,
+                                   unsigned rev) {
+      if (!status.ok() || rev != base_rev) {
+        unsigned rev_after_unlock = 0;
+        VINEYARD_DISCARD(lock->Release(rev_after_unlock));
+        return callback_after_updated(status, 0, rev);
+      }
+      const size_t size = changes.size();
+      self->commitUpdates(changes, [callback_after_updated, lock, size](
+                                       const Status& status, unsigned rev) {
+        unsigned rev_after_unlock = 0;
+        VINEYARD_DISCARD(lock->Release(rev_after_unlock));
+        return callback_after_updated(status, status.ok() ? size : 0, rev);
+      });
+      return Status::OK();
+    });
+    return Status::OK();
+  });
+}
+
+void IMetaService::flushPersists() {
+  if (persist_in_flight_ || pending_persists_.empty()) {
+    return;
+  }
+  if (stopped_.load()) {
+    std::vector<pending_persist_t> persists(pending_persists_.begin(),
+                                            pending_persists_.end());
+    pending_persists_.clear();
+    finishPersists(persists, Status::AlreadyStopped("etcd metadata service"));
+    return;
+  }
+  auto self(shared_from_this());
+  if (persist_catch_up_) {
+    // otherwise the commit would conflict with the previous commit
+    persist_in_flight_ = true;
+    requestValues("", [self](const Status& status, const json& meta,
+                             unsigned rev) {
+      self->persist_in_flight_ = false;
+      self->persist_catch_up_ = false;
+      if (!status.ok()) {
+        std::vector<pending_persist_t> persists(self->pending_persists_.begin(),
+                                                self->pending_persists_.end());
+        self->pending_persists_.clear();
+        self->finishPersists(persists, status);
+        return status;
+      }
+      self->flushPersists();
+      return Status::OK();
+    });
+    return;
+  }
+
+  // compute the ops of the pending requests against the same `meta_`, where
+  // the ops of the previous requests in the group are not applied yet. Thus
+  // the group is closed before a request that may depend on them, and the
+  // request is recomputed in the next group, after `meta_` catches up:
+  //
+  //  - it fails, or has nothing to do, e.g., puts the name on an object that
+  //    is being persisted, or drops a name that is being put;
+  //  - it updates the same keys, e.g., the name that is being put;
+  //  - it exceeds the `MAX_GROUP_COMMIT_OPS`.
+  //
+  // The first request of a group is never deferred.
+  std::vector<pending_persist_t> persists;
+  std::vector<op_t> ops;
+  std::unordered_set<std::string> keys;
+  while (!pending_persists_.empty()) {
+    pending_persist_t persist = pending_persists_.front();
+    std::vector<op_t> persist_ops;
+    auto s = persist.callback_after_ready(Status::OK(), meta_, persist_ops);
+    if (!persists.empty()) {
+      bool deferred = !s.ok() || persist_ops.empty() ||
+                      ops.size() + persist_ops.size() > MAX_GROUP_COMMIT_OPS;
+      for (size_t idx = 0; !deferred && idx < persist_ops.size(); ++idx) {
+        deferred = keys.find(persist_ops[idx].kv.key) != keys.end();
+      }
+      if (deferred) {
+        break;
+      }
+    }
+    pending_persists_.pop_front();
+    if (!s.ok() || persist_ops.empty()) {
+      VINEYARD_DISCARD(persist.callback_after_finish(s));
+      continue;
+    }
+    for (auto const& op : persist_ops) {
+      keys.emplace(op.kv.key);
+    }
+    ops.insert(ops.end(), persist_ops.begin(), persist_ops.end());
+    persists.emplace_back(persist);
+  }
+  if (persists.empty()) {
+    return;
+  }
+  // a request may update a key more than once, and the transaction doesn't
+  // accept duplicate keys, the last op wins
+  std::unordered_map<std::string, size_t> last_ops;
+  for (size_t idx = 0; idx < ops.size(); ++idx) {
+    last_ops[ops[idx].kv.key] = idx;
+  }
+  if (last_ops.size() < ops.size()) {
+    std::vector<op_t> merged_ops;
+    for (size_t idx = 0; idx < ops.size(); ++idx) {
+      if (last_ops[ops[idx].kv.key] == idx) {
+        merged_ops.emplace_back(ops[idx]);
+      }
+    }
+    ops.swap(merged_ops);
+  }
+  LOG_SUMMARY("meta_group_commit_size", "requests", persists.size());
+  LOG_SUMMARY("meta_group_commit_size", "ops", ops.size());
+
+  persist_in_flight_ = true;
+  auto committing = std::chrono::steady_clock::now();
+  commitUpdatesIf(rev_, ops, [self, ops, persists, committing](
+                                 const Status& status, size_t committed,
+                                 unsigned rev) mutable {
+    self->persist_in_flight_ = false;
+    LOG_SUMMARY("meta_group_commit_duration_microseconds", "",
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - committing)
+                    .count());
+    if (self->stopped_.load()) {
+      self->finishPersists(persists,
+                           Status::AlreadyStopped("etcd metadata service"));
+      return Status::OK();
+    }
+    if (committed > 0 && committed < ops.size()) {
+      // only a request that exceeds the `MAX_GROUP_COMMIT_OPS` needs more
+      // than one txn, and such a request is always committed alone
+      auto& committed_ops = persists.front().committed;
+      committed_ops.insert(committed_ops.end(), ops.begin(),
+                           ops.begin() + committed);
+    }
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to commit updates: " << status.ToString();
+      self->abortPersists(persists, status);
+    } else if (committed == ops.size()) {
+      // the watcher applies the ops again later, which is idempotent
+      self->metaUpdate(ops, false);
+      self->persist_catch_up_ = rev > self->rev_;
+      self->finishPersists(persists, Status::OK());
+    } else {
+      VLOG(10) << "conflicts on committing updates, retrying since revision "
+               << rev;
+      // catch up with the updates from other instances, then recompute the
+      // ops with the latest metadata, in the original order
+      self->persist_catch_up_ = true;
+      std::vector<pending_persist_t> exhausted;
+      for (auto persist = persists.rbegin(); persist != persists.rend();
+           ++persist) {
+        if (persist->retries <= 0) {
+          exhausted.emplace_back(*persist);
+        } else {
+          persist->retries -= 1;
+          self->pending_persists_.emplace_front(*persist);
+        }
+      }
+      if (!exhausted.empty()) {
+        self->abortPersists(
+            exhausted,
+            Status::EtcdError("Failed to commit updates, as the metadata keeps "
+                              "being changed by other instances"));
+      }
+    }
+    self->flushPersists();
+    return Status::OK();
+  });
+}
+
+void IMetaService::abortPersists(const std::vector<pending_persist_t>& persists,
+                                 const Status& status) {
+  std::vector<op_t> undo_ops;
+  for (auto const& persist : persists) {
+    for (auto const& op : persist.committed) {
+      // persisting only puts the keys of the objects and signatures
+      if (op.op == op_t::kPut) {
+        undo_ops.emplace_back(op_t::Del(op.kv.key));
+      }
+    }
+  }
+  if (undo_ops.empty()) {
+    finishPersists(persists, status);
+    return;
+  }
+
+  // no other persist is committed until the undo finishes, otherwise it
+  // might be computed against the objects that are being undone
+  persist_in_flight_ = true;
+  auto self(shared_from_this());
+  requestValues("", [self, persists, status, undo_ops](
+                        const Status& catch_up_status, const json& meta,
+                        unsigned rev) {
+    // the watcher has applied the committed ops to `meta_` by now, mark the
+    // objects as transient again, as they are deleted from the backend
+    std::vector<ObjectID> transient_ids;
+    for (auto const& op : undo_ops) {
+      auto path = json::json_pointer(op.kv.key);
+      if (boost::algorithm::starts_with(op.kv.key, "/data/") &&
+          self->meta_.contains(path)) {
+        self->meta_[path]["transient"] = true;
+        self->index_.Update(op.kv.key);
+        transient_ids.emplace_back(ObjectIDFromString(path.back()));
+      }
+      self->undoing_.emplace(op.kv.key);
+    }
+    self->server_ptr_->NotifyMetaInvalidation(transient_ids);
+    self->commitUpdates(undo_ops, [self, persists, status, undo_ops](
+                                      const Status& undo_status, unsigned) {
+      if (!undo_status.ok()) {
+        LOG(ERROR) << "Failed to undo the partially persisted objects: "
+                   << undo_status.ToString();
+        for (auto const& op : undo_ops) {
+          self->undoing_.erase(op.kv.key);
+        }
+      }
+      self->persist_in_flight_ = false;
+      self->persist_catch_up_ = true;
+      self->finishPersists(persists, status);
+      self->flushPersists();
+      return Status::OK();
+    });
+    return Status::OK();
+  });
+}
+
+void IMetaService::finishPersists(
+    const std::vector<pending_persist_t>& persists, const Status& status) {
+  auto now = std::chrono::steady_clock::now();
+  for (auto const& persist : persists) {
+    LOG_SUMMARY("meta_persist_duration_microseconds", "",
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - persist.requested)
+                    .count());
+    VINEYARD_DISCARD(persist.callback_after_finish(status));
+  }
+}
+
 /** Note [Deleting objects and blobs]
  *
  * Blob is special: suppose A -> B and A -> C, where A is an object, B is an
@@ -111,39 +365,15 @@ void IMetaService::IncRef(std::string const& instance_name,
     return;
   }
   ObjectID key_obj, value_obj;
-  if (meta_tree::DecodeObjectID(meta_, instance_name, value, value_obj).ok()) {
+  if (meta_tree::DecodeObjectID(index_, instance_name, value, value_obj).ok()) {
     key_obj = ObjectIDFromString(vs[1]);
     if (from_remote && IsBlob(value_obj)) {
       // don't put remote blob refs into deps graph, since two blobs may share
       // the same object id.
       return;
     }
-    {
-      // validate the dependency graph
-      decltype(subobjects_.begin()) iter;
-      auto range = subobjects_.equal_range(key_obj);
-      for (iter = range.first; iter != range.second; ++iter) {
-        if (iter->second == value_obj) {
-          break;
-        }
-      }
-      if (iter == range.second) {
-        subobjects_.emplace(key_obj, value_obj);
-      }
-    }
-    {
-      // validate the dependency graph
-      decltype(supobjects_.begin()) iter;
-      auto range = supobjects_.equal_range(value_obj);
-      for (iter = range.first; iter != range.second; ++iter) {
-        if (iter->second == key_obj) {
-          break;
-        }
-      }
-      if (iter == range.second) {
-        supobjects_.emplace(value_obj, key_obj);
-      }
-    }
+    addRef(subobjects_, key_obj, value_obj);
+    addRef(supobjects_, value_obj, key_obj);
   }
 }
 
@@ -155,15 +385,32 @@ void IMetaService::CloneRef(ObjectID const target, ObjectID const mirror) {
   if (supobjects_.find(mirror) != supobjects_.end()) {
     return;
   }
-  auto range = supobjects_.equal_range(target);
-  std::vector<ObjectID> suprefs;
+  auto suprefs = supobjects_.find(target);
+  if (suprefs == supobjects_.end()) {
+    return;
+  }
   // n.b.: avoid traverse & modify at the same time (in the same loop).
-  for (auto iter = range.first; iter != range.second; ++iter) {
-    suprefs.emplace_back(iter->second);
+  std::vector<ObjectID> targets(suprefs->second.begin(),
+                                suprefs->second.end());
+  for (auto const supref : targets) {
+    addRef(supobjects_, mirror, supref);
+    addRef(subobjects_, supref, mirror);
   }
-  for (auto const supref : suprefs) {
-    supobjects_.emplace(mirror, supref);
-    subobjects_.emplace(supref, mirror);
+}
+
+void IMetaService::addRef(refs_t& refs, ObjectID const from,
+                          ObjectID const to) {
+  refs[from].emplace(to);
+}
+
+void IMetaService::dropRef(refs_t& refs, ObjectID const from,
+                           ObjectID const to) {
+  auto iter = refs.find(from);
+  if (iter != refs.end()) {
+    iter->second.erase(to);
+    if (iter->second.empty()) {
+      refs.erase(iter);
+    }
   }
 }
 
@@ -175,7 +422,7 @@ bool IMetaService::deleteable(ObjectID const object_id) {
     return true;
   }
   ObjectID equivalent = InvalidObjectID();
-  return meta_tree::HasEquivalent(meta_, object_id, equivalent);
+  return meta_tree::HasEquivalent(index_, object_id, equivalent);
 }
 
 void IMetaService::traverseToDelete(std::set<ObjectID>& initial_delete_set,
@@ -194,11 +441,15 @@ void IMetaService::traverseToDelete(std::set<ObjectID>& initial_delete_set,
     return;
   }
   // process the "initial_delete_set" in topo-sort order.
-  auto sup_target_range = supobjects_.equal_range(object_id);
   std::set<ObjectID> sup_traget_to_preprocess;
-  for (auto it = sup_target_range.first; it != sup_target_range.second; ++it) {
-    if (initial_delete_set.find(it->second) != initial_delete_set.end()) {
-      sup_traget_to_preprocess.emplace(it->second);
+  {
+    auto sup_targets = supobjects_.find(object_id);
+    if (sup_targets != supobjects_.end()) {
+      for (auto const& sup_target : sup_targets->second) {
+        if (initial_delete_set.find(sup_target) != initial_delete_set.end()) {
+          sup_traget_to_preprocess.emplace(sup_target);
+        }
+      }
     }
   }
   for (ObjectID const& sup_target : sup_traget_to_preprocess) {
@@ -213,38 +464,26 @@ void IMetaService::traverseToDelete(std::set<ObjectID>& initial_delete_set,
       std::set<ObjectID> to_delete;
       {
         // delete sup-edges of subobjects
-        auto range = subobjects_.equal_range(object_id);
-        for (auto it = range.first; it != range.second; ++it) {
-          // remove dependency edge
-          auto suprange = supobjects_.equal_range(it->second);
-          decltype(suprange.first) p;
-          for (p = suprange.first; p != suprange.second; /* no self-inc */) {
-            if (p->second == object_id) {
-              supobjects_.erase(p++);
-            } else {
-              ++p;
+        auto subs = subobjects_.find(object_id);
+        if (subs != subobjects_.end()) {
+          for (auto const& sub : subs->second) {
+            // remove dependency edge
+            dropRef(supobjects_, sub, object_id);
+            if (deep || IsBlob(sub)) {
+              // blob is special: see Note [Deleting objects and blobs].
+              to_delete.emplace(sub);
             }
           }
-          if (deep || IsBlob(it->second)) {
-            // blob is special: see Note [Deleting objects and blobs].
-            to_delete.emplace(it->second);
-          }
         }
       }
 
       {
         // delete sub-edges of supobjects
-        auto range = supobjects_.equal_range(object_id);
-        for (auto it = range.first; it != range.second; ++it) {
-          // remove dependency edge
-          auto subrange = subobjects_.equal_range(it->second);
-          decltype(subrange.first) p;
-          for (p = subrange.first; p != subrange.second; /* no self-inc */) {
-            if (p->second == object_id) {
-              subobjects_.erase(p++);
-            } else {
-              ++p;
-            }
+        auto sups = supobjects_.find(object_id);
+        if (sups != supobjects_.end()) {
+          for (auto const& sup : sups->second) {
+            // remove dependency edge
+            dropRef(subobjects_, sup, object_id);
           }
         }
       }
@@ -257,27 +496,17 @@ void IMetaService::traverseToDelete(std::set<ObjectID>& initial_delete_set,
     if (force) {
       // delete upwards
       std::set<ObjectID> to_delete;
-      auto range = supobjects_.equal_range(object_id);
-      for (auto it = range.first; it != range.second; ++it) {
-        // remove dependency edge
-        auto subrange = subobjects_.equal_range(it->second);
-        decltype(subrange.first) p;
-        for (p = subrange.first; p != subrange.second; /* no self-inc */) {
-          if (p->second == object_id) {
-            subobjects_.erase(p++);
-          } else {
-            ++p;
-          }
-        }
-        if (force) {
-          to_delete.emplace(it->second);
+      auto sups = supobjects_.find(object_id);
+      if (sups != supobjects_.end()) {
+        for (auto const& sup : sups->second) {
+          // remove dependency edge
+          dropRef(subobjects_, sup, object_id);
+          to_delete.emplace(sup);
         }
       }
-      if (force) {
-        for (auto const& target : to_delete) {
-          traverseToDelete(initial_delete_set, delete_set, depth + 1, depthes,
-                           target, true, false);
-        }
+      for (auto const& target : to_delete) {
+        traverseToDelete(initial_delete_set, delete_set, depth + 1, depthes,
+                         target, true, false);
       }
     }
     subobjects_.erase(object_id);
@@ -321,13 +550,17 @@ void IMetaService::printDepsGraph() {
   std::stringstream ss;
   ss << "object top -> down dependencies: " << std::endl;
   for (auto const& kv : subobjects_) {
-    ss << ObjectIDToString(kv.first) << " -> " << ObjectIDToString(kv.second)
-       << std::endl;
+    for (auto const& sub : kv.second) {
+      ss << ObjectIDToString(kv.first) << " -> " << ObjectIDToString(sub)
+         << std::endl;
+    }
   }
   ss << "object down <- top dependencies: " << std::endl;
   for (auto const& kv : supobjects_) {
-    ss << ObjectIDToString(kv.first) << " <- " << ObjectIDToString(kv.second)
-       << std::endl;
+    for (auto const& sup : kv.second) {
+      ss << ObjectIDToString(kv.first) << " <- " << ObjectIDToString(sup)
+         << std::endl;
+    }
   }
   VLOG(100) << "Depenencies graph on " << server_ptr_->instance_name() << ": \n"
             << ss.str();
@@ -357,6 +590,7 @@ void IMetaService::putVal(const kv_t& kv, bool const from_remote) {
                              "', value = '" + value.dump(4) +
                              "', reason: " + status.ToString());
     }
+    index_.Update(kv.key);
     return Status::OK();
   };
 
@@ -368,7 +602,7 @@ void IMetaService::putVal(const kv_t& kv, bool const from_remote) {
       ObjectID equivalent = InvalidObjectID();
       std::string signature_key = kv.key.substr(kv.key.find_last_of("/") + 1);
       if (meta_tree::HasEquivalentWithSignature(
-              meta_, SignatureFromString(signature_key), object_id,
+              index_, SignatureFromString(signature_key), object_id,
               equivalent)) {
         CloneRef(equivalent, object_id);
       }
@@ -417,6 +651,7 @@ void IMetaService::delVal(std::string const& key) {
     if (meta_[ppath].empty()) {
       meta_[ppath.parent_pointer()].erase(ppath.back());
     }
+    index_.Update(key);
   }
 }
 
@@ -18,11 +18,14 @@ limitations under the License.
 
 #include <chrono>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "boost/asio/steady_timer.hpp"
@@ -42,6 +45,8 @@ limitations under the License.
 
 #define HEARTBEAT_TIME 60
 #define MAX_TIMEOUT_COUNT 3
+#define MAX_PERSIST_RETRIES 16
+#define MAX_GROUP_COMMIT_OPS 126
 
 namespace vineyard {
 
@@ -81,7 +86,15 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   };
 
   explicit IMetaService(std::shared_ptr<VineyardServer>& server_ptr)
-      : server_ptr_(server_ptr), rev_(0), meta_sync_lock_("/meta_sync_lock") {
+      : server_ptr_(server_ptr),
+        rev_(0),
+        persist_in_flight_(false),
+        persist_catch_up_(false),
+        persist_retries_(server_ptr->GetSpec()["metastore_spec"].value(
+            "persist_retries", MAX_PERSIST_RETRIES)),
+        meta_sync_lock_("/meta_sync_lock"),
+        meta_sync_revision_("/meta_sync_lock_revision"),
+        index_(meta_) {
     stopped_.store(false);
   }
 
@@ -153,60 +166,31 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     });
   }
 
+  /**
+   * Compute the ops against the local `meta_`, and commit them only if the
+   * metadata hasn't been changed by other instances since `rev_`, i.e., a
+   * compare-and-swap on the revision. On conflicts, catch up with the updates
+   * and recompute the ops, at most `persist_retries` times (see the
+   * `--meta_persist_retries` flag).
+   *
+   * Thus the cost doesn't grow with the size of the metadata in the cluster,
+   * and instances don't serialize on the `meta_sync_lock_`.
+   *
+   * The requests are group-committed: the requests that arrive while a commit
+   * is in flight are merged into the next commit, at most
+   * `MAX_GROUP_COMMIT_OPS` ops, to not issue a transaction for every small
+   * object under bursty workloads.
+   */
   inline void RequestToPersist(
       callback_t<const json&, std::vector<op_t>&> callback_after_ready,
       callback_t<> callback_after_finish) {
-    // NB: when persist local meta to etcd, we needs the meta_sync_lock_ to
-    // avoid contention between other vineyard instances.
     auto self(shared_from_this());
-    this->requestLock(
-        meta_sync_lock_,
-        [self, callback_after_ready, callback_after_finish](
-            const Status& status, std::shared_ptr<ILock> lock) {
-          if (self->stopped_.load()) {
-            return Status::AlreadyStopped("etcd metadata service");
-          }
-          if (status.ok()) {
-            self->requestValues(
-                "", [self, callback_after_ready, callback_after_finish, lock](
-                        const Status& status, const json& meta, unsigned rev) {
-                  if (self->stopped_.load()) {
-                    return Status::AlreadyStopped("etcd metadata service");
-                  }
-                  std::vector<op_t> ops;
-                  auto s = callback_after_ready(status, meta, ops);
-                  if (s.ok()) {
-                    if (ops.empty()) {
-                      unsigned rev_after_unlock = 0;
-                      VINEYARD_DISCARD(lock->Release(rev_after_unlock));
-                      return callback_after_finish(Status::OK());
-                    }
-                    // apply changes locally before committing to etcd
-                    self->metaUpdate(ops, false);
-                    // commit to etcd
-                    self->commitUpdates(ops, [self, callback_after_finish,
-                                              lock](const Status& status,
-                                                    unsigned rev) {
-                      if (self->stopped_.load()) {
-                        return Status::AlreadyStopped("etcd metadata service");
-                      }
-                      // update rev_ to the revision after unlock.
-                      unsigned rev_after_unlock = 0;
-                      VINEYARD_DISCARD(lock->Release(rev_after_unlock));
-                      return callback_after_finish(status);
-                    });
-                    return Status::OK();
-                  } else {
-                    unsigned rev_after_unlock = 0;
-                    VINEYARD_DISCARD(lock->Release(rev_after_unlock));
-                    return callback_after_finish(s);  // propogate the error
-                  }
-                });
-            return Status::OK();
-          } else {
-            LOG(ERROR) << status.ToString();
-            return callback_after_finish(status);  // propogate the error
-          }
+    server_ptr_->GetMetaContext().post(
+        [self, callback_after_ready, callback_after_finish]() {
+          self->pending_persists_.emplace_back(
+              callback_after_ready, callback_after_finish,
+              self->persist_retries_);
+          self->flushPersists();
         });
   }
 
@@ -228,6 +212,12 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     }
   }
 
+  /**
+   * The index of objects and signatures in `meta_`, it is only valid to
+   * access it in the callbacks of requests, i.e., in the meta context.
+   */
+  inline const meta_tree::MetaIndex& index() const { return index_; }
+
   inline void RequestToDelete(
       const std::vector<ObjectID>& object_ids, const bool force,
       const bool deep,
@@ -525,7 +515,7 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
                     return callback_after_finish(status);
                   });
               VINEYARD_SUPPRESS(
-                  self->server_ptr_->DeleteAllAt(self->meta_, target_inst));
+                  self->server_ptr_->DeleteAllAt(self->index_, target_inst));
               return status;
             } else {
               return callback_after_finish(status);
@@ -568,6 +558,20 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   virtual void commitUpdates(const std::vector<op_t>&,
                              callback_t<unsigned> callback_after_updated) = 0;
 
+  /**
+   * Commit the updates only if the metadata in the backend hasn't been
+   * changed since `base_rev`. The callback receives how many of the leading
+   * `changes` have been committed, which is less than `changes.size()` on
+   * conflicts, and may be more than zero if the changes need more than one
+   * transaction.
+   *
+   * The default implementation checks the revision while holding the
+   * `meta_sync_lock_`.
+   */
+  virtual void commitUpdatesIf(
+      unsigned base_rev, const std::vector<op_t>& changes,
+      callback_t<size_t, unsigned> callback_after_updated);
+
   void requestValues(const std::string& prefix,
                      callback_t<const json&, unsigned> callback) {
     // We still need to run a `etcdctl get` for the first time. With a
@@ -633,9 +637,61 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   unsigned rev_;
   bool backend_retrying_;
 
+  struct pending_persist_t {
+    pending_persist_t(
+        callback_t<const json&, std::vector<op_t>&> callback_after_ready,
+        callback_t<> callback_after_finish, int retries)
+        : callback_after_ready(callback_after_ready),
+          callback_after_finish(callback_after_finish),
+          retries(retries),
+          requested(std::chrono::steady_clock::now()) {}
+    callback_t<const json&, std::vector<op_t>&> callback_after_ready;
+    callback_t<> callback_after_finish;
+    int retries;
+    std::chrono::steady_clock::time_point requested;
+    // the ops committed by the attempts that failed halfway, which are undone
+    // if the request fails in the end, see also `abortPersists`
+    std::vector<op_t> committed;
+  };
+
+  // the persist requests that wait for the next group commit
+  std::deque<pending_persist_t> pending_persists_;
+  bool persist_in_flight_;
+  // whether `meta_` may be behind the `meta_sync_revision_` in the backend,
+  // i.e., after our own commits or conflicts
+  bool persist_catch_up_;
+  int persist_retries_;
+  // the keys being deleted to undo a failed persist, the deletions are not
+  // applied to `meta_` when they come back from the watcher
+  std::set<std::string> undoing_;
+
   std::string meta_sync_lock_;
+  // the key that is updated by every commit, to detect the conflicts of
+  // `commitUpdatesIf`, it is prefixed with `meta_sync_lock_` thus is ignored
+  // by the watchers
+  std::string meta_sync_revision_;
+
+  // updated with `meta_` in `putVal()` and `delVal()`
+  meta_tree::MetaIndex index_;
 
  private:
+  /**
+   * Commit the pending persist requests as a group, if there's no commit in
+   * flight, and flush again when the commit finishes.
+   */
+  void flushPersists();
+
+  void finishPersists(const std::vector<pending_persist_t>& persists,
+                      const Status& status);
+
+  /**
+   * Fail the persist requests, after undoing the ops that have been committed
+   * by their previous attempts: the keys are deleted from the backend, and
+   * the objects are marked as transient again in `meta_`.
+   */
+  void abortPersists(const std::vector<pending_persist_t>& persists,
+                     const Status& status);
+
   virtual Status preStart() { return Status::OK(); }
 
   bool deleteable(ObjectID const object_id);
@@ -687,6 +743,11 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
         // skip the update of etcd lock
         continue;
       }
+      if (from_remote && op.op == op_t::op_type_t::kDel &&
+          undoing_.erase(op.kv.key)) {
+        // the objects are kept as transient, see also `abortPersists`
+        continue;
+      }
 
       // update instance status
       if (boost::algorithm::starts_with(op.kv.key, "/instances/")) {
@@ -736,6 +797,24 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
       putVal(op.kv, from_remote);
     }
 
+    // the objects whose metadata is modified (e.g., persisted, or named) or
+    // deleted, the clients that cache the metadata are notified in the end
+    std::set<ObjectID> invalidated;
+    {
+      auto datas = meta_.find("data");
+      if (datas != meta_.end()) {
+        const size_t prefix = std::string("/data/").size();
+        for (const op_t& op : add_datas) {
+          size_t end = op.kv.key.find('/', prefix);
+          std::string id = op.kv.key.substr(
+              prefix, end == std::string::npos ? end : end - prefix);
+          if (datas->contains(id)) {
+            invalidated.emplace(ObjectIDFromString(id));
+          }
+        }
+      }
+    }
+
     // apply adding datas
     for (const op_t& op : add_datas) {
       putVal(op.kv, from_remote);
@@ -758,6 +837,7 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
         if (vs.size() >= 3 && vs[2] == "__name") {
           // move the key to `drop_others` to drop
           drop_others.emplace_back(op);
+          invalidated.emplace(ObjectIDFromString(vs[1]));
         } else {
           initial_delete_set.emplace(ObjectIDFromString(vs[1]));
         }
@@ -782,6 +862,8 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
       for (auto const target : processed_delete_set) {
         delVal(target, blobs_to_delete);
       }
+      invalidated.insert(processed_delete_set.begin(),
+                         processed_delete_set.end());
     }
 
     // apply drop others
@@ -804,6 +886,10 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
 
     VINEYARD_SUPPRESS(server_ptr_->DeleteBlobBatch(blobs_to_delete));
     VINEYARD_SUPPRESS(server_ptr_->ProcessDeferred(meta_));
+    if (!invalidated.empty()) {
+      server_ptr_->NotifyMetaInvalidation(
+          std::vector<ObjectID>(invalidated.begin(), invalidated.end()));
+    }
   }
 
   void instanceUpdate(const op_t& op) {
@@ -869,10 +955,17 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   int64_t target_latest_time_ = 0;
   size_t timeout_count_ = 0;
 
+  // the objects that refer (or are referred by) an object, an object has
+  // no entry in it when the set becomes empty.
+  using refs_t = std::unordered_map<ObjectID, std::unordered_set<ObjectID>>;
+
+  static void addRef(refs_t& refs, ObjectID const from, ObjectID const to);
+  static void dropRef(refs_t& refs, ObjectID const from, ObjectID const to);
+
   // dependency: object id -> members' object id
-  std::multimap<ObjectID, ObjectID> subobjects_;
-  // dependency: object id -> ancestors' object id
-  std::multimap<ObjectID, ObjectID> supobjects_;
+  refs_t subobjects_;
+  // dependency: object id -> ancestors' object id, i.e., the reverse index
+  refs_t supobjects_;
 };
 
 }  // namespace vineyard
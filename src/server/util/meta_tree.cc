@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <fnmatch.h>
 
+#include <algorithm>
 #include <iostream>
 #include <regex>
 #include <set>
@@ -182,29 +183,15 @@ static bool has_sub_tree(const json& tree, const std::string& prefix,
   return tree.contains(json::json_pointer(path));
 }
 
-static std::string object_id_from_signature(const json& tree,
+static std::string object_id_from_signature(const MetaIndex& index,
                                             const std::string& instance_name,
                                             const std::string& signature) {
-  auto signature_key =
-      json::json_pointer("/signatures/" + instance_name + "/" + signature);
-  if (tree.contains(signature_key)) {
-    return tree[signature_key].get_ref<std::string const&>();
-  }
-  auto iter = tree.find("signatures");
-  if (iter != tree.end()) {
-    for (auto const& item : iter->items()) {
-      auto val = item.value().find(signature);
-      if (val != item.value().end()) {
-        return val->get_ref<std::string const&>();
-      }
-    }
-    LOG(ERROR) << "Failed to resolve object ID from signature: for "
-               << signature << ", existing signatures are: " << iter->dump(4);
-  } else {
+  ObjectID object_id = index.FindSignature(instance_name, signature);
+  if (object_id == InvalidObjectID()) {
     LOG(ERROR) << "Failed to resolve object ID from signature: for "
-               << signature << ", as there's no existing signature";
+               << signature << ", as there's no such signature";
   }
-  return ObjectIDToString(InvalidObjectID());
+  return ObjectIDToString(object_id);
 }
 
 static Status get_name(const json& tree, std::string& name,
@@ -270,29 +257,202 @@ static bool is_meta_placeholder(const json& tree) {
   return tree.is_object() && tree.size() == 1 && tree.contains("id");
 }
 
+MetaIndex::MetaIndex(const json& tree) : tree_(tree) {}
+
+void MetaIndex::Update(const std::string& key) {
+  static const std::string data_prefix = "/data/";
+  static const std::string signature_prefix = "/signatures/";
+  static const std::string name_prefix = "/names/";
+  if (key.compare(0, data_prefix.size(), data_prefix) == 0) {
+    size_t end = key.find('/', data_prefix.size());
+    updateObject(key.substr(data_prefix.size(),
+                            end == std::string::npos
+                                ? end
+                                : end - data_prefix.size()));
+  } else if (key.compare(0, signature_prefix.size(), signature_prefix) == 0) {
+    size_t sep = key.find('/', signature_prefix.size());
+    if (sep == std::string::npos) {
+      return;
+    }
+    size_t end = key.find('/', sep + 1);
+    updateSignature(
+        key.substr(signature_prefix.size(), sep - signature_prefix.size()),
+        key.substr(sep + 1, end == std::string::npos ? end : end - sep - 1));
+  } else if (key.compare(0, name_prefix.size(), name_prefix) == 0) {
+    updateName(key.substr(name_prefix.size()));
+  }
+}
+
+const json* MetaIndex::Find(const ObjectID id) const {
+  auto iter = objects_.find(id);
+  if (iter == objects_.end()) {
+    return nullptr;
+  }
+  return iter->second.node;
+}
+
+ObjectID MetaIndex::FindSignature(const std::string& instance_name,
+                                  const std::string& signature) const {
+  auto iter = signatures_.find(signature);
+  if (iter == signatures_.end()) {
+    return InvalidObjectID();
+  }
+  auto object = iter->second.find(instance_name);
+  if (object != iter->second.end()) {
+    return object->second;
+  }
+  // must be non-empty, see also `updateSignature()`
+  return iter->second.begin()->second;
+}
+
+const std::unordered_map<std::string, ObjectID>* MetaIndex::FindSignatures(
+    const std::string& signature) const {
+  auto iter = signatures_.find(signature);
+  if (iter == signatures_.end()) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+ObjectID MetaIndex::FindName(const std::string& name) const {
+  auto iter = names_.find(name);
+  if (iter == names_.end()) {
+    return InvalidObjectID();
+  }
+  return iter->second;
+}
+
+const std::set<ObjectID>* MetaIndex::FindType(
+    const std::string& type) const {
+  auto iter = types_.find(type);
+  if (iter == types_.end()) {
+    return nullptr;
+  }
+  return &iter->second;
+}
+
+void MetaIndex::updateObject(const std::string& name) {
+  if (name.empty()) {
+    return;
+  }
+  ObjectID id = ObjectIDFromString(name);
+  const json* node = nullptr;
+  auto datas = tree_.find("data");
+  if (datas != tree_.end()) {
+    auto iter = datas->find(name);
+    if (iter != datas->end() && iter->is_object() && !iter->empty()) {
+      node = &*iter;
+    }
+  }
+
+  auto entry = objects_.find(id);
+  if (node == nullptr) {
+    if (entry != objects_.end()) {
+      eraseType(id, entry->second.type);
+      objects_.erase(entry);
+    }
+    return;
+  }
+
+  std::string type;
+  auto type_iter = node->find("typename");
+  if (type_iter != node->end() && type_iter->is_string()) {
+    NodeType node_type = NodeType::InvalidType;
+    decode_value(type_iter->get_ref<std::string const&>(), node_type, type);
+  }
+  if (entry == objects_.end()) {
+    entry = objects_.emplace(id, entry_t{node, std::string()}).first;
+  }
+  entry->second.node = node;
+  if (entry->second.type != type) {
+    eraseType(id, entry->second.type);
+    entry->second.type = type;
+    if (!type.empty()) {
+      types_[type].emplace(id);
+    }
+  }
+}
+
+void MetaIndex::updateSignature(const std::string& instance_name,
+                                const std::string& signature) {
+  const json* value = nullptr;
+  auto signatures = tree_.find("signatures");
+  if (signatures != tree_.end()) {
+    auto instance = signatures->find(instance_name);
+    if (instance != signatures->end()) {
+      auto iter = instance->find(signature);
+      if (iter != instance->end() && iter->is_string()) {
+        value = &*iter;
+      }
+    }
+  }
+  if (value != nullptr) {
+    signatures_[signature][instance_name] =
+        ObjectIDFromString(value->get_ref<std::string const&>());
+    return;
+  }
+  auto iter = signatures_.find(signature);
+  if (iter != signatures_.end()) {
+    iter->second.erase(instance_name);
+    if (iter->second.empty()) {
+      signatures_.erase(iter);
+    }
+  }
+}
+
+void MetaIndex::updateName(const std::string& name) {
+  auto names = tree_.find("names");
+  if (names != tree_.end()) {
+    auto iter = names->find(name);
+    if (iter != names->end() && iter->is_number_integer()) {
+      names_[name] = iter->get<ObjectID>();
+      return;
+    }
+  }
+  names_.erase(name);
+}
+
+void MetaIndex::eraseType(const ObjectID id, const std::string& type) {
+  if (type.empty()) {
+    return;
+  }
+  auto iter = types_.find(type);
+  if (iter != types_.end()) {
+    iter->second.erase(id);
+    if (iter->second.empty()) {
+      types_.erase(iter);
+    }
+  }
+}
+
 /**
  * Get metadata for an object "recursively".
  */
-Status GetData(const json& tree, const std::string& instance_name,
+Status GetData(const MetaIndex& index, const std::string& instance_name,
                const ObjectID id, json& sub_tree,
                InstanceID const& current_instance_id) {
-  return GetData(tree, instance_name, ObjectIDToString(id), sub_tree,
+  return GetData(index, instance_name, ObjectIDToString(id), sub_tree,
                  current_instance_id);
 }
 
 /**
  * Get metadata for an object "recursively".
  */
-Status GetData(const json& tree, const std::string& instance_name,
+Status GetData(const MetaIndex& index, const std::string& instance_name,
                const std::string& name, json& sub_tree,
                InstanceID const& current_instance_id) {
-  json tmp_tree;
   sub_tree.clear();
-  Status status = get_sub_tree(tree, "/data", name, tmp_tree);
-  if (!status.ok()) {
-    return status;
+  if (name.empty() || name.find('/') != std::string::npos) {
+    LOG(ERROR) << "meta tree name invalid. " << name;
+    return Status::MetaTreeNameInvalid("metadata for '" + name +
+                                       "' cannot be found");
   }
-  for (auto const& item : tmp_tree.items()) {
+  const json* tmp_tree = index.Find(ObjectIDFromString(name));
+  if (tmp_tree == nullptr) {
+    return Status::MetaTreeSubtreeNotExists("get subtree failed: " + name);
+  }
+  Status status;
+  for (auto const& item : tmp_tree->items()) {
     if (!item.value().is_string()) {
       sub_tree[item.key()] = item.value();
       continue;
@@ -312,7 +472,7 @@ Status GetData(const json& tree, const std::string& instance_name,
       // the sub_sub_tree_name might be a signature
       if (sub_sub_tree_name[0] == 's') {
         sub_sub_tree_name =
-            object_id_from_signature(tree, instance_name, sub_sub_tree_name);
+            object_id_from_signature(index, instance_name, sub_sub_tree_name);
       }
 
       if (!status.ok()) {
@@ -320,7 +480,7 @@ Status GetData(const json& tree, const std::string& instance_name,
         return status;
       }
       json sub_sub_tree;
-      status = GetData(tree, instance_name, sub_sub_tree_name, sub_sub_tree,
+      status = GetData(index, instance_name, sub_sub_tree_name, sub_sub_tree,
                        current_instance_id);
       if (status.ok()) {
         sub_tree[item.key()] = sub_sub_tree;
@@ -350,60 +510,86 @@ Status GetData(const json& tree, const std::string& instance_name,
   return Status::OK();
 }
 
-Status ListData(const json& tree, const std::string& instance_name,
+/**
+ * The literal prefix of the glob pattern, before the first wildcard.
+ */
+static std::string glob_prefix(std::string const& pattern) {
+  return pattern.substr(0, pattern.find_first_of("*?[\\"));
+}
+
+Status ListData(const MetaIndex& index, const std::string& instance_name,
                 std::string const& pattern, bool const regex,
                 size_t const limit, json& tree_group) {
-  if (!tree.contains("data")) {
-    return Status::OK();
-  }
-
-  size_t found = 0;
-
-  for (auto const& item : tree["data"].items()) {
-    if (found >= limit) {
-      break;
+  // the objects are listed in the order of their ids, i.e., the order of
+  // "/data", thus at most `limit` objects of every matched type are the
+  // candidates
+  std::vector<ObjectID> matched;
+  auto list_objects = [&](std::set<ObjectID> const& objects) {
+    size_t found = 0;
+    for (auto iter = objects.begin(); iter != objects.end() && found < limit;
+         ++iter, ++found) {
+      matched.emplace_back(*iter);
     }
-
-    if (!item.value().is_object() || item.value().empty()) {
-      VLOG(10) << "list metadata: object meta shouldn't be empty: "
-               << item.value().dump(4);
-      // skip invalid metadata entries when listing
-      continue;
-    }
-    std::string type;
-    auto s = get_type(item.value(), type, true);
-    if (!s.ok()) {
-      VLOG(10) << "list metadata: object meta has invalid type, "
-               << s.ToString() << ": " << item.value().dump(4);
-      // skip invalid metadata entries when listing
-      continue;
+  };
+  auto list_matched = [&]() {
+    std::sort(matched.begin(), matched.end());
+    if (matched.size() > limit) {
+      matched.resize(limit);
     }
-
-    // match type on pattern
-    if (MatchTypeName(regex, pattern, type)) {
-      found += 1;
+    for (auto const& id : matched) {
+      std::string name = ObjectIDToString(id);
       json object_meta_tree;
       // skip invalid metadata entries when listing, rather than returning an
       // error
-      if (GetData(tree, instance_name, item.key(), object_meta_tree).ok()) {
-        tree_group[item.key()] = object_meta_tree;
+      if (GetData(index, instance_name, name, object_meta_tree).ok()) {
+        tree_group[name] = object_meta_tree;
       }
     }
-  }
-  return Status::OK();
-}
-
-Status ListAllData(const json& tree, std::vector<ObjectID>& objects) {
-  if (!tree.contains("data")) {
     return Status::OK();
+  };
+
+  // match the pattern against the distinct typenames, rather than against
+  // every object
+  if (regex) {
+    // compile the regex pattern once, and for invalid regex pattern, return
+    // nothing.
+    std::regex regex_pattern;
+    try {
+      regex_pattern = std::regex(pattern);
+    } catch (std::regex_error const&) { return Status::OK(); }
+    for (auto const& type : index.types()) {
+      if (std::regex_match(type.first, regex_pattern)) {
+        list_objects(type.second);
+      }
+    }
+    return list_matched();
   }
 
-  for (auto const& item : tree["data"].items()) {
-    if (!item.value().is_object() || item.value().empty()) {
-      LOG(INFO) << "Object meta shouldn't be empty";
-      return Status::MetaTreeInvalid();
+  std::string prefix = glob_prefix(pattern);
+  if (prefix.size() == pattern.size()) {
+    // no wildcards: the exact typename
+    auto objects = index.FindType(pattern);
+    if (objects != nullptr) {
+      list_objects(*objects);
+    }
+    return list_matched();
+  }
+  auto const& types = index.types();
+  for (auto type = types.lower_bound(prefix);
+       type != types.end() &&
+       type->first.compare(0, prefix.size(), prefix) == 0;
+       ++type) {
+    if (MatchTypeName(false, pattern, type->first)) {
+      list_objects(type->second);
     }
-    objects.emplace_back(ObjectIDFromString(item.key()));
+  }
+  return list_matched();
+}
+
+Status ListAllData(const MetaIndex& index, std::vector<ObjectID>& objects) {
+  objects.reserve(objects.size() + index.objects().size());
+  for (auto const& item : index.objects()) {
+    objects.emplace_back(item.first);
   }
   return Status::OK();
 }
@@ -862,10 +1048,10 @@ Status PutDataOps(const json& tree, std::string const& instance_name,
   return Status::OK();
 }
 
-Status PersistOps(const json& tree, const std::string& instance_name,
+Status PersistOps(const MetaIndex& index, const std::string& instance_name,
                   const ObjectID id, std::vector<op_t>& ops) {
   json sub_tree, diff;
-  Status status = GetData(tree, instance_name, id, sub_tree);
+  Status status = GetData(index, instance_name, id, sub_tree);
   if (!status.ok()) {
     return status;
   }
@@ -881,9 +1067,8 @@ Status PersistOps(const json& tree, const std::string& instance_name,
   return Status::OK();
 }
 
-Status Exists(const json& tree, const ObjectID id, bool& exists) {
-  std::string name = ObjectIDToString(id);
-  exists = has_sub_tree(tree, "/data", name);
+Status Exists(const MetaIndex& index, const ObjectID id, bool& exists) {
+  exists = index.Find(id) != nullptr;
   return Status::OK();
 }
 
@@ -920,35 +1105,32 @@ Status ShallowCopyOps(const json& tree, const ObjectID id,
   return Status::OK();
 }
 
-Status IfPersist(const json& tree, const ObjectID id, bool& persist) {
-  std::string name = ObjectIDToString(id);
-  json tmp_tree;
-  Status status = get_sub_tree(tree, "/data", name, tmp_tree);
-  if (status.ok()) {
-    RETURN_ON_ASSERT(
-        tmp_tree.contains("transient") && tmp_tree["transient"].is_boolean(),
-        "The 'transient' should a plain boolean value");
-    persist = !tmp_tree["transient"].get<bool>();
+Status IfPersist(const MetaIndex& index, const ObjectID id, bool& persist) {
+  const json* tmp_tree = index.Find(id);
+  if (tmp_tree == nullptr) {
+    return Status::MetaTreeSubtreeNotExists("get subtree failed: " +
+                                            ObjectIDToString(id));
   }
-  return status;
+  auto transient = tmp_tree->find("transient");
+  RETURN_ON_ASSERT(transient != tmp_tree->end() && transient->is_boolean(),
+                   "The 'transient' should a plain boolean value");
+  persist = !transient->get<bool>();
+  return Status::OK();
 }
 
-Status FilterAtInstance(const json& tree, const InstanceID& instance_id,
+Status FilterAtInstance(const MetaIndex& index, const InstanceID& instance_id,
                         std::vector<ObjectID>& objects) {
-  if (tree.contains("data")) {
-    for (auto const& item : tree["data"].items()) {
-      if (item.value().is_object() && !item.value().empty()) {
-        if (item.value().contains("instance_id") &&
-            item.value()["instance_id"].get<InstanceID>() == instance_id) {
-          objects.emplace_back(ObjectIDFromString(item.key()));
-        }
-      }
+  for (auto const& item : index.objects()) {
+    auto iter = item.second.node->find("instance_id");
+    if (iter != item.second.node->end() &&
+        iter->get<InstanceID>() == instance_id) {
+      objects.emplace_back(item.first);
     }
   }
   return Status::OK();
 }
 
-Status DecodeObjectID(const json& tree, const std::string& instance_name,
+Status DecodeObjectID(const MetaIndex& index, const std::string& instance_name,
                       const std::string& value, ObjectID& object_id) {
   NodeType type;
   std::string link_value;
@@ -963,7 +1145,7 @@ Status DecodeObjectID(const json& tree, const std::string& instance_name,
         object_id = ObjectIDFromString(name_of_value);
       } else if (name_of_value[0] == 's') {
         object_id = ObjectIDFromString(
-            object_id_from_signature(tree, instance_name, name_of_value));
+            object_id_from_signature(index, instance_name, name_of_value));
       } else {
         return Status::Invalid("Not a name or signature: " + name_of_value);
       }
@@ -973,39 +1155,37 @@ Status DecodeObjectID(const json& tree, const std::string& instance_name,
   return Status::Invalid();
 }
 
-bool HasEquivalent(const json& tree, ObjectID const object_id,
+bool HasEquivalent(const MetaIndex& index, ObjectID const object_id,
                    ObjectID& equivalent) {
-  std::string object_name = ObjectIDToString(object_id);
-  auto path = json::json_pointer("/data/" + object_name + "/signature");
-  if (!tree.contains(path)) {
+  const json* tree = index.Find(object_id);
+  if (tree == nullptr) {
+    return false;
+  }
+  auto signature = tree->find("signature");
+  if (signature == tree->end()) {
     return false;
   }
-  return HasEquivalentWithSignature(tree, tree[path].get<Signature>(),
+  return HasEquivalentWithSignature(index, signature->get<Signature>(),
                                     object_id, equivalent);
 }
 
-bool HasEquivalentWithSignature(const json& tree, Signature const signature,
+bool HasEquivalentWithSignature(const MetaIndex& index,
+                                Signature const signature,
                                 ObjectID const object_id,
                                 ObjectID& equivalent) {
-  std::string signature_key = SignatureToString(signature);
-  std::string object_name = ObjectIDToString(object_id);
-  json::const_iterator signatures = tree.find("signatures");
-  if (signatures == tree.end()) {
+  auto objects = index.FindSignatures(SignatureToString(signature));
+  if (objects == nullptr) {
     return false;
   }
   bool found = false;
-  for (auto const& item : signatures->items()) {
-    auto val = item.value().find(signature_key);
-    if (val != item.value().end()) {
-      std::string const& val_ref = val->get_ref<std::string const&>();
-      if (val_ref != object_name) {
-        equivalent = ObjectIDFromString(val_ref);
-      }
-      if (found) {
-        return true;
-      }
-      found = true;
+  for (auto const& item : *objects) {
+    if (item.second != object_id) {
+      equivalent = item.second;
+    }
+    if (found) {
+      return true;
     }
+    found = true;
   }
   return false;
 }
@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef SRC_SERVER_UTIL_META_TREE_H_
 #define SRC_SERVER_UTIL_META_TREE_H_
 
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/util/json.h"
@@ -83,24 +85,111 @@ enum class NodeType {
   InvalidType = 15,
 };
 
-Status GetData(const json& tree, const std::string& instance_name,
+/**
+ * @brief MetaIndex indexes the objects and signatures in the meta tree, to
+ * resolve them without walking the json tree.
+ *
+ * The tree is still the source of truth, the index keeps pointers to the
+ * object nodes under "/data" (which are stable, as json objects are ordered
+ * maps), and must be updated with `Update()` after every key in the tree is
+ * put or deleted. The json of objects is materialized only when the metadata
+ * is returned to clients, see also `GetData()`.
+ */
+class MetaIndex {
+ public:
+  explicit MetaIndex(const json& tree);
+
+  const json& tree() const { return tree_; }
+
+  /**
+   * @brief Re-index the object, the signature or the name that the key (e.g.,
+   * "/data/<id>/<field>", "/signatures/<instance>/<signature>", or
+   * "/names/<name>") belongs to, after the key has been put or deleted.
+   */
+  void Update(const std::string& key);
+
+  /**
+   * @brief The (undecoded) node of the object in the tree, or nullptr.
+   */
+  const json* Find(const ObjectID id) const;
+
+  /**
+   * @brief Resolve the object id of the signature, prefer the object that
+   * lives in the given instance.
+   */
+  ObjectID FindSignature(const std::string& instance_name,
+                         const std::string& signature) const;
+
+  /**
+   * @brief The instances that have an object of the signature, and the
+   * object ids, or nullptr.
+   */
+  const std::unordered_map<std::string, ObjectID>* FindSignatures(
+      const std::string& signature) const;
+
+  /**
+   * @brief The object of the name, or `InvalidObjectID()`.
+   */
+  ObjectID FindName(const std::string& name) const;
+
+  /**
+   * @brief The objects of the (decoded) typename, ordered by the object ids,
+   * or nullptr.
+   */
+  const std::set<ObjectID>* FindType(const std::string& type) const;
+
+  /**
+   * @brief The typenames are ordered, thus the ones that start with the same
+   * prefix are adjacent, i.e., `types().lower_bound(prefix)`.
+   */
+  const std::map<std::string, std::set<ObjectID>>& types() const {
+    return types_;
+  }
+
+  struct entry_t {
+    const json* node;
+    // the decoded typename, empty if the "typename" hasn't been put yet
+    std::string type;
+  };
+
+  const std::unordered_map<ObjectID, entry_t>& objects() const {
+    return objects_;
+  }
+
+ private:
+  void updateObject(const std::string& name);
+  void updateSignature(const std::string& instance_name,
+                       const std::string& signature);
+  void updateName(const std::string& name);
+  void eraseType(const ObjectID id, const std::string& type);
+
+  const json& tree_;
+  std::unordered_map<ObjectID, entry_t> objects_;
+  std::map<std::string, std::set<ObjectID>> types_;
+  // signature -> (instance -> object id)
+  std::unordered_map<std::string, std::unordered_map<std::string, ObjectID>>
+      signatures_;
+  std::unordered_map<std::string, ObjectID> names_;
+};
+
+Status GetData(const MetaIndex& index, const std::string& instance_name,
                const ObjectID id, json& sub_tree,
                InstanceID const& current_instance_id = UnspecifiedInstanceID());
-Status GetData(const json& tree, const std::string& instance_name,
+Status GetData(const MetaIndex& index, const std::string& instance_name,
                const std::string& name, json& sub_tree,
                InstanceID const& current_instance_id = UnspecifiedInstanceID());
-Status ListData(const json& tree, const std::string& instance_name,
+Status ListData(const MetaIndex& index, const std::string& instance_name,
                 const std::string& pattern, bool const regex,
                 size_t const limit, json& tree_group);
-Status ListAllData(const json& tree, std::vector<ObjectID>& objects);
-Status IfPersist(const json& tree, const ObjectID id, bool& persist);
-Status Exists(const json& tree, const ObjectID id, bool& exists);
+Status ListAllData(const MetaIndex& index, std::vector<ObjectID>& objects);
+Status IfPersist(const MetaIndex& index, const ObjectID id, bool& persist);
+Status Exists(const MetaIndex& index, const ObjectID id, bool& exists);
 
 Status PutDataOps(const json& tree, const std::string& instance_name,
                   const ObjectID id, const json& sub_tree,
                   std::vector<op_t>& ops, InstanceID& computed_instance_id);
 
-Status PersistOps(const json& tree, const std::string& instance_name,
+Status PersistOps(const MetaIndex& index, const std::string& instance_name,
                   const ObjectID id, std::vector<op_t>& ops);
 
 Status DelDataOps(const json& tree, const ObjectID id, std::vector<op_t>& ops,
@@ -119,16 +208,17 @@ Status ShallowCopyOps(const json& tree, const ObjectID id,
                       const json& extra_metadata, const ObjectID target,
                       std::vector<op_t>& ops, bool& transient);
 
-Status FilterAtInstance(const json& tree, const InstanceID& instance_id,
+Status FilterAtInstance(const MetaIndex& index, const InstanceID& instance_id,
                         std::vector<ObjectID>& objects);
 
-Status DecodeObjectID(const json& tree, const std::string& instance_name,
+Status DecodeObjectID(const MetaIndex& index, const std::string& instance_name,
                       const std::string& value, ObjectID& object_id);
 
-bool HasEquivalent(const json& tree, ObjectID const object_id,
+bool HasEquivalent(const MetaIndex& index, ObjectID const object_id,
                    ObjectID& equivalent);
 
-bool HasEquivalentWithSignature(const json& tree, Signature const signature,
+bool HasEquivalentWithSignature(const MetaIndex& index,
+                                Signature const signature,
                                 ObjectID const object_id, ObjectID& equivalent);
 
 bool MatchTypeName(bool regex, std::string const& pattern,
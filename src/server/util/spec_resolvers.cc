@@ -38,6 +38,9 @@ DEFINE_string(meta, "etcd",
 DEFINE_string(etcd_endpoint, "http://127.0.0.1:2379", "endpoint of etcd");
 DEFINE_string(etcd_prefix, "vineyard", "metadata path prefix in etcd");
 DEFINE_string(etcd_cmd, "", "path of etcd executable");
+DEFINE_int32(meta_persist_retries, 16,
+             "how many times a persist is retried when it conflicts with the "
+             "commits of other instances");
 
 #if defined(BUILD_VINEYARDD_REDIS)
 DEFINE_string(redis_endpoint, "redis://127.0.0.1:6379", "endpoint of redis");
@@ -58,6 +61,12 @@ DEFINE_string(allocator,
               "allocator for shared memory allocation, can be one of: "
               "'dlmalloc', 'mimalloc'");
 
+DEFINE_string(small_blob_threshold, "4Ki",
+              "blobs not larger than the threshold are packed into slabs of "
+              "size classes, at most 16Ki, 0 means disabled");
+DEFINE_string(compaction_rate, "0",
+              "bytes of cold blobs that the background compaction moves per "
+              "second to defragment the shared memory, 0 means disabled");
 DEFINE_int64(stream_threshold, 80,
              "memory threshold of streams (percentage of total memory)");
 
@@ -69,6 +78,16 @@ DEFINE_double(spill_lower_rate, 0.3,
               "low watermark of triggering memory spilling");
 DEFINE_double(spill_upper_rate, 0.8,
               "high watermark of triggering memory spilling");
+DEFINE_string(spill_segment_size, "256Mi",
+              "size of the segment files that spilled blobs are appended to");
+DEFINE_string(spill_compression, "none",
+              "codec for compressing spilled blobs, one of none, lz4 and zstd");
+DEFINE_bool(spill_lazy_reload, false,
+            "serve reloaded blobs from the spill file via mmap, and move them "
+            "back to memory when they are accessed again");
+DEFINE_string(spill_eviction_policy, "lru",
+              "policy for choosing the cold blobs to spill, one of lru and "
+              "wtinylfu (scan-resistant)");
 
 // ipc
 DEFINE_string(socket, "/var/run/vineyard.sock", "IPC socket file location");
@@ -117,6 +136,7 @@ json MetaStoreSpecResolver::resolve() const {
   spec["etcd_prefix"] = FLAGS_etcd_prefix;
   spec["etcd_endpoint"] = FLAGS_etcd_endpoint;
   spec["etcd_cmd"] = FLAGS_etcd_cmd;
+  spec["persist_retries"] = FLAGS_meta_persist_retries;
 
   // resolve for redis
 #if defined(BUILD_VINEYARDD_REDIS)
@@ -132,10 +152,16 @@ json BulkstoreSpecResolver::resolve() const {
   size_t bulkstore_limit = parseMemoryLimit(FLAGS_size);
   spec["memory_size"] = bulkstore_limit;
   spec["allocator"] = FLAGS_allocator;
+  spec["small_blob_threshold"] = parseMemoryLimit(FLAGS_small_blob_threshold);
+  spec["compaction_rate"] = parseMemoryLimit(FLAGS_compaction_rate);
   spec["stream_threshold"] = FLAGS_stream_threshold;
   spec["spill_path"] = FLAGS_spill_path;
   spec["spill_lower_bound_rate"] = FLAGS_spill_lower_rate;
   spec["spill_upper_bound_rate"] = FLAGS_spill_upper_rate;
+  spec["spill_segment_size"] = parseMemoryLimit(FLAGS_spill_segment_size);
+  spec["spill_compression"] = FLAGS_spill_compression;
+  spec["spill_lazy_reload"] = FLAGS_spill_lazy_reload;
+  spec["spill_eviction_policy"] = FLAGS_spill_eviction_policy;
   return spec;
 }
 
@@ -15,19 +15,29 @@ limitations under the License.
 
 #include "server/util/spill_file.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common/memory/payload.h"
-#include "common/util/base64.h"
 #include "common/util/logging.h"
 #include "common/util/status.h"
 #include "common/util/uuid.h"
+#include "server/memory/allocator.h"
 #include "server/memory/memory.h"
-#include "server/util/file_io_adaptor.h"
 
 namespace util {
+using vineyard::BulkAllocator;
 using vineyard::BulkStore;
+using vineyard::ObjectID;
 using vineyard::Payload;
 using vineyard::Status;
 
@@ -37,70 +47,188 @@ void PutFixed64(std::string* dst, uint64_t value) {
   dst->append(buf, sizeof(buf));
 }
 
-Status SpillWriteFile::Init(uint64_t object_id) {
-  if (io_adaptor_) {
-    return Status::Invalid(
-        "Warning: may not flushed before io_adaptor_ is overwriten");
+namespace detail {
+
+static Status pwrite_fully(int fd, const void* buffer, size_t size,
+                           size_t offset) {
+  const char* pointer = static_cast<const char*>(buffer);
+  while (size > 0) {
+    ssize_t nbytes = pwrite(fd, pointer, size, offset);
+    if (nbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status::IOError(std::string("Failed to write spill segment: ") +
+                             strerror(errno));
+    }
+    pointer += nbytes;
+    offset += nbytes;
+    size -= nbytes;
   }
-  io_adaptor_ =
-      std::make_unique<FileIOAdaptor>(spill_path_ + std::to_string(object_id));
   return Status::OK();
 }
 
-Status SpillWriteFile::Write(const std::shared_ptr<Payload>& payload) {
-  RETURN_ON_ERROR(Init(payload->object_id));
-  if (io_adaptor_ == nullptr) {
-    return Status::IOError("Can't open io_adaptor");
+static Status pread_fully(int fd, void* buffer, size_t size, size_t offset) {
+  char* pointer = static_cast<char*>(buffer);
+  while (size > 0) {
+    ssize_t nbytes = pread(fd, pointer, size, offset);
+    if (nbytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status::IOError(std::string("Failed to read spill segment: ") +
+                             strerror(errno));
+    }
+    if (nbytes == 0) {
+      return Status::IOError("Unexpected end of spill segment");
+    }
+    pointer += nbytes;
+    offset += nbytes;
+    size -= nbytes;
   }
-  RETURN_ON_ERROR(io_adaptor_->Open("w"));
-  std::string to_spill;
-  PutFixed64(&to_spill, payload->object_id);
-  PutFixed64(&to_spill, static_cast<uint64_t>(payload->data_size));
-  to_spill.append(reinterpret_cast<const char*>(payload->pointer),
-                  payload->data_size);
-  return io_adaptor_->Write(to_spill.data(), to_spill.size());
+  return Status::OK();
 }
 
-Status SpillWriteFile::Sync() {
-  RETURN_ON_ERROR(io_adaptor_->Flush());
-  io_adaptor_ = nullptr;
-  return Status::OK();
+}  // namespace detail
+
+SpillSegmentStore::SpillSegmentStore(const std::string& spill_path,
+                                     size_t segment_size,
+                                     const std::string& compression)
+    : spill_path_(spill_path), segment_size_(segment_size) {
+  std::pair<SpillCodec, arrow::Compression::type> codecs[] = {
+      {kLZ4, arrow::Compression::LZ4_FRAME},
+      {kZstd, arrow::Compression::ZSTD},
+  };
+  for (auto const& item : codecs) {
+    if (arrow::util::Codec::IsAvailable(item.second)) {
+      auto codec = arrow::util::Codec::Create(item.second);
+      if (codec.ok()) {
+        codecs_[item.first] = std::move(codec).ValueOrDie();
+      }
+    }
+  }
+  if (compression == "lz4") {
+    codec_ = kLZ4;
+  } else if (compression == "zstd") {
+    codec_ = kZstd;
+  } else if (!compression.empty() && compression != "none") {
+    LOG(WARNING) << "Unknown spill compression '" << compression
+                 << "', spilled blobs won't be compressed";
+  }
+  if (codec_ != kNone && codecs_[codec_] == nullptr) {
+    LOG(WARNING) << "Spill compression '" << compression
+                 << "' is not supported by the arrow library, spilled blobs "
+                    "won't be compressed";
+    codec_ = kNone;
+  }
+  compact_worker_ = std::thread([this]() { this->CompactWorker(); });
 }
 
-Status SpillReadFile::Init(uint64_t object_id) {
-  if (io_adaptor_) {
-    return Status::Invalid(
-        "Warning: may not flushed before io_adaptor_ is overwriten");
+SpillSegmentStore::~SpillSegmentStore() {
+  {
+    std::lock_guard<std::mutex> locked(mu_);
+    stopped_ = true;
+  }
+  compact_cv_.notify_all();
+  if (compact_worker_.joinable()) {
+    compact_worker_.join();
+  }
+  for (auto& item : segments_) {
+    recycled_segments_.emplace_back(std::move(item.second));
+  }
+  for (auto& segment : recycled_segments_) {
+    if (segment.base != nullptr) {
+      munmap(segment.base, segment.capacity);
+    }
+    close(segment.fd);
+    unlink(segment.path.c_str());
   }
-  io_adaptor_ =
-      std::make_unique<FileIOAdaptor>(spill_path_ + std::to_string(object_id));
-  return Status::OK();
 }
 
-Status SpillReadFile::Read(std::shared_ptr<Payload>& payload,
-                           std::shared_ptr<BulkStore> bulk_store_ptr) {
-  RETURN_ON_ERROR(Init(payload->object_id));
-  // reload 1. object_id 2. data_size 3. content
-  if (io_adaptor_ == nullptr) {
-    return Status::IOError("Can't open io_adaptor");
+Status SpillSegmentStore::Write(const std::shared_ptr<Payload>& payload,
+                                const bool compress, size_t& stored_size) {
+  SpillCodec codec = kNone;
+  const uint8_t* content = payload->pointer;
+  stored_size = payload->data_size;
+
+  // compress before holding the lock
+  std::unique_ptr<uint8_t[]> compressed;
+  if (compress && codec_ != kNone && payload->data_size > 0) {
+    auto& compressor = codecs_[codec_];
+    int64_t bound =
+        compressor->MaxCompressedLen(payload->data_size, payload->pointer);
+    compressed.reset(new uint8_t[bound]);
+    auto r = compressor->Compress(payload->data_size, payload->pointer, bound,
+                                  compressed.get());
+    // keep the raw content if it cannot be compressed
+    if (r.ok() && static_cast<size_t>(*r) < stored_size) {
+      codec = codec_;
+      content = compressed.get();
+      stored_size = static_cast<size_t>(*r);
+    }
   }
-  RETURN_ON_ERROR(io_adaptor_->Open());
+
+  size_t record_size = kRecordHeaderSize + stored_size;
+  uint64_t segment_id = kInvalidSegment;
+  size_t offset = 0;
+  int fd = -1;
   {
-    char buf[sizeof(payload->object_id)];
-    RETURN_ON_ERROR(io_adaptor_->Read(buf, sizeof(payload->object_id)));
-    if (payload->object_id != util::DecodeFixed64(buf)) {
-      return Status::IOError("Open wrong file: " + spill_path_ +
-                             std::to_string(payload->object_id));
+    // reserve the space for the record, and write it without the lock
+    std::unique_lock<std::mutex> locked(mu_);
+    auto iter = WaitRecord(locked, payload->object_id);
+    if (iter != index_.end()) {
+      DropRecord(iter->first, iter->second);
+    }
+    RETURN_ON_ERROR(AllocateRecord(record_size, segment_id, offset));
+    auto& segment = segments_[segment_id];
+    segment.live_bytes += record_size;
+    segment.objects.emplace(payload->object_id);
+    segment.io_refs += 1;
+    segment.writing += 1;
+    index_.emplace(payload->object_id,
+                   Location{segment_id, offset, record_size, codec, false,
+                            true});
+    fd = segment.fd;
+  }
+
+  char header[kRecordHeaderSize];
+  EncodeFixed64(header, payload->object_id);
+  EncodeFixed64(header + sizeof(uint64_t),
+                static_cast<uint64_t>(payload->data_size));
+  EncodeFixed64(header + 2 * sizeof(uint64_t), codec);
+  EncodeFixed64(header + 3 * sizeof(uint64_t), stored_size);
+  auto status = detail::pwrite_fully(fd, header, kRecordHeaderSize, offset);
+  if (status.ok()) {
+    status = detail::pwrite_fully(fd, content, stored_size,
+                                  offset + kRecordHeaderSize);
+  }
+
+  std::lock_guard<std::mutex> locked(mu_);
+  // the record may have been dropped by `Delete()` in the meantime
+  auto iter = index_.find(payload->object_id);
+  if (iter != index_.end() && iter->second.writing &&
+      iter->second.segment == segment_id && iter->second.offset == offset) {
+    iter->second.writing = false;
+    segments_[segment_id].writing -= 1;
+    if (!status.ok()) {
+      DropRecord(iter->first, iter->second);
     }
   }
+  ReleaseSegment(segment_id);
+  write_cv_.notify_all();
+  return status;
+}
+
+Status SpillSegmentStore::Read(std::shared_ptr<Payload>& payload,
+                               std::shared_ptr<BulkStore> bulk_store_ptr) {
   {
-    char buf[sizeof(payload->data_size)];
-    RETURN_ON_ERROR(io_adaptor_->Read(buf, sizeof(payload->data_size)));
-    if (static_cast<uint64_t>(payload->data_size) != util::DecodeFixed64(buf)) {
-      return Status::IOError("Open wrong file: " + spill_path_ +
-                             std::to_string(payload->object_id));
+    std::unique_lock<std::mutex> locked(mu_);
+    if (WaitRecord(locked, payload->object_id) == index_.end()) {
+      return Status::IOError("Spilled blob not found: " +
+                             vineyard::ObjectIDToString(payload->object_id));
     }
   }
+  // n.b.: allocating may trigger spilling, which requires the lock.
   payload->pointer = bulk_store_ptr->AllocateMemoryWithSpill(
       payload->data_size, &payload->store_fd, &payload->map_size,
       &payload->data_offset);
@@ -109,18 +237,436 @@ Status SpillReadFile::Read(std::shared_ptr<Payload>& payload,
                                    std::to_string(payload->data_size) +
                                    " while reload spilling file");
   }
-  RETURN_ON_ERROR(io_adaptor_->Read(payload->pointer, payload->data_size));
-  RETURN_ON_ERROR(Delete_(payload->object_id));
-  io_adaptor_ = nullptr;
+
+  auto status = Status::OK();
+  uint64_t segment_id = kInvalidSegment;
+  size_t offset = 0;
+  int fd = -1;
+  std::string path;
+  {
+    // the record may have been relocated by compaction
+    std::unique_lock<std::mutex> locked(mu_);
+    auto iter = WaitRecord(locked, payload->object_id);
+    if (iter == index_.end()) {
+      status = Status::IOError("Spilled blob not found: " +
+                               vineyard::ObjectIDToString(payload->object_id));
+    } else {
+      segment_id = iter->second.segment;
+      offset = iter->second.offset;
+      auto& segment = segments_[segment_id];
+      segment.io_refs += 1;
+      fd = segment.fd;
+      path = segment.path;
+    }
+  }
+  if (status.ok()) {
+    // the content at the location won't be overwritten even if the record
+    // gets relocated, as the segment is pinned.
+    char header[kRecordHeaderSize];
+    status = detail::pread_fully(fd, header, kRecordHeaderSize, offset);
+    if (status.ok() &&
+        (DecodeFixed64(header) != payload->object_id ||
+         DecodeFixed64(header + sizeof(uint64_t)) !=
+             static_cast<uint64_t>(payload->data_size))) {
+      status = Status::IOError("Corrupted spill record for blob " +
+                               vineyard::ObjectIDToString(payload->object_id) +
+                               " in " + path);
+    }
+    if (status.ok()) {
+      status = ReadContent(fd, offset, header, payload);
+    }
+    std::lock_guard<std::mutex> locked(mu_);
+    if (status.ok()) {
+      auto iter = index_.find(payload->object_id);
+      if (iter != index_.end()) {
+        DropRecord(iter->first, iter->second);
+      }
+    }
+    ReleaseSegment(segment_id);
+  }
+  if (!status.ok()) {
+    BulkAllocator::Free(payload->pointer, payload->data_size);
+    payload->pointer = nullptr;
+  }
+  return status;
+}
+
+Status SpillSegmentStore::ReadContent(int fd, size_t offset,
+                                      const char* header,
+                                      std::shared_ptr<Payload>& payload) {
+  uint64_t codec = DecodeFixed64(header + 2 * sizeof(uint64_t));
+  size_t stored_size = DecodeFixed64(header + 3 * sizeof(uint64_t));
+  if (codec == kNone) {
+    return detail::pread_fully(fd, payload->pointer, payload->data_size,
+                               offset + kRecordHeaderSize);
+  }
+  if (codec >= sizeof(codecs_) / sizeof(codecs_[0]) ||
+      codecs_[codec] == nullptr) {
+    return Status::IOError("Unsupported codec of spilled blob: " +
+                           std::to_string(codec));
+  }
+  std::unique_ptr<uint8_t[]> compressed(new uint8_t[stored_size]);
+  RETURN_ON_ERROR(detail::pread_fully(fd, compressed.get(), stored_size,
+                                      offset + kRecordHeaderSize));
+  auto r = codecs_[codec]->Decompress(stored_size, compressed.get(),
+                                      payload->data_size, payload->pointer);
+  if (!r.ok()) {
+    return Status::ArrowError(r.status());
+  }
+  if (*r != payload->data_size) {
+    return Status::IOError("Failed to decompress spilled blob " +
+                           vineyard::ObjectIDToString(payload->object_id));
+  }
   return Status::OK();
 }
 
-Status SpillReadFile::Delete_(const vineyard::ObjectID& id) {
-  if (!io_adaptor_) {
-    return Status::Invalid("io_adaptor_ is not initialized");
+Status SpillSegmentStore::Map(std::shared_ptr<Payload>& payload) {
+  std::unique_lock<std::mutex> locked(mu_);
+  auto iter = WaitRecord(locked, payload->object_id);
+  if (iter == index_.end()) {
+    return Status::IOError("Spilled blob not found: " +
+                           vineyard::ObjectIDToString(payload->object_id));
+  }
+  auto& location = iter->second;
+  if (location.codec != kNone) {
+    return Status::NotImplemented("Compressed spilled blob cannot be mapped");
+  }
+  auto& segment = segments_[location.segment];
+  if (segment.base == nullptr) {
+    void* base =
+        mmap(nullptr, segment.capacity, PROT_READ, MAP_SHARED, segment.fd, 0);
+    if (base == MAP_FAILED) {
+      return Status::IOError("Failed to mmap spill segment '" + segment.path +
+                             "': " + strerror(errno));
+    }
+    segment.base = static_cast<uint8_t*>(base);
+  }
+  if (!location.mapped) {
+    location.mapped = true;
+    segment.mapped += 1;
+  }
+  segment.exported = true;
+  payload->store_fd = segment.fd;
+  payload->arena_fd = -1;
+  payload->data_offset = location.offset + kRecordHeaderSize;
+  payload->map_size = segment.capacity;
+  payload->pointer = segment.base + payload->data_offset;
+  payload->kind = Payload::Kind::kDiskMMap;
+  return Status::OK();
+}
+
+bool SpillSegmentStore::Unmap(const ObjectID& id) {
+  std::lock_guard<std::mutex> locked(mu_);
+  auto iter = index_.find(id);
+  if (iter == index_.end() || !iter->second.mapped) {
+    return false;
+  }
+  iter->second.mapped = false;
+  auto& segment = segments_[iter->second.segment];
+  segment.mapped -= 1;
+  if (NeedCompaction(iter->second.segment, segment)) {
+    compact_cv_.notify_one();
+  }
+  return true;
+}
+
+bool SpillSegmentStore::IsMapped(const ObjectID& id) {
+  std::lock_guard<std::mutex> locked(mu_);
+  auto iter = index_.find(id);
+  return iter != index_.end() && iter->second.mapped;
+}
+
+Status SpillSegmentStore::Delete(const ObjectID& id) {
+  std::lock_guard<std::mutex> locked(mu_);
+  auto iter = index_.find(id);
+  if (iter != index_.end()) {
+    DropRecord(iter->first, iter->second);
   }
-  RETURN_ON_ERROR(io_adaptor_->RemoveFile(spill_path_ + std::to_string(id)));
   return Status::OK();
 }
 
+Status SpillSegmentStore::Compact(bool& compacted) {
+  compacted = false;
+  ObjectID id = vineyard::InvalidObjectID();
+  Location source;
+  uint64_t target_id = kInvalidSegment;
+  size_t target_offset = 0;
+  int source_fd = -1, target_fd = -1;
+  {
+    std::lock_guard<std::mutex> locked(mu_);
+    auto segment_iter = segments_.begin();
+    while (segment_iter != segments_.end() &&
+           !NeedCompaction(segment_iter->first, segment_iter->second)) {
+      ++segment_iter;
+    }
+    if (segment_iter == segments_.end()) {
+      return Status::OK();
+    }
+    id = *segment_iter->second.objects.begin();
+    source = index_.at(id);
+    RETURN_ON_ERROR(AllocateRecord(source.size, target_id, target_offset));
+    auto& source_segment = segments_[source.segment];
+    auto& target_segment = segments_[target_id];
+    source_segment.io_refs += 1;
+    target_segment.io_refs += 1;
+    source_fd = source_segment.fd;
+    target_fd = target_segment.fd;
+  }
+
+  // copy without the lock, the record is published only if it is still
+  // there after copying
+  auto status = Status::OK();
+  constexpr size_t kCopyChunkSize = 4 * 1024 * 1024;
+  std::vector<char> buffer(std::min(source.size, kCopyChunkSize));
+  for (size_t copied = 0; status.ok() && copied < source.size;
+       copied += buffer.size()) {
+    size_t chunk = std::min(buffer.size(), source.size - copied);
+    status = detail::pread_fully(source_fd, buffer.data(), chunk,
+                                 source.offset + copied);
+    if (status.ok()) {
+      status = detail::pwrite_fully(target_fd, buffer.data(), chunk,
+                                    target_offset + copied);
+    }
+  }
+
+  std::lock_guard<std::mutex> locked(mu_);
+  ReleaseSegment(source.segment);
+  ReleaseSegment(target_id);
+  auto iter = index_.find(id);
+  bool relocate = status.ok() && iter != index_.end() &&
+                  iter->second.segment == source.segment &&
+                  iter->second.offset == source.offset &&
+                  !iter->second.mapped && !iter->second.writing;
+  if (relocate) {
+    DropRecord(id, source);
+    auto& target = segments_[target_id];
+    target.live_bytes += source.size;
+    target.objects.emplace(id);
+    index_.emplace(id, Location{target_id, target_offset, source.size,
+                                source.codec, false, false});
+  } else if (target_id != active_segment_ &&
+             segments_[target_id].objects.empty()) {
+    // the dedicated segment of a large blob
+    RemoveSegment(target_id);
+  }
+  RETURN_ON_ERROR(status);
+
+  for (auto const& item : segments_) {
+    if (NeedCompaction(item.first, item.second)) {
+      compacted = true;
+      break;
+    }
+  }
+  return Status::OK();
+}
+
+Status SpillSegmentStore::OpenSegment(size_t capacity, uint64_t& segment_id) {
+  segment_id = next_segment_id_++;
+  Segment segment;
+  // reuse the smallest recycled segment that is large enough, the capacity
+  // won't be changed as it has been used as the map size by clients.
+  auto recycled = recycled_segments_.end();
+  for (auto iter = recycled_segments_.begin();
+       iter != recycled_segments_.end(); ++iter) {
+    if (iter->capacity >= capacity &&
+        (recycled == recycled_segments_.end() ||
+         iter->capacity < recycled->capacity)) {
+      recycled = iter;
+    }
+  }
+  if (recycled != recycled_segments_.end()) {
+    segment = std::move(*recycled);
+    recycled_segments_.erase(recycled);
+    capacity = segment.capacity;
+  } else {
+    segment.path = spill_path_ + "segment-" + std::to_string(segment_id);
+    segment.capacity = capacity;
+    segment.fd = open(segment.path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (segment.fd < 0) {
+      return Status::IOError("Failed to create spill segment '" +
+                             segment.path + "': " + strerror(errno));
+    }
+  }
+  // preallocate the disk space of the whole segment to avoid the metadata
+  // updates when appending records.
+#if defined(__linux__) || defined(__linux) || defined(linux) || \
+    defined(__gnu_linux__)
+  int err = posix_fallocate(segment.fd, 0, static_cast<off_t>(capacity));
+#else
+  int err =
+      ftruncate(segment.fd, static_cast<off_t>(capacity)) == 0 ? 0 : errno;
+#endif
+  if (err != 0) {
+    std::string path = segment.path;
+    if (segment.exported) {
+      recycled_segments_.emplace_back(std::move(segment));
+    } else {
+      close(segment.fd);
+      unlink(segment.path.c_str());
+    }
+    return Status::IOError("Failed to preallocate spill segment '" + path +
+                           "': " + strerror(err));
+  }
+  segments_.emplace(segment_id, std::move(segment));
+  return Status::OK();
+}
+
+Status SpillSegmentStore::AllocateRecord(size_t size, uint64_t& segment_id,
+                                         size_t& offset) {
+  // large blobs are spilled to a dedicated segment
+  if (size > segment_size_) {
+    RETURN_ON_ERROR(OpenSegment(size, segment_id));
+    offset = 0;
+    segments_[segment_id].tail = size;
+    return Status::OK();
+  }
+  if (active_segment_ != kInvalidSegment) {
+    auto& active = segments_[active_segment_];
+    if (active.tail + size > active.capacity) {
+      uint64_t sealed_segment = active_segment_;
+      active_segment_ = kInvalidSegment;
+      if (active.objects.empty()) {
+        RemoveSegment(sealed_segment);
+      } else if (NeedCompaction(sealed_segment, segments_[sealed_segment])) {
+        compact_cv_.notify_one();
+      }
+    }
+  }
+  if (active_segment_ == kInvalidSegment) {
+    RETURN_ON_ERROR(OpenSegment(segment_size_, active_segment_));
+  }
+  auto& active = segments_[active_segment_];
+  segment_id = active_segment_;
+  offset = active.tail;
+  active.tail += size;
+  return Status::OK();
+}
+
+std::unordered_map<ObjectID, SpillSegmentStore::Location>::iterator
+SpillSegmentStore::WaitRecord(std::unique_lock<std::mutex>& locked,
+                              const ObjectID id) {
+  auto iter = index_.find(id);
+  while (iter != index_.end() && iter->second.writing) {
+    write_cv_.wait(locked);
+    iter = index_.find(id);
+  }
+  return iter;
+}
+
+void SpillSegmentStore::DropRecord(const ObjectID id,
+                                   const Location location) {
+  uint64_t segment_id = location.segment;
+  auto& segment = segments_[segment_id];
+  segment.live_bytes -= location.size;
+  if (location.mapped) {
+    segment.mapped -= 1;
+  }
+  if (location.writing) {
+    segment.writing -= 1;
+  }
+  segment.objects.erase(id);
+  index_.erase(id);
+  if (segment_id == active_segment_) {
+    return;
+  }
+  if (segment.objects.empty()) {
+    RemoveSegment(segment_id);
+  } else if (NeedCompaction(segment_id, segment)) {
+    compact_cv_.notify_one();
+  }
+}
+
+void SpillSegmentStore::ReleaseSegment(uint64_t segment_id) {
+  auto iter = segments_.find(segment_id);
+  if (iter == segments_.end()) {
+    return;
+  }
+  iter->second.io_refs -= 1;
+  if (iter->second.io_refs == 0 && iter->second.removing) {
+    RemoveSegment(segment_id);
+  } else if (NeedCompaction(segment_id, iter->second)) {
+    compact_cv_.notify_one();
+  }
+}
+
+void SpillSegmentStore::RemoveSegment(uint64_t segment_id) {
+  auto iter = segments_.find(segment_id);
+  if (iter == segments_.end()) {
+    return;
+  }
+  if (iter->second.io_refs > 0) {
+    // removed by the last `ReleaseSegment()`
+    iter->second.removing = true;
+    return;
+  }
+  if (iter->second.exported) {
+    // release the disk space but keep the file descriptor
+    auto& segment = iter->second;
+    if (ftruncate(segment.fd, 0) != 0) {
+      LOG(WARNING) << "Failed to truncate spill segment '" << segment.path
+                   << "': " << strerror(errno);
+    }
+    segment.tail = 0;
+    segment.live_bytes = 0;
+    segment.mapped = 0;
+    recycled_segments_.emplace_back(std::move(segment));
+    segments_.erase(iter);
+    return;
+  }
+  close(iter->second.fd);
+  if (unlink(iter->second.path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to remove spill segment '" << iter->second.path
+                 << "': " << strerror(errno);
+  }
+  segments_.erase(iter);
+}
+
+bool SpillSegmentStore::NeedCompaction(uint64_t segment_id,
+                                       const Segment& segment) const {
+  // compact the sealed segments where more than half of the space is wasted,
+  // mapped records are pinned.
+  return segment_id != active_segment_ && !segment.objects.empty() &&
+         segment.mapped == 0 && segment.writing == 0 &&
+         segment.live_bytes * 2 < segment.tail;
+}
+
+void SpillSegmentStore::CompactWorker() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> locked(mu_);
+      compact_cv_.wait(locked, [this]() {
+        if (stopped_) {
+          return true;
+        }
+        for (auto const& item : segments_) {
+          if (NeedCompaction(item.first, item.second)) {
+            return true;
+          }
+        }
+        return false;
+      });
+      if (stopped_) {
+        return;
+      }
+    }
+    // relocate records one by one, to not block spilling and reloading for
+    // too long.
+    bool compacted = true;
+    while (compacted) {
+      auto status = Compact(compacted);
+      std::unique_lock<std::mutex> locked(mu_);
+      if (stopped_) {
+        return;
+      }
+      if (!status.ok()) {
+        LOG(ERROR) << "Failed to compact spill segments: "
+                   << status.ToString();
+        // back off and retry later, e.g., when the disk is full
+        compact_cv_.wait_for(locked, std::chrono::seconds(1));
+        break;
+      }
+    }
+  }
+}
+
 }  // namespace util
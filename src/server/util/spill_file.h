@@ -16,75 +16,203 @@ limitations under the License.
 #ifndef SRC_SERVER_UTIL_SPILL_FILE_H_
 #define SRC_SERVER_UTIL_SPILL_FILE_H_
 
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "arrow/util/compression.h"
 
 #include "common/memory/payload.h"
-#include "common/util/arrow.h"
 #include "common/util/status.h"
 #include "common/util/uuid.h"
-#include "server/util/file_io_adaptor.h"
 
 namespace util {
 
 /*
-  For each spilled file, the disk-format is:
+  Spilled blobs are appended to large preallocated segment files, rather than
+  one file per blob, to avoid the metadata operations (create, unlink, inode
+  allocation) dominating the cost of spilling small blobs. For each spilled
+  blob, the record in segment is:
     - object_id: uint64
     - data_size: uint64
-    - content: uint8[data_size]
+    - codec: uint64, see `SpillCodec`
+    - stored_size: uint64
+    - content: uint8[stored_size]
+
+  Records are indexed in memory by the object id. Reloading or deleting a blob
+  only drops the index entry, and the segment file will be removed once all of
+  its records are dropped. Sealed segments that mostly consist of dropped
+  records will be compacted in background by relocating the live records to
+  the active segment.
+
+  The lock only guards reserving the space and the index, records are read
+  and written without it. A segment that has IO in flight is pinned and won't
+  be removed until the IO finishes, and a record being written won't be read
+  or relocated until it is complete.
+
+  Uncompressed records can also be served in place by mapping the segment
+  file, see `Map()`. Mapped records are pinned and won't be relocated. As
+  clients cache their mappings by the file descriptor, a segment that has
+  been mapped is never closed: it is truncated and recycled for later records
+  once it becomes empty.
 */
-class SpillWriteFile {
- public:
-  SpillWriteFile() = delete;
-
-  explicit SpillWriteFile(const std::string& spill_path)
-      : spill_path_(spill_path) {}
-
-  SpillWriteFile(const SpillWriteFile&) = delete;
-
-  SpillWriteFile& operator=(const SpillWriteFile&) = delete;
-
-  ~SpillWriteFile() {
-    if (io_adaptor_) {
-      DISCARD_ARROW_ERROR(io_adaptor_->Flush());
-    }
-  }
-
-  vineyard::Status Write(const std::shared_ptr<vineyard::Payload>& payload);
-  vineyard::Status Sync();
-
- private:
-  vineyard::Status Init(uint64_t object_id);
-  // TODO(ZjuYTW): change to string_view
-  std::string spill_path_;
-  std::unique_ptr<util::FileIOAdaptor> io_adaptor_ = nullptr;
-};
-
-class SpillReadFile {
+class SpillSegmentStore {
  public:
-  SpillReadFile() = delete;
-
-  explicit SpillReadFile(const std::string& spill_path)
-      : spill_path_(spill_path) {}
-
-  SpillReadFile(const SpillReadFile&) = delete;
-
-  SpillReadFile& operator=(const SpillReadFile&) = delete;
-
-  ~SpillReadFile() = default;
-
+  enum SpillCodec : uint64_t {
+    kNone = 0,
+    kLZ4 = 1,
+    kZstd = 2,
+  };
+
+  SpillSegmentStore() = delete;
+
+  /**
+   * @param compression The codec used for compressing spilled blobs, can be
+   * one of "none", "lz4" and "zstd".
+   */
+  SpillSegmentStore(const std::string& spill_path, size_t segment_size,
+                    const std::string& compression = "none");
+
+  SpillSegmentStore(const SpillSegmentStore&) = delete;
+
+  SpillSegmentStore& operator=(const SpillSegmentStore&) = delete;
+
+  ~SpillSegmentStore();
+
+  /**
+   * @brief Append the content of the payload to the active segment.
+   *
+   * @param compress Whether to compress the content with the configured codec,
+   * blobs that cannot be compressed will still be stored as they are.
+   * @param stored_size The size of the content in the record.
+   */
+  vineyard::Status Write(const std::shared_ptr<vineyard::Payload>& payload,
+                         const bool compress, size_t& stored_size);
+
+  /**
+   * @brief Reload the blob into newly allocated memory from the bulk store, and
+   * drop the record from the segment.
+   */
   vineyard::Status Read(std::shared_ptr<vineyard::Payload>& payload,
                         std::shared_ptr<vineyard::BulkStore> bulk_store_ptr);
 
+  /**
+   * @brief Point the payload to its record in the segment file without reading
+   * it into memory, the record is kept until the blob is deleted or promoted.
+   *
+   * Compressed records cannot be mapped and `NotImplemented` is returned.
+   */
+  vineyard::Status Map(std::shared_ptr<vineyard::Payload>& payload);
+
+  /**
+   * @brief Unpin a mapped record, i.e., the blob is spilled again and no
+   * longer served from the segment file.
+   *
+   * Return false if the blob has not been mapped.
+   */
+  bool Unmap(const vineyard::ObjectID& id);
+
+  bool IsMapped(const vineyard::ObjectID& id);
+
+  /**
+   * @brief Drop the spilled record of the blob without reloading.
+   */
+  vineyard::Status Delete(const vineyard::ObjectID& id);
+
+  /**
+   * @brief Relocate one live record out of a segment where the dropped records
+   * take the most part of it.
+   *
+   * Return true in `compacted` if there are still segments to be compacted.
+   */
+  vineyard::Status Compact(bool& compacted);
+
+  static constexpr size_t kRecordHeaderSize = 4 * sizeof(uint64_t);
+
  private:
-  vineyard::Status Init(uint64_t object_id);
+  static constexpr uint64_t kInvalidSegment = static_cast<uint64_t>(-1);
+
+  struct Segment {
+    int fd = -1;
+    std::string path;
+    // the preallocated size of the segment file
+    size_t capacity = 0;
+    // the end of last record
+    size_t tail = 0;
+    size_t live_bytes = 0;
+    std::unordered_set<vineyard::ObjectID> objects;
+    // the number of mapped records
+    size_t mapped = 0;
+    // the read-only mapping of the segment file on the server side
+    uint8_t* base = nullptr;
+    // whether the file descriptor has been sent to clients
+    bool exported = false;
+    // the reads and writes in flight, the segment won't be removed until
+    // they finish
+    size_t io_refs = 0;
+    // the records that are being written, which cannot be relocated
+    size_t writing = 0;
+    // the segment has been dropped while there are IO in flight
+    bool removing = false;
+  };
+
+  struct Location {
+    uint64_t segment;
+    size_t offset;
+    size_t size;
+    uint64_t codec;
+    bool mapped;
+    // the content is being written
+    bool writing;
+  };
+
+  vineyard::Status ReadContent(int fd, size_t offset, const char* header,
+                               std::shared_ptr<vineyard::Payload>& payload);
+
+  // The following methods require `mu_` being held.
+  vineyard::Status OpenSegment(size_t capacity, uint64_t& segment_id);
+  vineyard::Status AllocateRecord(size_t size, uint64_t& segment_id,
+                                  size_t& offset);
+  // wait until the record of the blob, if any, has been written
+  std::unordered_map<vineyard::ObjectID, Location>::iterator WaitRecord(
+      std::unique_lock<std::mutex>& locked, const vineyard::ObjectID id);
+  void DropRecord(const vineyard::ObjectID id, const Location location);
+  // finish an IO on the segment, see also `Segment::io_refs`
+  void ReleaseSegment(uint64_t segment_id);
+  void RemoveSegment(uint64_t segment_id);
+  bool NeedCompaction(uint64_t segment_id, const Segment& segment) const;
+
+  void CompactWorker();
 
-  // Delete should be called after Init()
-  vineyard::Status Delete_(const vineyard::ObjectID& id);
   std::string spill_path_;
-  std::unique_ptr<util::FileIOAdaptor> io_adaptor_ = nullptr;
+  size_t segment_size_;
+  SpillCodec codec_ = kNone;
+  // indexed by `SpillCodec`, used for decompressing as well
+  std::unique_ptr<arrow::util::Codec> codecs_[3];
+
+  std::mutex mu_;
+  // protected by mu_
+  uint64_t next_segment_id_ = 0;
+  uint64_t active_segment_ = kInvalidSegment;
+  std::map<uint64_t, Segment> segments_;
+  std::unordered_map<vineyard::ObjectID, Location> index_;
+  // empty segments that have been mapped by clients
+  std::vector<Segment> recycled_segments_;
+
+  // notified when records have been written
+  std::condition_variable write_cv_;
+
+  std::thread compact_worker_;
+  std::condition_variable compact_cv_;
+  bool stopped_ = false;
 };
 
 void PutFixed64(std::string* dst, uint64_t value);
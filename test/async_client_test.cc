@@ -0,0 +1,112 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+#include "arrow/io/api.h"
+
+#include "basic/ds/array.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./async_client_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  const size_t count = 8;
+  std::vector<std::unique_ptr<BlobWriter>> blob_writers(count);
+  std::vector<std::future<Status>> created;
+  for (size_t i = 0; i < count; ++i) {
+    created.emplace_back(
+        client.CreateBlobAsync(1024 * (i + 1), blob_writers[i]));
+  }
+  std::vector<ObjectID> ids;
+  for (size_t i = 0; i < count; ++i) {
+    VINEYARD_CHECK_OK(created[i].get());
+    CHECK_EQ(blob_writers[i]->size(), 1024 * (i + 1));
+    memset(blob_writers[i]->data(), static_cast<int>(i), 1024 * (i + 1));
+    // synchronous requests are still allowed in the async mode
+    ids.emplace_back(blob_writers[i]->Seal(client)->id());
+  }
+  LOG(INFO) << "Passed pipelined creating blobs tests...";
+
+  std::vector<std::shared_ptr<Blob>> blobs;
+  auto got = client.GetBlobsAsync(ids, blobs);
+  std::vector<ObjectMeta> metas(count);
+  std::vector<std::future<Status>> got_metas;
+  for (size_t i = 0; i < count; ++i) {
+    got_metas.emplace_back(client.GetMetaDataAsync(ids[i], metas[i]));
+  }
+  // the replies are completed by the client, rather than in `get()`
+  CHECK(got.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+  for (auto& got_meta : got_metas) {
+    CHECK(got_meta.wait_for(std::chrono::seconds(30)) ==
+          std::future_status::ready);
+  }
+  VINEYARD_CHECK_OK(got.get());
+  CHECK_EQ(blobs.size(), count);
+  for (size_t i = 0; i < count; ++i) {
+    CHECK_EQ(blobs[i]->size(), 1024 * (i + 1));
+    for (size_t j = 0; j < blobs[i]->size(); ++j) {
+      CHECK_EQ(blobs[i]->data()[j], static_cast<char>(i));
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    VINEYARD_CHECK_OK(got_metas[i].get());
+    CHECK_EQ(metas[i].GetId(), ids[i]);
+  }
+  LOG(INFO) << "Passed pipelined getting blobs and metadata tests...";
+
+  // the array builder issues synchronous requests in the async mode
+  std::vector<double> double_array = {1.0, 7.0, 3.0, 4.0, 2.0};
+  ArrayBuilder<double> builder(client, double_array);
+  auto sealed = std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+  ObjectMeta meta;
+  VINEYARD_CHECK_OK(client.GetMetaDataAsync(sealed->id(), meta).get());
+  CHECK_EQ(meta.GetTypeName(), sealed->meta().GetTypeName());
+  auto array = std::dynamic_pointer_cast<Array<double>>(
+      client.GetObject(sealed->id()));
+  CHECK(array != nullptr);
+  CHECK_EQ(array->size(), double_array.size());
+  for (size_t i = 0; i < double_array.size(); ++i) {
+    CHECK_EQ((*array)[i], double_array[i]);
+  }
+  LOG(INFO) << "Passed mixing synchronous and asynchronous requests tests...";
+
+  client.Disconnect();
+
+  // requests on a closed connection fail immediately
+  ObjectMeta closed_meta;
+  CHECK(!client.GetMetaDataAsync(ids[0], closed_meta).get().ok());
+  LOG(INFO) << "Passed async requests after disconnecting tests...";
+
+  return 0;
+}
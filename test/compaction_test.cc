@@ -0,0 +1,111 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * The test is run against vineyardd with `--compaction_rate`, see also
+ * `test/runner.py`. Deleting every other blob leaves holes in the shared
+ * memory, and the compaction moves the surviving cold blobs down into them.
+ */
+
+constexpr size_t kBlobSize = 64 * 1024;
+constexpr int kBlobs = 128;
+
+void FillBlob(uint8_t* data, int index) {
+  std::mt19937 engine(index);
+  for (size_t i = 0; i < kBlobSize; ++i) {
+    data[i] = static_cast<uint8_t>(engine());
+  }
+}
+
+void CheckBlob(Client& client, ObjectID id, int index) {
+  std::shared_ptr<Blob> blob;
+  VINEYARD_CHECK_OK(client.GetBlob(id, blob));
+  CHECK_EQ(blob->allocated_size(), kBlobSize);
+  std::vector<uint8_t> expected(kBlobSize);
+  FillBlob(expected.data(), index);
+  CHECK_EQ(std::memcmp(blob->data(), expected.data(), kBlobSize), 0);
+  VINEYARD_CHECK_OK(client.Release(id));
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./compaction_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  std::shared_ptr<InstanceStatus> status;
+  VINEYARD_CHECK_OK(client.InstanceStatus(status));
+  size_t moved_bytes = status->compaction_moved_bytes;
+  size_t reclaimed_bytes = status->compaction_reclaimed_bytes;
+
+  // fragment the shared memory by the interleaved create and delete
+  std::vector<ObjectID> blob_ids;
+  for (int i = 0; i < kBlobs; ++i) {
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(client.CreateBlob(kBlobSize, writer));
+    FillBlob(reinterpret_cast<uint8_t*>(writer->data()), i);
+    auto blob = writer->Seal(client);
+    blob_ids.emplace_back(blob->id());
+    VINEYARD_CHECK_OK(client.Release(blob->id()));
+  }
+  std::vector<ObjectID> dropped;
+  for (int i = 0; i < kBlobs; i += 2) {
+    dropped.emplace_back(blob_ids[i]);
+  }
+  VINEYARD_CHECK_OK(client.DelData(dropped));
+
+  // the compaction worker wakes up every second
+  for (int retries = 0; retries < 100; ++retries) {
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    if (status->compaction_moved_bytes > moved_bytes &&
+        status->compaction_reclaimed_bytes > reclaimed_bytes) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  CHECK_GT(status->compaction_moved_bytes, moved_bytes);
+  CHECK_GT(status->compaction_reclaimed_bytes, reclaimed_bytes);
+  LOG(INFO) << "Compaction moved " << status->compaction_moved_bytes
+            << " bytes, reclaimed " << status->compaction_reclaimed_bytes
+            << " bytes";
+
+  // the relocated blobs are still intact
+  for (int i = 1; i < kBlobs; i += 2) {
+    CheckBlob(client, blob_ids[i], i);
+  }
+  LOG(INFO) << "Passed compaction tests...";
+
+  client.Disconnect();
+  return 0;
+}
@@ -0,0 +1,93 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+#include "arrow/io/api.h"
+
+#include "basic/ds/arrow.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./create_blobs_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client1;
+  Client client2;
+  VINEYARD_CHECK_OK(client1.Connect(ipc_socket));
+  VINEYARD_CHECK_OK(client2.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  std::vector<size_t> sizes = {0, 16, 1024, 4096};
+  std::vector<std::unique_ptr<BlobWriter>> blob_writers;
+  VINEYARD_CHECK_OK(client1.CreateBlobs(sizes, blob_writers));
+  CHECK_EQ(blob_writers.size(), sizes.size());
+
+  std::vector<ObjectID> ids;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    CHECK_EQ(blob_writers[i]->size(), sizes[i]);
+    if (sizes[i] > 0) {
+      memset(blob_writers[i]->data(), static_cast<int>(i), sizes[i]);
+    }
+    ids.emplace_back(blob_writers[i]->Seal(client1)->id());
+  }
+
+  std::vector<std::shared_ptr<Blob>> blobs;
+  VINEYARD_CHECK_OK(client2.GetBlobs(ids, blobs));
+  CHECK_EQ(blobs.size(), sizes.size());
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    CHECK_EQ(blobs[i]->size(), sizes[i]);
+    for (size_t j = 0; j < sizes[i]; ++j) {
+      CHECK_EQ(blobs[i]->data()[j], static_cast<char>(i));
+    }
+  }
+  LOG(INFO) << "Passed creating blobs in a single request tests...";
+
+  // the blobs of an array are sealed in a single request
+  arrow::StringBuilder builder;
+  CHECK_ARROW_ERROR(builder.AppendValues({"a", "bb", "ccc"}));
+  CHECK_ARROW_ERROR(builder.AppendNull());
+  std::shared_ptr<arrow::StringArray> array;
+  CHECK_ARROW_ERROR(builder.Finish(&array));
+  StringArrayBuilder array_builder(client1, array);
+  auto sealed = array_builder.Seal(client1);
+
+  auto result =
+      std::dynamic_pointer_cast<StringArray>(client2.GetObject(sealed->id()));
+  CHECK(result != nullptr);
+  CHECK(result->GetArray()->Equals(array));
+  LOG(INFO) << "Passed sealing the blobs of an object in a batch tests...";
+
+  VINEYARD_CHECK_OK(client2.Release(ids));
+  VINEYARD_CHECK_OK(client2.Release(sealed->id()));
+  VINEYARD_CHECK_OK(client1.Release(ids));
+  LOG(INFO) << "Passed releasing blobs in a single request tests...";
+
+  client1.Disconnect();
+  client2.Disconnect();
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+#include "arrow/io/api.h"
+
+#include "basic/ds/array.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+ObjectID make_array(Client& client, ObjectID& blob_id) {
+  std::vector<double> double_array = {1.0, 7.0, 3.0, 4.0, 2.0};
+  ArrayBuilder<double> builder(client, double_array);
+  auto sealed_double_array =
+      std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+  blob_id = ObjectIDFromString(sealed_double_array->meta()
+                                   .MetaData()["buffer_"]["id"]
+                                   .get_ref<std::string const&>());
+  CHECK(blob_id != InvalidObjectID());
+  return sealed_double_array->id();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./deferred_release_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  // client2 observes the blobs released by client1, as `IsInUse` sends the
+  // deferred releases of the calling client first
+  Client client1, client2;
+  VINEYARD_CHECK_OK(client1.Connect(ipc_socket));
+  VINEYARD_CHECK_OK(client2.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  ObjectID blob_id = InvalidObjectID(), another_blob_id = InvalidObjectID();
+  ObjectID id = make_array(client1, blob_id);
+  ObjectID another_id = make_array(client1, another_blob_id);
+  VINEYARD_CHECK_OK(client1.Release({id, blob_id, another_id, another_blob_id}));
+
+  {  // deferred until flushed
+    VINEYARD_CHECK_OK(client1.DeferRelease(1024, 0));
+    bool is_in_use{false};
+    auto obj = client1.GetObject(id);
+    CHECK(obj != nullptr);
+    VINEYARD_CHECK_OK(client1.Release({id}));
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(is_in_use);
+    VINEYARD_CHECK_OK(client1.FlushReleases());
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(!is_in_use);
+  }
+
+  {  // canceled when got again
+    bool is_in_use{false};
+    auto obj = client1.GetObject(id);
+    CHECK(obj != nullptr);
+    VINEYARD_CHECK_OK(client1.Release({id}));
+    auto array = std::dynamic_pointer_cast<Array<double>>(client1.GetObject(id));
+    CHECK(array != nullptr);
+    CHECK_EQ(array->size(), 5);
+    CHECK_EQ(array->data()[1], 7.0);
+    VINEYARD_CHECK_OK(client1.FlushReleases());
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(is_in_use);
+    VINEYARD_CHECK_OK(client1.Release({id}));
+    VINEYARD_CHECK_OK(client1.FlushReleases());
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(!is_in_use);
+  }
+
+  {  // bounded by count
+    VINEYARD_CHECK_OK(client1.DeferRelease(2, 0));
+    bool is_in_use{false};
+    auto obj = client1.GetObject(id);
+    auto another_obj = client1.GetObject(another_id);
+    CHECK(obj != nullptr && another_obj != nullptr);
+    VINEYARD_CHECK_OK(client1.Release({id}));
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(is_in_use);
+    VINEYARD_CHECK_OK(client1.Release({another_id}));
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(!is_in_use);
+    VINEYARD_CHECK_OK(client2.IsInUse(another_blob_id, is_in_use));
+    CHECK(!is_in_use);
+  }
+
+  {  // bounded by time
+    VINEYARD_CHECK_OK(client1.DeferRelease(1024, 100));
+    bool is_in_use{false};
+    auto obj = client1.GetObject(id);
+    CHECK(obj != nullptr);
+    VINEYARD_CHECK_OK(client1.Release({id}));
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(is_in_use);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(!is_in_use);
+  }
+
+  {  // dropped on disconnection
+    bool is_in_use{false};
+    auto obj = client1.GetObject(id);
+    CHECK(obj != nullptr);
+    VINEYARD_CHECK_OK(client1.DeferRelease(1024, 0));
+    VINEYARD_CHECK_OK(client1.Release({id}));
+    client1.Disconnect();
+    sleep(5);
+    VINEYARD_CHECK_OK(client2.IsInUse(blob_id, is_in_use));
+    CHECK(!is_in_use);
+  }
+
+  LOG(INFO) << "Passed deferred release tests...";
+
+  client2.Disconnect();
+
+  return 0;
+}
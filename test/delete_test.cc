@@ -22,6 +22,7 @@ limitations under the License.
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -281,6 +282,45 @@ int main(int argc, char** argv) {
     CHECK(s.ok() && buffers.size() == 0);
   }
 
+  {
+    // deep deletion on a wide object, where one of the members is shared
+    // with another object
+    const size_t members = 1000;
+    std::vector<ObjectID> member_ids;
+    SequenceBuilder wide_builder(client);
+    wide_builder.SetSize(members);
+    for (size_t i = 0; i < members; ++i) {
+      std::vector<double> double_array = {1.0, 7.0, 3.0, 4.0, 2.0};
+      ArrayBuilder<double> builder(client, double_array);
+      auto member = builder.Seal(client);
+      member_ids.emplace_back(member->id());
+      wide_builder.SetValue(i, member);
+    }
+    auto wide_id = wide_builder.Seal(client)->id();
+
+    SequenceBuilder other_builder(client);
+    other_builder.SetSize(1);
+    other_builder.SetValue(0, client.GetObject(member_ids[0]));
+    auto other_id = other_builder.Seal(client)->id();
+
+    VINEYARD_CHECK_OK(client.DelData(wide_id, false, true));
+    VINEYARD_CHECK_OK(client.Exists(wide_id, exists));
+    CHECK(!exists);
+    for (size_t i = 1; i < members; ++i) {
+      VINEYARD_CHECK_OK(client.Exists(member_ids[i], exists));
+      CHECK(!exists);
+    }
+    // still referred by the other object
+    VINEYARD_CHECK_OK(client.Exists(member_ids[0], exists));
+    CHECK(exists);
+
+    VINEYARD_CHECK_OK(client.DelData(other_id, false, true));
+    VINEYARD_CHECK_OK(client.Exists(member_ids[0], exists));
+    CHECK(!exists);
+  }
+
+  LOG(INFO) << "wide deep deletion OK";
+
   // delete on complex data: and empty blob is quite special, since it cannot
   // been truely deleted.
   std::shared_ptr<InstanceStatus> status_before;
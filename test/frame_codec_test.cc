@@ -0,0 +1,113 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/util/compression.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// spans several frames, and the last frame is a partial one
+constexpr size_t kBufferSize = 2 * FrameCodec::kFrameSize + 12345;
+
+// encodes the buffer frame by frame, checks every frame with `check`, and
+// decodes the frames back into a copy of the buffer
+template <typename F>
+void RoundTrip(std::shared_ptr<FrameCodec> const& codec,
+               std::vector<uint8_t> const& buffer, F check) {
+  FrameEncoder encoder(codec, {{buffer.data(), buffer.size()}});
+  std::vector<uint8_t> decoded(buffer.size());
+  size_t offset = 0;
+  std::string frame;
+  for (encoder.Next(frame); !frame.empty(); encoder.Next(frame)) {
+    size_t raw_size = 0, stored_size = 0;
+    VINEYARD_CHECK_OK(codec->ReadHeader(
+        reinterpret_cast<const uint8_t*>(frame.data()), buffer.size() - offset,
+        raw_size, stored_size));
+    CHECK_EQ(frame.size(), FrameCodec::kHeaderSize + stored_size);
+    check(raw_size, stored_size);
+
+    const uint8_t* stored =
+        reinterpret_cast<const uint8_t*>(frame.data()) +
+        FrameCodec::kHeaderSize;
+    if (stored_size == raw_size) {
+      memcpy(decoded.data() + offset, stored, raw_size);
+    } else {
+      VINEYARD_CHECK_OK(codec->Decode(stored, stored_size,
+                                      decoded.data() + offset, raw_size));
+    }
+    offset += raw_size;
+  }
+  CHECK_EQ(offset, buffer.size());
+  CHECK_EQ(std::memcmp(decoded.data(), buffer.data(), buffer.size()), 0);
+}
+
+void TestCodec(const std::string& name) {
+  std::unique_ptr<FrameCodec> created;
+  VINEYARD_CHECK_OK(FrameCodec::Create(name, created));
+  std::shared_ptr<FrameCodec> codec(std::move(created));
+
+  // a small alphabet with long runs, which shrinks well
+  std::vector<uint8_t> compressible(kBufferSize);
+  std::mt19937 engine(0);
+  for (size_t i = 0; i < kBufferSize; i += 64) {
+    memset(compressible.data() + i, 'a' + engine() % 4,
+           std::min<size_t>(64, kBufferSize - i));
+  }
+  CHECK(codec->Compressible(compressible.data(), compressible.size()));
+  RoundTrip(codec, compressible, [](size_t raw_size, size_t stored_size) {
+    CHECK_LT(stored_size, raw_size);
+  });
+  LOG(INFO) << "Passed compressible frames of " << name;
+
+  // random bytes are passed through as they are
+  std::vector<uint8_t> incompressible(kBufferSize);
+  for (auto& byte : incompressible) {
+    byte = static_cast<uint8_t>(engine());
+  }
+  CHECK(!codec->Compressible(incompressible.data(), incompressible.size()));
+  RoundTrip(codec, incompressible, [](size_t raw_size, size_t stored_size) {
+    CHECK_EQ(stored_size, raw_size);
+  });
+
+  // even if the frame is asked to be compressed
+  std::string frame;
+  codec->Encode(incompressible.data(), FrameCodec::kFrameSize, true, frame);
+  CHECK_EQ(frame.size(), FrameCodec::kHeaderSize + FrameCodec::kFrameSize);
+  CHECK_EQ(std::memcmp(&frame[FrameCodec::kHeaderSize], incompressible.data(),
+                       FrameCodec::kFrameSize),
+           0);
+  LOG(INFO) << "Passed incompressible frames of " << name;
+}
+
+int main(int argc, char** argv) {
+  for (auto const& name : {"lz4", "zstd"}) {
+    if (!FrameCodec::IsAvailable(name)) {
+      LOG(INFO) << "Skipped the unavailable codec " << name;
+      continue;
+    }
+    TestCodec(name);
+  }
+  LOG(INFO) << "Passed frame codec tests...";
+  return 0;
+}
@@ -13,9 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <limits>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -50,6 +52,26 @@ int main(int argc, char** argv) {
   auto targets = client.ListObjects("vineyard::Tensor*");
   CHECK(!targets.empty());
 
+  auto contains = [&](std::vector<ObjectMeta> const& metas) {
+    for (auto const& meta : metas) {
+      if (meta.GetId() == sealed->id()) {
+        return true;
+      }
+    }
+    return false;
+  };
+  const size_t limit = std::numeric_limits<size_t>::max();
+  CHECK(contains(client.ListObjectMeta("vineyard::Tensor<double>", false,
+                                       limit)));
+  CHECK(contains(client.ListObjectMeta("vineyard::Tensor<*>", false, limit)));
+  CHECK(contains(client.ListObjectMeta("*Tensor*", false, limit)));
+  CHECK(contains(client.ListObjectMeta("vineyard::Tensor<.*>", true, limit)));
+  CHECK(!contains(client.ListObjectMeta("vineyard::Tensor<int>", false,
+                                        limit)));
+  CHECK(client.ListObjectMeta("vineyard::NotExists*", false, limit).empty());
+  CHECK(client.ListObjectMeta("((", true, limit).empty());
+  CHECK_LE(client.ListObjectMeta("vineyard::*", false, 1).size(), 1);
+
   LOG(INFO) << "Passed list objects tests...";
 
   client.Disconnect();
@@ -14,6 +14,7 @@ limitations under the License.
 */
 
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -48,8 +49,63 @@ void BasicTest() {
   }
 }
 
+void ScanResistanceTest() {
+  auto policy = detail::EvictionPolicy<uint64_t>::Make("wtinylfu");
+  CHECK(policy != nullptr);
+  // blobs that are reused frequently
+  for (int round = 0; round < 4; round++) {
+    for (uint64_t id = 0; id < 100; id++) {
+      policy->Access(id);
+      policy->Add(id);
+    }
+  }
+  // a scan where each blob is accessed only once
+  for (uint64_t id = 1000; id < 2000; id++) {
+    policy->Access(id);
+    policy->Add(id);
+  }
+  for (int i = 0; i < 1000; i++) {
+    uint64_t victim;
+    CHECK(policy->Victim(victim));
+    CHECK_GE(victim, 1000);
+    policy->Remove(victim);
+  }
+  CHECK_EQ(policy->Size(), 100);
+}
+
+// N.B.: the test is compiled with `-fno-access-control`
+void SketchIndexTest() {
+  using Sketch = detail::FrequencySketch<uint64_t>;
+  const size_t depth = Sketch::kDepth;
+  Sketch sketch;
+  std::vector<std::vector<size_t>> indices(depth);
+  for (uint64_t id = 0; id < 1000; id++) {
+    uint64_t hash = Sketch::Mix(std::hash<uint64_t>()(id));
+    for (size_t row = 0; row < depth; row++) {
+      indices[row].push_back(sketch.Index(hash, row));
+    }
+  }
+  // every row spreads the ids over its counters
+  for (size_t row = 0; row < depth; row++) {
+    std::set<size_t> counters(indices[row].begin(), indices[row].end());
+    CHECK_GT(counters.size(), 900);
+  }
+  // two distinct ids don't share a counter in every row
+  for (size_t i = 0; i < 1000; i++) {
+    for (size_t j = i + 1; j < 1000; j++) {
+      bool shared = true;
+      for (size_t row = 0; row < depth && shared; row++) {
+        shared = indices[row][i] == indices[row][j];
+      }
+      CHECK(!shared);
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   BasicTest();
+  ScanResistanceTest();
+  SketchIndexTest();
   LOG(INFO) << "Passed lru tests...";
   return 0;
 }
@@ -0,0 +1,147 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "basic/ds/array.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+ObjectID CreateArray(Client& client) {
+  std::vector<double> double_array = {1.0, 7.0, 3.0, 4.0, 2.0};
+  ArrayBuilder<double> builder(client, double_array);
+  return builder.Seal(client)->id();
+}
+
+// waits until the notification of the deletion arrives
+void WaitForInvalidations(Client& client, const uint64_t invalidations) {
+  for (int retries = 0; retries < 100; ++retries) {
+    if (client.GetMetaCacheStats().invalidations >= invalidations) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  LOG(FATAL) << "The invalidation notification doesn't arrive";
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./meta_cache_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client1, client2;
+  VINEYARD_CHECK_OK(client1.Connect(ipc_socket));
+  VINEYARD_CHECK_OK(client2.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  // the cache is disabled by default
+  CHECK_EQ(client1.GetMetaCacheStats().capacity, 0);
+  VINEYARD_CHECK_OK(client1.EnableMetaCache(2));
+  CHECK_EQ(client1.GetMetaCacheStats().capacity, 2);
+
+  {
+    ObjectID id = CreateArray(client1);
+    ObjectMeta meta;
+    VINEYARD_CHECK_OK(client1.GetMetaData(id, meta));
+    VINEYARD_CHECK_OK(client1.GetMetaData(id, meta));
+    auto stats = client1.GetMetaCacheStats();
+    CHECK_EQ(stats.misses, 1);
+    CHECK_EQ(stats.hits, 1);
+    CHECK_EQ(stats.size, 1);
+    CHECK_EQ(meta.GetId(), id);
+
+    auto array = client1.GetObject<Array<double>>(id);
+    CHECK(array != nullptr);
+    CHECK_EQ(array->size(), 5);
+
+    // deleted by another client, the cache doesn't serve the object once the
+    // deletion returns
+    VINEYARD_CHECK_OK(client2.DelData(id, true, true));
+    auto status = client1.GetMetaData(id, meta);
+    CHECK(status.IsObjectNotExists());
+    WaitForInvalidations(client1, 1);
+    CHECK_EQ(client1.GetMetaCacheStats().size, 0);
+  }
+
+  for (int i = 0; i < 16; ++i) {
+    ObjectID id = CreateArray(client1);
+    ObjectMeta meta;
+    VINEYARD_CHECK_OK(client1.GetMetaData(id, meta));
+    VINEYARD_CHECK_OK(client2.DelData(id, true, true));
+    auto status = client1.GetMetaData(id, meta);
+    CHECK(status.IsObjectNotExists());
+  }
+
+  LOG(INFO) << "Passed invalidation by other clients tests...";
+
+  {
+    ObjectID id = CreateArray(client1);
+    json tree;
+    VINEYARD_CHECK_OK(client1.GetData(id, tree));
+    VINEYARD_CHECK_OK(client1.GetData(id, tree));
+    auto hits = client1.GetMetaCacheStats().hits;
+
+    // deleted by the client itself, invalidated without waiting
+    VINEYARD_CHECK_OK(client1.DelData(id, true, true));
+    auto status = client1.GetData(id, tree);
+    CHECK(status.IsObjectNotExists());
+    CHECK_EQ(client1.GetMetaCacheStats().hits, hits);
+  }
+
+  LOG(INFO) << "Passed invalidation by the client itself tests...";
+
+  {
+    std::vector<ObjectID> ids;
+    for (int i = 0; i < 3; ++i) {
+      ids.emplace_back(CreateArray(client1));
+    }
+    std::vector<json> trees;
+    VINEYARD_CHECK_OK(client1.GetData(ids, trees));
+    CHECK_EQ(trees.size(), ids.size());
+    // bounded by the capacity
+    CHECK_EQ(client1.GetMetaCacheStats().size, 2);
+
+    auto hits = client1.GetMetaCacheStats().hits;
+    trees.clear();
+    VINEYARD_CHECK_OK(client1.GetData(ids, trees));
+    CHECK_EQ(trees.size(), ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      CHECK_EQ(ObjectIDFromString(trees[i]["id"].get<std::string>()), ids[i]);
+    }
+    CHECK_EQ(client1.GetMetaCacheStats().hits, hits + 2);
+    VINEYARD_CHECK_OK(client1.DelData(ids, true, true));
+  }
+
+  LOG(INFO) << "Passed batch get tests...";
+
+  client1.DisableMetaCache();
+  CHECK_EQ(client1.GetMetaCacheStats().capacity, 0);
+
+  LOG(INFO) << "Passed meta cache tests...";
+
+  client1.Disconnect();
+  client2.Disconnect();
+
+  return 0;
+}
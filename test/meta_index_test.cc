@@ -0,0 +1,183 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <string>
+#include <vector>
+
+#include "common/util/json.h"
+#include "common/util/logging.h"
+#include "common/util/uuid.h"
+#include "server/util/meta_tree.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * The index is updated key by key, the same as how the metadata service
+ * applies the puts and deletes to the tree, see also `metaUpdate()`.
+ */
+
+void PutObject(json& tree, meta_tree::MetaIndex& index, const ObjectID id,
+               const std::string& type) {
+  std::string name = ObjectIDToString(id);
+  tree["data"][name]["typename"] = "v" + type;
+  tree["data"][name]["instance_id"] = 0;
+  tree["data"][name]["transient"] = true;
+  index.Update("/data/" + name);
+}
+
+void DelObject(json& tree, meta_tree::MetaIndex& index, const ObjectID id) {
+  std::string name = ObjectIDToString(id);
+  tree["data"].erase(name);
+  index.Update("/data/" + name);
+}
+
+void CheckType(meta_tree::MetaIndex const& index, const std::string& type,
+               std::vector<ObjectID> const& expected) {
+  auto objects = index.FindType(type);
+  if (expected.empty()) {
+    CHECK(objects == nullptr);
+    return;
+  }
+  CHECK(objects != nullptr);
+  CHECK(std::vector<ObjectID>(objects->begin(), objects->end()) == expected);
+}
+
+void CheckList(meta_tree::MetaIndex const& index, const std::string& pattern,
+               bool const regex, size_t const limit,
+               std::vector<ObjectID> const& expected) {
+  json tree_group;
+  VINEYARD_CHECK_OK(
+      meta_tree::ListData(index, "instance_0", pattern, regex, limit,
+                          tree_group));
+  std::vector<ObjectID> listed;
+  for (auto const& item : tree_group.items()) {
+    listed.emplace_back(ObjectIDFromString(item.key()));
+  }
+  CHECK(listed == expected);
+}
+
+void TestData() {
+  json tree = json::object();
+  meta_tree::MetaIndex index(tree);
+
+  PutObject(tree, index, 0x300, "vineyard::A");
+  PutObject(tree, index, 0x100, "vineyard::A");
+  CHECK(index.Find(0x100) != nullptr);
+  CHECK(index.Find(0x200) == nullptr);
+  CheckType(index, "vineyard::A", {0x100, 0x300});
+
+  // a field of the object is put
+  std::string name = ObjectIDToString(0x300);
+  tree["data"][name]["typename"] = "vvineyard::B";
+  index.Update("/data/" + name + "/typename");
+  CheckType(index, "vineyard::A", {0x100});
+  CheckType(index, "vineyard::B", {0x300});
+
+  // a field of the object is deleted
+  tree["data"][name].erase("typename");
+  index.Update("/data/" + name + "/typename");
+  CHECK(index.Find(0x300) != nullptr);
+  CHECK(index.objects().at(0x300).type.empty());
+  CheckType(index, "vineyard::B", {});
+
+  DelObject(tree, index, 0x300);
+  DelObject(tree, index, 0x100);
+  CHECK(index.Find(0x100) == nullptr);
+  CHECK(index.Find(0x300) == nullptr);
+  CHECK(index.objects().empty());
+  CheckType(index, "vineyard::A", {});
+  CHECK(index.types().empty());
+  LOG(INFO) << "Passed data index tests...";
+}
+
+void TestSignatures() {
+  json tree = json::object();
+  meta_tree::MetaIndex index(tree);
+  std::string signature = SignatureToString(0x42);
+
+  tree["signatures"]["instance_0"][signature] = ObjectIDToString(0x100);
+  index.Update("/signatures/instance_0/" + signature);
+  tree["signatures"]["instance_1"][signature] = ObjectIDToString(0x200);
+  index.Update("/signatures/instance_1/" + signature);
+  CHECK_EQ(index.FindSignature("instance_0", signature), 0x100u);
+  CHECK_EQ(index.FindSignature("instance_1", signature), 0x200u);
+  CHECK_EQ(index.FindSignatures(signature)->size(), 2u);
+
+  // the object of the other instance is the fallback
+  tree["signatures"]["instance_0"].erase(signature);
+  index.Update("/signatures/instance_0/" + signature);
+  CHECK_EQ(index.FindSignature("instance_0", signature), 0x200u);
+  CHECK_EQ(index.FindSignatures(signature)->size(), 1u);
+
+  tree["signatures"]["instance_1"].erase(signature);
+  index.Update("/signatures/instance_1/" + signature);
+  CHECK_EQ(index.FindSignature("instance_0", signature), InvalidObjectID());
+  CHECK(index.FindSignatures(signature) == nullptr);
+  LOG(INFO) << "Passed signatures index tests...";
+}
+
+void TestNames() {
+  json tree = json::object();
+  meta_tree::MetaIndex index(tree);
+
+  tree["names"]["name_0"] = 0x100;
+  index.Update("/names/name_0");
+  CHECK_EQ(index.FindName("name_0"), 0x100u);
+  CHECK_EQ(index.FindName("name_1"), InvalidObjectID());
+
+  // the name is put again to another object
+  tree["names"]["name_0"] = 0x200;
+  index.Update("/names/name_0");
+  CHECK_EQ(index.FindName("name_0"), 0x200u);
+
+  tree["names"].erase("name_0");
+  index.Update("/names/name_0");
+  CHECK_EQ(index.FindName("name_0"), InvalidObjectID());
+  LOG(INFO) << "Passed names index tests...";
+}
+
+void TestList() {
+  json tree = json::object();
+  meta_tree::MetaIndex index(tree);
+  // the objects of the two types are interleaved, and are put in the reversed
+  // order of their ids
+  for (ObjectID id = 16; id > 0; --id) {
+    PutObject(tree, index, id << 8,
+              (id % 2 == 0) ? "vineyard::List<A>" : "vineyard::List<B>");
+  }
+  PutObject(tree, index, 0x80, "vineyard::Other");
+
+  // the limit keeps the objects of the smallest ids, across the types
+  CheckList(index, "vineyard::List*", false, 3, {0x100, 0x200, 0x300});
+  CheckList(index, "vineyard::List<.*>", true, 3, {0x100, 0x200, 0x300});
+  CheckList(index, "vineyard::*", false, 2, {0x80, 0x100});
+  CheckList(index, "vineyard::List<A>", false, 3, {0x200, 0x400, 0x600});
+  CheckList(index, "vineyard::Other", false, 3, {0x80});
+  CheckList(index, "vineyard::None*", false, 3, {});
+
+  DelObject(tree, index, 0x100);
+  DelObject(tree, index, 0x200);
+  CheckList(index, "vineyard::List*", false, 3, {0x300, 0x400, 0x500});
+  LOG(INFO) << "Passed list index tests...";
+}
+
+int main(int argc, char** argv) {
+  TestData();
+  TestSignatures();
+  TestNames();
+  TestList();
+  LOG(INFO) << "Passed meta index tests...";
+  return 0;
+}
@@ -0,0 +1,115 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdlib.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+#include "arrow/io/api.h"
+
+#include "basic/ds/array.h"
+#include "basic/ds/sequence.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+double value_at(size_t array, size_t index) {
+  return static_cast<double>(array * 1000003 + index);
+}
+
+std::shared_ptr<Object> make_array(Client& client, size_t array,
+                                   size_t length) {
+  std::vector<double> values(length);
+  for (size_t index = 0; index < length; ++index) {
+    values[index] = value_at(array, index);
+  }
+  ArrayBuilder<double> builder(client, values);
+  return builder.Seal(client);
+}
+
+void check_array(std::shared_ptr<Object> const& object, size_t array,
+                 size_t length) {
+  auto values = std::dynamic_pointer_cast<Array<double>>(object);
+  CHECK(values != nullptr);
+  CHECK_EQ(values->size(), length);
+  for (size_t index = 0; index < length; ++index) {
+    CHECK_EQ((*values)[index], value_at(array, index));
+  }
+}
+
+void MigrateTest(Client& source, Client& target, std::string const& streams) {
+  const size_t small_arrays = 200, small_length = 17;
+  const size_t large_length = 8 * 1024 * 1024 + 3;
+
+  // a large blob that spans many chunks, and many small blobs that are packed
+  // into a few stripes
+  SequenceBuilder builder(source, small_arrays + 1);
+  builder.SetValue(0, make_array(source, 0, large_length));
+  for (size_t i = 1; i <= small_arrays; ++i) {
+    builder.SetValue(i, make_array(source, i, small_length));
+  }
+  auto sequence = builder.Seal(source);
+  VINEYARD_CHECK_OK(source.Persist(sequence->id()));
+
+  setenv("VINEYARD_MIGRATION_STREAMS", streams.c_str(), 1);
+  setenv("VINEYARD_MIGRATION_CHUNK_SIZE", "1048576", 1);
+  ObjectID migrated_id = InvalidObjectID();
+  VINEYARD_CHECK_OK(target.MigrateObject(sequence->id(), migrated_id));
+  CHECK_NE(migrated_id, sequence->id());
+
+  auto migrated =
+      std::dynamic_pointer_cast<Sequence>(target.GetObject(migrated_id));
+  CHECK(migrated != nullptr);
+  CHECK_EQ(migrated->Size(), small_arrays + 1);
+  CHECK_EQ(migrated->meta().GetInstanceId(), target.instance_id());
+  check_array(migrated->At(0), 0, large_length);
+  for (size_t i = 1; i <= small_arrays; ++i) {
+    check_array(migrated->At(i), i, small_length);
+  }
+
+  LOG(INFO) << "Passed migration tests with " << streams << " streams...";
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf("usage ./migrate_test <ipc_socket_1> <ipc_socket_2>");
+    return 1;
+  }
+  std::string ipc_socket_1 = std::string(argv[1]);
+  std::string ipc_socket_2 = std::string(argv[2]);
+
+  Client source, target;
+  VINEYARD_CHECK_OK(source.Connect(ipc_socket_1));
+  VINEYARD_CHECK_OK(target.Connect(ipc_socket_2));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket_1 << " and "
+            << ipc_socket_2;
+  CHECK_NE(source.instance_id(), target.instance_id());
+
+  MigrateTest(source, target, "1");
+  MigrateTest(source, target, "4");
+
+  LOG(INFO) << "Passed migrate tests...";
+
+  source.Disconnect();
+  target.Disconnect();
+
+  return 0;
+}
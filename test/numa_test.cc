@@ -0,0 +1,127 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/env.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// small blobs share pages with their neighbours, and large blobs span pages
+// that are not entirely their own at both ends
+const std::vector<size_t> kBlobSizes = {64,          1000,
+                                        4096,        64 * 1024 + 100,
+                                        1024 * 1024, 3 * 1024 * 1024 + 7};
+
+void CheckBlob(Client& client, ObjectID id, size_t size, uint8_t value) {
+  std::shared_ptr<Blob> blob;
+  VINEYARD_CHECK_OK(client.GetBlob(id, blob));
+  CHECK_EQ(blob->allocated_size(), size);
+  for (size_t i = 0; i < size; ++i) {
+    CHECK_EQ(blob->data()[i], static_cast<char>(value));
+  }
+  VINEYARD_CHECK_OK(client.Release(id));
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./numa_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  int nodes = get_numa_node_count();
+  LOG(INFO) << "NUMA nodes: " << nodes;
+
+  // the usage reports race with the allocations
+  std::atomic<bool> done(false);
+  std::thread reporter([&]() {
+    Client status_client;
+    VINEYARD_CHECK_OK(status_client.Connect(ipc_socket));
+    while (!done.load()) {
+      std::shared_ptr<InstanceStatus> status;
+      VINEYARD_CHECK_OK(status_client.InstanceStatus(status));
+      for (auto const& item : status->numa_usage) {
+        CHECK_GE(item.first, 0);
+        CHECK_LT(item.first, std::max(nodes, 1));
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    status_client.Disconnect();
+  });
+
+  // interleave the nodes, thus the neighbouring blobs prefer different nodes,
+  // and a node that doesn't exist doesn't fail the allocation
+  std::vector<ObjectID> blob_ids;
+  std::vector<size_t> blob_sizes;
+  for (int round = 0; round < 4; ++round) {
+    for (size_t size : kBlobSizes) {
+      int node = static_cast<int>(blob_ids.size()) % (nodes + 1);
+      std::unique_ptr<BlobWriter> writer;
+      VINEYARD_CHECK_OK(client.CreateBlob(size, node, writer));
+      std::memset(writer->data(), static_cast<uint8_t>(blob_ids.size()), size);
+      blob_ids.emplace_back(writer->Seal(client)->id());
+      blob_sizes.emplace_back(size);
+    }
+  }
+  for (size_t i = 0; i < blob_ids.size(); ++i) {
+    CheckBlob(client, blob_ids[i], blob_sizes[i], static_cast<uint8_t>(i));
+  }
+  LOG(INFO) << "Passed NUMA placement tests...";
+
+  // rebinding the freed memory keeps the new blobs intact as well
+  VINEYARD_CHECK_OK(client.DelData(blob_ids));
+  blob_ids.clear();
+  for (size_t i = 0; i < kBlobSizes.size(); ++i) {
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(client.CreateBlob(kBlobSizes[i], nodes - 1, writer));
+    std::memset(writer->data(), 0xab, kBlobSizes[i]);
+    blob_ids.emplace_back(writer->Seal(client)->id());
+  }
+  for (size_t i = 0; i < blob_ids.size(); ++i) {
+    CheckBlob(client, blob_ids[i], kBlobSizes[i], 0xab);
+  }
+  VINEYARD_CHECK_OK(client.DelData(blob_ids));
+  LOG(INFO) << "Passed NUMA rebinding tests...";
+
+  done.store(true);
+  reporter.join();
+
+  std::shared_ptr<InstanceStatus> status;
+  VINEYARD_CHECK_OK(client.InstanceStatus(status));
+  for (auto const& item : status->numa_usage) {
+    CHECK_GE(item.first, 0);
+    CHECK_LT(item.first, std::max(nodes, 1));
+  }
+  LOG(INFO) << "Passed NUMA usage tests...";
+
+  client.Disconnect();
+
+  return 0;
+}
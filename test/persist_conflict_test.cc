@@ -0,0 +1,226 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * The test is run against two vineyardd instances that share the metadata
+ * service: the instances persist concurrently, thus their commits conflict
+ * and are retried. Every member object is an op of the persist, thus the
+ * wide objects need more than one etcd transaction to be persisted.
+ *
+ * With `exhausted`, the instances are started with `--meta_persist_retries 0`,
+ * the wide objects that fail to be persisted must not be left halfway in the
+ * metadata service, and stay intact in the instance where they are created.
+ */
+
+constexpr int kThreads = 4;
+constexpr int kObjects = 16;
+constexpr int kFields = 8;
+// exceeds the max-txn-ops of etcd
+constexpr int kWideMembers = 150;
+
+ObjectID CreateObject(Client& client, int value,
+                      std::vector<ObjectID>* members = nullptr) {
+  ObjectMeta meta;
+  meta.SetTypeName("vineyard::PersistConflictTest");
+  for (int i = 0; i < kFields; ++i) {
+    meta.AddKeyValue("field_" + std::to_string(i), value + i);
+  }
+  for (int i = 0; members != nullptr && i < kWideMembers; ++i) {
+    ObjectMeta member;
+    member.SetTypeName("vineyard::PersistConflictTestMember");
+    member.AddKeyValue("value", value + i);
+    ObjectID member_id = InvalidObjectID();
+    VINEYARD_CHECK_OK(client.CreateMetaData(member, member_id));
+    meta.AddMember("member_" + std::to_string(i), member_id);
+    members->emplace_back(member_id);
+  }
+  ObjectID id = InvalidObjectID();
+  VINEYARD_CHECK_OK(client.CreateMetaData(meta, id));
+  return id;
+}
+
+void CheckMeta(ObjectMeta const& meta, bool wide, int value) {
+  for (int i = 0; i < kFields; ++i) {
+    CHECK_EQ(meta.GetKeyValue<int>("field_" + std::to_string(i)), value + i);
+  }
+  for (int i = 0; wide && i < kWideMembers; ++i) {
+    auto member = meta.GetMemberMeta("member_" + std::to_string(i));
+    CHECK_EQ(member.GetKeyValue<int>("value"), value + i);
+  }
+}
+
+void CheckObject(Client& client, ObjectID id, bool wide, int value) {
+  ObjectMeta meta;
+  Status status;
+  for (int retries = 0; retries < 50; ++retries) {
+    status = client.GetMetaData(id, meta, true);
+    if (status.ok()) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  VINEYARD_CHECK_OK(status);
+  CheckMeta(meta, wide, value);
+}
+
+// persists objects from several threads of both instances, and names every
+// object at the instance where it has been created
+void PersistObjects(std::string const& ipc_socket, int instance,
+                    std::vector<std::vector<ObjectID>>& objects) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      Client client;
+      VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+      for (int i = 0; i < kObjects; ++i) {
+        int value = (instance * kThreads + t) * kObjects + i;
+        std::vector<ObjectID> members;
+        ObjectID id = CreateObject(client, value,
+                                   (i % 4 == 0) ? &members : nullptr);
+        VINEYARD_CHECK_OK(client.Persist(id));
+        VINEYARD_CHECK_OK(client.PutName(
+            id, "persist_conflict_" + std::to_string(value)));
+        objects[t].emplace_back(id);
+      }
+      client.Disconnect();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+// persists the wide objects at the first instance, while the second instance
+// keeps committing, and checks the objects that fail to be persisted
+void PersistExhausted(std::vector<std::string> const& ipc_sockets) {
+  std::atomic<bool> persisting(true);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      Client client;
+      VINEYARD_CHECK_OK(client.Connect(ipc_sockets[1]));
+      for (int i = 0; persisting.load(); ++i) {
+        VINEYARD_DISCARD(client.Persist(CreateObject(client, t + i)));
+      }
+      client.Disconnect();
+    });
+  }
+
+  Client client, other;
+  VINEYARD_CHECK_OK(client.Connect(ipc_sockets[0]));
+  VINEYARD_CHECK_OK(other.Connect(ipc_sockets[1]));
+  std::vector<ObjectID> ids;
+  std::vector<std::vector<ObjectID>> members(kObjects);
+  std::vector<bool> persisted;
+  for (int i = 0; i < kObjects; ++i) {
+    ids.emplace_back(CreateObject(client, i, &members[i]));
+    persisted.emplace_back(client.Persist(ids[i]).ok());
+  }
+  persisting.store(false);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  int failures = 0;
+  for (int i = 0; i < kObjects; ++i) {
+    if (persisted[i]) {
+      CheckObject(other, ids[i], true, i);
+      continue;
+    }
+    failures += 1;
+    // nothing is left in the metadata service
+    ObjectMeta meta;
+    CHECK(!other.GetMetaData(ids[i], meta, true).ok());
+    for (auto const& member : members[i]) {
+      CHECK(!other.GetMetaData(member, meta, true).ok());
+    }
+    // the object is still transient and intact locally
+    bool is_persisted = true;
+    VINEYARD_CHECK_OK(client.IfPersist(ids[i], is_persisted));
+    CHECK(!is_persisted);
+    VINEYARD_CHECK_OK(client.GetMetaData(ids[i], meta));
+    CheckMeta(meta, true, i);
+    // and can be persisted once the conflicts are gone
+    VINEYARD_CHECK_OK(client.Persist(ids[i]));
+    CheckObject(other, ids[i], true, i);
+  }
+  LOG(INFO) << failures << " of " << kObjects
+            << " wide objects failed to be persisted";
+  client.Disconnect();
+  other.Disconnect();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf(
+        "usage ./persist_conflict_test <ipc_socket_1> <ipc_socket_2> "
+        "[exhausted]");
+    return 1;
+  }
+  std::vector<std::string> ipc_sockets = {std::string(argv[1]),
+                                          std::string(argv[2])};
+  if (argc > 3 && std::string(argv[3]) == "exhausted") {
+    PersistExhausted(ipc_sockets);
+    LOG(INFO) << "Passed persist exhausted retries tests...";
+    return 0;
+  }
+
+  std::vector<std::vector<std::vector<ObjectID>>> objects(
+      2, std::vector<std::vector<ObjectID>>(kThreads));
+  {
+    std::thread persist0(
+        [&]() { PersistObjects(ipc_sockets[0], 0, objects[0]); });
+    std::thread persist1(
+        [&]() { PersistObjects(ipc_sockets[1], 1, objects[1]); });
+    persist0.join();
+    persist1.join();
+  }
+  LOG(INFO) << "Passed concurrent persist tests...";
+
+  // every object, including the wide ones, is complete at the other instance
+  for (int instance = 0; instance < 2; ++instance) {
+    Client client;
+    VINEYARD_CHECK_OK(client.Connect(ipc_sockets[1 - instance]));
+    for (int t = 0; t < kThreads; ++t) {
+      for (int i = 0; i < kObjects; ++i) {
+        int value = (instance * kThreads + t) * kObjects + i;
+        ObjectID id = objects[instance][t][i];
+        CheckObject(client, id, i % 4 == 0, value);
+
+        ObjectID named = InvalidObjectID();
+        VINEYARD_CHECK_OK(client.GetName(
+            "persist_conflict_" + std::to_string(value), named, true));
+        CHECK_EQ(named, id);
+      }
+    }
+    client.Disconnect();
+  }
+  LOG(INFO) << "Passed persist conflict tests...";
+
+  return 0;
+}
@@ -13,9 +13,13 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <unistd.h>
+
+#include <atomic>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -23,10 +27,42 @@ limitations under the License.
 #include "basic/ds/array.h"
 #include "client/client.h"
 #include "client/ds/object_meta.h"
+#include "client/io.h"
 #include "common/util/logging.h"
+#include "common/util/protocols.h"
 
 using namespace vineyard;  // NOLINT(build/namespaces)
 
+// sends the requests back to back, without waiting for the replies, thus they
+// arrive at the server together and can be committed in the same group
+class PipelinedConnection {
+ public:
+  explicit PipelinedConnection(std::string const& ipc_socket) {
+    VINEYARD_CHECK_OK(connect_ipc_socket_retry(ipc_socket, conn_));
+    std::string message_out;
+    WriteRegisterRequest(message_out, StoreType::kDefault);
+    VINEYARD_CHECK_OK(send_message(conn_, message_out));
+    json root;
+    Receive(root);
+    CHECK(root.value("type", "") == "register_reply");
+  }
+
+  ~PipelinedConnection() { close(conn_); }
+
+  void Send(std::string const& message_out) {
+    VINEYARD_CHECK_OK(send_message(conn_, message_out));
+  }
+
+  void Receive(json& root) {
+    std::string message_in;
+    VINEYARD_CHECK_OK(recv_message(conn_, message_in));
+    root = json::parse(message_in.c_str());
+  }
+
+ private:
+  int conn_ = -1;
+};
+
 int main(int argc, char** argv) {
   if (argc < 2) {
     printf("usage ./persist_test <ipc_socket>");
@@ -64,6 +100,98 @@ int main(int argc, char** argv) {
     CHECK_EQ((*vy_double_array)[i], double_array[i]);
   }
 
+  // concurrent persists, that are committed in groups by the server
+  {
+    const int parallelism = 8, objects = 64;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < parallelism; ++i) {
+      threads.emplace_back([&]() {
+        Client thread_client;
+        VINEYARD_CHECK_OK(thread_client.Connect(ipc_socket));
+        for (int j = 0; j < objects; ++j) {
+          ArrayBuilder<double> builder(thread_client, double_array);
+          auto array = builder.Seal(thread_client);
+          VINEYARD_CHECK_OK(array->Persist(thread_client));
+          CHECK(array->IsPersist());
+          // the same object is persisted by other threads as well
+          VINEYARD_CHECK_OK(thread_client.Persist(id));
+          bool persist = false;
+          VINEYARD_CHECK_OK(thread_client.IfPersist(array->id(), persist));
+          CHECK(persist);
+          VINEYARD_CHECK_OK(thread_client.DelData(array->id()));
+        }
+        thread_client.Disconnect();
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // conflicting requests in the same group are committed as if they were
+  // committed one by one, while other clients keep the commits in flight
+  {
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&]() {
+        Client thread_client;
+        VINEYARD_CHECK_OK(thread_client.Connect(ipc_socket));
+        while (!done.load()) {
+          ArrayBuilder<double> builder(thread_client, double_array);
+          auto array = builder.Seal(thread_client);
+          VINEYARD_CHECK_OK(array->Persist(thread_client));
+          VINEYARD_CHECK_OK(thread_client.DelData(array->id()));
+        }
+        thread_client.Disconnect();
+      });
+    }
+
+    PipelinedConnection conn(ipc_socket);
+    for (int round = 0; round < 64; ++round) {
+      ArrayBuilder<double> builder(client, double_array);
+      auto array = builder.Seal(client);
+      std::string kept = "persist_test_kept_" + std::to_string(round);
+      std::string dropped = "persist_test_dropped_" + std::to_string(round);
+
+      // the name is put on the object that is just persisted, and then put
+      // and dropped
+      std::string message_out;
+      WritePersistRequest(array->id(), message_out);
+      conn.Send(message_out);
+      WritePutNameRequest(array->id(), kept, message_out);
+      conn.Send(message_out);
+      WritePutNameRequest(array->id(), dropped, message_out);
+      conn.Send(message_out);
+      WriteDropNameRequest(dropped, message_out);
+      conn.Send(message_out);
+
+      json root;
+      conn.Receive(root);
+      VINEYARD_CHECK_OK(ReadPersistReply(root));
+      conn.Receive(root);
+      VINEYARD_CHECK_OK(ReadPutNameReply(root));
+      conn.Receive(root);
+      VINEYARD_CHECK_OK(ReadPutNameReply(root));
+      conn.Receive(root);
+      VINEYARD_CHECK_OK(ReadDropNameReply(root));
+
+      ObjectID named = InvalidObjectID();
+      VINEYARD_CHECK_OK(client.GetName(kept, named));
+      CHECK_EQ(named, array->id());
+      auto status = client.GetName(dropped, named);
+      CHECK(status.IsObjectNotExists());
+
+      VINEYARD_CHECK_OK(client.DropName(kept));
+      VINEYARD_CHECK_OK(client.DelData(array->id()));
+    }
+
+    done.store(true);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
   LOG(INFO) << "Passed persist tests...";
 
   client.Disconnect();
@@ -16,6 +16,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -131,6 +132,95 @@ void RemoteCreateAndGetTest(Client& ipc_client, RPCClient& rpc_client) {
   LOG(INFO) << "Passed remote buffer (remote create & remote get) tests...";
 }
 
+void RemoteGetManyTest(Client& ipc_client, RPCClient& rpc_client) {
+  // many small blobs, received with scatter reads
+  const size_t count = 2000;
+  std::vector<size_t> sizes;
+  for (size_t i = 0; i < count; ++i) {
+    sizes.emplace_back((i % 97) + 1);
+  }
+  std::vector<std::unique_ptr<BlobWriter>> writers;
+  VINEYARD_CHECK_OK(ipc_client.CreateBlobs(sizes, writers));
+  std::vector<ObjectID> blob_ids;
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t k = 0; k < sizes[i]; ++k) {
+      writers[i]->data()[k] = static_cast<char>(i + k);
+    }
+    blob_ids.emplace_back(writers[i]->Seal(ipc_client)->id());
+  }
+
+  std::vector<std::shared_ptr<RemoteBlob>> remote_buffers;
+  VINEYARD_CHECK_OK(rpc_client.GetRemoteBlobs(blob_ids, remote_buffers));
+  CHECK_EQ(remote_buffers.size(), count);
+  for (size_t i = 0; i < count; ++i) {
+    CHECK(remote_buffers[i] != nullptr);
+    CHECK_EQ(remote_buffers[i]->id(), blob_ids[i]);
+    CHECK_EQ(remote_buffers[i]->allocated_size(), sizes[i]);
+    for (size_t k = 0; k < sizes[i]; ++k) {
+      CHECK_EQ(remote_buffers[i]->data()[k], static_cast<char>(i + k));
+    }
+  }
+
+  LOG(INFO) << "Passed remote buffer (local create & remote get many) tests...";
+}
+
+void RemoteGetRangeTest(Client& ipc_client, RPCClient& rpc_client) {
+  const size_t size = 10000;
+  std::unique_ptr<BlobWriter> writer;
+  VINEYARD_CHECK_OK(ipc_client.CreateBlob(size, writer));
+  for (size_t k = 0; k < size; ++k) {
+    writer->data()[k] = static_cast<char>(k * 7);
+  }
+  ObjectID blob_id = writer->Seal(ipc_client)->id();
+
+  const size_t offset = 1234, length = 567;
+  std::shared_ptr<RemoteBlob> range;
+  VINEYARD_CHECK_OK(
+      rpc_client.GetRemoteBlobRange(blob_id, offset, length, range));
+  CHECK_EQ(range->id(), blob_id);
+  CHECK_EQ(range->offset(), offset);
+  CHECK_EQ(range->allocated_size(), length);
+  CHECK_EQ(range->blob_size(), size);
+  for (size_t k = 0; k < length; ++k) {
+    CHECK_EQ(range->data()[k], static_cast<char>((k + offset) * 7));
+  }
+
+  // a view over the sub-range of the sub-range
+  const size_t slice_offset = 100, slice_length = 200;
+  std::shared_ptr<RemoteBlob> slice;
+  VINEYARD_CHECK_OK(range->Slice(slice_offset, slice_length, slice));
+  CHECK_EQ(slice->offset(), offset + slice_offset);
+  CHECK_EQ(slice->allocated_size(), slice_length);
+  CHECK_EQ(slice->blob_size(), size);
+  CHECK_EQ(slice->data(), range->data() + slice_offset);
+  CHECK(range->Slice(length - 10, 11, slice).IsInvalid());
+
+  // many ranges with a single request
+  std::vector<BufferChunk> ranges = {
+      {blob_id, 0, 10}, {blob_id, size - 10, 10}, {blob_id, 5000, 0}};
+  std::vector<std::shared_ptr<RemoteBlob>> remote_buffers;
+  VINEYARD_CHECK_OK(rpc_client.GetRemoteBlobRanges(ranges, remote_buffers));
+  CHECK_EQ(remote_buffers.size(), ranges.size());
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    CHECK_EQ(remote_buffers[i]->offset(), ranges[i].offset);
+    CHECK_EQ(remote_buffers[i]->allocated_size(), ranges[i].size);
+    for (size_t k = 0; k < ranges[i].size; ++k) {
+      CHECK_EQ(remote_buffers[i]->data()[k],
+               static_cast<char>((k + ranges[i].offset) * 7));
+    }
+  }
+
+  // out of range
+  CHECK(!rpc_client.GetRemoteBlobRange(blob_id, size - 10, 11, range).ok());
+  // the connection is still usable after the failed request
+  VINEYARD_CHECK_OK(rpc_client.GetRemoteBlobRange(blob_id, 0, size, range));
+  CHECK_EQ(range->allocated_size(), size);
+
+  VINEYARD_CHECK_OK(ipc_client.DelData(blob_id));
+  LOG(INFO) << "Passed remote buffer (local create & remote get range) "
+               "tests...";
+}
+
 int main(int argc, char** argv) {
   if (argc < 3) {
     printf("usage ./remote_buffer_test <ipc_socket> <rpc_endpoint>");
@@ -150,6 +240,8 @@ int main(int argc, char** argv) {
   RemoteCreateTest(ipc_client, rpc_client);
   RemoteGetTest(ipc_client, rpc_client);
   RemoteCreateAndGetTest(ipc_client, rpc_client);
+  RemoteGetManyTest(ipc_client, rpc_client);
+  RemoteGetRangeTest(ipc_client, rpc_client);
 
   LOG(INFO) << "Passed remote buffer tests...";
 
@@ -0,0 +1,134 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdlib.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "client/rpc_client.h"
+#include "common/util/compression.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// covers: tiny (sent raw), compressible across many frames, and
+// incompressible (skipped by the sampling) blobs
+std::vector<std::string> MakeContents() {
+  std::vector<std::string> contents;
+  contents.emplace_back("tiny blob");
+  std::string repeated;
+  for (size_t i = 0; repeated.size() < 3 * FrameCodec::kFrameSize + 17; ++i) {
+    repeated += "vineyard " + std::to_string(i % 1024) + ", ";
+  }
+  contents.emplace_back(repeated);
+  std::mt19937 engine(42);
+  std::string random(FrameCodec::kFrameSize + 4096, '\0');
+  for (auto& c : random) {
+    c = static_cast<char>(engine());
+  }
+  contents.emplace_back(random);
+  return contents;
+}
+
+void CompressionTest(Client& ipc_client, const std::string& rpc_endpoint,
+                     const std::string& compression) {
+  CHECK_EQ(setenv("VINEYARD_RPC_COMPRESSION", compression.c_str(), 1), 0);
+  RPCClient rpc_client;
+  VINEYARD_CHECK_OK(rpc_client.Connect(rpc_endpoint));
+  if (FrameCodec::IsAvailable(compression)) {
+    CHECK_EQ(rpc_client.compression(), compression);
+  } else {
+    CHECK_EQ(rpc_client.compression(), "");
+  }
+
+  auto contents = MakeContents();
+
+  // remote create & local get
+  std::vector<ObjectID> created;
+  for (auto const& content : contents) {
+    auto writer = std::make_shared<RemoteBlobWriter>(content.size());
+    std::memcpy(writer->data(), content.data(), content.size());
+    ObjectID blob_id = InvalidObjectID();
+    VINEYARD_CHECK_OK(rpc_client.CreateRemoteBlob(writer, blob_id));
+    created.emplace_back(blob_id);
+  }
+  for (size_t i = 0; i < contents.size(); ++i) {
+    std::shared_ptr<Blob> blob;
+    VINEYARD_CHECK_OK(ipc_client.GetBlob(created[i], blob));
+    CHECK_EQ(blob->allocated_size(), contents[i].size());
+    CHECK_EQ(std::memcmp(blob->data(), contents[i].data(), contents[i].size()),
+             0);
+  }
+
+  // local create & remote get
+  std::vector<ObjectID> blob_ids;
+  for (auto const& content : contents) {
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(ipc_client.CreateBlob(content.size(), writer));
+    std::memcpy(writer->data(), content.data(), content.size());
+    blob_ids.emplace_back(writer->Seal(ipc_client)->id());
+  }
+  std::vector<std::shared_ptr<RemoteBlob>> remote_blobs;
+  VINEYARD_CHECK_OK(rpc_client.GetRemoteBlobs(blob_ids, remote_blobs));
+  CHECK_EQ(remote_blobs.size(), contents.size());
+  for (size_t i = 0; i < contents.size(); ++i) {
+    CHECK_EQ(remote_blobs[i]->allocated_size(), contents[i].size());
+    CHECK_EQ(std::memcmp(remote_blobs[i]->data(), contents[i].data(),
+                         contents[i].size()),
+             0);
+
+    std::shared_ptr<RemoteBlob> remote_blob;
+    VINEYARD_CHECK_OK(rpc_client.GetRemoteBlob(blob_ids[i], remote_blob));
+    CHECK_EQ(remote_blob->allocated_size(), contents[i].size());
+    CHECK_EQ(std::memcmp(remote_blob->data(), contents[i].data(),
+                         contents[i].size()),
+             0);
+  }
+
+  VINEYARD_CHECK_OK(ipc_client.DelData(created));
+  VINEYARD_CHECK_OK(ipc_client.DelData(blob_ids));
+  rpc_client.Disconnect();
+  LOG(INFO) << "Passed remote buffer tests with compression '" << compression
+            << "'...";
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf("usage ./rpc_compression_test <ipc_socket> <rpc_endpoint>");
+    return 1;
+  }
+  std::string ipc_socket(argv[1]);
+  std::string rpc_endpoint(argv[2]);
+
+  Client ipc_client;
+  VINEYARD_CHECK_OK(ipc_client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  for (auto const& compression : {"none", "lz4", "zstd"}) {
+    CompressionTest(ipc_client, rpc_endpoint, compression);
+  }
+  unsetenv("VINEYARD_RPC_COMPRESSION");
+
+  LOG(INFO) << "Passed rpc compression tests...";
+
+  ipc_client.Disconnect();
+  return 0;
+}
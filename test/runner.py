@@ -4,9 +4,12 @@
 import contextlib
 import importlib
 import importlib.util
+import json
 import os
 import platform
+import shutil
 import socket
+import struct
 import subprocess
 import sys
 import time
@@ -210,6 +213,7 @@ def start_vineyardd(
     spill_path="",
     spill_upper_rate=0.8,
     spill_lower_rate=0.3,
+    extra_args=(),
     **kw,
 ):
     rpc_socket_port = find_port()
@@ -233,6 +237,7 @@ def start_vineyardd(
             str(spill_lower_rate),
             '--spill_upper_rate',
             str(spill_upper_rate),
+            *extra_args,
             verbose=True,
             **kw,
         )
@@ -403,6 +408,20 @@ def run_invalid_client_test(tests, host, port):
     send_garbage_bytes(b'\xFF' * 10000)
     send_garbage_bytes(b'\xFF' * 100000)
 
+    # unknown commands are replied with an error rather than left hanging
+    def expect_error_reply(message):
+        sock = socket.create_connection((host, port))
+        sock.settimeout(10)
+        sock.sendall(struct.pack('=Q', len(message)) + message)
+        with sock.makefile('rb') as reader:
+            (length,) = struct.unpack('=Q', reader.read(8))
+            reply = json.loads(reader.read(length))
+        sock.close()
+        assert reply['code'] == 6, reply  # NotImplemented
+
+    expect_error_reply(b'{"type": "unknown_request"}')
+    expect_error_reply(struct.pack('=BBhI', 0xB7, 0, 0x7FFF, 0))
+
 
 def run_single_vineyardd_tests(meta, endpoints, tests):
     meta_prefix = 'vineyard_test_%s' % time.time()
@@ -418,10 +437,14 @@ def run_single_vineyardd_tests(meta, endpoints, tests):
         # FIXME: cannot be safely dtor after #350 and #354.
         # run_test('allocator_test')
         run_test(tests, 'arrow_data_structure_test')
+        run_test(tests, 'async_client_test')
         run_test(tests, 'clear_test')
+        run_test(tests, 'create_blobs_test')
         run_test(tests, 'custom_vector_test')
         run_test(tests, 'dataframe_test')
+        run_test(tests, 'deferred_release_test')
         run_test(tests, 'delete_test')
+        run_test(tests, 'frame_codec_test')
         run_test(tests, 'get_wait_test')
         run_test(tests, 'get_blob_test')
         run_test(tests, 'get_blob_disk_test')
@@ -433,12 +456,16 @@ def run_single_vineyardd_tests(meta, endpoints, tests):
         run_test(tests, 'large_meta_test')
         run_test(tests, 'list_object_test')
         run_test(tests, 'lru_test')
+        run_test(tests, 'meta_cache_test')
+        run_test(tests, 'meta_index_test')
         run_test(tests, 'mutable_blob_test')
         run_test(tests, 'name_test')
+        run_test(tests, 'numa_test')
         run_test(tests, 'persist_test')
         run_test(tests, 'plasma_test')
         run_test(tests, 'release_test')
         run_test(tests, 'remote_buffer_test', '127.0.0.1:%d' % rpc_socket_port)
+        run_test(tests, 'rpc_compression_test', '127.0.0.1:%d' % rpc_socket_port)
         run_test(tests, 'rpc_delete_test', '127.0.0.1:%d' % rpc_socket_port)
         run_test(tests, 'rpc_get_object_test', '127.0.0.1:%d' % rpc_socket_port)
         run_test(tests, 'rpc_test', '127.0.0.1:%d' % rpc_socket_port)
@@ -446,6 +473,7 @@ def run_single_vineyardd_tests(meta, endpoints, tests):
         run_test(tests, 'sequence_test')
         run_test(tests, 'server_status_test')
         run_test(tests, 'session_test')
+        run_test(tests, 'shm_channel_test')
         run_test(tests, 'signature_test')
         run_test(tests, 'shallow_copy_test')
         run_test(tests, 'shared_memory_test')
@@ -466,6 +494,76 @@ def run_single_vineyardd_tests(meta, endpoints, tests):
     ):
         run_test(tests, 'spill_test')
 
+    # small segments to exercise the compaction, with and without the
+    # compression and the lazy reload of spilled blobs
+    for spill_args, test_args in [
+        ([], []),
+        (['--spill_compression', 'lz4'], ['compressed']),
+        (['--spill_compression', 'zstd'], ['compressed']),
+        (['--spill_lazy_reload=true'], ['lazy']),
+    ]:
+        spill_path = '/tmp/spill_segment_path'
+        shutil.rmtree(spill_path, ignore_errors=True)
+        os.makedirs(spill_path)
+        with start_vineyardd(
+            metadata_settings,
+            size=1024 * 1024,
+            default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+            spill_path=spill_path,
+            extra_args=['--spill_segment_size', '256Ki', *spill_args],
+        ):
+            run_test(tests, 'spill_segment_test', spill_path, *test_args)
+
+    # moves the cold blobs to fill the holes in the shared memory
+    with start_vineyardd(
+        metadata_settings,
+        size=64 * 1024 * 1024,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        extra_args=['--compaction_rate', '64Mi'],
+    ):
+        run_test(tests, 'compaction_test')
+
+
+def run_migration_tests(meta, endpoints, tests):
+    meta_prefix = 'vineyard_test_%s' % time.time()
+    metadata_settings = make_metadata_settings(meta, endpoints, meta_prefix)
+    with start_multiple_vineyardd(
+        metadata_settings,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        instance_size=2,
+    ):
+        time.sleep(5)
+        run_test(
+            tests,
+            'migrate_test',
+            '%s.1' % VINEYARD_CI_IPC_SOCKET,
+            vineyard_ipc_socket='%s.0' % VINEYARD_CI_IPC_SOCKET,
+        )
+        run_test(
+            tests,
+            'persist_conflict_test',
+            '%s.1' % VINEYARD_CI_IPC_SOCKET,
+            vineyard_ipc_socket='%s.0' % VINEYARD_CI_IPC_SOCKET,
+        )
+
+    # persists that conflict are not retried, to fail halfway
+    meta_prefix = 'vineyard_test_%s' % time.time()
+    metadata_settings = make_metadata_settings(meta, endpoints, meta_prefix)
+    with start_multiple_vineyardd(
+        metadata_settings,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        instance_size=2,
+        extra_args=['--meta_persist_retries', '0'],
+    ):
+        time.sleep(5)
+        run_test(
+            tests,
+            'persist_conflict_test',
+            '%s.1' % VINEYARD_CI_IPC_SOCKET,
+            'exhausted',
+            vineyard_ipc_socket='%s.0' % VINEYARD_CI_IPC_SOCKET,
+        )
+
 
 def run_scale_in_out_tests(meta, endpoints, instance_size=4):
     meta_prefix = 'vineyard_test_%s' % time.time()
@@ -817,6 +915,8 @@ def execute_tests(args):
     if args.with_cpp:
         with start_metadata_engine(args.meta) as (_, endpoints):
             run_single_vineyardd_tests(args.meta, endpoints, args.tests)
+        with start_metadata_engine(args.meta) as (_, endpoints):
+            run_migration_tests(args.meta, endpoints, args.tests)
 
         if args.with_deployment:
             with start_metadata_engine(args.meta) as (_, endpoints):
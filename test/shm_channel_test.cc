@@ -0,0 +1,95 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdlib.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./shm_channel_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  // blob commands of client1 go through the shared memory channel, and
+  // client2 talks to the server over the socket.
+  setenv("VINEYARD_IPC_SHM_CHANNEL", "1", 1);
+  Client client1;
+  VINEYARD_CHECK_OK(client1.Connect(ipc_socket));
+  setenv("VINEYARD_IPC_SHM_CHANNEL", "0", 1);
+  Client client2;
+  VINEYARD_CHECK_OK(client2.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+  CHECK(client1.ShmChannelEnabled());
+  CHECK(!client2.ShmChannelEnabled());
+
+  std::vector<ObjectID> ids;
+  for (size_t i = 0; i < 3000; ++i) {
+    size_t size = (i % 7) * 513;
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(client1.CreateBlob(size, writer));
+    CHECK_EQ(writer->size(), size);
+    if (size > 0) {
+      memset(writer->data(), static_cast<int>(i), size);
+    }
+    ids.emplace_back(writer->Seal(client1)->id());
+
+    std::shared_ptr<Blob> blob;
+    VINEYARD_CHECK_OK(client1.GetBlob(ids.back(), blob));
+    CHECK_EQ(blob->size(), size);
+    for (size_t j = 0; j < size; ++j) {
+      CHECK_EQ(blob->data()[j], static_cast<char>(i));
+    }
+    VINEYARD_CHECK_OK(client1.Release(ids.back()));
+  }
+  // the channel is still in use, rather than having fallen back to the socket
+  CHECK(client1.ShmChannelEnabled());
+  LOG(INFO) << "Passed blob commands over the shared memory channel tests...";
+
+  std::vector<std::shared_ptr<Blob>> blobs;
+  VINEYARD_CHECK_OK(client2.GetBlobs(ids, blobs));
+  CHECK_EQ(blobs.size(), ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    CHECK_EQ(blobs[i]->size(), (i % 7) * 513);
+  }
+  LOG(INFO) << "Passed getting blobs created over the shared memory channel "
+               "tests...";
+
+  // requests of more than 2048 blobs are too large for the channel, and fall
+  // back to the socket
+  std::vector<std::shared_ptr<Blob>> local_blobs;
+  VINEYARD_CHECK_OK(client1.GetBlobs(ids, local_blobs));
+  CHECK_EQ(local_blobs.size(), ids.size());
+  VINEYARD_CHECK_OK(client1.Release(ids));
+  LOG(INFO) << "Passed falling back to the socket tests...";
+
+  VINEYARD_CHECK_OK(client2.Release(ids));
+  VINEYARD_CHECK_OK(client1.DelData(ids, true, true));
+
+  client1.Disconnect();
+  client2.Disconnect();
+
+  return 0;
+}
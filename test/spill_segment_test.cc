@@ -0,0 +1,195 @@
+/** Copyright 2020-2022 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <dirent.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+/**
+ * The test is run against vineyardd with a small memory and small spill
+ * segments, with or without the spill compression and the lazy reload, see
+ * also `test/runner.py`.
+ *
+ * The blobs are only compressed when spilled by the background worker, thus
+ * the blobs are created slowly enough to let the worker keep the usage below
+ * the upper watermark, and no allocation spills synchronously.
+ */
+
+constexpr size_t kBlobSize = 32 * 1024;
+constexpr int kBlobs = 64;
+// the default `--spill_upper_rate`
+constexpr double kSpillUpperRate = 0.8;
+
+// different for each blob, and compressible to about a half, thus the blobs
+// still span several segments when compressed
+void FillBlob(uint8_t* data, int index) {
+  std::mt19937 engine(index);
+  for (size_t i = 0; i < kBlobSize / 2; ++i) {
+    data[i] = static_cast<uint8_t>(engine());
+  }
+  std::memset(data + kBlobSize / 2, index, kBlobSize - kBlobSize / 2);
+}
+
+void CheckBlob(Client& client, ObjectID id, int index) {
+  std::shared_ptr<Blob> blob;
+  VINEYARD_CHECK_OK(client.GetBlob(id, blob));
+  CHECK_EQ(blob->allocated_size(), kBlobSize);
+  std::vector<uint8_t> expected(kBlobSize);
+  FillBlob(expected.data(), index);
+  CHECK_EQ(std::memcmp(blob->data(), expected.data(), kBlobSize), 0);
+  VINEYARD_CHECK_OK(client.Release(id));
+}
+
+size_t CountSegments(const std::string& spill_path) {
+  size_t segments = 0;
+  DIR* dir = opendir(spill_path.c_str());
+  CHECK(dir != nullptr);
+  while (struct dirent* entry = readdir(dir)) {
+    if (std::strncmp(entry->d_name, "segment-", 8) == 0) {
+      segments += 1;
+    }
+  }
+  closedir(dir);
+  return segments;
+}
+
+// whether the client maps a spill segment, i.e., a blob is served from the
+// spill file by the lazy reload
+bool MapsSpillSegment(const std::string& spill_path) {
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  while (std::getline(maps, line)) {
+    if (line.find(spill_path + "/segment-") != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// wait until the spill worker brings the usage below the upper watermark, the
+// next allocation then crosses the watermark by at most one blob and wakes up
+// the worker again
+void WaitForSpillWorker(Client& client) {
+  for (int retries = 0; retries < 500; ++retries) {
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    if (status->memory_usage < status->memory_limit * kSpillUpperRate) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  LOG(FATAL) << "The spill worker doesn't release the memory";
+}
+
+bool WaitForSpilled(Client& client, ObjectID const& id) {
+  bool is_spilled = false;
+  for (int retries = 0; retries < 50; ++retries) {
+    VINEYARD_CHECK_OK(client.IsSpilled(id, is_spilled));
+    if (is_spilled) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  return is_spilled;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf(
+        "usage ./spill_segment_test <ipc_socket> <spill_path> "
+        "[lazy|compressed]");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  std::string spill_path = std::string(argv[2]);
+  bool lazy_reload = argc > 3 && std::string(argv[3]) == "lazy";
+  bool compressed = argc > 3 && std::string(argv[3]) == "compressed";
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  std::vector<ObjectID> blob_ids;
+  for (int i = 0; i < kBlobs; ++i) {
+    WaitForSpillWorker(client);
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(client.CreateBlob(kBlobSize, writer));
+    FillBlob(reinterpret_cast<uint8_t*>(writer->data()), i);
+    auto blob = writer->Seal(client);
+    blob_ids.emplace_back(blob->id());
+    VINEYARD_CHECK_OK(client.Release(blob->id()));
+  }
+  CHECK(WaitForSpilled(client, blob_ids[0]));
+
+  // every blob has been spilled by the worker, compressed to about a half if
+  // the compression is enabled
+  {
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    CHECK_EQ(status->allocation_stall_count, 0);
+    CHECK_GT(status->spill_bytes, 0);
+    if (compressed) {
+      CHECK_LT(status->spill_stored_bytes, status->spill_bytes * 3 / 4);
+    } else {
+      CHECK_EQ(status->spill_stored_bytes, status->spill_bytes);
+    }
+  }
+
+  // spill and reload, with the configured codec
+  CHECK(!MapsSpillSegment(spill_path));
+  CheckBlob(client, blob_ids[0], 0);
+  CHECK_EQ(MapsSpillSegment(spill_path), lazy_reload);
+  LOG(INFO) << "Passed spill and reload tests...";
+
+  // drop 3/4 of the records, the sealed segments then get compacted
+  size_t segments = CountSegments(spill_path);
+  CHECK_GT(segments, 1);
+  std::vector<ObjectID> dropped;
+  for (int i = 1; i < kBlobs; ++i) {
+    if (i % 4 != 0) {
+      dropped.emplace_back(blob_ids[i]);
+    }
+  }
+  VINEYARD_CHECK_OK(client.DelData(dropped));
+  for (int retries = 0; retries < 50; ++retries) {
+    if (CountSegments(spill_path) < segments) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  CHECK_LT(CountSegments(spill_path), segments);
+
+  // the relocated records are still intact
+  for (int i = 4; i < kBlobs; i += 4) {
+    CheckBlob(client, blob_ids[i], i);
+  }
+  LOG(INFO) << "Passed spill segment compaction tests...";
+
+  client.Disconnect();
+  return 0;
+}
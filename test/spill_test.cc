@@ -13,8 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <chrono>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include "arrow/api.h"
@@ -50,6 +52,20 @@ vector<T> InitArray(int size, std::function<T(int n)> init_func) {
   return array;
 }
 
+// The memory usage crossing the upper watermark only wakes up the spill
+// worker in vineyardd, thus blobs may be spilled asynchronously.
+bool WaitForSpilled(Client& client, ObjectID const& id) {
+  bool is_spilled = false;
+  for (int retries = 0; retries < 50; ++retries) {
+    VINEYARD_CHECK_OK(client.IsSpilled(id, is_spilled));
+    if (is_spilled) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  return is_spilled;
+}
+
 void BasicTest(Client& client) {
   auto double_array = InitArray<double>(250, [](int i) { return i; });
   ArrayBuilder<double> builder(client, double_array);
@@ -71,7 +87,6 @@ void BasicTest(Client& client) {
     CHECK(status.IsNotEnoughMemory());
   }
 
-  bool is_spilled{false};
   bool is_in_use{false};
   VINEYARD_CHECK_OK(client.Release({id1, blob_id}));
   VINEYARD_CHECK_OK(client.IsInUse(blob_id, is_in_use));
@@ -81,8 +96,7 @@ void BasicTest(Client& client) {
       std::dynamic_pointer_cast<Array<double>>(builder3.Seal(client));
   auto id2 = sealed_double_array3->id();
   auto blob_id2 = GetObjectID(sealed_double_array3);
-  VINEYARD_CHECK_OK(client.IsSpilled(blob_id, is_spilled));
-  CHECK(is_spilled);
+  CHECK(WaitForSpilled(client, blob_id));
   VINEYARD_CHECK_OK(client.IsInUse(blob_id2, is_in_use));
   CHECK(is_in_use);
   VINEYARD_CHECK_OK(client.Release({id2, blob_id2}));
@@ -149,9 +163,7 @@ void ReloadTest(Client& client) {
   }
   // now check for double_array
   {
-    bool is_spilled{false};
-    VINEYARD_CHECK_OK(client.IsSpilled(bid, is_spilled));
-    CHECK(is_spilled);
+    CHECK(WaitForSpilled(client, bid));
     auto double_array_copy = client.GetObject<Array<double>>(id);
     CHECK(double_array_copy->size() == double_array.size());
     for (size_t i = 0; i < double_array.size(); i++) {
@@ -159,9 +171,7 @@ void ReloadTest(Client& client) {
     }
   }
   {
-    bool is_spilled{false};
-    VINEYARD_CHECK_OK(client.IsSpilled(bid1, is_spilled));
-    CHECK(is_spilled);
+    CHECK(WaitForSpilled(client, bid1));
     auto str_array_copy = client.GetObject<Array<std::string>>(id1);
     CHECK(str_array_copy->size() == string_array1.size());
     for (size_t i = 0; i < string_array1.size(); i++) {